@@ -0,0 +1,66 @@
+/**
+* @file async_io.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Completion of one submitted read or write
+ */
+struct IoCompletion {
+    uint64_t tag;       // tag given at submission
+    bool success;
+    size_t bytes;       // bytes transferred
+    uint64_t latencyNs; // submission to completion
+};
+
+/**
+ * Whole-file asynchronous reads and writes, used to keep many files in flight
+ * while the device works. Implemented on io_uring when built with liburing and
+ * the kernel allows it, otherwise on a thread pool.
+ */
+class AsyncFileIO {
+public:
+    /**
+     * @brief Create the best available engine
+     * @param [in] depth: max requests in flight
+     * @return engine, nullptr on failure
+     */
+    static std::unique_ptr<AsyncFileIO> Create(unsigned depth);
+
+    virtual ~AsyncFileIO() = default;
+
+    /**
+     * @brief Read size bytes from the start of path into buffer
+     */
+    virtual bool SubmitRead(uint64_t tag, const std::string &path, void *buffer, size_t size) = 0;
+
+    /**
+     * @brief Create or truncate path and write size bytes of buffer into it
+     */
+    virtual bool SubmitWrite(uint64_t tag, const std::string &path, const void *buffer, size_t size) = 0;
+
+    /**
+     * @brief Block until one submitted request completes
+     * @param [out] done: the completed request
+     * @return false if nothing is in flight
+     */
+    virtual bool WaitCompletion(IoCompletion &done) = 0;
+
+    /**
+     * @brief Engine name for logs
+     */
+    virtual const char *Name() const = 0;
+};
+
+#endif // ASYNC_IO_H
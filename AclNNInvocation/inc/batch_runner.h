@@ -0,0 +1,30 @@
+/**
+* @file batch_runner.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <string>
+
+#include "op_runner.h"
+
+/**
+ * @brief Run the op over every tensor file of a manifest
+ *
+ * Each manifest line is "<input file> <output file>". Reads of the next ioDepth inputs
+ * and writes of finished outputs stay in flight while the device runs the current one.
+ * An OpRunner is kept per input shape and reused.
+ * @param [in] manifest: manifest path
+ * @param [in] ioDepth: max files in flight in each direction
+ * @param [in] completion: how each run waits for the device
+ * @return run result
+ */
+bool RunBatch(const std::string &manifest, unsigned ioDepth, const CompletionOptions &completion = CompletionOptions());
+
+#endif // BATCH_RUNNER_H
@@ -0,0 +1,131 @@
+/**
+* @file batch_scheduler.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef BATCH_SCHEDULER_H
+#define BATCH_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "mpsc_queue.h"
+
+class BatchScheduler;
+class RunnerCache;
+
+/**
+ * One Mish request for the BatchScheduler. Input and output are count fp16 values in
+ * caller memory and must stay valid until Done() is true.
+ */
+struct BatchRequest : MpscNode {
+    const uint16_t *input = nullptr;
+    uint16_t *output = nullptr;
+    size_t count = 0;
+    uint64_t submitNs = 0;                 // set by Submit
+    BatchScheduler *scheduler = nullptr;   // set by Submit, Wait parks on it
+    std::atomic<int> status{ STATUS_PENDING };
+
+    static constexpr int STATUS_PENDING = 1;
+    static constexpr int STATUS_OK = 0;
+    static constexpr int STATUS_FAILED = -1;
+
+    bool Done() const
+    {
+        return status.load(std::memory_order_acquire) != STATUS_PENDING;
+    }
+
+    /**
+     * @brief Spin, yield for a while, then sleep until the scheduler has finished the request.
+     * Only valid after Submit
+     * @return true if the request succeeded
+     */
+    bool Wait() const;
+};
+
+struct BatchSchedulerOptions {
+    size_t maxBatchRequests = 32;          // requests merged into one launch
+    size_t maxBatchElements = 1 << 20;     // elements merged into one launch
+    uint64_t maxDelayUs = 200;             // how long the oldest request may wait for company
+    size_t minBucketElements = 4096;       // smallest launch shape
+};
+
+struct BatchSchedulerStats {
+    uint64_t requests = 0;
+    uint64_t launches = 0;
+    uint64_t elements = 0;                 // useful elements
+    uint64_t paddedElements = 0;           // elements launched, padding included
+    uint64_t runners = 0;
+};
+
+/**
+ * Coalesces concurrent elementwise Mish requests into one launch. Producers push into a
+ * lock-free MPSC queue; one dispatcher thread gathers requests until the batch is full or
+ * the oldest one has waited maxDelayUs, copies them back to back into the input of an
+ * OpRunner whose 1-D shape is the next power of two bucket, launches once and scatters
+ * the output back. Mish is elementwise, so the zero padding does not affect the results.
+ */
+class BatchScheduler {
+public:
+    explicit BatchScheduler(const BatchSchedulerOptions &options);
+    ~BatchScheduler();
+
+    /**
+     * @brief Start the dispatcher thread, it binds itself to deviceId
+     * @return start result
+     */
+    bool Start();
+
+    /**
+     * @brief Finish every submitted request, then stop the dispatcher
+     */
+    void Stop();
+
+    /**
+     * @brief Queue a request, never blocks
+     * @param [in] request: request to run, completion is reported through its status
+     */
+    void Submit(BatchRequest *request);
+
+    /**
+     * @brief Counters, only stable after Stop()
+     */
+    BatchSchedulerStats Stats() const;
+
+private:
+    friend struct BatchRequest;
+
+    void Loop();
+    void Park(const BatchRequest &request);
+    BatchRequest *Next(bool block, uint64_t deadlineNs);
+    void RunBatch(RunnerCache &runners, BatchRequest **batch, size_t num, size_t elements);
+
+    BatchSchedulerOptions options_;
+    MpscQueue queue_;
+    BatchRequest *carry_ = nullptr;        // popped but did not fit the previous batch
+
+    // the dispatcher only sleeps on the condvar when the queue stayed empty for a while
+    std::atomic<bool> sleeping_{ false };
+    std::atomic<bool> stop_{ false };
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+
+    // waiters that gave up spinning; the dispatcher only notifies when there are some. The condvar lives
+    // here and not in the request, a request may be freed as soon as its status is published
+    std::atomic<int> parked_{ 0 };
+    std::mutex doneMutex_;
+    std::condition_variable done_;
+
+    BatchSchedulerStats stats_;
+};
+
+#endif // BATCH_SCHEDULER_H
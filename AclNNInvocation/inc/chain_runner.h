@@ -0,0 +1,197 @@
+/**
+* @file chain_runner.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef CHAIN_RUNNER_H
+#define CHAIN_RUNNER_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "aclnn/acl_meta.h"
+#include "acl/acl.h"
+#include "op_runner.h"
+
+/**
+ * A named tensor of a chain
+ */
+struct ChainTensorDesc {
+    std::string name;
+    aclDataType dataType = ACL_DT_UNDEFINED;
+    std::vector<int64_t> dims;
+    aclFormat format = ACL_FORMAT_ND;
+
+    /**
+     * @brief Bytes of the tensor
+     */
+    size_t Size() const;
+};
+
+/**
+ * First phase of an aclnn call, the <Op>GetWorkspaceSize function with the op's attributes bound.
+ * Tensors come in the order of ChainStep::inputs and ChainStep::outputs, nullptr for an absent optional.
+ */
+using ChainPrepareFunc = std::function<aclnnStatus(const std::vector<aclTensor *> &inputs,
+    const std::vector<aclTensor *> &outputs, uint64_t *workspaceSize, aclOpExecutor **handle)>;
+
+/**
+ * Second phase of an aclnn call, the <Op> function itself
+ */
+using ChainLaunchFunc = aclnnStatus (*)(void *workspace, uint64_t workspaceSize, aclOpExecutor *handle,
+    aclrtStream stream);
+
+/**
+ * One aclnn invocation of a chain. Inputs refer to chain inputs or to outputs of earlier
+ * steps by name, "" passes nullptr; every output is a new tensor.
+ */
+struct ChainStep {
+    std::string opType;     // for the log only
+    std::vector<std::string> inputs;
+    std::vector<ChainTensorDesc> outputs;
+    ChainPrepareFunc prepare;
+    ChainLaunchFunc launch = nullptr;
+};
+
+/**
+ * @brief Steps of the custom ops of this project, y (and t) described by the caller
+ */
+ChainStep MishStep(const std::string &x, const ChainTensorDesc &y);
+ChainStep MishResidualStep(const std::string &x, const ChainTensorDesc &y, const ChainTensorDesc &t);
+ChainStep MishDropoutStep(const std::string &x, float keepProb, int64_t seed, int64_t offset,
+    const ChainTensorDesc &y, const ChainTensorDesc &mask);
+ChainStep GatedMishStep(const std::string &x, const ChainTensorDesc &y);
+ChainStep MatmulMishStep(const std::string &a, const std::string &b, const std::string &bias,
+    const ChainTensorDesc &y);
+
+/**
+ * Runs a list of aclnn ops back to back on one stream with everything in between kept on
+ * the device. Only the chain inputs are copied in and only the tensors passed to AddOutput
+ * are copied back, once per Run, where one OpRunner per op would copy every intermediate
+ * out and in again.
+ *
+ * Init works out the last step reading each tensor and plans the device memory from that:
+ * a tensor's buffer goes back to the pool once its last reader has been launched and is
+ * handed to the next tensor it fits, so a long chain needs about as much memory as its
+ * widest two steps instead of the sum of all intermediates. Steps run in order on a single
+ * stream, which is what makes the reuse safe without any extra synchronization. Chain
+ * inputs take part in the reuse too, Run copies them in again every time.
+ */
+class ChainRunner {
+public:
+    ChainRunner() = default;
+    ~ChainRunner();
+
+    /**
+     * @brief Declare a tensor filled by the application through GetInputBuffer
+     */
+    bool AddInput(const ChainTensorDesc &desc);
+
+    /**
+     * @brief Append a step; its inputs must already be declared, its outputs must be new
+     */
+    bool AddStep(const ChainStep &step);
+
+    /**
+     * @brief Copy a tensor back to the host after each Run, it keeps its own device buffer
+     */
+    bool AddOutput(const std::string &name);
+
+    /**
+     * @brief Plan the device memory and allocate everything, no step may be added afterwards
+     */
+    bool Init();
+
+    /**
+     * @brief Copy the inputs in, launch every step, wait once and copy the outputs back
+     */
+    bool Run();
+
+    /**
+     * @brief Timeout of the single wait at the end of Run, -1 waits forever
+     */
+    void SetSyncTimeout(int32_t timeoutMs)
+    {
+        timeoutMs_ = timeoutMs;
+    }
+
+    /**
+     * @brief Host buffer of an input or an output, nullptr when the name is neither
+     */
+    void *GetHostBuffer(const std::string &name);
+
+    /**
+     * @brief Description of a tensor, nullptr when unknown
+     */
+    const ChainTensorDesc *FindTensor(const std::string &name) const;
+
+    /**
+     * @brief Device bytes of the pooled (non output) tensors as planned by Init
+     */
+    size_t GetPooledBytes() const;
+
+    /**
+     * @brief Device bytes the same tensors would take with one buffer each
+     */
+    size_t GetUnpooledBytes() const;
+
+    size_t GetPoolBlocks() const
+    {
+        return pool_.size();
+    }
+
+    /**
+     * @brief Host <-> device copies made by Run so far
+     */
+    const CopyStats &GetCopyStats() const
+    {
+        return copyStats_;
+    }
+
+private:
+    ChainRunner(const ChainRunner &) = delete;
+    ChainRunner &operator=(const ChainRunner &) = delete;
+
+    struct Tensor {
+        ChainTensorDesc desc;
+        int producer = -1;      // step writing it, -1 for a chain input
+        int lastUse = -1;       // last step reading it, -1 when nobody does
+        bool isInput = false;
+        bool isOutput = false;
+        int block = -1;         // pool block, -1 for outputs
+        void *dev = nullptr;
+        void *host = nullptr;
+        aclTensor *tensor = nullptr;
+    };
+
+    struct Block {
+        size_t size = 0;
+        void *dev = nullptr;
+    };
+
+    bool Define(const ChainTensorDesc &desc, int producer);
+    void PlanPool();
+    bool Allocate();
+    bool GrowWorkspace(uint64_t size, aclrtStream stream);
+    bool LaunchSteps();
+    void WaitIdle();
+
+    std::vector<Tensor> tensors_;
+    std::map<std::string, size_t> index_;
+    std::vector<ChainStep> steps_;
+    std::vector<Block> pool_;
+    void *workspace_ = nullptr;
+    uint64_t workspaceSize_ = 0;
+    aclrtStream stream_ = nullptr;
+    bool initialized_ = false;
+    int32_t timeoutMs_ = 5000;
+    CopyStats copyStats_;
+};
+
+#endif // CHAIN_RUNNER_H
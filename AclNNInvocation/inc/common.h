@@ -10,6 +10,7 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <cstdint>
 #include <cstdio>
 #include <string>
 #include <vector>
@@ -17,29 +18,110 @@
 #include <iomanip>
 
 #include "acl/acl.h"
+#include "log.h"
 
 #define SUCCESS 0
 #define FAILED 1
 
-#define INFO_LOG(fmt, args...) fprintf(stdout, "[INFO]  " fmt "\n", ##args)
-#define WARN_LOG(fmt, args...) fprintf(stdout, "[WARN]  " fmt "\n", ##args)
-#define ERROR_LOG(fmt, args...) fprintf(stderr, "[ERROR]  " fmt "\n", ##args)
 
 /**
- * @brief Read data from file
+ * Self-describing tensor file. The header and the optional chunk index sit in front of
+ * the payload, which starts at a TENSOR_FILE_ALIGN boundary so it can be mmap-ed or read
+ * with O_DIRECT. All fields are little endian; scripts/tensor_file.py uses the same layout.
+ */
+constexpr char TENSOR_FILE_MAGIC[8] = { 'M', 'I', 'S', 'H', 'T', 'N', 'S', 'R' };
+constexpr uint32_t TENSOR_FILE_VERSION = 1;
+constexpr uint64_t TENSOR_FILE_ALIGN = 4096;
+constexpr uint32_t TENSOR_FILE_MAX_DIMS = 8;
+
+struct TensorFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(TensorFileHeader)
+    int32_t dataType;           // aclDataType
+    int32_t format;             // aclFormat
+    uint32_t numDims;
+    uint32_t numChunks;         // 0 when the file has no chunk index
+    int64_t dims[TENSOR_FILE_MAX_DIMS];
+    int64_t strides[TENSOR_FILE_MAX_DIMS]; // in elements
+    uint64_t dataOffset;        // payload offset, multiple of TENSOR_FILE_ALIGN
+    uint64_t dataSize;          // payload bytes
+    uint64_t chunkIndexOffset;  // TensorFileChunk array, right after the header
+    uint32_t dataChecksum;      // crc32 of the payload
+    uint32_t headerChecksum;    // crc32 of header and chunk index with this field zeroed
+};
+
+struct TensorFileChunk {
+    uint64_t offset;            // relative to dataOffset, multiple of TENSOR_FILE_ALIGN
+    uint64_t size;
+    uint32_t checksum;          // crc32 of the chunk
+    uint32_t reserved;
+};
+
+/**
+ * @brief Standard (zlib compatible) crc32
+ * @param [in] data: data to checksum
+ * @param [in] size: data size
+ * @param [in] crc: crc of the preceding data, to checksum in pieces
+ * @return crc32 value
+ */
+uint32_t Crc32(const void *data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Read and validate the header and chunk index of a tensor file
  * @param [in] filePath: file path
- * @param [out] fileSize: file size
+ * @param [out] header: file header
+ * @param [out] chunks: chunk index, may be nullptr
  * @return read result
  */
-bool ReadFile(const std::string &filePath, size_t fileSize, void *buffer, size_t bufferSize);
+bool ReadTensorFileHeader(const std::string &filePath, TensorFileHeader &header,
+                          std::vector<TensorFileChunk> *chunks = nullptr);
+
+/**
+ * @brief Read the payload of a tensor file, chunk by chunk when it has a chunk index.
+ * Only contiguous row major payloads are read
+ * @param [in] filePath: file path
+ * @param [out] buffer: payload destination
+ * @param [in] bufferSize: buffer size, must equal the payload size
+ * @return read result
+ */
+bool ReadTensorFile(const std::string &filePath, void *buffer, size_t bufferSize);
+
+/**
+ * @brief Build the header and chunk index of a tensor file, zero padded up to the payload offset
+ * @param [in] dataType: data type
+ * @param [in] dims: shape, contiguous row major
+ * @param [in] buffer: payload
+ * @param [in] size: payload size
+ * @param [in] chunkSize: chunk index granularity, 0 for no index, else a multiple of TENSOR_FILE_ALIGN
+ * @return encoded bytes, empty on failure
+ */
+std::vector<char> EncodeTensorFileHeader(aclDataType dataType, const std::vector<int64_t> &dims,
+                                         const void *buffer, size_t size, size_t chunkSize = 0);
+
+/**
+ * @brief Validate a tensor file that is already in memory
+ * @param [in] filePath: file path, for messages only
+ * @param [in] fileData: whole file content
+ * @param [in] fileSize: file size
+ * @param [out] header: file header
+ * @param [out] payload: start of the payload inside fileData
+ * @return decode result
+ */
+bool DecodeTensorFile(const std::string &filePath, const void *fileData, size_t fileSize,
+                      TensorFileHeader &header, const void **payload);
 
 /**
- * @brief Write data to file
+ * @brief Write a tensor file
  * @param [in] filePath: file path
- * @param [in] buffer: data to write to file
- * @param [in] size: size to write
+ * @param [in] dataType: data type
+ * @param [in] dims: shape, contiguous row major
+ * @param [in] buffer: payload
+ * @param [in] size: payload size
+ * @param [in] chunkSize: chunk index granularity, 0 for no index, else a multiple of TENSOR_FILE_ALIGN
  * @return write result
  */
-bool WriteFile(const std::string &filePath, const void *buffer, size_t size);
+bool WriteTensorFile(const std::string &filePath, aclDataType dataType, const std::vector<int64_t> &dims,
+                     const void *buffer, size_t size, size_t chunkSize = 0);
 
 #endif // COMMON_H
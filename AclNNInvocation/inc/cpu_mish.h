@@ -0,0 +1,82 @@
+/**
+* @file cpu_mish.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef CPU_MISH_H
+#define CPU_MISH_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "acl/acl.h"
+
+/**
+ * @brief Mish on the host with the formula of the MishCustom kernel: n = e^x (e^x + 2),
+ * t = n / (n + 2), y = x * t, x clamped before the exp so n stays finite
+ * @param [in] x: count fp16 inputs
+ * @param [out] y: count fp16 outputs
+ * @param [out] t: count fp16 tanh(softplus(x)), nullptr when not wanted
+ */
+void CpuMish(const aclFloat16 *x, aclFloat16 *y, aclFloat16 *t, size_t count);
+
+/**
+ * Fixed set of host threads running CpuMish on equal slices of one range. Submit returns at
+ * once, so the caller can drive the device in the meantime, and Wait reports how long the
+ * slowest thread took.
+ */
+class CpuMishPool {
+public:
+    /**
+     * @param [in] threads: worker threads, at least one is started
+     */
+    explicit CpuMishPool(unsigned threads);
+    ~CpuMishPool();
+
+    unsigned NumThreads() const
+    {
+        return numThreads_;
+    }
+
+    /**
+     * @brief Hand count elements to the workers, the previous range must have been waited for
+     */
+    void Submit(const aclFloat16 *x, aclFloat16 *y, aclFloat16 *t, size_t count);
+
+    /**
+     * @brief Block until every worker is done with the submitted range
+     * @return ns from Submit to the last worker finishing, 0 when nothing was submitted
+     */
+    uint64_t Wait();
+
+private:
+    CpuMishPool(const CpuMishPool &) = delete;
+    CpuMishPool &operator=(const CpuMishPool &) = delete;
+
+    void Work(unsigned index);
+
+    const unsigned numThreads_;     // fixed before the workers start, they read it without the lock
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable startCv_;
+    std::condition_variable doneCv_;
+    const aclFloat16 *x_ = nullptr;
+    aclFloat16 *y_ = nullptr;
+    aclFloat16 *t_ = nullptr;
+    size_t count_ = 0;
+    uint64_t generation_ = 0;   // bumped by every Submit, workers run once per value
+    unsigned remaining_ = 0;    // workers still busy with the current generation
+    uint64_t submitNs_ = 0;
+    uint64_t finishNs_ = 0;
+    bool stop_ = false;
+};
+
+#endif // CPU_MISH_H
@@ -0,0 +1,84 @@
+/**
+* @file log.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef LOG_H
+#define LOG_H
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+
+/**
+ * Log calls below MISH_LOG_LEVEL are compiled out, so a release build with
+ * -DMISH_LOG_LEVEL=2 has no INFO call left in RunOp. The call stays behind if (0):
+ * no code is emitted, but the arguments are still type checked and count as used,
+ * so values computed only for a log line do not turn into warnings. Calls at or
+ * above the level are filtered again at runtime by LogSetLevel.
+ */
+#ifndef MISH_LOG_LEVEL
+#define MISH_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if MISH_LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define DEBUG_LOG(fmt, args...) LogWrite(LOG_LEVEL_DEBUG, "[DEBUG] " fmt "\n", ##args)
+#else
+#define DEBUG_LOG(fmt, args...) do { if (0) LogWrite(LOG_LEVEL_DEBUG, "[DEBUG] " fmt "\n", ##args); } while (0)
+#endif
+
+#if MISH_LOG_LEVEL <= LOG_LEVEL_INFO
+#define INFO_LOG(fmt, args...) LogWrite(LOG_LEVEL_INFO, "[INFO]  " fmt "\n", ##args)
+#else
+#define INFO_LOG(fmt, args...) do { if (0) LogWrite(LOG_LEVEL_INFO, "[INFO]  " fmt "\n", ##args); } while (0)
+#endif
+
+#if MISH_LOG_LEVEL <= LOG_LEVEL_WARN
+#define WARN_LOG(fmt, args...) LogWrite(LOG_LEVEL_WARN, "[WARN]  " fmt "\n", ##args)
+#else
+#define WARN_LOG(fmt, args...) do { if (0) LogWrite(LOG_LEVEL_WARN, "[WARN]  " fmt "\n", ##args); } while (0)
+#endif
+
+#define ERROR_LOG(fmt, args...) LogWrite(LOG_LEVEL_ERROR, "[ERROR]  " fmt "\n", ##args)
+
+/**
+ * @brief Write one message: errors go to stderr, the rest to stdout. With the async sink
+ * on, everything below ERROR is formatted into a preallocated ring slot without taking a
+ * lock or allocating; errors flush the ring and are written right away so they are never
+ * lost in a crash.
+ * @param [in] level: LOG_LEVEL_*
+ * @param [in] fmt: printf format
+ */
+void LogWrite(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Runtime threshold, LOG_LEVEL_INFO by default; has no effect below MISH_LOG_LEVEL
+ */
+void LogSetLevel(int level);
+int LogGetLevel();
+
+/**
+ * @brief Parse "debug", "info", "warn" or "error"
+ * @return level, -1 when unknown
+ */
+int LogParseLevel(const char *name);
+
+/**
+ * @brief Switch the async sink on or off. On starts a background writer thread; off flushes
+ * the queue, stops the thread and goes back to writing in the caller. The sink is also
+ * stopped at exit.
+ * @return false when the writer thread can not be started
+ */
+bool LogSetAsync(bool async);
+
+/**
+ * @brief Block until every message queued so far is written
+ */
+void LogFlush();
+
+#endif // LOG_H
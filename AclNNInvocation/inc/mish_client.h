@@ -0,0 +1,108 @@
+/**
+* @file mish_client.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef MISH_CLIENT_H
+#define MISH_CLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+
+/**
+ * Wire format between mish_server and its clients over a SOCK_SEQPACKET Unix socket.
+ * Tensor data never goes through the socket: each connection shares one memfd region,
+ * sent once with SCM_RIGHTS in a REGISTER request. A RUN request names a range of that
+ * region, the server reads the input from it and writes the output back in place.
+ * The memfd must carry MISH_SERVE_REQUIRED_SEALS, so the client cannot truncate it while
+ * the server has it mapped.
+ */
+constexpr uint32_t MISH_SERVE_MAGIC = 0x4853494d; // "MISH"
+constexpr uint32_t MISH_SERVE_MAX_DIMS = 8;
+constexpr const char *MISH_SERVE_DEFAULT_SOCKET = "/tmp/mish_server.sock";
+constexpr int MISH_SERVE_REQUIRED_SEALS = F_SEAL_SHRINK | F_SEAL_GROW;
+
+enum MishServeOp : uint32_t {
+    MISH_SERVE_REGISTER = 1,  // carries the memfd, regionSize is its size
+    MISH_SERVE_RUN = 2,
+};
+
+struct MishServeRequest {
+    uint32_t magic;
+    uint32_t op;
+    uint64_t id;
+    int32_t dataType;         // aclDataType
+    uint32_t numDims;
+    int64_t dims[MISH_SERVE_MAX_DIMS];
+    uint64_t offset;          // payload range in the shared region
+    uint64_t size;
+    uint64_t regionSize;
+};
+
+struct MishServeReply {
+    uint32_t magic;
+    int32_t status;           // 0 on success
+    uint64_t id;
+    uint64_t serverNs;        // time spent in the server, copies and launch included
+};
+
+/**
+ * Client side of mish_server. Fill Buffer() with the input, call Run(), read the output
+ * from Buffer(). One client is one connection and must not be shared across threads.
+ */
+class MishClient {
+public:
+    MishClient();
+    ~MishClient();
+
+    /**
+     * @brief Connect and share a region of at least capacity bytes with the server
+     * @param [in] socketPath: server socket path
+     * @param [in] capacity: bytes available through Buffer()
+     * @return connect result
+     */
+    bool Connect(const std::string &socketPath, size_t capacity);
+
+    void Close();
+
+    /**
+     * @brief Shared region, input before Run() and output after it
+     */
+    void *Buffer() const
+    {
+        return region_;
+    }
+
+    size_t Capacity() const
+    {
+        return capacity_;
+    }
+
+    /**
+     * @brief Run the op on the first size bytes of Buffer(), the output overwrites them
+     * @param [in] dataType: aclDataType of the tensor
+     * @param [in] dims: shape of the tensor
+     * @param [in] size: payload bytes
+     * @param [out] serverNs: time spent in the server, may be nullptr
+     * @return run result
+     */
+    bool Run(int32_t dataType, const std::vector<int64_t> &dims, size_t size, uint64_t *serverNs = nullptr);
+
+private:
+    bool Call(const MishServeRequest &request, int fd, MishServeReply &reply);
+
+    int sock_ = -1;
+    int memfd_ = -1;
+    void *region_ = nullptr;
+    size_t capacity_ = 0;
+    uint64_t nextId_ = 1;
+};
+
+#endif // MISH_CLIENT_H
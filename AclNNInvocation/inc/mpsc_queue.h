@@ -0,0 +1,77 @@
+/**
+* @file mpsc_queue.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+
+/**
+ * Intrusive link of an MpscQueue element, embed it as the first base of the element type.
+ */
+struct MpscNode {
+    std::atomic<MpscNode *> next{nullptr};
+};
+
+/**
+ * Unbounded intrusive multi-producer single-consumer queue (D. Vyukov). Push is one
+ * atomic exchange and never blocks; Pop may only be called from one thread. Pop can
+ * return nullptr for a moment while a producer is between its two stores, callers just
+ * treat that as empty and retry later.
+ */
+class MpscQueue {
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void Push(MpscNode *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    MpscNode *Pop()
+    {
+        MpscNode *tail = tail_;
+        MpscNode *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;  // a producer has swapped head but not linked it yet
+        }
+        // tail is the last element, put the stub behind it so it can be handed out
+        Push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+private:
+    alignas(64) std::atomic<MpscNode *> head_;  // written by producers
+    alignas(64) MpscNode *tail_;                // owned by the consumer
+    MpscNode stub_;
+};
+
+#endif // MPSC_QUEUE_H
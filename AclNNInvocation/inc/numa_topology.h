@@ -0,0 +1,104 @@
+/**
+* @file numa_topology.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Which NUMA node each device hangs off and which cpus each node has. On a multi
+ * socket host, pinned host buffers and the threads copying them should sit on the
+ * device's node, a cross socket H2D copy gets roughly half the bandwidth.
+ */
+struct NumaTopology {
+    std::map<int32_t, int> deviceNode;          // device id -> numa node
+    std::map<int, std::vector<int>> nodeCpus;   // numa node -> cpu ids
+
+    /**
+     * @brief Node of a device
+     * @return node id, -1 when unknown
+     */
+    int NodeOfDevice(int32_t deviceId) const;
+};
+
+/**
+ * @brief Parse a device to node map such as "0:0,1:0,2:1,3:1"
+ * @param [in] text: comma separated device:node pairs
+ * @param [out] deviceNode: parsed map
+ * @return parse result
+ */
+bool ParseDeviceNodeMap(const std::string &text, std::map<int32_t, int> &deviceNode);
+
+/**
+ * @brief Load the topology from sysfs under root, "" for the real /sys
+ *
+ * Node cpus come from sys/devices/system/node/node<N>/cpulist. Devices are the pci
+ * functions bound to the Ascend driver in sys/bus/pci/drivers/devdrv_device_driver,
+ * numbered in bus address order like the driver does. A non empty deviceMap
+ * (ParseDeviceNodeMap format) overrides what sysfs says about the devices.
+ * A fake tree under root describes a topology the host does not have.
+ * @param [in] root: sysfs root prefix
+ * @param [in] deviceMap: device to node override, may be empty
+ * @param [out] topology: loaded topology
+ * @return false when no node is found
+ */
+bool LoadNumaTopology(const std::string &root, const std::string &deviceMap, NumaTopology &topology);
+
+/**
+ * @brief Restrict the calling thread to the cpus of a node; threads it creates afterwards inherit this
+ * @return pin result
+ */
+bool PinThreadToNode(const NumaTopology &topology, int node);
+
+/**
+ * @brief Node holding the page at addr
+ * @return node id, -1 when unknown
+ */
+int NodeOfAddress(const void *addr);
+
+/**
+ * @brief Node for pinned host buffers allocated by OpRunner::Init from now on
+ * @param [in] node: node id, -1 leaves placement to the allocating thread (the default)
+ */
+void SetHostMemoryNode(int node);
+int GetHostMemoryNode();
+
+/**
+ * Sets the calling thread's memory policy to prefer one node while in scope, so the pages
+ * aclrtMallocHost pins meanwhile come from that node when it has room; restores the previous policy
+ * afterwards. aclrtMallocHost has no placement argument and pinned pages cannot be
+ * moved by mbind once allocated, so the policy has to be in place before the call.
+ */
+class ScopedMemPolicy {
+public:
+    /**
+     * @param [in] node: node id, -1 does nothing
+     */
+    explicit ScopedMemPolicy(int node);
+    ~ScopedMemPolicy();
+
+    bool Applied() const
+    {
+        return applied_;
+    }
+
+private:
+    ScopedMemPolicy(const ScopedMemPolicy &) = delete;
+    ScopedMemPolicy &operator=(const ScopedMemPolicy &) = delete;
+
+    bool applied_ = false;
+    int oldMode_ = 0;
+    std::vector<unsigned long> oldMask_;
+};
+
+#endif // NUMA_TOPOLOGY_H
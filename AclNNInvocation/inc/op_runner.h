@@ -10,11 +10,90 @@
 #ifndef OP_RUNNER_H
 #define OP_RUNNER_H
 
+#include <memory>
+
 #include "aclnn/acl_meta.h"
 #include "acl/acl.h"
 #include "common.h"
 #include "operator_desc.h"
 
+extern bool g_isDevice;
+
+class CpuMishPool;
+
+/**
+ * How RunOp waits for the launch to finish before copying the outputs back
+ */
+enum CompletionPolicy {
+    COMPLETION_BLOCK = 0,   // aclrtSynchronizeStreamWithTimeout, the thread sleeps in the runtime
+    COMPLETION_SPIN,        // busy-poll an event recorded after the launch, lowest wake up latency
+    COMPLETION_HYBRID,      // spin for spinUs, then block for the rest of the timeout
+};
+
+struct CompletionOptions {
+    CompletionPolicy policy = COMPLETION_BLOCK;
+    int32_t timeoutMs = 5000;   // -1 waits forever
+    uint32_t spinUs = 50;       // spin budget of COMPLETION_HYBRID
+};
+
+/**
+ * @brief Parse "block", "spin" or "hybrid"
+ * @param [in] name: policy name
+ * @param [out] policy: parsed policy
+ * @return parse result
+ */
+bool ParseCompletionPolicy(const std::string &name, CompletionPolicy &policy);
+
+/**
+ * @brief Name of a completion policy, as accepted by ParseCompletionPolicy
+ */
+const char *CompletionPolicyName(CompletionPolicy policy);
+
+/**
+ * Staging copies RunOp made between the application buffers and the tensors the op reads and writes
+ */
+struct CopyStats {
+    uint64_t copies = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * Tiles of the last MishCustom launch by compute path, summed over the cores
+ */
+struct MishPathCounters {
+    uint64_t saturateHigh = 0;  // whole tile >= 4.5, y = x
+    uint64_t saturateLow = 0;   // whole tile <= -20.5, y = 0
+    uint64_t fast = 0;          // no clamp needed
+    uint64_t full = 0;          // mixed tile, clamped before exp
+
+    uint64_t Total() const
+    {
+        return saturateHigh + saturateLow + fast + full;
+    }
+};
+
+/**
+ * Co-execution of MishCustom: the tail of x is computed by host threads while the device runs the head
+ */
+struct CoExecOptions {
+    bool enabled = false;
+    unsigned cpuThreads = 0;        // 0 for one per host cpu but the one driving the device
+    double initialCpuShare = 0.1;   // share of the host before the first run has been timed
+    double maxCpuShare = 0.9;
+    double smoothing = 0.3;         // weight of the newest run in the throughput averages
+};
+
+struct CoExecStats {
+    uint64_t runs = 0;
+    double cpuShare = 0;            // share of the elements the next run gives the host
+    size_t lastCpuElements = 0;
+    size_t lastNpuElements = 0;
+    double lastCpuNs = 0;
+    double lastNpuNs = 0;           // host to device copy up to the device to host copy, both included
+    double cpuRate = 0;             // smoothed elements per ns, 0 until that side has run
+    double npuRate = 0;
+};
+
 /**
  * Op Runner
  */
@@ -97,7 +176,13 @@ public:
     std::vector<int64_t> GetOutputShape(size_t index) const;
 
     /**
-     * @brief Get input buffer(host memory) by index
+     * @brief Get the device memory held by the runner's inputs and outputs
+     * @return bytes allocated on the device by Init
+     */
+    size_t GetDeviceMemorySize() const;
+
+    /**
+     * @brief Get input buffer(host memory, the device buffer itself in zero copy mode) by index
      * @tparam T: data type
      * @param [in] index: input index
      * @return host address of the input
@@ -113,7 +198,7 @@ public:
     }
 
     /**
-     * @brief Get output buffer(host memory) by index
+     * @brief Get output buffer(host memory, the device buffer itself in zero copy mode) by index
      * @tparam T: data type
      * @param [in] index: output index
      * @return host address of the output
@@ -161,7 +246,107 @@ public:
      */
     bool RunOp();
 
+    /**
+     * @brief Set how RunOp waits for the device, blocking with a 5000 ms timeout by default
+     * @param [in] options: completion policy and timeout
+     */
+    void SetCompletion(const CompletionOptions &options)
+    {
+        completion_ = options;
+    }
+
+    const CompletionOptions &GetCompletion() const
+    {
+        return completion_;
+    }
+
+    /**
+     * @brief In device run mode (the app runs on the SoC, sharing DRAM with the AI core), hand the
+     * op's own device buffers to the application instead of staging copies. Must be called before
+     * Init; ignored in host run mode, where the buffers have to cross pcie.
+     * @param [in] zeroCopy: true for no staging copies
+     */
+    void SetZeroCopy(bool zeroCopy)
+    {
+        zeroCopy_ = zeroCopy;
+    }
+
+    /**
+     * @brief Whether Init set the runner up without staging buffers
+     */
+    bool IsZeroCopy() const
+    {
+        return zeroCopy_ && g_isDevice;
+    }
+
+    /**
+     * @brief Read the per core path counters MishCustom leaves at the end of its workspace. The workspace
+     * is kept from one RunOp to the next, so this reports the last launch.
+     * @param [out] counters: tiles per path
+     * @return false when the op is not MishCustom or the workspace has no counters
+     */
+    bool ReadPathCounters(MishPathCounters &counters);
+
+    /**
+     * @brief Split every RunOp of MishCustom between the device and a pool of host threads. The device
+     * takes a head of x whose length is a multiple of CO_EXEC_ALIGN elements and only that part is staged;
+     * the host reads the tail from the input buffer and writes y (and t) in place in the output buffers,
+     * so the application sees one tensor as before. The split follows the throughput both sides reached
+     * in the previous runs, which evens out their finishing times.
+     * @param [in] options: co-execution settings, enabled = false goes back to the device alone
+     * @return false when the op is not a single input fp16 MishCustom
+     */
+    bool SetCoExecution(const CoExecOptions &options);
+
+    const CoExecStats &GetCoExecStats() const
+    {
+        return coExecStats_;
+    }
+
+    /**
+     * @brief Staging copies made by RunOp since the runner was created
+     */
+    const CopyStats &GetCopyStats() const
+    {
+        return copyStats_;
+    }
+
+    /**
+     * Elements of the device part of a co-executed run are a multiple of this: 8 cores x one 512 byte GM burst
+     */
+    static constexpr size_t CO_EXEC_ALIGN = 2048;
+
 private:
+    bool WaitCompletion(aclrtStream stream);
+
+    /**
+     * @brief Stage the inputs, launch on the given tensors, wait and copy the outputs back
+     * @param [in] inputs: tensors over devInputs_, the full ones or a head of them
+     * @param [in] outputs: tensors over devOutputs_
+     * @param [in] elements: leading elements of every tensor to stage, SIZE_MAX for all of them
+     */
+    bool RunOnDevice(const std::vector<aclTensor *> &inputs, const std::vector<aclTensor *> &outputs,
+        size_t elements);
+
+    bool RunCoExecution();
+
+    bool IsMishCustom() const;
+
+    /**
+     * @brief Call the aclnn workspace query of opDesc_->opType
+     * @param [in] inputs: input tensors of the launch
+     * @param [in] outputs: output tensors of the launch
+     * @param [out] workspaceSize: workspace the launch needs
+     * @param [out] handle: executor consumed by LaunchExecutor
+     */
+    aclnnStatus PrepareExecutor(const std::vector<aclTensor *> &inputs, const std::vector<aclTensor *> &outputs,
+        uint64_t &workspaceSize, aclOpExecutor *&handle);
+
+    /**
+     * @brief Launch the executor created by PrepareExecutor on stream
+     */
+    aclnnStatus LaunchExecutor(void *workspace, uint64_t workspaceSize, aclOpExecutor *handle, aclrtStream stream);
+
     size_t numInputs_;
     size_t numOutputs_;
 
@@ -177,6 +362,17 @@ private:
     std::vector<aclTensor *> inputTensor_;
     std::vector<aclTensor *> outputTensor_;
     OperatorDesc *opDesc_;
+
+    CompletionOptions completion_;
+    aclrtEvent event_ = nullptr;    // created on first spin/hybrid wait, reused afterwards
+    bool zeroCopy_ = false;
+    CopyStats copyStats_;
+    void *workspace_ = nullptr;     // grown on demand, reused by later RunOp calls
+    uint64_t workspaceSize_ = 0;
+    uint64_t lastWorkspaceSize_ = 0;
+    CoExecOptions coExec_;
+    CoExecStats coExecStats_;
+    std::unique_ptr<CpuMishPool> cpuPool_;  // started by the first co-executed run
 };
 
 #endif // OP_RUNNER_H
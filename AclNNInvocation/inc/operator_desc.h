@@ -52,6 +52,14 @@ struct OperatorDesc {
     std::string opType;
     std::vector<aclTensorDesc *> inputDesc;
     std::vector<aclTensorDesc *> outputDesc;
+
+    // attributes of MishDropoutCustom, only read when opType is "MishDropoutCustom"
+    float keepProb = 1.0f;
+    int64_t seed = 0;
+    int64_t offset = 0;
+
+    // attribute of MishCustom: pick the compute path per tile, off runs every tile on the full path
+    bool adaptive = false;
 };
 
 #endif // OPERATOR_DESC_H
@@ -0,0 +1,68 @@
+/**
+* @file runner_cache.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef RUNNER_CACHE_H
+#define RUNNER_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "op_runner.h"
+
+/**
+ * Initialized OpRunners keyed by dtype and shape, so repeated shapes skip buffer
+ * allocation and stay warm. With a capacity, creating a runner beyond it destroys the
+ * least recently used one, otherwise runners live until the cache is destroyed.
+ */
+class RunnerCache {
+public:
+    /**
+     * @param [in] capacity: most runners kept at once, 0 for no limit
+     */
+    explicit RunnerCache(size_t capacity = 0);
+    ~RunnerCache();
+
+    /**
+     * @brief Get the runner for a dtype and shape, creating it on first use
+     * @param [in] dataType: data type of input and output
+     * @param [in] dims: shape of input and output
+     * @param [in] format: format of input and output
+     * @return runner, nullptr if Init failed. With a capacity the runner may be evicted by
+     * the next Get, so do not keep it across calls
+     */
+    OpRunner *Get(aclDataType dataType, const std::vector<int64_t> &dims, aclFormat format = ACL_FORMAT_ND);
+
+    /**
+     * @brief Number of cached runners
+     */
+    size_t Size() const;
+
+    /**
+     * @brief Completion options given to runners created from now on
+     */
+    void SetCompletion(const CompletionOptions &completion)
+    {
+        completion_ = completion;
+    }
+
+private:
+    struct Entry;
+    void EvictLeastRecent();
+
+    std::map<std::string, std::unique_ptr<Entry>> entries_;
+    CompletionOptions completion_;
+    size_t capacity_;
+    uint64_t useClock_ = 0;
+};
+
+#endif // RUNNER_CACHE_H
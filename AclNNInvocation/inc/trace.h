@@ -0,0 +1,89 @@
+/**
+* @file trace.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+/**
+ * Host phase tracer. Disabled unless MISH_TRACE_FILE names an output file, in which
+ * case every recorded phase is written there as chrome trace-event json by TraceDump,
+ * ready to be opened in Perfetto or chrome://tracing.
+ */
+
+/**
+ * @brief Whether tracing was requested for this process
+ * @return true if MISH_TRACE_FILE is set
+ */
+bool TraceEnabled();
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ */
+uint64_t TraceNowNs();
+
+/**
+ * @brief Record a finished phase into the ring buffer of the calling thread
+ * @param [in] name: phase name, must be a string literal or otherwise outlive the process
+ * @param [in] beginNs: phase begin time from TraceNowNs
+ * @param [in] endNs: phase end time from TraceNowNs
+ */
+void TraceRecord(const char *name, uint64_t beginNs, uint64_t endNs);
+
+/**
+ * @brief Write all recorded phases to MISH_TRACE_FILE, called once at exit
+ * @return write result
+ */
+bool TraceDump();
+
+/**
+ * @brief Begin time of a phase, 0 without reading the clock when tracing is off
+ * @return TraceNowNs() or 0
+ */
+inline uint64_t TraceBeginNs()
+{
+    return TraceEnabled() ? TraceNowNs() : 0;
+}
+
+/**
+ * @brief Record the phase started at beginNs, does nothing when TraceBeginNs returned 0
+ * @param [in] name: phase name, same lifetime rule as TraceRecord
+ * @param [in] beginNs: value from TraceBeginNs
+ */
+inline void TraceEnd(const char *name, uint64_t beginNs)
+{
+    if (beginNs != 0) {
+        TraceRecord(name, beginNs, TraceNowNs());
+    }
+}
+
+/**
+ * Records the enclosing block as one phase
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : name_(name), begin_(TraceBeginNs()) {}
+    ~TraceScope()
+    {
+        TraceEnd(name_, begin_);
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    uint64_t begin_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,164 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+把 MishCustom 回放 kernel 的指令流转换成按 pipe（MTE2 / V / MTE3 / S）统计的忙闲时间线，
+并标出 CopyIn -> Compute -> CopyOut 之间的等待。
+
+回放 kernel 由 MishCustom 以 -DENABLE_OPS_REPLAY=True 构建得到，在仿真器上运行后导出的
+指令 trace 可以是 chrome trace-event json（每条指令一个 "X" 事件，tid/线程名为 pipe 名），
+也可以是 csv（列 pipe,start,end[,instr]，时间单位为 cycle）。
+    python3 scripts/analyze_pipe_trace.py <trace.json|trace.csv> [--core 0] [--json]
+"""
+import argparse
+import csv
+import json
+import sys
+
+PIPES = ['MTE2', 'V', 'MTE3', 'S']
+# 仿真器/工具里对同一 pipe 的不同叫法
+PIPE_ALIAS = {
+    'MTE2': 'MTE2', 'PIPE_MTE2': 'MTE2',
+    'V': 'V', 'VEC': 'V', 'VECTOR': 'V', 'PIPE_V': 'V',
+    'MTE3': 'MTE3', 'PIPE_MTE3': 'MTE3',
+    'S': 'S', 'SCALAR': 'S', 'PIPE_S': 'S',
+}
+# (等待方, 被等待方, 含义)：等待方空闲且紧接着被等待方的指令结束时记为一次阻塞。
+# 同一等待方有多个被等待方时，一段空闲只记给在它结束前最后结束的那个
+STALL_EDGES = [
+    ('V', 'MTE2', 'Compute waits CopyIn'),
+    ('MTE3', 'V', 'CopyOut waits Compute'),
+    ('MTE2', 'MTE3', 'CopyIn waits free buffer (CopyOut)'),
+    ('MTE2', 'V', 'CopyIn waits free buffer (Compute)'),
+]
+
+
+def pipe_of(name):
+    return PIPE_ALIAS.get(str(name).strip().upper())
+
+
+def load_json(path, core):
+    with open(path) as f:
+        data = json.load(f)
+    events = data['traceEvents'] if isinstance(data, dict) else data
+    names = {}
+    for e in events:
+        if e.get('ph') == 'M' and e.get('name') == 'thread_name':
+            names[(e.get('pid'), e.get('tid'))] = e.get('args', {}).get('name', '')
+    instrs = []
+    for e in events:
+        if e.get('ph') != 'X':
+            continue
+        if core is not None and str(e.get('pid')) != str(core):
+            continue
+        pipe = pipe_of(names.get((e.get('pid'), e.get('tid')), e.get('tid')))
+        if pipe is None:
+            continue
+        start = float(e['ts'])
+        instrs.append((pipe, start, start + float(e.get('dur', 0)), e.get('name', '')))
+    return instrs
+
+
+def load_csv(path):
+    instrs = []
+    with open(path, newline='') as f:
+        for row in csv.DictReader(f):
+            pipe = pipe_of(row.get('pipe', ''))
+            if pipe is None:
+                continue
+            instrs.append((pipe, float(row['start']), float(row['end']), row.get('instr', '')))
+    return instrs
+
+
+def merge(intervals):
+    merged = []
+    for start, end in sorted(intervals):
+        if merged and start <= merged[-1][1]:
+            merged[-1][1] = max(merged[-1][1], end)
+        else:
+            merged.append([start, end])
+    return merged
+
+
+def analyze(instrs, min_stall, slack):
+    begin = min(i[1] for i in instrs)
+    end = max(i[2] for i in instrs)
+    span = max(end - begin, 1e-9)
+    busy = {p: merge([(s, e) for q, s, e, _ in instrs if q == p]) for p in PIPES}
+    report = {'span': span, 'pipes': {}, 'stalls': []}
+    for pipe in PIPES:
+        total = sum(e - s for s, e in busy[pipe])
+        report['pipes'][pipe] = {'busy': total, 'idle': span - total, 'util': total / span,
+                                 'instr': sum(1 for i in instrs if i[0] == pipe)}
+    for waiter in PIPES:
+        edges = [(producer, desc) for w, producer, desc in STALL_EDGES if w == waiter]
+        if not edges:
+            continue
+        # 第一段指令之前是流水线填充，不算阻塞
+        for (_, prev_end), (start, _) in zip(busy[waiter], busy[waiter][1:]):
+            gap = start - prev_end
+            if gap < min_stall:
+                continue
+            # 空闲结束前 slack 内、空闲开始之后结束的被等待方指令中取最后结束的一个
+            latest = None
+            for producer, desc in edges:
+                for _, e in busy[producer]:
+                    if max(prev_end, start - slack) <= e <= start and (latest is None or e > latest[0]):
+                        latest = (e, desc)
+            if latest is not None:
+                report['stalls'].append({'type': latest[1], 'start': prev_end - begin, 'cycles': gap})
+    report['stalls'].sort(key=lambda stall: stall['start'])
+    return report, busy, begin
+
+
+def timeline(busy, begin, span, width):
+    lines = []
+    for pipe in PIPES:
+        cells = [0.0] * width
+        for start, end in busy[pipe]:
+            for idx in range(int((start - begin) / span * width), min(width, int((end - begin) / span * width) + 1)):
+                lo = begin + idx * span / width
+                hi = lo + span / width
+                cells[idx] += max(0.0, min(end, hi) - max(start, lo)) / (span / width)
+        lines.append('{:<5}|{}|'.format(pipe, ''.join('#' if c > 0.66 else '+' if c > 0.33 else
+                                                       '.' if c > 0 else ' ' for c in cells)))
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='per pipe busy/idle analysis of a replay instruction trace')
+    parser.add_argument('trace', help='chrome trace json 或 csv(pipe,start,end[,instr])')
+    parser.add_argument('--core', default=None, help='只分析该 core（json 中的 pid）')
+    parser.add_argument('--min-stall', type=float, default=1.0, help='小于该时长的空闲不算阻塞')
+    parser.add_argument('--slack', type=float, default=16.0, help='flag 同步延迟容忍，被等待方结束后这段时间内开始的指令视为被其阻塞')
+    parser.add_argument('--width', type=int, default=100, help='时间线宽度')
+    parser.add_argument('--json', action='store_true', help='输出 json')
+    args = parser.parse_args()
+
+    instrs = load_csv(args.trace) if args.trace.endswith('.csv') else load_json(args.trace, args.core)
+    if not instrs:
+        print('[ERROR] no MTE2/V/MTE3/S instruction found in {}'.format(args.trace))
+        return 1
+    report, busy, begin = analyze(instrs, args.min_stall, args.slack)
+    if args.json:
+        print(json.dumps(report, indent=2))
+        return 0
+
+    print('span: {:.0f}'.format(report['span']))
+    for line in timeline(busy, begin, report['span'], args.width):
+        print(line)
+    print('{:<6}{:>8}{:>14}{:>14}{:>8}'.format('pipe', 'instr', 'busy', 'idle', 'util'))
+    for pipe, p in report['pipes'].items():
+        print('{:<6}{:>8}{:>14.0f}{:>14.0f}{:>7.1f}%'.format(pipe, p['instr'], p['busy'], p['idle'], p['util'] * 100))
+    stall_sum = {}
+    for stall in report['stalls']:
+        stall_sum.setdefault(stall['type'], [0, 0.0])
+        stall_sum[stall['type']][0] += 1
+        stall_sum[stall['type']][1] += stall['cycles']
+    for desc, (count, cycles) in sorted(stall_sum.items(), key=lambda x: -x[1][1]):
+        print('[STALL] {:<38} count {:>5}  total {:>10.0f}'.format(desc, count, cycles))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,16 +1,110 @@
 #!/usr/bin/python3
 # -*- coding:utf-8 -*-
 # Copyright 2022-2023 Huawei Technologies Co., Ltd
+import os
+
 import numpy as np
 
+from tensor_file import write_tensor
+
+ROOT = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+
+# MishDropoutCustom 的参数，与 execute_mish_op --keep-prob 0.9 --seed 2024 --offset 0 一致
+KEEP_PROB = 0.9
+SEED = 2024
+OFFSET = 0
+
+# MatmulMishCustom 的形状，M/N/K 都是 16 的整数倍
+MATMUL_M = 256
+MATMUL_K = 512
+MATMUL_N = 256
+
+PHILOX_M = (0xD2511F53, 0xCD9E8D57)
+PHILOX_W = (0x9E3779B9, 0xBB67AE85)
+MASK32 = 0xFFFFFFFF
+
+
+def philox4x32(counter, seed, rounds=10):
+    """Philox4x32-10 主机参考实现，counter 为 [n, 4] 的 uint64 数组（每个值不超过 32 位），返回 [n, 4] 的随机数"""
+    c = [counter[:, i].astype(np.uint64) for i in range(4)]
+    k0, k1 = seed & MASK32, (seed >> 32) & MASK32
+    for _ in range(rounds):
+        p0 = c[0] * np.uint64(PHILOX_M[0])
+        p1 = c[2] * np.uint64(PHILOX_M[1])
+        c = [(p1 >> np.uint64(32)) ^ c[1] ^ np.uint64(k0), p1 & np.uint64(MASK32),
+             (p0 >> np.uint64(32)) ^ c[3] ^ np.uint64(k1), p0 & np.uint64(MASK32)]
+        k0 = (k0 + PHILOX_W[0]) & MASK32
+        k1 = (k1 + PHILOX_W[1]) & MASK32
+    return np.stack(c, axis=1)
+
+
+def dropout_mask(count, keep_prob, seed, offset):
+    """与核内 GenMask 相同的规则：元素 i 取计数器 (i/4, 0, offset) 的第 i%4 个随机数，高 24 位小于阈值时保留"""
+    counter = np.zeros([(count + 3) // 4, 4], dtype=np.uint64)
+    counter[:, 0] = np.arange(counter.shape[0], dtype=np.uint64)
+    counter[:, 2] = offset & MASK32
+    counter[:, 3] = (offset >> 32) & MASK32
+    rand = philox4x32(counter, seed & 0xFFFFFFFFFFFFFFFF).reshape(-1)[:count]
+    threshold = int(keep_prob * (1 << 24) + 0.5)
+    return (rand >> np.uint64(8)) < np.uint64(threshold)
+
+
 def gen_golden_data_simple():
     input_x = np.random.uniform(1, 10, [8, 2048]).astype(np.float16)
-    # 生成Mish测试数据
-    golden = input_x*np.tanh(np.log(1+np.exp(input_x)))
+    # 每行开头放一段 x >= 12 的值：fp16 的 exp(x) 在这里已经溢出，核内必须先截断再 Exp，否则得到 NaN
+    input_x[:, :64] = np.random.uniform(12, 100, [8, 64]).astype(np.float16)
+    # 前两行的后半段（GatedMish 的 b）也都 >= 12，前半段其余的 a 取小值：a 很小时 a * Mish(b) 也不能因 exp(b) 溢出成 NaN
+    half = input_x.shape[-1] // 2
+    input_x[:2, half:] = np.random.uniform(12, 100, [2, half]).astype(np.float16)
+    input_x[:2, 64:half] = np.random.uniform(-1, 1, [2, half - 64]).astype(np.float16)
+    # 生成Mish测试数据，在 float32 下计算；x >= 20 时 tanh(softplus(x)) 已是 1，截断只为避免 exp 溢出
+    x32 = input_x.astype(np.float32)
+    residual = np.tanh(np.log1p(np.exp(np.minimum(x32, 20))))
+    golden = (x32 * residual).astype(np.float16)
 
     # print(golden)
-    input_x.tofile("./AclNNInvocation/input/input_x.bin")
-    golden.tofile("./AclNNInvocation/output/golden.bin")
+    # shape 和 dtype 写在文件头里，执行程序和校验脚本都从文件头读取
+    write_tensor(os.path.join(ROOT, "input", "input_x.bin"), input_x)
+    write_tensor(os.path.join(ROOT, "output", "golden.bin"), golden)
+    # execute_mish_op --residual 输出的 t = tanh(softplus(x))，反向用
+    write_tensor(os.path.join(ROOT, "output", "golden_t.bin"), residual.astype(np.float16))
+
+    # MishDropoutCustom：y = Mish(x) * mask / keep_prob，掩码按位打包，第 i 个元素是第 i/8 个字节的第 i%8 位
+    keep = dropout_mask(input_x.size, KEEP_PROB, SEED, OFFSET)
+    # Mish 在 float32 下计算后转 fp16，再与核内一样用 fp16 乘 1/keep_prob
+    mish = (x32 * residual).astype(np.float16)
+    scale = np.float16(1.0 / KEEP_PROB)
+    golden_dropout = np.where(keep.reshape(input_x.shape), mish * scale, np.float16(0))
+    write_tensor(os.path.join(ROOT, "output", "golden_dropout.bin"), golden_dropout.astype(np.float16))
+    write_tensor(os.path.join(ROOT, "output", "golden_mask.bin"), np.packbits(keep, bitorder='little'))
+
+    # GatedMishCustom：最后一维平分为 a、b 两半，y = a * Mish(b)，对应 execute_mish_op --gated
+    gate_a = input_x[..., :half].astype(np.float32)
+    gate_b = input_x[..., half:].astype(np.float32)
+    golden_gated = gate_a * gate_b * np.tanh(np.log1p(np.exp(np.minimum(gate_b, 20))))
+    write_tensor(os.path.join(ROOT, "output", "golden_gated.bin"), golden_gated.astype(np.float16))
+
+    # MatmulMishCustom：y = Mish(a @ b + bias)，fp16 输入、fp32 累加和偏置，对应 execute_mish_op --matmul
+    input_a = np.random.uniform(-1, 1, [MATMUL_M, MATMUL_K]).astype(np.float16)
+    input_b = np.random.uniform(-1, 1, [MATMUL_K, MATMUL_N]).astype(np.float16)
+    input_bias = np.random.uniform(-1, 1, [MATMUL_N]).astype(np.float32)
+    acc = input_a.astype(np.float32) @ input_b.astype(np.float32) + input_bias
+    golden_matmul = acc * np.tanh(np.log1p(np.exp(acc)))
+    write_tensor(os.path.join(ROOT, "input", "input_a.bin"), input_a)
+    write_tensor(os.path.join(ROOT, "input", "input_b.bin"), input_b)
+    write_tensor(os.path.join(ROOT, "input", "input_bias.bin"), input_bias)
+    write_tensor(os.path.join(ROOT, "output", "golden_matmul.bin"), golden_matmul.astype(np.float16))
+
+    # 算子链 MatmulMish -> Mish -> Mish -> GatedMish，每一步的结果都按 fp16 落到 device，对应 execute_mish_op --chain
+    hidden = golden_matmul.astype(np.float16)
+    for _ in range(2):
+        h = hidden.astype(np.float32)
+        hidden = (h * np.tanh(np.log1p(np.exp(h)))).astype(np.float16)
+    half = hidden.shape[-1] // 2
+    gate_a = hidden[..., :half].astype(np.float32)
+    gate_b = hidden[..., half:].astype(np.float32)
+    golden_chain = gate_a * gate_b * np.tanh(np.log1p(np.exp(gate_b)))
+    write_tensor(os.path.join(ROOT, "output", "golden_chain.bin"), golden_chain.astype(np.float16))
 
 if __name__ == "__main__":
     gen_golden_data_simple()
@@ -0,0 +1,198 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+离线解析 msprof 导出的 op_summary / task_time csv，统计 MishCustom 的性能数据。
+
+采集方式：在 scripts/acl.json 中打开 profiling，例如
+    {"profiler": {"switch": "on", "output": "./prof", "aic_metrics": "PipeUtilization"}}
+运行后用 msprof --export=on --output=<prof目录> 导出 csv，再执行
+    python3 scripts/parse_msprof.py summary <prof目录>
+    python3 scripts/parse_msprof.py diff <基线prof目录> <新prof目录>
+只依赖标准库，不需要 NPU 环境。
+"""
+import argparse
+import csv
+import glob
+import json
+import os
+import re
+import sys
+
+# 不同芯片/版本导出的列名不同，按顺序取第一个存在的列
+COLUMNS = {
+    'op_type': ['OP Type', 'Op Type', 'kernel_type'],
+    'op_name': ['Op Name', 'kernel_name'],
+    'task_type': ['Task Type'],
+    'shape': ['Input Shapes'],
+    'dtype': ['Input Data Types'],
+    'block_dim': ['Block Dim'],
+    'duration': ['Task Duration(us)', 'task_time(us)'],
+    'aicore_time': ['aicore_time(us)', 'aiv_time(us)'],
+    'vec_ratio': ['vec_ratio', 'aiv_vec_ratio'],
+    'mte2_ratio': ['mte2_ratio', 'aiv_mte2_ratio'],
+    'mte3_ratio': ['mte3_ratio', 'aiv_mte3_ratio'],
+    'scalar_ratio': ['scalar_ratio', 'aiv_scalar_ratio'],
+}
+METRICS = ['duration', 'aicore_time', 'vec_ratio', 'mte2_ratio', 'mte3_ratio', 'scalar_ratio']
+
+
+def find_csv(path, prefix):
+    if os.path.isfile(path):
+        return [path] if os.path.basename(path).startswith(prefix) else []
+    return sorted(glob.glob(os.path.join(path, '**', prefix + '*.csv'), recursive=True))
+
+
+def get_field(row, key):
+    for name in COLUMNS[key]:
+        value = row.get(name)
+        if value is not None and value.strip() not in ('', 'N/A'):
+            return value.strip().strip('"')
+    return None
+
+
+def to_float(value):
+    try:
+        return float(value)
+    except (TypeError, ValueError):
+        return None
+
+
+def task_matcher(op_type):
+    """
+    op_summary 有算子类型列时按类型精确比较；task_time 的 kernel_type 只是 KERNEL_AIVEC 之类，
+    按名字匹配：算子名 MishCustom 或 MishCustom_3，kernel 名 mish_custom_<hash>[_mix_aiv]。
+    只比较前缀会把 GatedMishCustom、MishDropoutCustom 之类也算进来
+    """
+    snake = ''.join('_' + c.lower() if c.isupper() else c for c in op_type).lstrip('_')
+    op_name = re.compile(r'^{}(_\d+)?$'.format(re.escape(op_type)))
+    kernel_name = re.compile(r'^{}_[0-9a-f]+(_mix_aiv|_mix_aic)?$'.format(re.escape(snake)))
+
+    def match(row):
+        row_type = get_field(row, 'op_type') or ''
+        if row_type and not row_type.startswith('KERNEL_'):
+            return row_type == op_type
+        row_name = get_field(row, 'op_name') or ''
+        return bool(op_name.match(row_name) or kernel_name.match(row_name))
+    return match
+
+
+def load_tasks(path, op_type):
+    """读取 op_summary，没有时退回 task_time，只保留目标算子的任务"""
+    files = find_csv(path, 'op_summary')
+    if not files:
+        files = find_csv(path, 'task_time')
+    if not files:
+        raise FileNotFoundError('no op_summary*.csv or task_time*.csv under {}'.format(path))
+    match = task_matcher(op_type)
+    tasks = []
+    for name in files:
+        with open(name, newline='') as f:
+            for row in csv.DictReader(f):
+                if not match(row):
+                    continue
+                task = {key: to_float(get_field(row, key)) for key in METRICS}
+                task['shape'] = get_field(row, 'shape') or 'unknown'
+                task['dtype'] = get_field(row, 'dtype') or ''
+                task['block_dim'] = int(to_float(get_field(row, 'block_dim')) or 0)
+                tasks.append(task)
+    return tasks
+
+
+def percentile(values, q):
+    values = sorted(values)
+    idx = min(len(values) - 1, max(0, int(round(q * (len(values) - 1)))))
+    return values[idx]
+
+
+def summarize(tasks, core_num):
+    groups = {}
+    for task in tasks:
+        groups.setdefault((task['shape'], task['dtype']), []).append(task)
+    summary = {}
+    for (shape, dtype), items in sorted(groups.items()):
+        entry = {'count': len(items)}
+        for key in METRICS:
+            values = [t[key] for t in items if t[key] is not None]
+            if values:
+                entry[key] = sum(values) / len(values)
+        durations = [t['duration'] for t in items if t['duration'] is not None]
+        if durations:
+            entry['duration_p50'] = percentile(durations, 0.5)
+            entry['duration_p99'] = percentile(durations, 0.99)
+        block_dim = max(t['block_dim'] for t in items)
+        entry['block_dim'] = block_dim
+        if core_num:
+            # 分核数不是核数整数倍时，最后一轮只有部分核在工作
+            waves = -(-block_dim // core_num) if block_dim else 0
+            entry['block_util'] = block_dim / (waves * core_num) if waves else 0.0
+        summary['{} {}'.format(shape, dtype).strip()] = entry
+    return summary
+
+
+def fmt(value, ratio=False):
+    if value is None:
+        return '-'
+    return '{:.1f}%'.format(value * 100) if ratio else '{:.2f}'.format(value)
+
+
+def print_summary(summary):
+    header = ['shape', 'count', 'task(us)', 'p99(us)', 'aicore(us)', 'vec', 'mte2', 'mte3', 'block_dim', 'util']
+    print(('{:<28}' + '{:>11}' * (len(header) - 1)).format(*header))
+    for key, e in summary.items():
+        print(('{:<28}' + '{:>11}' * (len(header) - 1)).format(
+            key, e['count'], fmt(e.get('duration')), fmt(e.get('duration_p99')), fmt(e.get('aicore_time')),
+            fmt(e.get('vec_ratio'), True), fmt(e.get('mte2_ratio'), True), fmt(e.get('mte3_ratio'), True),
+            e['block_dim'], fmt(e.get('block_util'), True)))
+
+
+def print_diff(base, new):
+    header = ['shape', 'task base', 'task new', 'delta', 'aicore base', 'aicore new', 'delta']
+    print(('{:<28}' + '{:>12}' * (len(header) - 1)).format(*header))
+    for key in sorted(set(base) | set(new)):
+        b, n = base.get(key, {}), new.get(key, {})
+        row = [key]
+        for metric in ('duration', 'aicore_time'):
+            bv, nv = b.get(metric), n.get(metric)
+            delta = '{:+.1f}%'.format((nv - bv) / bv * 100) if bv and nv is not None else '-'
+            row += [fmt(bv), fmt(nv), delta]
+        print(('{:<28}' + '{:>12}' * (len(header) - 1)).format(*row))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='MishCustom msprof summary')
+    parser.add_argument('--op-type', default='MishCustom', help='算子类型，默认 MishCustom')
+    parser.add_argument('--core-num', type=int, default=0, help='AI Core 数，给出时计算分核利用率')
+    parser.add_argument('--json', action='store_true', help='输出 json 便于版本间比较')
+    sub = parser.add_subparsers(dest='cmd')
+    summary_cmd = sub.add_parser('summary')
+    summary_cmd.add_argument('prof')
+    diff_cmd = sub.add_parser('diff')
+    diff_cmd.add_argument('base')
+    diff_cmd.add_argument('new')
+    args = parser.parse_args()
+
+    if args.cmd == 'summary':
+        summary = summarize(load_tasks(args.prof, args.op_type), args.core_num)
+        if not summary:
+            print('[ERROR] no {} task found in {}'.format(args.op_type, args.prof))
+            return 1
+        if args.json:
+            print(json.dumps(summary, indent=2))
+        else:
+            print_summary(summary)
+    elif args.cmd == 'diff':
+        base = summarize(load_tasks(args.base, args.op_type), args.core_num)
+        new = summarize(load_tasks(args.new, args.op_type), args.core_num)
+        if args.json:
+            print(json.dumps({'base': base, 'new': new}, indent=2))
+        else:
+            print_diff(base, new)
+    else:
+        parser.print_help()
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
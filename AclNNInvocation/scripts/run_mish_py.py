@@ -0,0 +1,46 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+不落盘地跑一遍 MishCustom：numpy 数据直接写进 mish_acl.Runner 的 pinned 输入内存，
+结果以 numpy 视图返回后与真值比较，省掉 gen_data -> execute_mish_op -> verify_result 的文件往返。
+mish_acl 由 src/CMakeLists.txt 在找到 pybind11 时构建到 output 目录：
+    python3 scripts/run_mish_py.py [--shape 8,2048] [--loops 10]
+"""
+import argparse
+import os
+import sys
+
+import numpy as np
+
+from verify_result import compare
+
+ROOT = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+sys.path.insert(0, os.path.join(ROOT, "output"))
+import mish_acl  # noqa: E402
+
+
+def main():
+    parser = argparse.ArgumentParser(description='run MishCustom through the python binding')
+    parser.add_argument('--shape', default='8,2048', help='输入 shape，逗号分隔')
+    parser.add_argument('--loops', type=int, default=1, help='运行次数，每次生成新的输入')
+    parser.add_argument('--device', type=int, default=0)
+    args = parser.parse_args()
+    shape = [int(d) for d in args.shape.split(',')]
+
+    mish_acl.init(args.device, os.path.join(ROOT, "scripts", "acl.json"))
+    runner = mish_acl.Runner(shape, np.float16)
+    for _ in range(args.loops):
+        # 直接在 pinned 输入内存上生成数据，run() 不再拷贝
+        runner.input[...] = np.random.uniform(1, 10, shape).astype(np.float16)
+        output = runner.run()
+        x = runner.input
+        golden = x * np.tanh(np.log(1 + np.exp(x)))
+        # output 是输出 buffer 的只读视图，下次 run 会被覆盖，需要保留时用 np.from_dlpack / copy
+        if not compare(output, golden):
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,132 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+自描述张量文件的读写，格式与 inc/common.h 中的 TensorFileHeader 一致：
+头部(magic, dtype, shape, strides, 校验和) + 可选分块索引，数据区按 4KiB 对齐，
+可以直接 np.memmap 或 O_DIRECT 读取。
+"""
+import os
+import struct
+import zlib
+
+import numpy as np
+
+MAGIC = b'MISHTNSR'
+VERSION = 1
+ALIGN = 4096
+MAX_DIMS = 8
+HEADER_FMT = '<8sIIiiII8q8qQQQII'
+CHUNK_FMT = '<QQII'
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+CHUNK_SIZE = struct.calcsize(CHUNK_FMT)
+FORMAT_ND = 2
+
+# numpy dtype 与 aclDataType 的对应关系
+ACL_DTYPE = {
+    np.dtype(np.float32): 0, np.dtype(np.float16): 1, np.dtype(np.int8): 2, np.dtype(np.int32): 3,
+    np.dtype(np.uint8): 4, np.dtype(np.int16): 6, np.dtype(np.uint16): 7, np.dtype(np.uint32): 8,
+    np.dtype(np.int64): 9, np.dtype(np.uint64): 10, np.dtype(np.float64): 11, np.dtype(np.bool_): 12,
+}
+NP_DTYPE = {v: k for k, v in ACL_DTYPE.items()}
+
+
+def _pack_header(fields, chunks, header_crc):
+    head = struct.pack(HEADER_FMT, *(fields + [header_crc]))
+    return head + b''.join(struct.pack(CHUNK_FMT, *c) for c in chunks)
+
+
+def write_tensor(path, array, chunk_size=0):
+    """chunk_size 为 0 时不写分块索引，否则必须是 4096 的整数倍"""
+    array = np.ascontiguousarray(array)
+    if array.ndim > MAX_DIMS or chunk_size % ALIGN != 0:
+        raise ValueError('at most {} dims and chunk size aligned to {} are supported'.format(MAX_DIMS, ALIGN))
+    payload = array.tobytes()
+    chunks = []
+    if chunk_size:
+        for offset in range(0, len(payload), chunk_size):
+            piece = payload[offset:offset + chunk_size]
+            chunks.append((offset, len(piece), zlib.crc32(piece), 0))
+    dims = list(array.shape) + [0] * (MAX_DIMS - array.ndim)
+    strides = [s // array.itemsize for s in array.strides] + [0] * (MAX_DIMS - array.ndim)
+    index_end = HEADER_SIZE + len(chunks) * CHUNK_SIZE
+    data_offset = (index_end + ALIGN - 1) // ALIGN * ALIGN
+    fields = [MAGIC, VERSION, HEADER_SIZE, ACL_DTYPE[array.dtype], FORMAT_ND, array.ndim, len(chunks)] + \
+        dims + strides + [data_offset, len(payload), HEADER_SIZE if chunks else 0, zlib.crc32(payload)]
+    header_crc = zlib.crc32(_pack_header(fields, chunks, 0))
+    head = _pack_header(fields, chunks, header_crc)
+    with open(path, 'wb') as f:
+        f.write(head)
+        f.write(b'\0' * (data_offset - len(head)))
+        f.write(payload)
+
+
+def read_header(path):
+    with open(path, 'rb') as f:
+        raw = f.read(HEADER_SIZE)
+        if len(raw) != HEADER_SIZE:
+            raise ValueError('{} is too small to be a tensor file'.format(path))
+        values = list(struct.unpack(HEADER_FMT, raw))
+        magic, version, header_size, dtype, fmt, ndim, nchunks = values[:7]
+        if magic != MAGIC or version != VERSION or header_size != HEADER_SIZE:
+            raise ValueError('{} is not a version {} tensor file'.format(path, VERSION))
+        dims = values[7:7 + MAX_DIMS][:ndim]
+        strides = values[7 + MAX_DIMS:7 + 2 * MAX_DIMS][:ndim]
+        data_offset, data_size, index_offset, data_crc, header_crc = values[7 + 2 * MAX_DIMS:]
+        file_size = os.fstat(f.fileno()).st_size
+        # 先按文件大小检查索引和数据区的位置，再按头部里的数量读索引
+        if nchunks and (index_offset > file_size or nchunks > (file_size - index_offset) // CHUNK_SIZE):
+            raise ValueError('{} chunk index is out of the file'.format(path))
+        if data_offset > file_size or data_size > file_size - data_offset:
+            raise ValueError('{} is truncated'.format(path))
+        chunks = []
+        if nchunks:
+            f.seek(index_offset)
+            raw_index = f.read(nchunks * CHUNK_SIZE)
+            chunks = [struct.unpack_from(CHUNK_FMT, raw_index, i * CHUNK_SIZE) for i in range(nchunks)]
+    if zlib.crc32(_pack_header(values[:-1], chunks, 0)) != header_crc:
+        raise ValueError('{} header checksum mismatch'.format(path))
+    # 分块按 4KiB 对齐、依次排列，恰好覆盖整个数据区
+    end = 0
+    for i, (offset, size, _, _) in enumerate(chunks):
+        if offset % ALIGN or offset != end or size == 0 or size > data_size - end:
+            raise ValueError('{} chunk {} does not continue the payload at {}'.format(path, i, end))
+        end += size
+    if chunks and end != data_size:
+        raise ValueError('{} chunks cover {} of {} payload bytes'.format(path, end, data_size))
+    return {'dtype': NP_DTYPE[dtype], 'acl_dtype': dtype, 'format': fmt, 'shape': tuple(dims),
+            'strides': tuple(strides), 'data_offset': data_offset, 'data_size': data_size,
+            'checksum': data_crc, 'chunks': chunks}
+
+
+def is_contiguous(shape, strides):
+    """与 common.cpp 的 IsContiguous 一致：行优先且没有空隙，长度为 1 的维度步长任意"""
+    expected = 1
+    for dim, stride in reversed(list(zip(shape, strides))):
+        if dim != 1 and stride != expected:
+            return False
+        expected *= dim
+    return True
+
+
+def read_tensor(path, mmap=False, verify=True):
+    """mmap=True 时返回只读 np.memmap，不拷贝数据；verify 时校验整体和每个分块的 crc"""
+    header = read_header(path)
+    if not is_contiguous(header['shape'], header['strides']):
+        raise ValueError('{} has non contiguous strides {}'.format(path, header['strides']))
+    count = int(np.prod(header['shape'])) if header['shape'] else 1
+    if count * header['dtype'].itemsize != header['data_size']:
+        raise ValueError('{} payload is {} bytes, shape {} needs {}'.format(
+            path, header['data_size'], header['shape'], count * header['dtype'].itemsize))
+    if mmap:
+        data = np.memmap(path, dtype=header['dtype'], mode='r', offset=header['data_offset'], shape=(count,))
+    else:
+        data = np.fromfile(path, dtype=header['dtype'], count=count, offset=header['data_offset'])
+    if verify:
+        raw = memoryview(data).cast('B')
+        for i, (offset, size, crc, _) in enumerate(header['chunks']):
+            if zlib.crc32(raw[offset:offset + size]) != crc:
+                raise ValueError('{} chunk {} checksum mismatch'.format(path, i))
+        if zlib.crc32(raw) != header['checksum']:
+            raise ValueError('{} payload checksum mismatch'.format(path))
+    return data.reshape(header['shape'])
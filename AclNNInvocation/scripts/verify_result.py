@@ -2,12 +2,23 @@ import os
 import sys
 import numpy as np
 
+from tensor_file import read_tensor
+
 loss = 1e-3 # 容忍偏差，一般fp16要求绝对误差和相对误差均不超过千分之一
 minimum = 10e-10
 
 def verify_result(real_result, golden):
-    real_result = np.fromfile(real_result, dtype=np.float16) # 从bin文件读取实际运算结果
-    golden = np.fromfile(golden, dtype=np.float16) # 从bin文件读取预期运算结果
+    real_result = read_tensor(real_result) # 从bin文件读取实际运算结果，dtype和shape来自文件头
+    golden = read_tensor(golden) # 从bin文件读取预期运算结果
+    return compare(real_result, golden)
+
+def compare(real_result, golden):
+    if real_result.shape != golden.shape or real_result.dtype != golden.dtype:
+        print("[ERROR] result shape or dtype mismatch")
+        return False
+    # 误差在 float64 下计算：fp16 下 minimum 会变成 0，全零元素（如 dropout 丢弃的位置）会算出 0/0；uint8 掩码相减也会回绕
+    real_result = real_result.reshape(-1).astype(np.float64)
+    golden = golden.reshape(-1).astype(np.float64)
     result = np.abs(real_result - golden) # 计算运算结果和预期结果偏差
     deno = np.maximum(np.abs(real_result), np.abs(golden))  # 获取最大值并组成新数组
     result_atol = np.less_equal(result, loss) # 计算绝对误差
@@ -0,0 +1,311 @@
+/**
+* @file async_io.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "async_io.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "common.h"
+
+namespace {
+uint64_t NowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+int OpenForIo(const std::string &path, bool write)
+{
+    int fd = write ? open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWRITE) :
+        open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        ERROR_LOG("Open file failed. path = %s", path.c_str());
+    }
+    return fd;
+}
+
+/**
+ * Synchronous transfer of the remaining bytes, used by the pool
+ */
+bool TransferAll(int fd, char *buffer, size_t size, size_t done, bool write)
+{
+    while (done < size) {
+        ssize_t ret = write ? pwrite(fd, buffer + done, size - done, static_cast<off_t>(done)) :
+            pread(fd, buffer + done, size - done, static_cast<off_t>(done));
+        if (ret <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+struct IoRequest {
+    uint64_t tag;
+    std::string path;
+    char *buffer;
+    size_t size;
+    bool write;
+    uint64_t submitNs;
+};
+
+class ThreadPoolFileIO : public AsyncFileIO {
+public:
+    explicit ThreadPoolFileIO(unsigned threads)
+    {
+        for (unsigned i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]() { Work(); });
+        }
+    }
+
+    ~ThreadPoolFileIO() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        pendingCv_.notify_all();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    bool SubmitRead(uint64_t tag, const std::string &path, void *buffer, size_t size) override
+    {
+        return Submit({ tag, path, static_cast<char *>(buffer), size, false, NowNs() });
+    }
+
+    bool SubmitWrite(uint64_t tag, const std::string &path, const void *buffer, size_t size) override
+    {
+        return Submit({ tag, path, static_cast<char *>(const_cast<void *>(buffer)), size, true, NowNs() });
+    }
+
+    bool WaitCompletion(IoCompletion &done) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (inFlight_ == 0) {
+            return false;
+        }
+        doneCv_.wait(lock, [this]() { return !completed_.empty(); });
+        done = completed_.front();
+        completed_.pop_front();
+        --inFlight_;
+        return true;
+    }
+
+    const char *Name() const override
+    {
+        return "thread pool";
+    }
+
+private:
+    bool Submit(const IoRequest &request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(request);
+            ++inFlight_;
+        }
+        pendingCv_.notify_one();
+        return true;
+    }
+
+    void Work()
+    {
+        for (;;) {
+            IoRequest request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                pendingCv_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+                if (pending_.empty()) {
+                    return;
+                }
+                request = pending_.front();
+                pending_.pop_front();
+            }
+            int fd = OpenForIo(request.path, request.write);
+            bool ok = fd >= 0 && TransferAll(fd, request.buffer, request.size, 0, request.write);
+            if (fd >= 0) {
+                (void)close(fd);
+            }
+            IoCompletion done = { request.tag, ok, ok ? request.size : 0, NowNs() - request.submitNs };
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                completed_.push_back(done);
+            }
+            doneCv_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable pendingCv_;
+    std::condition_variable doneCv_;
+    std::deque<IoRequest> pending_;
+    std::deque<IoCompletion> completed_;
+    size_t inFlight_ = 0;
+    bool stop_ = false;
+};
+
+#ifdef HAVE_LIBURING
+// one sqe moves at most this many bytes: its length is 32 bits and read/write stop near 2 GiB anyway
+const size_t URING_MAX_TRANSFER = 1UL << 30;
+
+class UringFileIO : public AsyncFileIO {
+public:
+    ~UringFileIO() override
+    {
+        if (ready_) {
+            io_uring_queue_exit(&ring_);
+        }
+    }
+
+    bool Init(unsigned depth)
+    {
+        int ret = io_uring_queue_init(std::max(depth, 1U), &ring_, 0);
+        if (ret < 0) {
+            WARN_LOG("io_uring is not available (%d), fall back to thread pool", ret);
+            return false;
+        }
+        ready_ = true;
+        return true;
+    }
+
+    bool SubmitRead(uint64_t tag, const std::string &path, void *buffer, size_t size) override
+    {
+        return Submit(tag, path, static_cast<char *>(buffer), size, false);
+    }
+
+    bool SubmitWrite(uint64_t tag, const std::string &path, const void *buffer, size_t size) override
+    {
+        return Submit(tag, path, static_cast<char *>(const_cast<void *>(buffer)), size, true);
+    }
+
+    bool WaitCompletion(IoCompletion &done) override
+    {
+        if (inFlight_ == 0) {
+            return false;
+        }
+        for (;;) {
+            struct io_uring_cqe *cqe = nullptr;
+            int ret = io_uring_wait_cqe(&ring_, &cqe);
+            if (ret < 0) {
+                ERROR_LOG("io_uring wait failed. error code is %d", ret);
+                return false;
+            }
+            std::unique_ptr<Request> request(static_cast<Request *>(io_uring_cqe_get_data(cqe)));
+            int res = cqe->res;
+            io_uring_cqe_seen(&ring_, cqe);
+
+            // a short transfer, or a file above URING_MAX_TRANSFER, continues with the remaining bytes
+            bool ok = res >= 0 && (res > 0 || request->done == request->size);
+            if (ok && request->done + static_cast<size_t>(res) < request->size) {
+                request->done += static_cast<size_t>(res);
+                if (PrepTransfer(request.get()) && Flush()) {
+                    (void)request.release();
+                    continue;
+                }
+                ok = false;
+            }
+            (void)close(request->fd);
+            --inFlight_;
+            done = { request->tag, ok, ok ? request->size : 0, NowNs() - request->submitNs };
+            return true;
+        }
+    }
+
+    const char *Name() const override
+    {
+        return "io_uring";
+    }
+
+private:
+    struct Request {
+        uint64_t tag;
+        int fd;
+        char *buffer;
+        size_t size;
+        size_t done;
+        bool write;
+        uint64_t submitNs;
+    };
+
+    bool PrepTransfer(Request *request)
+    {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+        if (sqe == nullptr) {
+            ERROR_LOG("io_uring submission queue is full");
+            return false;
+        }
+        unsigned length = static_cast<unsigned>(std::min(request->size - request->done, URING_MAX_TRANSFER));
+        if (request->write) {
+            io_uring_prep_write(sqe, request->fd, request->buffer + request->done, length, request->done);
+        } else {
+            io_uring_prep_read(sqe, request->fd, request->buffer + request->done, length, request->done);
+        }
+        io_uring_sqe_set_data(sqe, request);
+        return true;
+    }
+
+    bool Flush()
+    {
+        int ret = io_uring_submit(&ring_);
+        if (ret < 0) {
+            ERROR_LOG("io_uring submit failed. error code is %d", ret);
+            return false;
+        }
+        return true;
+    }
+
+    bool Submit(uint64_t tag, const std::string &path, char *buffer, size_t size, bool write)
+    {
+        int fd = OpenForIo(path, write);
+        if (fd < 0) {
+            return false;
+        }
+        std::unique_ptr<Request> request(new Request { tag, fd, buffer, size, 0, write, NowNs() });
+        if (!PrepTransfer(request.get()) || !Flush()) {
+            (void)close(fd);
+            return false;
+        }
+        (void)request.release();
+        ++inFlight_;
+        return true;
+    }
+
+    struct io_uring ring_;
+    bool ready_ = false;
+    size_t inFlight_ = 0;
+};
+#endif
+}
+
+std::unique_ptr<AsyncFileIO> AsyncFileIO::Create(unsigned depth)
+{
+#ifdef HAVE_LIBURING
+    std::unique_ptr<UringFileIO> uring(new UringFileIO());
+    if (uring->Init(depth)) {
+        return std::unique_ptr<AsyncFileIO>(uring.release());
+    }
+#endif
+    unsigned threads = std::max(1U, std::min(depth, 8U));
+    return std::unique_ptr<AsyncFileIO>(new ThreadPoolFileIO(threads));
+}
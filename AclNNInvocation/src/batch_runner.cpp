@@ -0,0 +1,289 @@
+/**
+* @file batch_runner.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "batch_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+
+#include "async_io.h"
+#include "common.h"
+#include "runner_cache.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+uint64_t ElapsedNs(Clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start).count());
+}
+
+struct BatchItem {
+    std::string input;
+    std::string output;
+};
+
+/**
+ * Buffers of one pipeline slot. Item i uses slot i % depth, so the read of item
+ * i + depth can start as soon as item i has been copied into its runner.
+ */
+struct BatchSlot {
+    std::vector<char> readBuffer;
+    std::vector<char> writeBuffer;
+    bool readDone = false;
+    bool writePending = false;
+};
+
+struct BatchStats {
+    uint64_t computeNs = 0;  // copy into runner, RunOp, encode output
+    uint64_t ioWaitNs = 0;   // main thread blocked on a completion it needed
+    uint64_t ioBusyNs = 0;   // sum of request latencies
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+bool LoadManifest(const std::string &manifest, std::vector<BatchItem> &items)
+{
+    std::ifstream file(manifest);
+    if (!file.is_open()) {
+        ERROR_LOG("Open manifest failed. path = %s", manifest.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        BatchItem item;
+        if (!(fields >> item.input)) {
+            continue;
+        }
+        if (item.input[0] == '#') {
+            continue;
+        }
+        if (!(fields >> item.output)) {
+            ERROR_LOG("Manifest line without output file: %s", line.c_str());
+            return false;
+        }
+        items.push_back(item);
+    }
+    return true;
+}
+
+class BatchPipeline {
+public:
+    /**
+     * The pipeline owns the engine: io_ is declared after slots_, so the engine is torn down
+     * (pool workers joined, ring closed) before the buffers its requests point into are freed.
+     */
+    BatchPipeline(const std::vector<BatchItem> &items, unsigned depth, std::unique_ptr<AsyncFileIO> io,
+        const CompletionOptions &completion)
+        : items_(items), slots_(depth), io_(std::move(io))
+    {
+        runners_.SetCompletion(completion);
+    }
+
+    bool Run()
+    {
+        bool ok = RunItems();
+        // reads ahead and writes behind may still target slots_, wait for all of them on every path
+        auto waitStart = Clock::now();
+        size_t drained = 0;
+        IoCompletion done;
+        while (io_->WaitCompletion(done)) {
+            ok = OnCompletion(done) && ok;
+            ++drained;
+        }
+        stats_.ioWaitNs += ElapsedNs(waitStart);
+        if (!ok) {
+            INFO_LOG("Batch stopped, waited for %zu requests still in flight", drained);
+        }
+        return ok;
+    }
+
+    const char *IoName() const
+    {
+        return io_->Name();
+    }
+
+    const BatchStats &Stats() const
+    {
+        return stats_;
+    }
+
+private:
+    // read tags are the item index, write tags have the top bit set
+    static constexpr uint64_t WRITE_TAG = 1ULL << 63;
+
+    bool RunItems()
+    {
+        for (size_t i = 0; i < items_.size() && i < slots_.size(); ++i) {
+            if (!SubmitRead(i)) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < items_.size(); ++i) {
+            if (!ProcessItem(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SubmitRead(size_t index)
+    {
+        struct stat sBuf;
+        if (stat(items_[index].input.c_str(), &sBuf) != 0 || !S_ISREG(sBuf.st_mode)) {
+            ERROR_LOG("%s is not a file", items_[index].input.c_str());
+            return false;
+        }
+        BatchSlot &slot = slots_[index % slots_.size()];
+        slot.readBuffer.resize(static_cast<size_t>(sBuf.st_size));
+        slot.readDone = false;
+        return io_->SubmitRead(index, items_[index].input, slot.readBuffer.data(), slot.readBuffer.size());
+    }
+
+    bool OnCompletion(const IoCompletion &done)
+    {
+        stats_.ioBusyNs += done.latencyNs;
+        bool isWrite = (done.tag & WRITE_TAG) != 0;
+        size_t index = static_cast<size_t>(done.tag & ~WRITE_TAG);
+        if (!done.success) {
+            ERROR_LOG("%s %s failed", isWrite ? "Write" : "Read",
+                (isWrite ? items_[index].output : items_[index].input).c_str());
+            return false;
+        }
+        BatchSlot &slot = slots_[index % slots_.size()];
+        if (isWrite) {
+            slot.writePending = false;
+            stats_.bytesWritten += done.bytes;
+        } else {
+            slot.readDone = true;
+            stats_.bytesRead += done.bytes;
+        }
+        return true;
+    }
+
+    bool WaitFor(const bool &ready, bool expect)
+    {
+        auto waitStart = Clock::now();
+        IoCompletion done;
+        while (ready != expect) {
+            if (!io_->WaitCompletion(done) || !OnCompletion(done)) {
+                return false;
+            }
+        }
+        stats_.ioWaitNs += ElapsedNs(waitStart);
+        return true;
+    }
+
+    bool ProcessItem(size_t index)
+    {
+        BatchSlot &slot = slots_[index % slots_.size()];
+        if (!WaitFor(slot.readDone, true)) {
+            return false;
+        }
+
+        auto computeStart = Clock::now();
+        TensorFileHeader header;
+        const void *payload = nullptr;
+        if (!DecodeTensorFile(items_[index].input, slot.readBuffer.data(), slot.readBuffer.size(), header,
+            &payload)) {
+            return false;
+        }
+        std::vector<int64_t> dims(header.dims, header.dims + header.numDims);
+        OpRunner *runner = runners_.Get(static_cast<aclDataType>(header.dataType), dims,
+            static_cast<aclFormat>(header.format));
+        if (runner == nullptr || header.dataSize != runner->GetInputSize(0)) {
+            ERROR_LOG("Prepare runner for %s failed", items_[index].input.c_str());
+            return false;
+        }
+        memcpy(runner->GetInputBuffer<void>(0), payload, header.dataSize);
+        stats_.computeNs += ElapsedNs(computeStart);
+
+        // the read buffer is free again, start reading ahead before the device runs
+        if (index + slots_.size() < items_.size() && !SubmitRead(index + slots_.size())) {
+            return false;
+        }
+
+        computeStart = Clock::now();
+        if (!runner->RunOp()) {
+            ERROR_LOG("Run op failed for %s", items_[index].input.c_str());
+            return false;
+        }
+        stats_.computeNs += ElapsedNs(computeStart);
+
+        if (!WaitFor(slot.writePending, false)) {
+            return false;
+        }
+        computeStart = Clock::now();
+        size_t outSize = runner->GetOutputSize(0);
+        std::vector<char> head = EncodeTensorFileHeader(runner->GetOutputDataType(0), runner->GetOutputShape(0),
+            runner->GetOutputBuffer<void>(0), outSize);
+        if (head.empty()) {
+            return false;
+        }
+        slot.writeBuffer.swap(head);
+        slot.writeBuffer.insert(slot.writeBuffer.end(), runner->GetOutputBuffer<char>(0),
+            runner->GetOutputBuffer<char>(0) + outSize);
+        stats_.computeNs += ElapsedNs(computeStart);
+        slot.writePending = true;
+        return io_->SubmitWrite(index | WRITE_TAG, items_[index].output, slot.writeBuffer.data(),
+            slot.writeBuffer.size());
+    }
+
+    const std::vector<BatchItem> &items_;
+    std::vector<BatchSlot> slots_;
+    std::unique_ptr<AsyncFileIO> io_;
+    RunnerCache runners_;
+    BatchStats stats_;
+};
+}
+
+bool RunBatch(const std::string &manifest, unsigned ioDepth, const CompletionOptions &completion)
+{
+    std::vector<BatchItem> items;
+    if (!LoadManifest(manifest, items)) {
+        return false;
+    }
+    if (items.empty() || ioDepth == 0) {
+        ERROR_LOG("Manifest %s is empty or io depth is 0", manifest.c_str());
+        return false;
+    }
+    std::unique_ptr<AsyncFileIO> io = AsyncFileIO::Create(ioDepth * 2);
+    if (io == nullptr) {
+        ERROR_LOG("Create async file io failed");
+        return false;
+    }
+    BatchPipeline pipeline(items, ioDepth, std::move(io), completion);
+    INFO_LOG("Batch of %zu files, io depth %u, io engine %s", items.size(), ioDepth, pipeline.IoName());
+
+    auto start = Clock::now();
+    bool ok = pipeline.Run();
+    uint64_t wallNs = ElapsedNs(start);
+    if (!ok) {
+        return false;
+    }
+
+    const BatchStats &stats = pipeline.Stats();
+    // share of io time that was hidden behind compute instead of blocking the device thread
+    double hidden = stats.ioBusyNs == 0 ? 1.0 :
+        1.0 - static_cast<double>(std::min(stats.ioWaitNs, stats.ioBusyNs)) / stats.ioBusyNs;
+    INFO_LOG("Batch done: wall %.3f ms, compute %.3f ms, io busy %.3f ms, io wait %.3f ms, io hidden %.1f%%",
+        wallNs / 1e6, stats.computeNs / 1e6, stats.ioBusyNs / 1e6, stats.ioWaitNs / 1e6, hidden * 100);
+    INFO_LOG("Batch io: read %.3f MB, written %.3f MB, %.1f files/s",
+        stats.bytesRead / 1e6, stats.bytesWritten / 1e6, items.size() / (wallNs / 1e9));
+    return true;
+}
@@ -0,0 +1,246 @@
+/**
+* @file batch_scheduler.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "batch_scheduler.h"
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include "acl/acl.h"
+#include "common.h"
+#include "runner_cache.h"
+
+extern int deviceId;
+
+namespace {
+constexpr int SPIN_BEFORE_SLEEP = 1000;
+constexpr int YIELD_BEFORE_PARK = 100;
+constexpr int SLEEP_TIMEOUT_MS = 1;
+
+uint64_t NowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+constexpr int BatchRequest::STATUS_PENDING;
+constexpr int BatchRequest::STATUS_OK;
+constexpr int BatchRequest::STATUS_FAILED;
+
+bool BatchRequest::Wait() const
+{
+    for (int i = 0; i < SPIN_BEFORE_SLEEP && !Done(); ++i) {
+    }
+    for (int i = 0; i < YIELD_BEFORE_PARK && !Done(); ++i) {
+        std::this_thread::yield();
+    }
+    if (!Done()) {
+        scheduler->Park(*this);
+    }
+    return status.load(std::memory_order_acquire) == STATUS_OK;
+}
+
+BatchScheduler::BatchScheduler(const BatchSchedulerOptions &options) : options_(options)
+{
+    if (options_.maxBatchRequests == 0) {
+        options_.maxBatchRequests = 1;
+    }
+    if (options_.minBucketElements == 0) {
+        options_.minBucketElements = 1;
+    }
+}
+
+BatchScheduler::~BatchScheduler()
+{
+    Stop();
+}
+
+bool BatchScheduler::Start()
+{
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    stop_.store(false);
+    thread_ = std::thread([this, &started]() {
+        // acl contexts are per thread, the dispatcher owns its own binding to the device
+        if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
+            ERROR_LOG("Set device %d for batch scheduler failed", deviceId);
+            started.set_value(false);
+            return;
+        }
+        started.set_value(true);
+        Loop();
+        (void)aclrtResetDevice(deviceId);
+    });
+    if (!result.get()) {
+        thread_.join();
+        return false;
+    }
+    return true;
+}
+
+void BatchScheduler::Stop()
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    stop_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_one();
+    }
+    thread_.join();
+}
+
+void BatchScheduler::Submit(BatchRequest *request)
+{
+    request->status.store(BatchRequest::STATUS_PENDING, std::memory_order_relaxed);
+    request->submitNs = NowNs();
+    request->scheduler = this;
+    queue_.Push(request);
+    // pairs with the fence in Next: either the dispatcher sees the request or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_one();
+    }
+}
+
+void BatchScheduler::Park(const BatchRequest &request)
+{
+    std::unique_lock<std::mutex> lock(doneMutex_);
+    parked_.fetch_add(1, std::memory_order_relaxed);
+    // pairs with the fence in RunBatch: either the dispatcher sees us parked or we see the status
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    done_.wait(lock, [&request]() { return request.Done(); });
+    parked_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+BatchSchedulerStats BatchScheduler::Stats() const
+{
+    return stats_;
+}
+
+BatchRequest *BatchScheduler::Next(bool block, uint64_t deadlineNs)
+{
+    if (carry_ != nullptr) {
+        BatchRequest *request = carry_;
+        carry_ = nullptr;
+        return request;
+    }
+    int spins = 0;
+    while (true) {
+        MpscNode *node = queue_.Pop();
+        if (node != nullptr) {
+            return static_cast<BatchRequest *>(node);
+        }
+        if (stop_.load(std::memory_order_acquire)) {
+            // Stop() is called once producers are done, so an empty queue here stays empty
+            node = queue_.Pop();
+            return static_cast<BatchRequest *>(node);
+        }
+        if (!block) {
+            if (NowNs() >= deadlineNs) {
+                return nullptr;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        if (++spins < SPIN_BEFORE_SLEEP) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        node = queue_.Pop();
+        if (node == nullptr && !stop_.load(std::memory_order_acquire)) {
+            // the timeout covers a producer caught between its two stores in Push
+            wake_.wait_for(lock, std::chrono::milliseconds(SLEEP_TIMEOUT_MS));
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+        if (node != nullptr) {
+            return static_cast<BatchRequest *>(node);
+        }
+        spins = 0;
+    }
+}
+
+void BatchScheduler::Loop()
+{
+    RunnerCache runners;
+    std::vector<BatchRequest *> batch;
+    while (true) {
+        BatchRequest *first = Next(true, 0);
+        if (first == nullptr) {
+            break;
+        }
+        batch.clear();
+        batch.push_back(first);
+        size_t elements = first->count;
+        uint64_t deadline = first->submitNs + options_.maxDelayUs * 1000;
+        while (batch.size() < options_.maxBatchRequests && elements < options_.maxBatchElements) {
+            BatchRequest *request = Next(false, deadline);
+            if (request == nullptr) {
+                break;
+            }
+            if (elements + request->count > options_.maxBatchElements) {
+                carry_ = request;
+                break;
+            }
+            batch.push_back(request);
+            elements += request->count;
+        }
+        RunBatch(runners, batch.data(), batch.size(), elements);
+    }
+    stats_.runners = runners.Size();
+}
+
+void BatchScheduler::RunBatch(RunnerCache &runners, BatchRequest **batch, size_t num, size_t elements)
+{
+    // power of two buckets keep the number of distinct runners, and so of shapes to tile, small
+    size_t bucket = options_.minBucketElements;
+    while (bucket < elements) {
+        bucket <<= 1;
+    }
+    OpRunner *runner = runners.Get(ACL_FLOAT16, { static_cast<int64_t>(bucket) });
+    bool ok = runner != nullptr;
+    if (ok) {
+        uint16_t *input = runner->GetInputBuffer<uint16_t>(0);
+        size_t offset = 0;
+        for (size_t i = 0; i < num; ++i) {
+            memcpy(input + offset, batch[i]->input, batch[i]->count * sizeof(uint16_t));
+            offset += batch[i]->count;
+        }
+        memset(input + offset, 0, (bucket - offset) * sizeof(uint16_t));
+        ok = runner->RunOp();
+    }
+    const uint16_t *output = ok ? runner->GetOutputBuffer<uint16_t>(0) : nullptr;
+    size_t offset = 0;
+    for (size_t i = 0; i < num; ++i) {
+        if (ok) {
+            memcpy(batch[i]->output, output + offset, batch[i]->count * sizeof(uint16_t));
+        }
+        offset += batch[i]->count;
+        int status = ok ? BatchRequest::STATUS_OK : BatchRequest::STATUS_FAILED;
+        // the owner may free the request once it sees the status, batch[i] is not touched again
+        batch[i]->status.store(status, std::memory_order_release);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed) != 0) {
+        std::lock_guard<std::mutex> lock(doneMutex_);
+        done_.notify_all();
+    }
+    stats_.requests += num;
+    stats_.launches += 1;
+    stats_.elements += elements;
+    stats_.paddedElements += bucket;
+}
@@ -0,0 +1,206 @@
+/**
+* @file batch_scheduler_bench.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "acl/acl.h"
+#include "batch_scheduler.h"
+#include "common.h"
+
+bool g_isDevice = false;
+int deviceId = 0;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+    int producers = 16;
+    int requests = 2000;          // per producer
+    size_t elements = 1024;       // per request
+    double rate = 0;              // requests/s per producer, 0 submits again as soon as one finishes
+    BatchSchedulerOptions batching;
+};
+
+struct LoadResult {
+    std::vector<uint64_t> latencyNs;
+    int errors = 0;
+    std::vector<uint16_t> output;   // the unbatched run's output, the batched run must match it
+};
+
+bool ParseOptions(int argc, char **argv, LoadOptions &opts)
+{
+    bool valid = (argc % 2 == 1);
+    for (int i = 1; valid && i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        const char *value = argv[i + 1];
+        if (arg == "--producers") {
+            opts.producers = atoi(value);
+        } else if (arg == "--requests") {
+            opts.requests = atoi(value);
+        } else if (arg == "--elements") {
+            opts.elements = strtoull(value, nullptr, 10);
+        } else if (arg == "--rate") {
+            opts.rate = atof(value);
+        } else if (arg == "--max-batch") {
+            opts.batching.maxBatchRequests = strtoull(value, nullptr, 10);
+        } else if (arg == "--max-elements") {
+            opts.batching.maxBatchElements = strtoull(value, nullptr, 10);
+        } else if (arg == "--max-delay-us") {
+            opts.batching.maxDelayUs = strtoull(value, nullptr, 10);
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || opts.producers <= 0 || opts.requests <= 0 || opts.elements == 0) {
+        ERROR_LOG("usage: %s [--producers N] [--requests N] [--elements N] [--rate R] [--max-batch N] "
+            "[--max-elements N] [--max-delay-us N]", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+bool InitResource()
+{
+    if (aclInit("../scripts/acl.json") != ACL_SUCCESS) {
+        ERROR_LOG("acl init failed");
+        return false;
+    }
+    if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
+        ERROR_LOG("Set device failed. deviceId is %d", deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    aclrtRunMode runMode;
+    if (aclrtGetRunMode(&runMode) != ACL_SUCCESS) {
+        ERROR_LOG("Get run mode failed");
+        (void)aclrtResetDevice(deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    g_isDevice = (runMode == ACL_DEVICE);
+    return true;
+}
+
+void DestoryResource()
+{
+    (void)aclrtResetDevice(deviceId);
+    (void)aclFinalize();
+}
+
+void Produce(const LoadOptions &opts, BatchScheduler &scheduler, int index, LoadResult &result)
+{
+    std::vector<uint16_t> input(opts.elements);
+    std::vector<uint16_t> output(opts.elements);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<uint16_t>(0x3c00 + ((i + index) & 0x3ff));  // fp16 values in [1, 2)
+    }
+    std::chrono::nanoseconds interval(opts.rate > 0 ? static_cast<int64_t>(1e9 / opts.rate) : 0);
+    Clock::time_point next = Clock::now() + interval * index / opts.producers;
+    BatchRequest request;
+    request.input = input.data();
+    request.output = output.data();
+    request.count = input.size();
+    result.latencyNs.reserve(opts.requests);
+    for (int r = 0; r < opts.requests; ++r) {
+        if (interval.count() > 0) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+        }
+        Clock::time_point start = Clock::now();
+        scheduler.Submit(&request);
+        if (!request.Wait()) {
+            ++result.errors;
+            continue;
+        }
+        if (result.output.empty()) {
+            result.output = output;
+        } else if (output != result.output) {
+            ERROR_LOG("Producer %d request %d differs from its one launch per request output", index, r);
+            ++result.errors;
+            continue;
+        }
+        result.latencyNs.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+    }
+}
+
+double Percentile(const std::vector<uint64_t> &sorted, double q)
+{
+    size_t idx = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)] / 1e3;
+}
+
+bool RunLoad(const char *name, const LoadOptions &opts, const BatchSchedulerOptions &batching,
+    std::vector<LoadResult> &results)
+{
+    BatchScheduler scheduler(batching);
+    if (!scheduler.Start()) {
+        return false;
+    }
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < opts.producers; ++i) {
+        threads.emplace_back(Produce, std::cref(opts), std::ref(scheduler), i, std::ref(results[i]));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    scheduler.Stop();
+
+    std::vector<uint64_t> latency;
+    int errors = 0;
+    for (auto &r : results) {
+        latency.insert(latency.end(), r.latencyNs.begin(), r.latencyNs.end());
+        r.latencyNs.clear();
+        errors += r.errors;
+        r.errors = 0;
+    }
+    if (latency.empty()) {
+        ERROR_LOG("%s: every request failed", name);
+        return false;
+    }
+    std::sort(latency.begin(), latency.end());
+    BatchSchedulerStats stats = scheduler.Stats();
+    printf("%-10s req/s %10.1f  launches %7lu  avg batch %6.2f  padding %5.1f%%  runners %lu  "
+        "latency(us) p50 %8.1f  p99 %8.1f  max %8.1f  errors %d\n", name, latency.size() / wall,
+        static_cast<unsigned long>(stats.launches), static_cast<double>(stats.requests) / stats.launches,
+        100.0 * (stats.paddedElements - stats.elements) / stats.paddedElements,
+        static_cast<unsigned long>(stats.runners), Percentile(latency, 0.5), Percentile(latency, 0.99),
+        latency.back() / 1e3, errors);
+    return errors == 0;
+}
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        return FAILED;
+    }
+    if (!InitResource()) {
+        ERROR_LOG("Init resource failed");
+        return FAILED;
+    }
+    // same load twice: one launch per request, then coalesced; every coalesced output is compared with the
+    // first unbatched output of the same producer
+    BatchSchedulerOptions unbatched = opts.batching;
+    unbatched.maxBatchRequests = 1;
+    unbatched.minBucketElements = opts.elements;
+    std::vector<LoadResult> results(opts.producers);
+    bool ok = RunLoad("unbatched", opts, unbatched, results) && RunLoad("batched", opts, opts.batching, results);
+    DestoryResource();
+    return ok ? SUCCESS : FAILED;
+}
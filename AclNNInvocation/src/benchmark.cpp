@@ -0,0 +1,584 @@
+/**
+* @file benchmark.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn_mish_custom.h"
+#include "op_runner.h"
+
+#include "common.h"
+
+bool g_isDevice = false;
+int deviceId = 0;
+
+namespace {
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double realTimeNs;
+    std::string aggregate;  // empty for a mean per iteration, else p50/p99/p999/max
+};
+
+struct BenchOptions {
+    uint64_t iterations = 1000;
+    std::vector<int64_t> shape { 8, 2048 };
+    std::string outFile = "../output/benchmark.json";
+    CompletionOptions completion;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedNs(Clock::time_point start, Clock::time_point end)
+{
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// results are printed with printf, not INFO_LOG: they must show up whatever the log level of the build or the run
+
+/**
+ * @brief Run body iterations times and report the mean wall time per iteration
+ * @param [in] name: benchmark name
+ * @param [in] iterations: number of timed iterations
+ * @param [in] body: step under test, returns false on failure
+ * @param [out] results: result list to append to
+ * @return run result
+ */
+bool RunBench(const std::string &name, uint64_t iterations, const std::function<bool()> &body,
+              std::vector<BenchResult> &results)
+{
+    // one untimed warm up round so first-call caches are not part of the figure
+    if (!body()) {
+        ERROR_LOG("Benchmark %s failed in warm up", name.c_str());
+        return false;
+    }
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (!body()) {
+            ERROR_LOG("Benchmark %s failed at iteration %lu", name.c_str(), i);
+            return false;
+        }
+    }
+    auto end = Clock::now();
+    results.push_back({ name, iterations, ElapsedNs(start, end) / iterations, "" });
+    printf("%-40s %12.1f ns/iter\n", name.c_str(), results.back().realTimeNs);
+    return true;
+}
+
+/**
+ * @brief Same as RunBench, but the body reports the time of its measured part only
+ */
+bool RunManualBench(const std::string &name, uint64_t iterations, const std::function<bool(double &)> &body,
+                    std::vector<BenchResult> &results)
+{
+    double ns = 0;
+    if (!body(ns)) {
+        ERROR_LOG("Benchmark %s failed in warm up", name.c_str());
+        return false;
+    }
+    double total = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        ns = 0;
+        if (!body(ns)) {
+            ERROR_LOG("Benchmark %s failed at iteration %lu", name.c_str(), i);
+            return false;
+        }
+        total += ns;
+    }
+    results.push_back({ name, iterations, total / iterations, "" });
+    printf("%-40s %12.1f ns/iter\n", name.c_str(), results.back().realTimeNs);
+    return true;
+}
+
+/**
+ * @brief Same as RunBench, but times every iteration and also reports the latency distribution
+ */
+bool RunLatencyBench(const std::string &name, uint64_t iterations, const std::function<bool()> &body,
+                     std::vector<BenchResult> &results)
+{
+    if (!body()) {
+        ERROR_LOG("Benchmark %s failed in warm up", name.c_str());
+        return false;
+    }
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (uint64_t i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        if (!body()) {
+            ERROR_LOG("Benchmark %s failed at iteration %lu", name.c_str(), i);
+            return false;
+        }
+        samples.push_back(ElapsedNs(start, Clock::now()));
+    }
+    double total = 0;
+    for (double ns : samples) {
+        total += ns;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto Percentile = [&samples](double q) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(q * (samples.size() - 1) + 0.5))];
+    };
+    results.push_back({ name, iterations, total / iterations, "" });
+    results.push_back({ name + "_p50", iterations, Percentile(0.5), "p50" });
+    results.push_back({ name + "_p99", iterations, Percentile(0.99), "p99" });
+    results.push_back({ name + "_p999", iterations, Percentile(0.999), "p999" });
+    results.push_back({ name + "_max", iterations, samples.back(), "max" });
+    printf("%-40s %12.1f ns/iter  p50 %.1f  p99 %.1f  p999 %.1f  max %.1f\n", name.c_str(), total / iterations,
+        Percentile(0.5), Percentile(0.99), Percentile(0.999), samples.back());
+    return true;
+}
+
+/**
+ * @brief Write results in the google benchmark json layout, so its compare.py can diff two releases
+ */
+bool WriteJson(const BenchOptions &opts, const std::vector<BenchResult> &results)
+{
+    std::ofstream out(opts.outFile);
+    if (!out.is_open()) {
+        ERROR_LOG("Open file failed. path = %s", opts.outFile.c_str());
+        return false;
+    }
+    std::string shape;
+    for (size_t i = 0; i < opts.shape.size(); ++i) {
+        shape += (i == 0 ? "" : ",") + std::to_string(opts.shape[i]);
+    }
+    out << "{\n  \"context\": {\n";
+    out << "    \"executable\": \"benchmark_mish_op\",\n";
+    out << "    \"shape\": \"" << shape << "\",\n";
+    out << "    \"run_mode\": \"" << (g_isDevice ? "device" : "host") << "\",\n";
+    out << "    \"log_level\": " << MISH_LOG_LEVEL << "\n";
+    out << "  },\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", ";
+        if (r.aggregate.empty()) {
+            out << "\"run_type\": \"iteration\", ";
+        } else {
+            out << "\"run_type\": \"aggregate\", \"aggregate_name\": \"" << r.aggregate << "\", ";
+        }
+        out << "\"iterations\": " << r.iterations
+            << ", \"real_time\": " << r.realTimeNs << ", \"cpu_time\": " << r.realTimeNs
+            << ", \"time_unit\": \"ns\"}" << (i + 1 == results.size() ? "\n" : ",\n");
+    }
+    out << "  ]\n}\n";
+    INFO_LOG("Write benchmark result to %s", opts.outFile.c_str());
+    return true;
+}
+
+bool ParseOptions(int argc, char **argv, BenchOptions &opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            opts.iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--spin-us" && i + 1 < argc) {
+            opts.completion.spinUs = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--sync-timeout-ms" && i + 1 < argc) {
+            opts.completion.timeoutMs = static_cast<int32_t>(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--out" && i + 1 < argc) {
+            opts.outFile = argv[++i];
+        } else if (arg == "--shape" && i + 1 < argc) {
+            // comma separated dims, e.g. --shape 8,2048
+            opts.shape.clear();
+            std::string dims = argv[++i];
+            size_t pos = 0;
+            while (pos < dims.size()) {
+                size_t next = dims.find(',', pos);
+                if (next == std::string::npos) {
+                    next = dims.size();
+                }
+                opts.shape.push_back(std::strtoll(dims.substr(pos, next - pos).c_str(), nullptr, 10));
+                pos = next + 1;
+            }
+        } else {
+            ERROR_LOG("Unknown option %s. usage: %s [--iterations N] [--shape d0,d1,...] "
+                "[--spin-us N] [--sync-timeout-ms N] [--out file]",
+                arg.c_str(), argv[0]);
+            return false;
+        }
+    }
+    if (opts.iterations == 0 || opts.shape.empty()) {
+        ERROR_LOG("iterations and shape can not be empty");
+        return false;
+    }
+    return true;
+}
+
+bool InitResource()
+{
+    if (aclInit("../scripts/acl.json") != ACL_SUCCESS) {
+        ERROR_LOG("acl init failed");
+        return false;
+    }
+    if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
+        ERROR_LOG("Set device failed. deviceId is %d", deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    aclrtRunMode runMode;
+    if (aclrtGetRunMode(&runMode) != ACL_SUCCESS) {
+        ERROR_LOG("Get run mode failed");
+        (void)aclrtResetDevice(deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    g_isDevice = (runMode == ACL_DEVICE);
+    return true;
+}
+
+void DestoryResource()
+{
+    (void)aclrtResetDevice(deviceId);
+    (void)aclFinalize();
+}
+
+/**
+ * Input value range and the MishCustom path every tile of it should take
+ */
+struct PathInput {
+    const char *name;
+    float low;
+    float high;
+};
+
+bool RunPathBenchmarks(const BenchOptions &opts, OperatorDesc &opDesc, OpRunner &runner,
+    std::vector<BenchResult> &results)
+{
+    const PathInput inputs[] = {
+        { "saturate_high", 5.0f, 10.0f },
+        { "saturate_low", -30.0f, -21.0f },
+        { "fast", -4.0f, 4.0f },
+        { "full", -10.0f, 10.0f },
+    };
+    aclFloat16 *x = runner.GetInputBuffer<aclFloat16>(0);
+    size_t count = runner.GetInputElementCount(0);
+    bool ok = true;
+    for (const PathInput &input : inputs) {
+        uint32_t state = 12345;
+        for (size_t i = 0; i < count; ++i) {
+            state = state * 1664525u + 1013904223u;
+            float u = static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+            x[i] = aclFloatToFloat16(input.low + (input.high - input.low) * u);
+        }
+        for (bool adaptive : { false, true }) {
+            // RunOp queries the workspace on every call, so the attribute takes effect on the next run
+            opDesc.adaptive = adaptive;
+            std::string name = std::string("OpRunner/RunOp/path_") + input.name + (adaptive ? "" : "_off");
+            ok = ok && RunLatencyBench(name, opts.iterations, [&]() { return runner.RunOp(); }, results);
+            MishPathCounters paths;
+            if (ok && runner.ReadPathCounters(paths)) {
+                printf("%-40s tiles: %lu saturate high, %lu saturate low, %lu fast, %lu full\n", name.c_str(),
+                    static_cast<unsigned long>(paths.saturateHigh), static_cast<unsigned long>(paths.saturateLow),
+                    static_cast<unsigned long>(paths.fast), static_cast<unsigned long>(paths.full));
+            }
+        }
+    }
+    opDesc.adaptive = false;
+    return ok;
+}
+
+/**
+ * @brief Effective bandwidth of MishCustom on sizes that do not split evenly over the cores, with the
+ * per core ranges aligned to the 512 byte GM burst (default) and to 32 bytes only (burst_align attribute off)
+ */
+bool RunPartitionBenchmarks(const BenchOptions &opts, aclrtStream stream, std::vector<BenchResult> &results)
+{
+    // element counts are multiples of 16 (32 bytes) but not of 8 * 256, so the unaligned split cuts bursts
+    const int64_t sizes[] = { 65536 + 48, (1 << 20) + 16 * 37, (4 << 20) + 16 * 5, (16 << 20) + 16 * 111 };
+    void *workspace = nullptr;
+    uint64_t workspaceCapacity = 0;
+    bool ok = true;
+    for (int64_t count : sizes) {
+        std::vector<int64_t> shape { count };
+        size_t bytes = static_cast<size_t>(count) * aclDataTypeSize(ACL_FLOAT16);
+        void *xMem = nullptr;
+        void *yMem = nullptr;
+        if (aclrtMalloc(&xMem, bytes, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS ||
+            aclrtMalloc(&yMem, bytes, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
+            ERROR_LOG("Malloc %zu bytes of device memory failed", bytes);
+            (void)aclrtFree(xMem);
+            ok = false;
+            break;
+        }
+        // zero input, every tile takes the same path so both splits do the same work
+        std::vector<aclFloat16> zeros(static_cast<size_t>(count), aclFloatToFloat16(0.0f));
+        aclTensor *x = aclCreateTensor(shape.data(), shape.size(), ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND,
+            shape.data(), shape.size(), xMem);
+        aclTensor *y = aclCreateTensor(shape.data(), shape.size(), ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND,
+            shape.data(), shape.size(), yMem);
+        ok = x != nullptr && y != nullptr &&
+            aclrtMemcpy(xMem, bytes, zeros.data(), bytes, ACL_MEMCPY_HOST_TO_DEVICE) == ACL_SUCCESS;
+        // fewer rounds for the big sizes, the total bytes moved stay about the same
+        uint64_t iterations = std::max<uint64_t>(1, opts.iterations * 65536 / static_cast<uint64_t>(count));
+        for (bool aligned : { true, false }) {
+            if (!ok) {
+                break;
+            }
+            std::string name = "aclnnMishCustom/partition_" + std::to_string(count) +
+                (aligned ? "_aligned" : "_unaligned");
+            // tiling is done at the query and is the same for both splits, only launch and completion are timed
+            ok = RunManualBench(name, iterations, [&](double &ns) {
+                uint64_t workspaceSize = 0;
+                aclOpExecutor *handle = nullptr;
+                if (aclnnMishCustomGetWorkspaceSize(x, false, aligned, y, nullptr, &workspaceSize, &handle) !=
+                    ACL_SUCCESS) {
+                    return false;
+                }
+                if (workspaceSize > workspaceCapacity) {
+                    (void)aclrtFree(workspace);
+                    workspace = nullptr;
+                    workspaceCapacity = 0;
+                    if (aclrtMalloc(&workspace, workspaceSize, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+                        ERROR_LOG("Malloc device memory for workspace failed");
+                        return false;
+                    }
+                    workspaceCapacity = workspaceSize;
+                }
+                auto start = Clock::now();
+                bool launched = aclnnMishCustom(workspace, workspaceSize, handle, stream) == ACL_SUCCESS &&
+                    aclrtSynchronizeStream(stream) == ACL_SUCCESS;
+                ns = ElapsedNs(start, Clock::now());
+                return launched;
+            }, results);
+            if (ok) {
+                // x read once and y written once
+                printf("%-40s %12.2f GB/s\n", name.c_str(), 2.0 * bytes / results.back().realTimeNs);
+            }
+        }
+        (void)aclDestroyTensor(x);
+        (void)aclDestroyTensor(y);
+        (void)aclrtFree(xMem);
+        (void)aclrtFree(yMem);
+        if (!ok) {
+            break;
+        }
+    }
+    (void)aclrtFree(workspace);
+    return ok;
+}
+
+/**
+ * @brief A large MishCustom run on the device alone and split with the host threads. The warm up round
+ * of the split run is the calibration, the timed rounds keep adapting the share.
+ */
+bool RunCoExecBenchmarks(const BenchOptions &opts, std::vector<BenchResult> &results)
+{
+    const std::vector<int64_t> shape { 4 << 20 };
+    OperatorDesc opDesc;
+    opDesc.AddInputTensorDesc(ACL_FLOAT16, shape.size(), shape.data(), ACL_FORMAT_ND);
+    opDesc.AddOutputTensorDesc(ACL_FLOAT16, shape.size(), shape.data(), ACL_FORMAT_ND);
+    OpRunner runner(&opDesc);
+    if (!runner.Init()) {
+        ERROR_LOG("Init OpRunner failed");
+        return false;
+    }
+    runner.SetCompletion(opts.completion);
+    aclFloat16 *x = runner.GetInputBuffer<aclFloat16>(0);
+    size_t count = runner.GetInputElementCount(0);
+    uint32_t state = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 1664525u + 1013904223u;
+        x[i] = aclFloatToFloat16(-10.0f + 20.0f * static_cast<float>(state >> 8) / static_cast<float>(1u << 24));
+    }
+    uint64_t iterations = std::max<uint64_t>(3, opts.iterations * 65536 / count);
+    bool ok = RunLatencyBench("OpRunner/RunOp/co_exec_off", iterations, [&]() { return runner.RunOp(); }, results);
+
+    CoExecOptions coExec;
+    coExec.enabled = true;
+    ok = ok && runner.SetCoExecution(coExec);
+    ok = ok && RunLatencyBench("OpRunner/RunOp/co_exec", iterations, [&]() { return runner.RunOp(); }, results);
+    if (ok) {
+        const CoExecStats &stats = runner.GetCoExecStats();
+        printf("%-40s host share %.3f after %lu runs, %.3f elements/ns on the host, %.3f on the device\n",
+            "OpRunner/RunOp/co_exec", stats.cpuShare, static_cast<unsigned long>(stats.runs), stats.cpuRate,
+            stats.npuRate);
+    }
+    return ok;
+}
+
+bool RunBenchmarks(const BenchOptions &opts, std::vector<BenchResult> &results)
+{
+    const aclDataType dataType = ACL_FLOAT16;
+    const aclFormat format = ACL_FORMAT_ND;
+    const std::vector<int64_t> &shape = opts.shape;
+
+    // 1. tensor descriptor setup, as done by CreateOpDesc for every launch
+    bool ok = RunBench("OperatorDesc/AddTensorDesc", opts.iterations, [&]() {
+        OperatorDesc desc;
+        desc.AddInputTensorDesc(dataType, shape.size(), shape.data(), format);
+        desc.AddOutputTensorDesc(dataType, shape.size(), shape.data(), format);
+        return desc.inputDesc.size() == 1 && desc.outputDesc.size() == 1;
+    }, results);
+    if (!ok) {
+        return false;
+    }
+
+    OperatorDesc opDesc;
+    opDesc.AddInputTensorDesc(dataType, shape.size(), shape.data(), format);
+    opDesc.AddOutputTensorDesc(dataType, shape.size(), shape.data(), format);
+    OpRunner runner(&opDesc);
+    if (!runner.Init()) {
+        ERROR_LOG("Init OpRunner failed");
+        return false;
+    }
+
+    // 2. aclCreateTensor on an existing device buffer, as done by OpRunner::Init
+    void *devMem = nullptr;
+    size_t size = runner.GetInputSize(0);
+    if (aclrtMalloc(&devMem, size, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+        ERROR_LOG("Malloc device memory failed");
+        return false;
+    }
+    ok = RunBench("OpRunner/aclCreateTensor", opts.iterations, [&]() {
+        aclTensor *tensor = aclCreateTensor(shape.data(), shape.size(), dataType, nullptr, 0, format,
+            shape.data(), shape.size(), devMem);
+        if (tensor == nullptr) {
+            return false;
+        }
+        (void)aclDestroyTensor(tensor);
+        return true;
+    }, results);
+
+    aclTensor *x = aclCreateTensor(shape.data(), shape.size(), dataType, nullptr, 0, format,
+        shape.data(), shape.size(), devMem);
+    aclTensor *y = aclCreateTensor(shape.data(), shape.size(), dataType, nullptr, 0, format,
+        shape.data(), shape.size(), devMem);
+    aclrtStream stream = nullptr;
+    if (!ok || x == nullptr || y == nullptr || aclrtCreateStream(&stream) != ACL_SUCCESS) {
+        ERROR_LOG("Prepare tensors and stream failed");
+        (void)aclDestroyTensor(x);
+        (void)aclDestroyTensor(y);
+        (void)aclrtFree(devMem);
+        return false;
+    }
+
+    // workspace is grown on demand and reused, so allocation is never part of a measured step
+    void *workspace = nullptr;
+    uint64_t workspaceCapacity = 0;
+    auto ReserveWorkspace = [&](uint64_t workspaceSize) {
+        if (workspaceSize <= workspaceCapacity) {
+            return true;
+        }
+        (void)aclrtFree(workspace);
+        workspace = nullptr;
+        workspaceCapacity = 0;
+        if (aclrtMalloc(&workspace, workspaceSize, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+            ERROR_LOG("Malloc device memory for workspace failed");
+            return false;
+        }
+        workspaceCapacity = workspaceSize;
+        return true;
+    };
+
+    // 3. workspace query: runs TilingFunc + SaveToBuffer and NnopbaseGetExecutor inside the generated wrapper.
+    // The executor is consumed by a launch afterwards, which is not part of the measured time.
+    ok = RunManualBench("aclnnMishCustomGetWorkspaceSize", opts.iterations, [&](double &ns) {
+        uint64_t workspaceSize = 0;
+        aclOpExecutor *handle = nullptr;
+        auto start = Clock::now();
+        auto ret = aclnnMishCustomGetWorkspaceSize(x, false, true, y, nullptr, &workspaceSize, &handle);
+        ns = ElapsedNs(start, Clock::now());
+        if (ret != ACL_SUCCESS || !ReserveWorkspace(workspaceSize)) {
+            return false;
+        }
+        return aclnnMishCustom(workspace, workspaceSize, handle, stream) == ACL_SUCCESS &&
+            aclrtSynchronizeStream(stream) == ACL_SUCCESS;
+    }, results);
+
+    // 4. launch enqueue cost only, the device work is drained outside of the measured part
+    ok = ok && RunManualBench("aclnnMishCustom/launch", opts.iterations, [&](double &ns) {
+        uint64_t workspaceSize = 0;
+        aclOpExecutor *handle = nullptr;
+        if (aclnnMishCustomGetWorkspaceSize(x, false, true, y, nullptr, &workspaceSize, &handle) != ACL_SUCCESS ||
+            !ReserveWorkspace(workspaceSize)) {
+            return false;
+        }
+        auto start = Clock::now();
+        auto ret = aclnnMishCustom(workspace, workspaceSize, handle, stream);
+        ns = ElapsedNs(start, Clock::now());
+        return ret == ACL_SUCCESS && aclrtSynchronizeStream(stream) == ACL_SUCCESS;
+    }, results);
+
+    // 5. whole runner: copy in, stream create, query, launch, sync, copy out
+    ok = ok && RunBench("OpRunner/RunOp", opts.iterations, [&]() {
+        return runner.RunOp();
+    }, results);
+
+    // 6. tail latency of the whole runner under each completion policy
+    for (auto policy : { COMPLETION_BLOCK, COMPLETION_SPIN, COMPLETION_HYBRID }) {
+        CompletionOptions completion = opts.completion;
+        completion.policy = policy;
+        runner.SetCompletion(completion);
+        ok = ok && RunLatencyBench(std::string("OpRunner/RunOp/") + CompletionPolicyName(policy), opts.iterations,
+            [&]() { return runner.RunOp(); }, results);
+    }
+
+    // 7. RunOp logs every copy, the stream creation and the sync. Same loop with those messages written
+    // synchronously to stdout, queued to the async writer, and filtered out at runtime. A build with
+    // -DMISH_LOG_LEVEL=2 compiles them out instead, context.log_level in the json tells the builds apart.
+    runner.SetCompletion(opts.completion);
+    const int level = LogGetLevel();
+    LogSetLevel(LOG_LEVEL_INFO);
+    ok = ok && RunLatencyBench("OpRunner/RunOp/log_sync", opts.iterations, [&]() { return runner.RunOp(); }, results);
+    if (ok && LogSetAsync(true)) {
+        ok = RunLatencyBench("OpRunner/RunOp/log_async", opts.iterations, [&]() { return runner.RunOp(); }, results);
+        (void)LogSetAsync(false);
+    }
+    LogSetLevel(LOG_LEVEL_WARN);
+    ok = ok && RunLatencyBench("OpRunner/RunOp/log_filtered", opts.iterations, [&]() { return runner.RunOp(); },
+        results);
+    LogSetLevel(level);
+
+    // 8. per tile path choice in MishCustom: input whose tiles all take one path, with the ReduceMax/ReduceMin
+    // of every tile (adaptive attribute on) and without it (the default, every tile on the clamped full path)
+    ok = ok && RunPathBenchmarks(opts, opDesc, runner, results);
+
+    // 9. core partitioning of sizes that do not divide evenly: per core ranges on GM burst boundaries against
+    // the plain 32 byte split, reported as effective bandwidth
+    ok = ok && RunPartitionBenchmarks(opts, stream, results);
+
+    // 10. a large tensor on the device alone and co-executed with host threads at the adapted split
+    ok = ok && RunCoExecBenchmarks(opts, results);
+
+    (void)aclrtFree(workspace);
+    (void)aclrtDestroyStream(stream);
+    (void)aclDestroyTensor(x);
+    (void)aclDestroyTensor(y);
+    (void)aclrtFree(devMem);
+    return ok;
+}
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        return FAILED;
+    }
+    if (!InitResource()) {
+        ERROR_LOG("Init resource failed");
+        return FAILED;
+    }
+
+    std::vector<BenchResult> results;
+    bool ok = RunBenchmarks(opts, results);
+    DestoryResource();
+    if (!ok || !WriteJson(opts, results)) {
+        return FAILED;
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,493 @@
+/**
+* @file chain_runner.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "chain_runner.h"
+
+#include "aclnn_mish_custom.h"
+#include "aclnn_mish_dropout_custom.h"
+#include "aclnn_gated_mish_custom.h"
+#include "aclnn_matmul_mish_custom.h"
+#include "common.h"
+#include "numa_topology.h"
+#include "trace.h"
+
+size_t ChainTensorDesc::Size() const
+{
+    size_t count = 1;
+    for (auto dim : dims) {
+        count *= static_cast<size_t>(dim);
+    }
+    return count * aclDataTypeSize(dataType);
+}
+
+ChainStep MishStep(const std::string &x, const ChainTensorDesc &y)
+{
+    ChainStep step;
+    step.opType = "MishCustom";
+    step.inputs = { x };
+    step.outputs = { y };
+    step.prepare = [](const std::vector<aclTensor *> &in, const std::vector<aclTensor *> &out,
+        uint64_t *workspaceSize, aclOpExecutor **handle) {
+        return aclnnMishCustomGetWorkspaceSize(in[0], false, true, out[0], nullptr, workspaceSize, handle);
+    };
+    step.launch = aclnnMishCustom;
+    return step;
+}
+
+ChainStep MishResidualStep(const std::string &x, const ChainTensorDesc &y, const ChainTensorDesc &t)
+{
+    ChainStep step = MishStep(x, y);
+    step.outputs.push_back(t);
+    step.prepare = [](const std::vector<aclTensor *> &in, const std::vector<aclTensor *> &out,
+        uint64_t *workspaceSize, aclOpExecutor **handle) {
+        return aclnnMishCustomGetWorkspaceSize(in[0], false, true, out[0], out[1], workspaceSize, handle);
+    };
+    return step;
+}
+
+ChainStep MishDropoutStep(const std::string &x, float keepProb, int64_t seed, int64_t offset,
+    const ChainTensorDesc &y, const ChainTensorDesc &mask)
+{
+    ChainStep step;
+    step.opType = "MishDropoutCustom";
+    step.inputs = { x };
+    step.outputs = { y, mask };
+    step.prepare = [keepProb, seed, offset](const std::vector<aclTensor *> &in, const std::vector<aclTensor *> &out,
+        uint64_t *workspaceSize, aclOpExecutor **handle) {
+        return aclnnMishDropoutCustomGetWorkspaceSize(in[0], keepProb, seed, offset, out[0], out[1], workspaceSize,
+            handle);
+    };
+    step.launch = aclnnMishDropoutCustom;
+    return step;
+}
+
+ChainStep GatedMishStep(const std::string &x, const ChainTensorDesc &y)
+{
+    ChainStep step;
+    step.opType = "GatedMishCustom";
+    step.inputs = { x };
+    step.outputs = { y };
+    step.prepare = [](const std::vector<aclTensor *> &in, const std::vector<aclTensor *> &out,
+        uint64_t *workspaceSize, aclOpExecutor **handle) {
+        return aclnnGatedMishCustomGetWorkspaceSize(in[0], out[0], workspaceSize, handle);
+    };
+    step.launch = aclnnGatedMishCustom;
+    return step;
+}
+
+ChainStep MatmulMishStep(const std::string &a, const std::string &b, const std::string &bias,
+    const ChainTensorDesc &y)
+{
+    ChainStep step;
+    step.opType = "MatmulMishCustom";
+    step.inputs = { a, b, bias };
+    step.outputs = { y };
+    step.prepare = [](const std::vector<aclTensor *> &in, const std::vector<aclTensor *> &out,
+        uint64_t *workspaceSize, aclOpExecutor **handle) {
+        return aclnnMatmulMishCustomGetWorkspaceSize(in[0], in[1], in[2], out[0], workspaceSize, handle);
+    };
+    step.launch = aclnnMatmulMishCustom;
+    return step;
+}
+
+ChainRunner::~ChainRunner()
+{
+    // a failed run may have left launches queued on the stream, they still use the buffers freed below
+    WaitIdle();
+    for (auto &tensor : tensors_) {
+        if (tensor.tensor != nullptr) {
+            (void)aclDestroyTensor(tensor.tensor);
+        }
+        if (tensor.isOutput) {
+            (void)aclrtFree(tensor.dev);
+        }
+        if (tensor.host == nullptr) {
+            continue;
+        }
+        if (g_isDevice) {
+            (void)aclrtFree(tensor.host);
+        } else {
+            (void)aclrtFreeHost(tensor.host);
+        }
+    }
+    for (auto &block : pool_) {
+        (void)aclrtFree(block.dev);
+    }
+    if (workspace_ != nullptr) {
+        (void)aclrtFree(workspace_);
+    }
+    if (stream_ != nullptr) {
+        (void)aclrtDestroyStream(stream_);
+    }
+}
+
+bool ChainRunner::Define(const ChainTensorDesc &desc, int producer)
+{
+    if (initialized_) {
+        ERROR_LOG("Chain is already initialized, can not add %s", desc.name.c_str());
+        return false;
+    }
+    if (desc.name.empty() || index_.count(desc.name) != 0) {
+        ERROR_LOG("Chain tensor name \"%s\" is empty or already used", desc.name.c_str());
+        return false;
+    }
+    if (desc.Size() == 0) {
+        ERROR_LOG("Chain tensor %s is empty", desc.name.c_str());
+        return false;
+    }
+    Tensor tensor;
+    tensor.desc = desc;
+    tensor.producer = producer;
+    tensor.isInput = (producer < 0);
+    index_[desc.name] = tensors_.size();
+    tensors_.push_back(tensor);
+    return true;
+}
+
+bool ChainRunner::AddInput(const ChainTensorDesc &desc)
+{
+    return Define(desc, -1);
+}
+
+bool ChainRunner::AddStep(const ChainStep &step)
+{
+    if (!step.prepare || step.launch == nullptr) {
+        ERROR_LOG("Step %zu (%s) has no aclnn functions", steps_.size(), step.opType.c_str());
+        return false;
+    }
+    int stepId = static_cast<int>(steps_.size());
+    for (const auto &name : step.inputs) {
+        if (name.empty()) {
+            continue;
+        }
+        auto it = index_.find(name);
+        if (it == index_.end()) {
+            ERROR_LOG("Step %d (%s) reads %s, which no earlier step writes", stepId, step.opType.c_str(),
+                name.c_str());
+            return false;
+        }
+        tensors_[it->second].lastUse = stepId;
+    }
+    for (const auto &desc : step.outputs) {
+        if (!Define(desc, stepId)) {
+            return false;
+        }
+    }
+    steps_.push_back(step);
+    return true;
+}
+
+bool ChainRunner::AddOutput(const std::string &name)
+{
+    auto it = index_.find(name);
+    if (initialized_ || it == index_.end()) {
+        ERROR_LOG("Can not add chain output %s", name.c_str());
+        return false;
+    }
+    tensors_[it->second].isOutput = true;
+    return true;
+}
+
+const ChainTensorDesc *ChainRunner::FindTensor(const std::string &name) const
+{
+    auto it = index_.find(name);
+    return it == index_.end() ? nullptr : &tensors_[it->second].desc;
+}
+
+void *ChainRunner::GetHostBuffer(const std::string &name)
+{
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+        ERROR_LOG("Unknown chain tensor %s", name.c_str());
+        return nullptr;
+    }
+    return tensors_[it->second].host;
+}
+
+void ChainRunner::PlanPool()
+{
+    std::vector<bool> busy;
+    auto take = [this, &busy](Tensor &tensor) {
+        // best fit among the free blocks; if none is big enough, enlarge the biggest free one
+        // rather than adding a block, the total stays lower that way
+        size_t need = tensor.desc.Size();
+        int best = -1;
+        int biggest = -1;
+        for (size_t i = 0; i < pool_.size(); ++i) {
+            if (busy[i]) {
+                continue;
+            }
+            if (pool_[i].size >= need && (best < 0 || pool_[i].size < pool_[best].size)) {
+                best = static_cast<int>(i);
+            }
+            if (biggest < 0 || pool_[i].size > pool_[biggest].size) {
+                biggest = static_cast<int>(i);
+            }
+        }
+        if (best < 0 && biggest >= 0) {
+            best = biggest;
+            pool_[best].size = need;
+        }
+        if (best < 0) {
+            best = static_cast<int>(pool_.size());
+            pool_.push_back(Block());
+            pool_.back().size = need;
+            busy.push_back(false);
+        }
+        busy[best] = true;
+        tensor.block = best;
+    };
+    auto release = [this, &busy](int step) {
+        for (auto &tensor : tensors_) {
+            int end = tensor.lastUse >= 0 ? tensor.lastUse : tensor.producer;
+            if (tensor.block >= 0 && end == step) {
+                busy[tensor.block] = false;
+            }
+        }
+    };
+
+    for (auto &tensor : tensors_) {
+        if (tensor.isInput && !tensor.isOutput) {
+            take(tensor);
+        }
+    }
+    release(-1);    // inputs nobody reads
+    for (int step = 0; step < static_cast<int>(steps_.size()); ++step) {
+        // a step's outputs never share memory with its inputs, an aclnn op is not required to work in place
+        for (auto &tensor : tensors_) {
+            if (tensor.producer == step && !tensor.isOutput) {
+                take(tensor);
+            }
+        }
+        release(step);
+    }
+}
+
+bool ChainRunner::Allocate()
+{
+    for (size_t i = 0; i < pool_.size(); ++i) {
+        if (aclrtMalloc(&pool_[i].dev, pool_[i].size, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+            pool_[i].dev = nullptr;
+            ERROR_LOG("Malloc device memory for pool block[%zu] failed", i);
+            return false;
+        }
+    }
+    // pinned host buffers on the node chosen by SetHostMemoryNode, as OpRunner does
+    ScopedMemPolicy placement(g_isDevice ? -1 : GetHostMemoryNode());
+    for (auto &tensor : tensors_) {
+        size_t size = tensor.desc.Size();
+        if (tensor.isOutput) {
+            if (aclrtMalloc(&tensor.dev, size, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+                tensor.dev = nullptr;
+                ERROR_LOG("Malloc device memory for %s failed", tensor.desc.name.c_str());
+                return false;
+            }
+        } else {
+            tensor.dev = pool_[tensor.block].dev;
+        }
+        if (tensor.isInput || tensor.isOutput) {
+            aclError ret = g_isDevice ? aclrtMalloc(&tensor.host, size, ACL_MEM_MALLOC_NORMAL_ONLY) :
+                aclrtMallocHost(&tensor.host, size);
+            if (ret != ACL_SUCCESS || tensor.host == nullptr) {
+                tensor.host = nullptr;
+                ERROR_LOG("Malloc host memory for %s failed", tensor.desc.name.c_str());
+                return false;
+            }
+        }
+        const ChainTensorDesc &desc = tensor.desc;
+        tensor.tensor = aclCreateTensor(desc.dims.data(), desc.dims.size(), desc.dataType, nullptr, 0,
+            desc.format, desc.dims.data(), desc.dims.size(), tensor.dev);
+        if (tensor.tensor == nullptr) {
+            ERROR_LOG("Create Tensor for %s failed", desc.name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChainRunner::Init()
+{
+    TRACE_SCOPE("chain init");
+    if (initialized_ || steps_.empty()) {
+        ERROR_LOG("Chain is already initialized or has no step");
+        return false;
+    }
+    bool hasOutput = false;
+    for (const auto &tensor : tensors_) {
+        hasOutput = hasOutput || tensor.isOutput;
+        if (tensor.isInput && tensor.lastUse < 0 && !tensor.isOutput) {
+            WARN_LOG("Chain input %s is never read", tensor.desc.name.c_str());
+        }
+    }
+    if (!hasOutput) {
+        ERROR_LOG("Chain has no output, nothing would be copied back");
+        return false;
+    }
+    initialized_ = true;
+    PlanPool();
+    if (!Allocate()) {
+        return false;
+    }
+    if (aclrtCreateStream(&stream_) != ACL_SUCCESS) {
+        stream_ = nullptr;
+        ERROR_LOG("Create stream failed");
+        return false;
+    }
+    DEBUG_LOG("Chain of %zu steps: %zu bytes in %zu pool blocks for %zu bytes of inputs and intermediates",
+        steps_.size(), GetPooledBytes(), pool_.size(), GetUnpooledBytes());
+    return true;
+}
+
+size_t ChainRunner::GetPooledBytes() const
+{
+    size_t total = 0;
+    for (const auto &block : pool_) {
+        total += block.size;
+    }
+    return total;
+}
+
+size_t ChainRunner::GetUnpooledBytes() const
+{
+    size_t total = 0;
+    for (const auto &tensor : tensors_) {
+        if (!tensor.isOutput) {
+            total += tensor.desc.Size();
+        }
+    }
+    return total;
+}
+
+bool ChainRunner::GrowWorkspace(uint64_t size, aclrtStream stream)
+{
+    if (size <= workspaceSize_) {
+        return true;
+    }
+    // earlier steps of this run may still be reading the old workspace
+    if (workspace_ != nullptr) {
+        if (aclrtSynchronizeStreamWithTimeout(stream, timeoutMs_) != ACL_SUCCESS) {
+            ERROR_LOG("Synchronize stream failed");
+            return false;
+        }
+        (void)aclrtFree(workspace_);
+        workspace_ = nullptr;
+        workspaceSize_ = 0;
+    }
+    if (aclrtMalloc(&workspace_, size, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+        workspace_ = nullptr;
+        ERROR_LOG("Malloc %lu bytes of workspace failed", static_cast<unsigned long>(size));
+        return false;
+    }
+    workspaceSize_ = size;
+    return true;
+}
+
+bool ChainRunner::LaunchSteps()
+{
+    std::vector<aclTensor *> in;
+    std::vector<aclTensor *> out;
+    for (size_t s = 0; s < steps_.size(); ++s) {
+        const ChainStep &step = steps_[s];
+        in.clear();
+        out.clear();
+        for (const auto &name : step.inputs) {
+            in.push_back(name.empty() ? nullptr : tensors_[index_[name]].tensor);
+        }
+        for (const auto &desc : step.outputs) {
+            out.push_back(tensors_[index_[desc.name]].tensor);
+        }
+        uint64_t workspaceSize = 0;
+        aclOpExecutor *handle = nullptr;
+        auto ret = step.prepare(in, out, &workspaceSize, &handle);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Get workspace of step %zu (%s) failed. error code is %d", s, step.opType.c_str(),
+                static_cast<int32_t>(ret));
+            return false;
+        }
+        if (!GrowWorkspace(workspaceSize, stream_)) {
+            return false;
+        }
+        ret = step.launch(workspaceSize == 0 ? nullptr : workspace_, workspaceSize, handle, stream_);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Launch step %zu (%s) failed. error code is %d", s, step.opType.c_str(),
+                static_cast<int32_t>(ret));
+            return false;
+        }
+        DEBUG_LOG("Launched step %zu (%s)", s, step.opType.c_str());
+    }
+    return true;
+}
+
+void ChainRunner::WaitIdle()
+{
+    if (stream_ == nullptr) {
+        return;
+    }
+    auto ret = aclrtSynchronizeStream(stream_);
+    if (ret != ACL_SUCCESS) {
+        WARN_LOG("Synchronize chain stream failed. error code is %d", static_cast<int32_t>(ret));
+    }
+}
+
+bool ChainRunner::Run()
+{
+    if (!initialized_) {
+        ERROR_LOG("Chain is not initialized");
+        return false;
+    }
+    uint64_t traceBegin = TraceBeginNs();
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_HOST_TO_DEVICE;
+    for (auto &tensor : tensors_) {
+        if (!tensor.isInput) {
+            continue;
+        }
+        size_t size = tensor.desc.Size();
+        if (aclrtMemcpy(tensor.dev, size, tensor.host, size, kind) != ACL_SUCCESS) {
+            ERROR_LOG("Copy chain input %s failed", tensor.desc.name.c_str());
+            return false;
+        }
+        ++copyStats_.copies;
+        copyStats_.bytes += size;
+    }
+    TraceEnd("H2D copy", traceBegin);
+
+    traceBegin = TraceBeginNs();
+    if (!LaunchSteps()) {
+        // steps launched before the failing one are still queued
+        WaitIdle();
+        return false;
+    }
+    TraceEnd("launch", traceBegin);
+
+    traceBegin = TraceBeginNs();
+    auto ret = aclrtSynchronizeStreamWithTimeout(stream_, timeoutMs_);
+    if (ret != ACL_SUCCESS) {
+        ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
+        WaitIdle();
+        return false;
+    }
+    TraceEnd("sync", traceBegin);
+
+    traceBegin = TraceBeginNs();
+    kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    for (auto &tensor : tensors_) {
+        if (!tensor.isOutput) {
+            continue;
+        }
+        size_t size = tensor.desc.Size();
+        if (aclrtMemcpy(tensor.host, size, tensor.dev, size, kind) != ACL_SUCCESS) {
+            ERROR_LOG("Copy chain output %s failed", tensor.desc.name.c_str());
+            return false;
+        }
+        ++copyStats_.copies;
+        copyStats_.bytes += size;
+    }
+    TraceEnd("D2H copy", traceBegin);
+    return true;
+}
@@ -9,56 +9,328 @@
 */
 #include "common.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
 extern bool g_isDevice;
 
-bool ReadFile(const std::string &filePath, size_t fileSize, void *buffer, size_t bufferSize)
+namespace {
+std::vector<uint32_t> BuildCrc32Table()
 {
-    struct stat sBuf;
-    int fileStatus = stat(filePath.data(), &sBuf);
-    if (fileStatus == -1) {
-        ERROR_LOG("failed to get file %s", filePath.c_str());
+    std::vector<uint32_t> table(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+        }
+        table[i] = c;
+    }
+    return table;
+}
+}
+
+uint32_t Crc32(const void *data, size_t size, uint32_t crc)
+{
+    static const std::vector<uint32_t> table = BuildCrc32Table();
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+namespace {
+uint32_t HeaderChecksum(const TensorFileHeader &header, const std::vector<TensorFileChunk> &chunks)
+{
+    TensorFileHeader copy = header;
+    copy.headerChecksum = 0;
+    uint32_t crc = Crc32(&copy, sizeof(copy));
+    if (!chunks.empty()) {
+        crc = Crc32(chunks.data(), chunks.size() * sizeof(TensorFileChunk), crc);
+    }
+    return crc;
+}
+
+bool PreadAll(int fd, void *buffer, size_t size, uint64_t offset)
+{
+    char *p = static_cast<char *>(buffer);
+    while (size > 0) {
+        ssize_t ret = pread(fd, p, size, static_cast<off_t>(offset));
+        if (ret <= 0) {
+            return false;
+        }
+        p += ret;
+        size -= static_cast<size_t>(ret);
+        offset += static_cast<uint64_t>(ret);
+    }
+    return true;
+}
+
+bool PwriteAll(int fd, const void *buffer, size_t size, uint64_t offset)
+{
+    const char *p = static_cast<const char *>(buffer);
+    while (size > 0) {
+        ssize_t ret = pwrite(fd, p, size, static_cast<off_t>(offset));
+        if (ret <= 0) {
+            return false;
+        }
+        p += ret;
+        size -= static_cast<size_t>(ret);
+        offset += static_cast<uint64_t>(ret);
+    }
+    return true;
+}
+
+bool CheckHeader(const std::string &filePath, const TensorFileHeader &header)
+{
+    if (memcmp(header.magic, TENSOR_FILE_MAGIC, sizeof(TENSOR_FILE_MAGIC)) != 0 ||
+        header.version != TENSOR_FILE_VERSION || header.headerSize != sizeof(TensorFileHeader)) {
+        ERROR_LOG("%s is not a version %u tensor file", filePath.c_str(), TENSOR_FILE_VERSION);
         return false;
     }
-    if (S_ISREG(sBuf.st_mode) == 0) {
-        ERROR_LOG("%s is not a file, please enter a file", filePath.c_str());
+    if (header.numDims > TENSOR_FILE_MAX_DIMS || header.dataOffset % TENSOR_FILE_ALIGN != 0) {
+        ERROR_LOG("Invalid tensor file header. path = %s", filePath.c_str());
         return false;
     }
+    return true;
+}
+
+// the chunk index and the payload have to lie inside the file, checked before anything is sized from the header
+bool CheckLayout(const std::string &filePath, const TensorFileHeader &header, uint64_t fileSize)
+{
+    if (header.numChunks != 0 && (header.chunkIndexOffset > fileSize ||
+        header.numChunks > (fileSize - header.chunkIndexOffset) / sizeof(TensorFileChunk))) {
+        ERROR_LOG("Tensor file chunk index is out of the file. path = %s", filePath.c_str());
+        return false;
+    }
+    if (header.dataOffset > fileSize || header.dataSize > fileSize - header.dataOffset) {
+        ERROR_LOG("Tensor file is truncated. path = %s", filePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// chunks are aligned, in order and cover the payload without gaps or overlaps
+bool CheckChunks(const std::string &filePath, const TensorFileHeader &header,
+                 const std::vector<TensorFileChunk> &chunks)
+{
+    uint64_t end = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const TensorFileChunk &chunk = chunks[i];
+        if (chunk.offset % TENSOR_FILE_ALIGN != 0 || chunk.offset != end || chunk.size == 0 ||
+            chunk.size > header.dataSize - end) {
+            ERROR_LOG("Chunk %zu does not continue the payload at %lu. path = %s", i,
+                static_cast<unsigned long>(end), filePath.c_str());
+            return false;
+        }
+        end += chunk.size;
+    }
+    if (!chunks.empty() && end != header.dataSize) {
+        ERROR_LOG("Chunks cover %lu of %lu payload bytes. path = %s", static_cast<unsigned long>(end),
+            static_cast<unsigned long>(header.dataSize), filePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ReadHeaderFromFd(int fd, const std::string &filePath, TensorFileHeader &header,
+                      std::vector<TensorFileChunk> &chunks)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !PreadAll(fd, &header, sizeof(header), 0)) {
+        ERROR_LOG("Read tensor file header failed. path = %s", filePath.c_str());
+        return false;
+    }
+    if (!CheckHeader(filePath, header) || !CheckLayout(filePath, header, static_cast<uint64_t>(st.st_size))) {
+        return false;
+    }
+    chunks.resize(header.numChunks);
+    if (header.numChunks != 0 && !PreadAll(fd, chunks.data(), chunks.size() * sizeof(TensorFileChunk),
+        header.chunkIndexOffset)) {
+        ERROR_LOG("Read tensor file chunk index failed. path = %s", filePath.c_str());
+        return false;
+    }
+    if (HeaderChecksum(header, chunks) != header.headerChecksum) {
+        ERROR_LOG("Tensor file header checksum mismatch. path = %s", filePath.c_str());
+        return false;
+    }
+    return CheckChunks(filePath, header, chunks);
+}
 
-    std::ifstream file;
-    file.open(filePath, std::ios::binary);
-    if (!file.is_open()) {
+// the payload is copied as is, so it has to be row major without gaps; dims of 1 may carry any stride
+bool IsContiguous(const TensorFileHeader &header)
+{
+    int64_t expected = 1;
+    for (uint32_t i = header.numDims; i > 0; --i) {
+        if (header.dims[i - 1] != 1 && header.strides[i - 1] != expected) {
+            return false;
+        }
+        expected *= header.dims[i - 1];
+    }
+    return true;
+}
+}
+
+bool ReadTensorFileHeader(const std::string &filePath, TensorFileHeader &header,
+                          std::vector<TensorFileChunk> *chunks)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
         ERROR_LOG("Open file failed. path = %s", filePath.c_str());
         return false;
     }
+    std::vector<TensorFileChunk> index;
+    bool ret = ReadHeaderFromFd(fd, filePath, header, index);
+    (void)close(fd);
+    if (ret && chunks != nullptr) {
+        chunks->swap(index);
+    }
+    return ret;
+}
+
+bool ReadTensorFile(const std::string &filePath, void *buffer, size_t bufferSize)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        ERROR_LOG("Open file failed. path = %s", filePath.c_str());
+        return false;
+    }
+    TensorFileHeader header;
+    std::vector<TensorFileChunk> chunks;
+    if (!ReadHeaderFromFd(fd, filePath, header, chunks)) {
+        (void)close(fd);
+        return false;
+    }
+    if (header.dataSize != bufferSize) {
+        ERROR_LOG("Payload is %lu bytes but the buffer is %zu bytes. path = %s",
+            static_cast<unsigned long>(header.dataSize), bufferSize, filePath.c_str());
+        (void)close(fd);
+        return false;
+    }
+    if (!IsContiguous(header)) {
+        ERROR_LOG("Non contiguous strides are not supported. path = %s", filePath.c_str());
+        (void)close(fd);
+        return false;
+    }
+    if (chunks.empty()) {
+        chunks.push_back({ 0, header.dataSize, header.dataChecksum, 0 });
+    }
+    char *dst = static_cast<char *>(buffer);
+    uint32_t crc = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const TensorFileChunk &chunk = chunks[i];
+        if (!PreadAll(fd, dst + chunk.offset, chunk.size, header.dataOffset + chunk.offset)) {
+            ERROR_LOG("Read chunk %zu failed. path = %s", i, filePath.c_str());
+            (void)close(fd);
+            return false;
+        }
+        uint32_t chunkCrc = Crc32(dst + chunk.offset, chunk.size);
+        if (chunkCrc != chunk.checksum) {
+            ERROR_LOG("Chunk %zu checksum mismatch. path = %s", i, filePath.c_str());
+            (void)close(fd);
+            return false;
+        }
+        crc = Crc32(dst + chunk.offset, chunk.size, crc);
+    }
+    (void)close(fd);
+    if (crc != header.dataChecksum) {
+        ERROR_LOG("Tensor file checksum mismatch. path = %s", filePath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<char> EncodeTensorFileHeader(aclDataType dataType, const std::vector<int64_t> &dims,
+                                         const void *buffer, size_t size, size_t chunkSize)
+{
+    std::vector<char> encoded;
+    if (buffer == nullptr || dims.size() > TENSOR_FILE_MAX_DIMS || chunkSize % TENSOR_FILE_ALIGN != 0) {
+        ERROR_LOG("Encode tensor file failed. at most %u dims and chunk size aligned to %lu are supported",
+            TENSOR_FILE_MAX_DIMS, TENSOR_FILE_ALIGN);
+        return encoded;
+    }
+
+    TensorFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TENSOR_FILE_MAGIC, sizeof(TENSOR_FILE_MAGIC));
+    header.version = TENSOR_FILE_VERSION;
+    header.headerSize = sizeof(TensorFileHeader);
+    header.dataType = dataType;
+    header.format = ACL_FORMAT_ND;
+    header.numDims = static_cast<uint32_t>(dims.size());
+    int64_t stride = 1;
+    for (size_t i = dims.size(); i > 0; --i) {
+        header.dims[i - 1] = dims[i - 1];
+        header.strides[i - 1] = stride;
+        stride *= dims[i - 1];
+    }
+
+    std::vector<TensorFileChunk> chunks;
+    for (size_t offset = 0; chunkSize != 0 && offset < size; offset += chunkSize) {
+        size_t len = std::min(chunkSize, size - offset);
+        chunks.push_back({ offset, len, Crc32(static_cast<const char *>(buffer) + offset, len), 0 });
+    }
+    header.numChunks = static_cast<uint32_t>(chunks.size());
+    header.chunkIndexOffset = chunks.empty() ? 0 : sizeof(TensorFileHeader);
+    uint64_t indexEnd = sizeof(TensorFileHeader) + chunks.size() * sizeof(TensorFileChunk);
+    header.dataOffset = (indexEnd + TENSOR_FILE_ALIGN - 1) / TENSOR_FILE_ALIGN * TENSOR_FILE_ALIGN;
+    header.dataSize = size;
+    header.dataChecksum = Crc32(buffer, size);
+    header.headerChecksum = HeaderChecksum(header, chunks);
+
+    // zero filled up to the payload offset
+    encoded.resize(header.dataOffset, 0);
+    memcpy(encoded.data(), &header, sizeof(header));
+    if (!chunks.empty()) {
+        memcpy(encoded.data() + header.chunkIndexOffset, chunks.data(), chunks.size() * sizeof(TensorFileChunk));
+    }
+    return encoded;
+}
 
-    std::filebuf *buf = file.rdbuf();
-    size_t size = buf->pubseekoff(0, std::ios::end, std::ios::in);
-    if (size == 0) {
-        ERROR_LOG("file size is 0");
-        file.close();
+bool DecodeTensorFile(const std::string &filePath, const void *fileData, size_t fileSize,
+                      TensorFileHeader &header, const void **payload)
+{
+    if (fileSize < sizeof(TensorFileHeader)) {
+        ERROR_LOG("%s is too small to be a tensor file", filePath.c_str());
+        return false;
+    }
+    const char *base = static_cast<const char *>(fileData);
+    memcpy(&header, base, sizeof(header));
+    if (!CheckHeader(filePath, header)) {
+        return false;
+    }
+    if (!CheckLayout(filePath, header, fileSize)) {
+        return false;
+    }
+    std::vector<TensorFileChunk> chunks(header.numChunks);
+    if (!chunks.empty()) {
+        memcpy(chunks.data(), base + header.chunkIndexOffset, chunks.size() * sizeof(TensorFileChunk));
+    }
+    if (HeaderChecksum(header, chunks) != header.headerChecksum) {
+        ERROR_LOG("Tensor file header checksum mismatch. path = %s", filePath.c_str());
+        return false;
+    }
+    if (!CheckChunks(filePath, header, chunks)) {
         return false;
     }
-    if (size > bufferSize) {
-        ERROR_LOG("file size is larger than buffer size");
-        file.close();
+    if (Crc32(base + header.dataOffset, header.dataSize) != header.dataChecksum) {
+        ERROR_LOG("Tensor file checksum mismatch. path = %s", filePath.c_str());
         return false;
     }
-    buf->pubseekpos(0, std::ios::in);
-    buf->sgetn(static_cast<char *>(buffer), size);
-    fileSize = size;
-    file.close();
+    *payload = base + header.dataOffset;
     return true;
 }
 
-bool WriteFile(const std::string &filePath, const void *buffer, size_t size)
+bool WriteTensorFile(const std::string &filePath, aclDataType dataType, const std::vector<int64_t> &dims,
+                     const void *buffer, size_t size, size_t chunkSize)
 {
-    if (buffer == nullptr) {
-        ERROR_LOG("Write file failed. buffer is nullptr");
+    std::vector<char> head = EncodeTensorFileHeader(dataType, dims, buffer, size, chunkSize);
+    if (head.empty()) {
+        ERROR_LOG("Write file failed.");
         return false;
     }
 
@@ -67,13 +339,11 @@ bool WriteFile(const std::string &filePath, const void *buffer, size_t size)
         ERROR_LOG("Open file failed. path = %s", filePath.c_str());
         return false;
     }
-
-    auto writeSize = write(fd, buffer, size);
-    (void) close(fd);
-    if (writeSize != size) {
+    bool ret = PwriteAll(fd, head.data(), head.size(), 0) && PwriteAll(fd, buffer, size, head.size());
+    (void)close(fd);
+    if (!ret) {
         ERROR_LOG("Write file Failed.");
         return false;
     }
-
     return true;
 }
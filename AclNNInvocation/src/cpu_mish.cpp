@@ -0,0 +1,180 @@
+/**
+* @file cpu_mish.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "cpu_mish.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// t rounds to 1.0f from about x = 9 on, and e^x (e^x + 2) is still finite in float at 20
+constexpr float CLAMP_HIGH = 20.0f;
+// slices handed to the workers are whole cache lines of fp16
+constexpr size_t SLICE_ALIGN = 32;
+
+uint64_t NowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// aclFloat16ToFloat and aclFloatToFloat16 are calls into the runtime, too slow per element
+#if defined(__aarch64__)
+inline float HalfToFloat(aclFloat16 value)
+{
+    __fp16 half;
+    memcpy(&half, &value, sizeof(half));
+    return static_cast<float>(half);
+}
+
+inline aclFloat16 FloatToHalf(float value)
+{
+    __fp16 half = static_cast<__fp16>(value);
+    aclFloat16 bits;
+    memcpy(&bits, &half, sizeof(bits));
+    return bits;
+}
+#else
+inline float HalfToFloat(aclFloat16 value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0) {
+        // zero or subnormal, mantissa * 2^-24
+        float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign != 0 ? -magnitude : magnitude;
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline aclFloat16 FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude >= 0x7f800000) {
+        return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0);   // inf, nan stays quiet nan
+    }
+    if (magnitude >= 0x477ff000) {
+        return sign | 0x7c00;   // 65520 and up round to inf
+    }
+    if (magnitude < 0x38800000) {
+        // below the smallest normal: round value * 2^24 to the nearest even integer
+        float scaled;
+        memcpy(&scaled, &magnitude, sizeof(scaled));
+        return sign | static_cast<uint16_t>(std::nearbyint(scaled * 16777216.0f));
+    }
+    // rebias the exponent and round the 13 dropped bits to nearest even, a carry moves into the exponent
+    magnitude += 0xc8000fff + ((magnitude >> 13) & 1);
+    return sign | static_cast<uint16_t>(magnitude >> 13);
+}
+#endif
+}
+
+void CpuMish(const aclFloat16 *x, aclFloat16 *y, aclFloat16 *t, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        float value = HalfToFloat(x[i]);
+        float e = std::exp(std::min(value, CLAMP_HIGH));
+        float n = e * (e + 2.0f);
+        float tanhSoftplus = n / (n + 2.0f);
+        // x * 0 would turn -inf into nan, the kernel's saturated low path writes 0
+        y[i] = FloatToHalf(tanhSoftplus == 0.0f ? 0.0f : value * tanhSoftplus);
+        if (t != nullptr) {
+            t[i] = FloatToHalf(tanhSoftplus);
+        }
+    }
+}
+
+CpuMishPool::CpuMishPool(unsigned threads) : numThreads_(std::max(threads, 1U))
+{
+    for (unsigned i = 0; i < numThreads_; ++i) {
+        workers_.emplace_back([this, i]() { Work(i); });
+    }
+}
+
+CpuMishPool::~CpuMishPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    startCv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void CpuMishPool::Submit(const aclFloat16 *x, aclFloat16 *y, aclFloat16 *t, size_t count)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        x_ = x;
+        y_ = y;
+        t_ = t;
+        count_ = count;
+        remaining_ = NumThreads();
+        submitNs_ = NowNs();
+        finishNs_ = submitNs_;
+        ++generation_;
+    }
+    startCv_.notify_all();
+}
+
+uint64_t CpuMishPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this]() { return remaining_ == 0; });
+    return finishNs_ - submitNs_;
+}
+
+void CpuMishPool::Work(unsigned index)
+{
+    uint64_t seen = 0;
+    for (;;) {
+        const aclFloat16 *x;
+        aclFloat16 *y;
+        aclFloat16 *t;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            startCv_.wait(lock, [this, seen]() { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            x = x_;
+            y = y_;
+            t = t_;
+            count = count_;
+        }
+        size_t slice = (count / NumThreads() + SLICE_ALIGN - 1) / SLICE_ALIGN * SLICE_ALIGN;
+        size_t begin = std::min(count, slice * index);
+        size_t end = index + 1 == NumThreads() ? count : std::min(count, begin + slice);
+        CpuMish(x + begin, y + begin, t == nullptr ? nullptr : t + begin, end - begin);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finishNs_ = std::max(finishNs_, NowNs());
+            if (--remaining_ == 0) {
+                doneCv_.notify_all();
+            }
+        }
+    }
+}
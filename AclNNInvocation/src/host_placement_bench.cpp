@@ -0,0 +1,184 @@
+/**
+* @file host_placement_bench.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "acl/acl.h"
+#include "common.h"
+#include "numa_topology.h"
+
+bool g_isDevice = false;
+int deviceId = 0;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    size_t bytes = 64UL << 20;
+    int iters = 20;
+    std::string numaMap;
+    std::string sysfsRoot;  // fake topology for hosts with a single node
+};
+
+/**
+ * Where the copying thread runs and where its pinned buffer lives, -1 for unrestricted
+ */
+struct Placement {
+    const char *name;
+    int cpuNode;
+    int memNode;
+};
+
+bool ParseOptions(int argc, char **argv, BenchOptions &opts)
+{
+    bool valid = (argc % 2 == 1);
+    for (int i = 1; valid && i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        const char *value = argv[i + 1];
+        if (arg == "--device") {
+            deviceId = atoi(value);
+        } else if (arg == "--size-mb") {
+            opts.bytes = strtoull(value, nullptr, 10) << 20;
+        } else if (arg == "--iters") {
+            opts.iters = atoi(value);
+        } else if (arg == "--numa-map") {
+            opts.numaMap = value;
+        } else if (arg == "--sysfs-root") {
+            opts.sysfsRoot = value;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || opts.bytes == 0 || opts.iters <= 0) {
+        ERROR_LOG("usage: %s [--device N] [--size-mb N] [--iters N] [--numa-map <device:node,...>] "
+            "[--sysfs-root DIR]", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+bool InitResource()
+{
+    if (aclInit("../scripts/acl.json") != ACL_SUCCESS) {
+        ERROR_LOG("acl init failed");
+        return false;
+    }
+    if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
+        ERROR_LOG("Set device failed. deviceId is %d", deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    return true;
+}
+
+void DestoryResource()
+{
+    (void)aclrtResetDevice(deviceId);
+    (void)aclFinalize();
+}
+
+double CopyGBps(void *dst, const void *src, size_t bytes, aclrtMemcpyKind kind, int iters)
+{
+    // first copy pays for page table setup in the driver, keep it out of the number
+    if (aclrtMemcpy(dst, bytes, src, bytes, kind) != ACL_SUCCESS) {
+        return -1;
+    }
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iters; ++i) {
+        if (aclrtMemcpy(dst, bytes, src, bytes, kind) != ACL_SUCCESS) {
+            return -1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(bytes) * iters / seconds / 1e9;
+}
+
+/**
+ * Runs on its own thread so the pinning of one placement does not leak into the next
+ */
+void RunPlacement(const BenchOptions &opts, const NumaTopology &topology, const Placement &placement,
+    void *devMem, bool &ok)
+{
+    ok = false;
+    if (placement.cpuNode >= 0 && !PinThreadToNode(topology, placement.cpuNode)) {
+        return;
+    }
+    void *host = nullptr;
+    {
+        ScopedMemPolicy policy(placement.memNode);
+        if (aclrtMallocHost(&host, opts.bytes) != ACL_SUCCESS || host == nullptr) {
+            ERROR_LOG("%s: malloc %zu bytes of host memory failed", placement.name, opts.bytes);
+            return;
+        }
+        memset(host, 0x3c, opts.bytes);   // fault every page in while the policy holds
+    }
+    double h2d = CopyGBps(devMem, host, opts.bytes, ACL_MEMCPY_HOST_TO_DEVICE, opts.iters);
+    double d2h = CopyGBps(host, devMem, opts.bytes, ACL_MEMCPY_DEVICE_TO_HOST, opts.iters);
+    // the node the pages really ended up on, the policy is only a request
+    printf("%-8s cpu node %3d  mem node %3d (actual %3d)  H2D %7.2f GB/s  D2H %7.2f GB/s\n", placement.name,
+        placement.cpuNode, placement.memNode, NodeOfAddress(host), h2d, d2h);
+    (void)aclrtFreeHost(host);
+    ok = h2d > 0 && d2h > 0;
+}
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        return FAILED;
+    }
+    NumaTopology topology;
+    if (!LoadNumaTopology(opts.sysfsRoot, opts.numaMap, topology)) {
+        return FAILED;
+    }
+    if (!InitResource()) {
+        ERROR_LOG("Init resource failed");
+        return FAILED;
+    }
+    void *devMem = nullptr;
+    if (aclrtMalloc(&devMem, opts.bytes, ACL_MEM_MALLOC_HUGE_FIRST) != ACL_SUCCESS) {
+        ERROR_LOG("Malloc %zu bytes of device memory failed", opts.bytes);
+        DestoryResource();
+        return FAILED;
+    }
+
+    int local = topology.NodeOfDevice(deviceId);
+    std::vector<Placement> placements = { { "default", -1, -1 } };
+    if (local < 0) {
+        WARN_LOG("Numa node of device %d is unknown, pass --numa-map to compare placements", deviceId);
+    } else {
+        placements.push_back({ "local", local, local });
+        for (const auto &node : topology.nodeCpus) {
+            if (node.first != local) {
+                placements.push_back({ "remote", node.first, node.first });
+                placements.push_back({ "split", local, node.first });   // local cpus copying remote memory
+                break;
+            }
+        }
+    }
+    INFO_LOG("device %d on node %d, %zu nodes, %zu MB x %d copies per direction", deviceId, local,
+        topology.nodeCpus.size(), opts.bytes >> 20, opts.iters);
+
+    bool ok = true;
+    for (const auto &placement : placements) {
+        bool placementOk = false;
+        std::thread worker(RunPlacement, std::cref(opts), std::cref(topology), std::cref(placement), devMem,
+            std::ref(placementOk));
+        worker.join();
+        ok = ok && placementOk;
+    }
+    (void)aclrtFree(devMem);
+    DestoryResource();
+    return ok ? SUCCESS : FAILED;
+}
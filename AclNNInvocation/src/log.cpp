@@ -0,0 +1,263 @@
+/**
+* @file log.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "log.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t LOG_RECORD_SIZE = 512;     // longer messages are cut
+constexpr size_t LOG_RING_SIZE = 1024;      // records in flight, a power of two
+constexpr std::chrono::milliseconds LOG_IDLE_WAIT(1);
+
+/**
+ * One ring slot. seq tells who owns it: equal to the claim position it is free for
+ * that producer, position + 1 it holds a formatted record for the writer.
+ */
+struct LogRecord {
+    std::atomic<uint64_t> seq{0};
+    int level = 0;
+    size_t length = 0;
+    char text[LOG_RECORD_SIZE];
+};
+
+std::atomic<int> g_level(LOG_LEVEL_INFO);
+std::atomic<bool> g_async(false);
+std::atomic<int> g_pushing(0);   // producers between checking g_async and publishing
+
+FILE *StreamOf(int level)
+{
+    return level >= LOG_LEVEL_ERROR ? stderr : stdout;
+}
+
+/**
+ * Background writer of the queued records. The records live in a ring allocated once
+ * (bounded MPMC queue, D. Vyukov, with a single consumer): a producer claims a slot with
+ * one CAS, formats into it and publishes it by storing its sequence. The writer polls the
+ * ring and sleeps LOG_IDLE_WAIT when it is empty, so the logging path neither takes a
+ * lock, allocates, nor wakes anyone up. A producer that finds the ring full yields until
+ * the writer frees a slot.
+ */
+class AsyncSink {
+public:
+    AsyncSink() : ring_(LOG_RING_SIZE)
+    {
+        for (size_t i = 0; i < LOG_RING_SIZE; ++i) {
+            ring_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool Start()
+    {
+        stop_.store(false);
+        try {
+            thread_ = std::thread(&AsyncSink::Run, this);
+        } catch (const std::system_error &) {
+            return false;
+        }
+        return true;
+    }
+
+    void Stop()
+    {
+        if (!thread_.joinable()) {
+            return;
+        }
+        stop_.store(true);
+        thread_.join();
+    }
+
+    void Push(int level, const char *fmt, va_list args)
+    {
+        uint64_t pos = claim_.load(std::memory_order_relaxed);
+        LogRecord *record = nullptr;
+        for (;;) {
+            record = &ring_[pos & (LOG_RING_SIZE - 1)];
+            uint64_t seq = record->seq.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (claim_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (seq < pos) {
+                // full: the slot still holds the record from one lap ago
+                std::this_thread::yield();
+                pos = claim_.load(std::memory_order_relaxed);
+            } else {
+                pos = claim_.load(std::memory_order_relaxed);
+            }
+        }
+        record->level = level;
+        int n = vsnprintf(record->text, LOG_RECORD_SIZE, fmt, args);
+        if (n < 0) {
+            n = 0;
+        } else if (static_cast<size_t>(n) >= LOG_RECORD_SIZE) {
+            n = LOG_RECORD_SIZE - 1;
+            record->text[n - 1] = '\n';
+        }
+        record->length = static_cast<size_t>(n);
+        record->seq.store(pos + 1, std::memory_order_release);
+    }
+
+    void Flush()
+    {
+        uint64_t target = claim_.load();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (written_.load() < target && thread_.joinable()) {
+            cv_.wait_for(lock, LOG_IDLE_WAIT);
+        }
+    }
+
+private:
+    void Run()
+    {
+        for (;;) {
+            bool stopping = stop_.load();
+            if (Drain() == 0) {
+                if (stopping && written_.load() == claim_.load()) {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_for(lock, LOG_IDLE_WAIT);
+            }
+        }
+    }
+
+    size_t Drain()
+    {
+        size_t count = 0;
+        uint64_t pos = written_.load(std::memory_order_relaxed);
+        for (;; ++pos, ++count) {
+            LogRecord &record = ring_[pos & (LOG_RING_SIZE - 1)];
+            if (record.seq.load(std::memory_order_acquire) != pos + 1) {
+                break;  // empty, or claimed and not published yet
+            }
+            (void)fwrite(record.text, 1, record.length, StreamOf(record.level));
+            record.seq.store(pos + LOG_RING_SIZE, std::memory_order_release);
+        }
+        if (count != 0) {
+            (void)fflush(stdout);
+            written_.store(pos);
+            cv_.notify_all();
+        }
+        return count;
+    }
+
+    std::vector<LogRecord> ring_;
+    alignas(64) std::atomic<uint64_t> claim_{0};    // next position producers claim
+    alignas(64) std::atomic<uint64_t> written_{0};  // next position the writer reads
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    std::mutex mutex_;              // only for the writer's idle sleep and flush waiters
+    std::condition_variable cv_;
+};
+
+AsyncSink &Sink()
+{
+    static AsyncSink sink;
+    return sink;
+}
+
+void StopAtExit()
+{
+    (void)LogSetAsync(false);
+}
+}
+
+void LogWrite(int level, const char *fmt, ...)
+{
+    if (level < g_level.load(std::memory_order_relaxed)) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    if (level < LOG_LEVEL_ERROR && g_async.load()) {
+        g_pushing.fetch_add(1);
+        if (g_async.load()) {
+            Sink().Push(level, fmt, args);
+            g_pushing.fetch_sub(1);
+            va_end(args);
+            return;
+        }
+        g_pushing.fetch_sub(1);
+    } else if (g_async.load()) {
+        // keep errors after the messages that led to them, and out of the queue in case we are about to die
+        LogFlush();
+    }
+    (void)vfprintf(StreamOf(level), fmt, args);
+    va_end(args);
+}
+
+void LogSetLevel(int level)
+{
+    g_level.store(level, std::memory_order_relaxed);
+}
+
+int LogGetLevel()
+{
+    return g_level.load(std::memory_order_relaxed);
+}
+
+int LogParseLevel(const char *name)
+{
+    const char *names[] = { "debug", "info", "warn", "error" };
+    for (int level = LOG_LEVEL_DEBUG; level <= LOG_LEVEL_ERROR; ++level) {
+        if (strcmp(name, names[level]) == 0) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+bool LogSetAsync(bool async)
+{
+    static std::mutex switchMutex;
+    static bool atExitRegistered = false;
+    std::lock_guard<std::mutex> lock(switchMutex);
+    if (async == g_async.load()) {
+        return true;
+    }
+    if (async) {
+        AsyncSink &sink = Sink();
+        if (!atExitRegistered) {
+            atExitRegistered = (atexit(StopAtExit) == 0);
+        }
+        (void)fflush(stdout);
+        if (!sink.Start()) {
+            return false;
+        }
+        g_async.store(true);
+        return true;
+    }
+    g_async.store(false);
+    // a producer that saw g_async set may still be pushing, its record must be written before the writer stops
+    while (g_pushing.load() != 0) {
+        std::this_thread::yield();
+    }
+    Sink().Stop();
+    return true;
+}
+
+void LogFlush()
+{
+    if (g_async.load()) {
+        Sink().Flush();
+    } else {
+        (void)fflush(stdout);
+    }
+}
@@ -8,48 +8,171 @@
 * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 */
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
 #include "acl/acl.h"
+#include "batch_runner.h"
+#include "chain_runner.h"
+#include "numa_topology.h"
 #include "op_runner.h"
+#include "trace.h"
 
 #include "common.h"
 
 bool g_isDevice = false;
 int deviceId = 0;
 
-OperatorDesc CreateOpDesc()
+const std::string INPUT_FILE = "../input/input_x.bin";
+const std::string OUTPUT_FILE = "../output/output_z.bin";
+const std::string RESIDUAL_FILE = "../output/output_t.bin";
+const std::string MASK_FILE = "../output/output_mask.bin";
+const std::vector<std::string> MATMUL_INPUT_FILES = {
+    "../input/input_a.bin", "../input/input_b.bin", "../input/input_bias.bin"
+};
+
+/**
+ * What to run on input_x.bin: plain MishCustom, MishCustom with the optional
+ * tanh(softplus(x)) output, MishDropoutCustom when keepProb is given, or
+ * GatedMishCustom over the two halves of the last dim. MatmulMishCustom reads
+ * input_a.bin, input_b.bin and input_bias.bin instead. The chain runs
+ * MatmulMishCustom -> MishCustom -> MishCustom -> GatedMishCustom on the
+ * matmul inputs with the intermediates kept on the device.
+ */
+struct RunConfig {
+    bool residual = false;
+    bool gated = false;
+    bool matmul = false;
+    bool chain = false;
+    float keepProb = 0.0f;    // > 0 runs MishDropoutCustom
+    int64_t seed = 0;
+    int64_t offset = 0;
+    bool zeroCopy = false;    // device run mode only: the op's device buffers are the application buffers
+    bool adaptive = false;    // MishCustom picks the compute path per tile
+    bool pathStats = false;   // report the tiles MishCustom ran on each compute path
+    int coExecThreads = -1;   // >= 0 splits MishCustom with that many host threads, 0 for all cpus but one
+};
+
+const std::vector<std::string> &InputFiles(const RunConfig &config)
 {
-    // define operator
-    std::vector<int64_t> shape { 8, 2048 };
-    aclDataType dataType = ACL_FLOAT16;
-    aclFormat format = ACL_FORMAT_ND;
-    OperatorDesc opDesc;
+    static const std::vector<std::string> single = { INPUT_FILE };
+    return config.matmul ? MATMUL_INPUT_FILES : single;
+}
+
+bool CreateMatmulOpDesc(OperatorDesc &opDesc)
+{
+    // y[M, N] = mish(a[M, K] @ b[K, N] + bias[N])
+    std::vector<int64_t> dims[3];
+    for (size_t i = 0; i < MATMUL_INPUT_FILES.size(); ++i) {
+        TensorFileHeader header;
+        if (!ReadTensorFileHeader(MATMUL_INPUT_FILES[i], header)) {
+            ERROR_LOG("Read input header of %s failed", MATMUL_INPUT_FILES[i].c_str());
+            return false;
+        }
+        dims[i].assign(header.dims, header.dims + header.numDims);
+        opDesc.AddInputTensorDesc(static_cast<aclDataType>(header.dataType), header.numDims, header.dims,
+            static_cast<aclFormat>(header.format));
+    }
+    if (dims[0].size() != 2 || dims[1].size() != 2 || dims[2].size() != 1 || dims[0][1] != dims[1][0] ||
+        dims[1][1] != dims[2][0]) {
+        ERROR_LOG("MatmulMishCustom needs a[M, K], b[K, N] and bias[N]");
+        return false;
+    }
+    int64_t outDims[2] = { dims[0][0], dims[1][1] };
+    opDesc.opType = "MatmulMishCustom";
+    opDesc.AddOutputTensorDesc(ACL_FLOAT16, 2, outDims, ACL_FORMAT_ND);
+    return opDesc.inputDesc.size() == 3 && opDesc.outputDesc.size() == 1;
+}
+
+bool CreateOpDesc(OperatorDesc &opDesc, const RunConfig &config)
+{
+    int modes = static_cast<int>(config.residual) + static_cast<int>(config.gated) +
+        static_cast<int>(config.matmul) + static_cast<int>(config.keepProb > 0);
+    if (modes > 1) {
+        ERROR_LOG("--residual, --keep-prob, --gated and --matmul can not be combined");
+        return false;
+    }
+    if (config.matmul) {
+        return CreateMatmulOpDesc(opDesc);
+    }
+    // define operator, dtype and shape come from the input file header
+    TensorFileHeader header;
+    if (!ReadTensorFileHeader(INPUT_FILE, header)) {
+        ERROR_LOG("Read input header failed");
+        return false;
+    }
+    std::vector<int64_t> shape(header.dims, header.dims + header.numDims);
+    aclDataType dataType = static_cast<aclDataType>(header.dataType);
+    aclFormat format = static_cast<aclFormat>(header.format);
     opDesc.AddInputTensorDesc(dataType, shape.size(), shape.data(), format);
+    opDesc.opType = "MishCustom";
+    opDesc.adaptive = config.adaptive;
+    if (config.gated) {
+        // y = x[..., :n/2] * mish(x[..., n/2:])
+        if (shape.empty() || shape.back() % 2 != 0) {
+            ERROR_LOG("GatedMishCustom needs an even last dim");
+            return false;
+        }
+        opDesc.opType = "GatedMishCustom";
+        shape.back() /= 2;
+    }
     opDesc.AddOutputTensorDesc(dataType, shape.size(), shape.data(), format);
-    return opDesc;
+    if (config.keepProb > 0) {
+        // one bit of keep mask per element
+        int64_t elements = 1;
+        for (auto dim : shape) {
+            elements *= dim;
+        }
+        int64_t maskBytes = (elements + 7) / 8;
+        opDesc.opType = "MishDropoutCustom";
+        opDesc.keepProb = config.keepProb;
+        opDesc.seed = config.seed;
+        opDesc.offset = config.offset;
+        opDesc.AddOutputTensorDesc(ACL_UINT8, 1, &maskBytes, format);
+    } else if (config.residual) {
+        // optional output t = tanh(softplus(x)), kept in fp16 for the backward pass
+        opDesc.AddOutputTensorDesc(ACL_FLOAT16, shape.size(), shape.data(), format);
+    }
+    bool twoOutputs = config.residual || config.keepProb > 0;
+    return opDesc.inputDesc.size() == 1 && opDesc.outputDesc.size() == (twoOutputs ? 2 : 1);
 }
 
-bool SetInputData(OpRunner &runner)
+bool SetInputData(OpRunner &runner, const RunConfig &config)
 {
-    size_t fileSize = 0;
-    ReadFile("../input/input_x.bin", fileSize, runner.GetInputBuffer<void>(0), runner.GetInputSize(0));
+    TRACE_SCOPE("file read");
+    const std::vector<std::string> &files = InputFiles(config);
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!ReadTensorFile(files[i], runner.GetInputBuffer<void>(i), runner.GetInputSize(i))) {
+            return false;
+        }
+    }
     INFO_LOG("Set input success");
     return true;
 }
 
-bool ProcessOutputData(OpRunner &runner)
+bool ProcessOutputData(OpRunner &runner, const RunConfig &config)
 {
-    WriteFile("../output/output_z.bin", runner.GetOutputBuffer<void>(0), runner.GetOutputSize(0));
+    TRACE_SCOPE("file write");
+    if (!WriteTensorFile(OUTPUT_FILE, runner.GetOutputDataType(0), runner.GetOutputShape(0),
+        runner.GetOutputBuffer<void>(0), runner.GetOutputSize(0))) {
+        return false;
+    }
+    const std::string &second = config.keepProb > 0 ? MASK_FILE : RESIDUAL_FILE;
+    if (runner.NumOutputs() > 1 && !WriteTensorFile(second, runner.GetOutputDataType(1),
+        runner.GetOutputShape(1), runner.GetOutputBuffer<void>(1), runner.GetOutputSize(1))) {
+        return false;
+    }
     INFO_LOG("Write output success");
     return true;
 }
 
 void DestoryResource()
 {
+    TRACE_SCOPE("DestoryResource");
     bool flag = false;
     if (aclrtResetDevice(deviceId) != ACL_SUCCESS) {
         ERROR_LOG("Reset device %d failed", deviceId);
@@ -82,16 +205,20 @@ bool InitResource()
     }
 
     // acl.json is dump or profiling config file
+    uint64_t traceBegin = TraceBeginNs();
     if (aclInit("../scripts/acl.json") != ACL_SUCCESS) {
         ERROR_LOG("acl init failed");
         return false;
     }
+    TraceEnd("aclInit", traceBegin);
 
+    traceBegin = TraceBeginNs();
     if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
         ERROR_LOG("Set device failed. deviceId is %d", deviceId);
         (void)aclFinalize();
         return false;
     }
+    TraceEnd("aclrtSetDevice", traceBegin);
     INFO_LOG("Set device[%d] success", deviceId);
 
     // runMode is ACL_HOST which represents app is running in host
@@ -108,20 +235,102 @@ bool InitResource()
     return true;
 }
 
-bool RunOp()
+/**
+ * @brief Keep the host side of the copies on one numa node: pin the main thread before
+ * InitResource, so the runtime threads and the io workers started later are pinned too, and
+ * allocate the runners' pinned buffers there.
+ * @param [in] numa: "auto" for the node of deviceId, or a node id
+ * @param [in] numaMap: device to node override in ParseDeviceNodeMap format, may be empty
+ * @return false on a bad option; an unknown device node only warns
+ */
+bool SetupNumaPlacement(const std::string &numa, const std::string &numaMap)
+{
+    NumaTopology topology;
+    if (!LoadNumaTopology("", numaMap, topology)) {
+        return false;
+    }
+    int node = -1;
+    if (numa == "auto") {
+        node = topology.NodeOfDevice(deviceId);
+        if (node < 0) {
+            WARN_LOG("Numa node of device %d is unknown, pass --numa-map to set it; placement unchanged", deviceId);
+            return true;
+        }
+    } else {
+        char *end = nullptr;
+        node = static_cast<int>(strtol(numa.c_str(), &end, 10));
+        if (end == numa.c_str() || *end != '\0' || topology.nodeCpus.count(node) == 0) {
+            ERROR_LOG("Bad --numa %s, expect auto or one of the %zu node ids", numa.c_str(), topology.nodeCpus.size());
+            return false;
+        }
+    }
+    if (!PinThreadToNode(topology, node)) {
+        return false;
+    }
+    SetHostMemoryNode(node);
+    INFO_LOG("Host buffers and copy threads on numa node %d (%zu cpus)", node, topology.nodeCpus[node].size());
+    return true;
+}
+
+/**
+ * @brief Report what a training step has to keep alive between forward and backward.
+ * Composed autograd keeps x plus the fp32 softplus and tanh results; with the residual
+ * output only x and the fp16 t are kept. measuredBytes is the device memory Init took
+ * according to the runtime, which includes the allocator's rounding.
+ */
+void ReportResidualMemory(OpRunner &runner, size_t measuredBytes)
+{
+    size_t count = runner.GetInputElementCount(0);
+    size_t xBytes = runner.GetInputSize(0);
+    size_t composed = xBytes + 2 * count * sizeof(float);
+    size_t fused = xBytes + runner.GetOutputSize(1);
+    INFO_LOG("Device memory of the runner: %zu bytes allocated, %zu bytes measured", runner.GetDeviceMemorySize(),
+        measuredBytes);
+    INFO_LOG("Kept for backward: composed (x + fp32 softplus + fp32 tanh) %zu bytes, "
+        "fused (x + fp16 t) %zu bytes, saved %zu bytes (%.1f%%)", composed, fused, composed - fused,
+        100.0 * (composed - fused) / composed);
+}
+
+bool RunOp(const CompletionOptions &completion, const RunConfig &config)
 {
     // create op desc
-    OperatorDesc opDesc = CreateOpDesc();
+    OperatorDesc opDesc;
+    if (!CreateOpDesc(opDesc, config)) {
+        ERROR_LOG("Create op desc failed");
+        return false;
+    }
 
     // create Runner
     OpRunner opRunner(&opDesc);
+    opRunner.SetCompletion(completion);
+    if (config.zeroCopy && !g_isDevice) {
+        WARN_LOG("--zero-copy only applies in device run mode, host buffers are still staged");
+    }
+    opRunner.SetZeroCopy(config.zeroCopy);
+    if (config.coExecThreads >= 0) {
+        CoExecOptions coExec;
+        coExec.enabled = true;
+        coExec.cpuThreads = static_cast<unsigned>(config.coExecThreads);
+        if (!opRunner.SetCoExecution(coExec)) {
+            ERROR_LOG("--co-exec needs MishCustom without --keep-prob/--gated/--matmul");
+            return false;
+        }
+    }
+    size_t freeBefore = 0;
+    size_t freeAfter = 0;
+    size_t totalMem = 0;
+    (void)aclrtGetMemInfo(ACL_HBM_MEM, &freeBefore, &totalMem);
     if (!opRunner.Init()) {
         ERROR_LOG("Init OpRunner failed");
         return false;
     }
+    (void)aclrtGetMemInfo(ACL_HBM_MEM, &freeAfter, &totalMem);
+    if (opDesc.opType == "MishCustom" && config.residual) {
+        ReportResidualMemory(opRunner, freeBefore > freeAfter ? freeBefore - freeAfter : 0);
+    }
 
     // Load inputs
-    if (!SetInputData(opRunner)) {
+    if (!SetInputData(opRunner, config)) {
         ERROR_LOG("Set input data failed");
         return false;
     }
@@ -133,29 +342,227 @@ bool RunOp()
     }
 
     // process output data
-    if (!ProcessOutputData(opRunner)) {
+    if (!ProcessOutputData(opRunner, config)) {
         ERROR_LOG("Process output data failed");
         return false;
     }
 
+    MishPathCounters paths;
+    if (config.pathStats && opRunner.ReadPathCounters(paths)) {
+        INFO_LOG("Tiles by path: %lu saturated high, %lu saturated low, %lu fast, %lu full of %lu",
+            static_cast<unsigned long>(paths.saturateHigh), static_cast<unsigned long>(paths.saturateLow),
+            static_cast<unsigned long>(paths.fast), static_cast<unsigned long>(paths.full),
+            static_cast<unsigned long>(paths.Total()));
+    } else if (config.pathStats) {
+        WARN_LOG("No path counters in the workspace, --path-stats needs MishCustom without --keep-prob/--gated/--matmul");
+    }
+
+    const CopyStats &copies = opRunner.GetCopyStats();
+    INFO_LOG("Staging copies: %lu, %lu bytes%s", static_cast<unsigned long>(copies.copies),
+        static_cast<unsigned long>(copies.bytes), opRunner.IsZeroCopy() ? " (zero copy)" : "");
     INFO_LOG("Run op success");
     return true;
 }
 
+/**
+ * @brief Build mish(a @ b + bias) -> mish -> mish -> gated mish over the halves of the last dim.
+ * Only a, b and bias go to the device and only the final y comes back.
+ */
+bool BuildMishChain(ChainRunner &chain)
+{
+    const char *names[] = { "a", "b", "bias" };
+    std::vector<int64_t> dims[3];
+    for (size_t i = 0; i < MATMUL_INPUT_FILES.size(); ++i) {
+        TensorFileHeader header;
+        if (!ReadTensorFileHeader(MATMUL_INPUT_FILES[i], header)) {
+            ERROR_LOG("Read input header of %s failed", MATMUL_INPUT_FILES[i].c_str());
+            return false;
+        }
+        ChainTensorDesc desc;
+        desc.name = names[i];
+        desc.dataType = static_cast<aclDataType>(header.dataType);
+        desc.dims.assign(header.dims, header.dims + header.numDims);
+        desc.format = static_cast<aclFormat>(header.format);
+        dims[i] = desc.dims;
+        if (!chain.AddInput(desc)) {
+            return false;
+        }
+    }
+    if (dims[0].size() != 2 || dims[1].size() != 2 || dims[2].size() != 1 || dims[0][1] != dims[1][0] ||
+        dims[1][1] != dims[2][0] || dims[1][1] % 2 != 0) {
+        ERROR_LOG("The chain needs a[M, K], b[K, N] and bias[N] with an even N");
+        return false;
+    }
+    ChainTensorDesc hidden;
+    hidden.dataType = ACL_FLOAT16;
+    hidden.dims = { dims[0][0], dims[1][1] };
+    ChainTensorDesc y = hidden;
+    y.name = "y";
+    y.dims.back() /= 2;
+    ChainTensorDesc h[3] = { hidden, hidden, hidden };
+    h[0].name = "h0";
+    h[1].name = "h1";
+    h[2].name = "h2";
+    return chain.AddStep(MatmulMishStep("a", "b", "bias", h[0])) && chain.AddStep(MishStep("h0", h[1])) &&
+        chain.AddStep(MishStep("h1", h[2])) && chain.AddStep(GatedMishStep("h2", y)) && chain.AddOutput("y");
+}
+
+/**
+ * @brief Whether any option of a single RunOp is set; the chain and batch modes run plain MishCustom
+ */
+bool HasSingleOpOptions(const RunConfig &config)
+{
+    return config.residual || config.gated || config.matmul || config.keepProb > 0 || config.zeroCopy ||
+        config.coExecThreads >= 0;
+}
+
+bool RunChain(const CompletionOptions &completion, const RunConfig &config)
+{
+    if (HasSingleOpOptions(config)) {
+        ERROR_LOG("--chain can not be combined with the single op options");
+        return false;
+    }
+    ChainRunner chain;
+    chain.SetSyncTimeout(completion.timeoutMs);
+    if (!BuildMishChain(chain) || !chain.Init()) {
+        ERROR_LOG("Init ChainRunner failed");
+        return false;
+    }
+    {
+        TRACE_SCOPE("file read");
+        const char *names[] = { "a", "b", "bias" };
+        for (size_t i = 0; i < MATMUL_INPUT_FILES.size(); ++i) {
+            if (!ReadTensorFile(MATMUL_INPUT_FILES[i], chain.GetHostBuffer(names[i]),
+                chain.FindTensor(names[i])->Size())) {
+                return false;
+            }
+        }
+    }
+    if (!chain.Run()) {
+        ERROR_LOG("Run chain failed");
+        return false;
+    }
+    {
+        TRACE_SCOPE("file write");
+        const ChainTensorDesc *y = chain.FindTensor("y");
+        if (!WriteTensorFile(OUTPUT_FILE, y->dataType, y->dims, chain.GetHostBuffer("y"), y->Size())) {
+            return false;
+        }
+    }
+    const CopyStats &copies = chain.GetCopyStats();
+    INFO_LOG("Chain device memory: %zu bytes in %zu blocks, %zu bytes without reuse", chain.GetPooledBytes(),
+        chain.GetPoolBlocks(), chain.GetUnpooledBytes());
+    INFO_LOG("Staging copies: %lu, %lu bytes", static_cast<unsigned long>(copies.copies),
+        static_cast<unsigned long>(copies.bytes));
+    INFO_LOG("Run chain success");
+    return true;
+}
+
 int main(int argc, char **argv)
 {
+    // default runs input_x.bin once, "--manifest <file> [--io-depth N]" runs every pair listed in the file,
+    // "--residual" also writes t = tanh(softplus(x)) to output_t.bin and reports the backward memory,
+    // "--keep-prob P" runs MishDropoutCustom and writes the bit packed mask to output_mask.bin,
+    // "--gated" runs GatedMishCustom, whose output has half the last dim,
+    // "--matmul" runs MatmulMishCustom on input_a.bin, input_b.bin and input_bias.bin,
+    // "--numa auto|<node> [--numa-map 0:0,1:1]" places host buffers and copy threads on the device's numa node
+    // "--log-level debug|info|warn|error" filters messages, "--log-async" hands them to a background writer
+    // "--zero-copy" lets the op work on the application buffers directly in device run mode
+    // "--adaptive" lets MishCustom pick the compute path per tile, "--path-stats" prints how many tiles took each
+    // "--co-exec N" computes a share of MishCustom on N host threads (0 for all cpus but one) beside the device
+    // "--chain" runs matmul mish -> mish -> mish -> gated mish on the matmul inputs without leaving the device
+    std::string manifest;
+    unsigned ioDepth = 4;
+    CompletionOptions completion;
+    RunConfig config;
+    std::string numa;
+    std::string numaMap;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc) {
+            manifest = argv[++i];
+        } else if (strcmp(argv[i], "--io-depth") == 0 && i + 1 < argc) {
+            ioDepth = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--completion") == 0 && i + 1 < argc) {
+            if (!ParseCompletionPolicy(argv[++i], completion.policy)) {
+                return FAILED;
+            }
+        } else if (strcmp(argv[i], "--sync-timeout-ms") == 0 && i + 1 < argc) {
+            completion.timeoutMs = static_cast<int32_t>(strtol(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--spin-us") == 0 && i + 1 < argc) {
+            completion.spinUs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--residual") == 0) {
+            config.residual = true;
+        } else if (strcmp(argv[i], "--matmul") == 0) {
+            config.matmul = true;
+        } else if (strcmp(argv[i], "--gated") == 0) {
+            config.gated = true;
+        } else if (strcmp(argv[i], "--chain") == 0) {
+            config.chain = true;
+        } else if (strcmp(argv[i], "--keep-prob") == 0 && i + 1 < argc) {
+            config.keepProb = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = strtoll(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--offset") == 0 && i + 1 < argc) {
+            config.offset = strtoll(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--numa") == 0 && i + 1 < argc) {
+            numa = argv[++i];
+        } else if (strcmp(argv[i], "--numa-map") == 0 && i + 1 < argc) {
+            numaMap = argv[++i];
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc && LogParseLevel(argv[i + 1]) >= 0) {
+            LogSetLevel(LogParseLevel(argv[++i]));
+        } else if (strcmp(argv[i], "--zero-copy") == 0) {
+            config.zeroCopy = true;
+        } else if (strcmp(argv[i], "--adaptive") == 0) {
+            config.adaptive = true;
+        } else if (strcmp(argv[i], "--path-stats") == 0) {
+            config.pathStats = true;
+        } else if (strcmp(argv[i], "--co-exec") == 0 && i + 1 < argc) {
+            config.coExecThreads = static_cast<int>(strtol(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--log-async") == 0) {
+            if (!LogSetAsync(true)) {
+                ERROR_LOG("Start async log writer failed");
+                return FAILED;
+            }
+        } else {
+            ERROR_LOG("Usage: %s [--manifest <file> [--io-depth N]] [--completion block|spin|hybrid] "
+                "[--sync-timeout-ms N] [--spin-us N] [--residual | --keep-prob P [--seed N] [--offset N] | --gated | --matmul | --chain] "
+                "[--numa auto|<node> [--numa-map <device:node,...>]] [--log-level debug|info|warn|error] [--log-async] [--zero-copy] [--adaptive] [--path-stats] [--co-exec N]",
+                argv[0]);
+            return FAILED;
+        }
+    }
+
+    // placement first: the runtime threads aclInit and aclrtSetDevice start inherit the cpu affinity
+    if (!numa.empty() && !SetupNumaPlacement(numa, numaMap)) {
+        return FAILED;
+    }
     if (!InitResource()) {
         ERROR_LOG("Init resource failed");
         return FAILED;
     }
     INFO_LOG("Init resource success");
 
-    if (!RunOp()) {
+    bool ok = false;
+    if (!manifest.empty()) {
+        // the batch runs plain MishCustom and writes output 0 of every file
+        if (HasSingleOpOptions(config) || config.chain || config.adaptive || config.pathStats) {
+            ERROR_LOG("--manifest can not be combined with --chain or the single op options");
+        } else {
+            ok = RunBatch(manifest, ioDepth, completion);
+        }
+    } else if (config.chain) {
+        ok = RunChain(completion, config);
+    } else {
+        ok = RunOp(completion, config);
+    }
+    if (!ok) {
         DestoryResource();
+        (void)TraceDump();
         return FAILED;
     }
 
     DestoryResource();
+    (void)TraceDump();
 
     return SUCCESS;
 }
@@ -0,0 +1,185 @@
+/**
+* @file mish_client.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "mish_client.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+#include "log.h"
+
+// glibc older than 2.27 does not define these
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+namespace {
+int CreateMemfd(const char *name)
+{
+#ifdef SYS_memfd_create
+    // glibc older than 2.27 has no memfd_create wrapper
+    return static_cast<int>(syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+#else
+    (void)name;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+}
+
+MishClient::MishClient() = default;
+
+MishClient::~MishClient()
+{
+    Close();
+}
+
+bool MishClient::Connect(const std::string &socketPath, size_t capacity)
+{
+    Close();
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        ERROR_LOG("Socket path too long: %s", socketPath.c_str());
+        return false;
+    }
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    sock_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock_ < 0 || connect(sock_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ERROR_LOG("Connect %s failed: %s", socketPath.c_str(), strerror(errno));
+        Close();
+        return false;
+    }
+
+    memfd_ = CreateMemfd("mish_client");
+    // the server refuses regions that could still shrink under its mapping
+    if (memfd_ < 0 || ftruncate(memfd_, static_cast<off_t>(capacity)) != 0 ||
+        fcntl(memfd_, F_ADD_SEALS, MISH_SERVE_REQUIRED_SEALS) != 0) {
+        ERROR_LOG("Create shared region of %zu bytes failed: %s", capacity, strerror(errno));
+        Close();
+        return false;
+    }
+    region_ = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, memfd_, 0);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        ERROR_LOG("Map shared region failed: %s", strerror(errno));
+        Close();
+        return false;
+    }
+    capacity_ = capacity;
+
+    MishServeRequest request;
+    memset(&request, 0, sizeof(request));
+    request.magic = MISH_SERVE_MAGIC;
+    request.op = MISH_SERVE_REGISTER;
+    request.id = nextId_++;
+    request.regionSize = capacity;
+    MishServeReply reply;
+    if (!Call(request, memfd_, reply) || reply.status != 0) {
+        ERROR_LOG("Register shared region failed");
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MishClient::Close()
+{
+    if (region_ != nullptr) {
+        (void)munmap(region_, capacity_);
+        region_ = nullptr;
+    }
+    capacity_ = 0;
+    if (memfd_ >= 0) {
+        (void)close(memfd_);
+        memfd_ = -1;
+    }
+    if (sock_ >= 0) {
+        (void)close(sock_);
+        sock_ = -1;
+    }
+}
+
+bool MishClient::Run(int32_t dataType, const std::vector<int64_t> &dims, size_t size, uint64_t *serverNs)
+{
+    if (sock_ < 0 || size > capacity_ || dims.size() > MISH_SERVE_MAX_DIMS) {
+        ERROR_LOG("Invalid run request, size %zu, capacity %zu, dims %zu", size, capacity_, dims.size());
+        return false;
+    }
+    MishServeRequest request;
+    memset(&request, 0, sizeof(request));
+    request.magic = MISH_SERVE_MAGIC;
+    request.op = MISH_SERVE_RUN;
+    request.id = nextId_++;
+    request.dataType = dataType;
+    request.numDims = static_cast<uint32_t>(dims.size());
+    for (size_t i = 0; i < dims.size(); ++i) {
+        request.dims[i] = dims[i];
+    }
+    request.offset = 0;
+    request.size = size;
+    request.regionSize = capacity_;
+    MishServeReply reply;
+    if (!Call(request, -1, reply)) {
+        return false;
+    }
+    if (serverNs != nullptr) {
+        *serverNs = reply.serverNs;
+    }
+    if (reply.status != 0) {
+        ERROR_LOG("Server failed request %lu with status %d", static_cast<unsigned long>(reply.id), reply.status);
+        return false;
+    }
+    return true;
+}
+
+bool MishClient::Call(const MishServeRequest &request, int fd, MishServeReply &reply)
+{
+    iovec iov;
+    iov.iov_base = const_cast<MishServeRequest *>(&request);
+    iov.iov_len = sizeof(request);
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    char control[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    if (sendmsg(sock_, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(request))) {
+        ERROR_LOG("Send request failed: %s", strerror(errno));
+        return false;
+    }
+    ssize_t got;
+    do {
+        got = recv(sock_, &reply, sizeof(reply), 0);
+    } while (got < 0 && errno == EINTR);
+    if (got != static_cast<ssize_t>(sizeof(reply)) || reply.magic != MISH_SERVE_MAGIC || reply.id != request.id) {
+        ERROR_LOG("Receive reply failed: %s", got < 0 ? strerror(errno) : "bad reply");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+/**
+* @file mish_loadgen.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+#include "mish_client.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr int32_t ACL_FLOAT16_VALUE = 1;  // aclDataType ACL_FLOAT16, the client does not link acl
+
+struct LoadOptions {
+    std::string socketPath = MISH_SERVE_DEFAULT_SOCKET;
+    int clients = 4;
+    int requests = 1000;      // per client
+    double qps = 0;           // aggregate target rate, 0 sends back to back
+    std::vector<int64_t> shape = { 8, 2048 };
+};
+
+struct ClientResult {
+    std::vector<uint64_t> latencyNs;
+    uint64_t serverNs = 0;
+    int errors = 0;
+};
+
+void Usage(const char *prog)
+{
+    ERROR_LOG("Usage: %s [--socket path] [--clients N] [--requests N] [--qps R] [--shape d0,d1,...]", prog);
+}
+
+bool ParseArgs(int argc, char **argv, LoadOptions &opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--socket") {
+            opts.socketPath = value;
+        } else if (arg == "--clients") {
+            opts.clients = atoi(value.c_str());
+        } else if (arg == "--requests") {
+            opts.requests = atoi(value.c_str());
+        } else if (arg == "--qps") {
+            opts.qps = atof(value.c_str());
+        } else if (arg == "--shape") {
+            opts.shape.clear();
+            std::stringstream ss(value);
+            std::string dim;
+            while (std::getline(ss, dim, ',')) {
+                opts.shape.push_back(atoll(dim.c_str()));
+            }
+        } else {
+            return false;
+        }
+    }
+    return opts.clients > 0 && opts.requests > 0 && !opts.shape.empty();
+}
+
+void RunClient(const LoadOptions &opts, Clock::time_point start, int index, ClientResult &result)
+{
+    size_t count = 1;
+    for (int64_t dim : opts.shape) {
+        count *= static_cast<size_t>(dim);
+    }
+    size_t size = count * sizeof(uint16_t);
+    MishClient client;
+    if (!client.Connect(opts.socketPath, size)) {
+        result.errors = opts.requests;
+        return;
+    }
+    // each client gets an even share of the target rate, offset so clients do not fire together
+    std::chrono::nanoseconds interval(opts.qps > 0 ? static_cast<int64_t>(1e9 * opts.clients / opts.qps) : 0);
+    Clock::time_point next = start + interval * index / opts.clients;
+    uint16_t *data = static_cast<uint16_t *>(client.Buffer());
+    result.latencyNs.reserve(opts.requests);
+    for (int r = 0; r < opts.requests; ++r) {
+        if (interval.count() > 0) {
+            std::this_thread::sleep_until(next);
+        } else {
+            next = Clock::now();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = static_cast<uint16_t>(0x3c00 + ((i + r) & 0x3ff));  // fp16 values in [1, 2)
+        }
+        uint64_t serverNs = 0;
+        if (!client.Run(ACL_FLOAT16_VALUE, opts.shape, size, &serverNs)) {
+            ++result.errors;
+            continue;
+        }
+        // measured from the scheduled send time, so a slow server also delays later requests
+        result.latencyNs.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - next).count()));
+        result.serverNs += serverNs;
+        next += interval;
+    }
+}
+
+double Percentile(const std::vector<uint64_t> &sorted, double q)
+{
+    size_t idx = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)] / 1e3;
+}
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions opts;
+    if (!ParseArgs(argc, argv, opts)) {
+        Usage(argv[0]);
+        return 1;
+    }
+    std::vector<ClientResult> results(opts.clients);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < opts.clients; ++i) {
+        threads.emplace_back(RunClient, std::cref(opts), start, i, std::ref(results[i]));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<uint64_t> latency;
+    uint64_t serverNs = 0;
+    int errors = 0;
+    for (auto &r : results) {
+        latency.insert(latency.end(), r.latencyNs.begin(), r.latencyNs.end());
+        serverNs += r.serverNs;
+        errors += r.errors;
+    }
+    if (latency.empty()) {
+        ERROR_LOG("no request succeeded, is mish_server running on %s?", opts.socketPath.c_str());
+        return 1;
+    }
+    std::sort(latency.begin(), latency.end());
+    printf("clients %d, requests %zu, errors %d, wall %.3f s, qps %.1f\n", opts.clients, latency.size(), errors,
+        wall, latency.size() / wall);
+    printf("latency(us) p50 %.1f  p90 %.1f  p99 %.1f  p999 %.1f  max %.1f  server avg %.1f\n",
+        Percentile(latency, 0.5), Percentile(latency, 0.9), Percentile(latency, 0.99), Percentile(latency, 0.999),
+        latency.back() / 1e3, serverNs / 1e3 / latency.size());
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+/**
+* @file mish_py.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "acl/acl.h"
+#include "common.h"
+#include "op_runner.h"
+
+namespace py = pybind11;
+
+bool g_isDevice = false;
+int deviceId = 0;
+
+namespace {
+/**
+ * DLPack v0.8 ABI, only the parts needed to hand host tensors across frameworks.
+ * See https://github.com/dmlc/dlpack/blob/main/include/dlpack/dlpack.h
+ */
+constexpr int32_t DL_CPU = 1;
+constexpr int32_t DL_CUDA_HOST = 3;
+constexpr uint8_t DL_FLOAT = 2;
+
+struct DLDevice {
+    int32_t device_type;
+    int32_t device_id;
+};
+
+struct DLDataType {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+};
+
+struct DLTensor {
+    void *data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t *shape;
+    int64_t *strides;
+    uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void *manager_ctx;
+    void (*deleter)(DLManagedTensor *self);
+};
+
+bool g_initialized = false;
+
+class MishRunner;
+
+/**
+ * Runners whose OpRunner still holds device and pinned host memory. Every entry point
+ * runs under the GIL, which also guards this set.
+ */
+std::set<MishRunner *> &LiveRunners()
+{
+    static std::set<MishRunner *> runners;
+    return runners;
+}
+
+void ReleaseRunners();
+
+void ResetAndFinalize()
+{
+    g_initialized = false;
+    (void)aclrtResetDevice(deviceId);
+    (void)aclFinalize();
+}
+
+/**
+ * finalize(): the runtime can not be torn down under buffers it still has to free, so
+ * refuse while any Runner is alive. numpy views and DLPack exports keep their Runner
+ * alive, drop them as well.
+ */
+void Finalize()
+{
+    if (!g_initialized) {
+        return;
+    }
+    if (!LiveRunners().empty()) {
+        throw std::runtime_error(std::to_string(LiveRunners().size()) +
+            " Runner objects are still alive, delete them and their input/output views before finalize()");
+    }
+    ResetAndFinalize();
+}
+
+/**
+ * At exit the remaining runners free their buffers first; any later call on them raises.
+ */
+void FinalizeAtExit()
+{
+    if (!g_initialized) {
+        return;
+    }
+    ReleaseRunners();
+    ResetAndFinalize();
+}
+
+void Init(int device, const std::string &aclConfig)
+{
+    if (g_initialized) {
+        return;
+    }
+    if (aclInit(aclConfig.empty() ? nullptr : aclConfig.c_str()) != ACL_SUCCESS) {
+        throw std::runtime_error("acl init failed");
+    }
+    deviceId = device;
+    if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
+        (void)aclFinalize();
+        throw std::runtime_error("set device " + std::to_string(deviceId) + " failed");
+    }
+    aclrtRunMode runMode;
+    if (aclrtGetRunMode(&runMode) != ACL_SUCCESS) {
+        (void)aclrtResetDevice(deviceId);
+        (void)aclFinalize();
+        throw std::runtime_error("get run mode failed");
+    }
+    g_isDevice = (runMode == ACL_DEVICE);
+    g_initialized = true;
+}
+
+bool IsFloat16(const py::dtype &dtype)
+{
+    return dtype.kind() == 'f' && dtype.itemsize() == 2;
+}
+
+aclDataType ToAclDataType(const py::dtype &dtype)
+{
+    // MishCustom only registers float16
+    if (IsFloat16(dtype)) {
+        return ACL_FLOAT16;
+    }
+    throw std::invalid_argument("MishCustom only supports float16, got " + py::str(dtype).cast<std::string>());
+}
+
+/**
+ * One OperatorDesc/OpRunner pair for a fixed shape. Its input and output are pinned host
+ * buffers owned by the runner; numpy views and DLPack exports point straight at them and
+ * keep the Python runner object alive for as long as they exist.
+ */
+class MishRunner {
+public:
+    MishRunner(const std::vector<int64_t> &shape, py::object dtype)
+        : shape_(shape), dtype_(py::dtype::from_args(dtype))
+    {
+        if (!g_initialized) {
+            throw std::runtime_error("call init() before creating a Runner");
+        }
+        aclDataType dataType = ToAclDataType(dtype_);
+        desc_.AddInputTensorDesc(dataType, shape_.size(), shape_.data(), ACL_FORMAT_ND);
+        desc_.AddOutputTensorDesc(dataType, shape_.size(), shape_.data(), ACL_FORMAT_ND);
+        runner_.reset(new OpRunner(&desc_));
+        if (!runner_->Init()) {
+            throw std::runtime_error("init OpRunner failed");
+        }
+        LiveRunners().insert(this);
+    }
+
+    ~MishRunner()
+    {
+        LiveRunners().erase(this);
+    }
+
+    /**
+     * Free the OpRunner while the runtime is still up, used at exit before aclFinalize
+     */
+    void Release()
+    {
+        runner_.reset();
+        LiveRunners().erase(this);
+    }
+
+    py::array Input(py::object self)
+    {
+        return py::array(dtype_, shape_, Op().GetInputBuffer<void>(0), self);
+    }
+
+    py::array Output(py::object self)
+    {
+        py::array out(dtype_, shape_, Op().GetOutputBuffer<void>(0), self);
+        // the next run overwrites it, do not let callers write into it as well
+        out.attr("setflags")(py::arg("write") = false);
+        return out;
+    }
+
+    py::array Run(py::object self, py::object x)
+    {
+        if (!x.is_none()) {
+            SetInput(x);
+        }
+        OpRunner &op = Op();
+        bool ok;
+        {
+            py::gil_scoped_release release;
+            ok = op.RunOp();
+        }
+        if (!ok) {
+            throw std::runtime_error("run MishCustom failed");
+        }
+        return Output(self);
+    }
+
+    void SetInput(py::object x)
+    {
+        (void)Op();
+        if (py::hasattr(x, "__dlpack__") && !py::isinstance<py::array>(x)) {
+            SetInputFromDlpack(x.attr("__dlpack__")());
+            return;
+        }
+        if (PyCapsule_CheckExact(x.ptr())) {
+            SetInputFromDlpack(x);
+            return;
+        }
+        py::array array = py::array::ensure(x, py::array::c_style);
+        if (!array || array.dtype().itemsize() != dtype_.itemsize() || array.dtype().kind() != dtype_.kind()) {
+            throw std::invalid_argument("input must be a C contiguous array of dtype " +
+                py::str(dtype_).cast<std::string>());
+        }
+        CheckInputShape(array.ndim(), array.shape());
+        void *dst = Op().GetInputBuffer<void>(0);
+        // r.run(r.input) after filling the view in place needs no copy at all
+        if (array.data() != dst) {
+            memcpy(dst, array.data(), Op().GetInputSize(0));
+        }
+    }
+
+    py::capsule OutputDlpack(py::object self)
+    {
+        struct Context {
+            DLManagedTensor tensor;
+            std::vector<int64_t> shape;
+            PyObject *owner;
+        };
+        std::unique_ptr<Context> ctx(new Context());
+        ctx->shape = shape_;
+        ctx->owner = self.release().ptr();
+        DLTensor &t = ctx->tensor.dl_tensor;
+        t.data = const_cast<void *>(Op().GetOutputBuffer<void>(0));
+        t.device = { DL_CPU, 0 };
+        t.ndim = static_cast<int32_t>(ctx->shape.size());
+        t.dtype = { DL_FLOAT, static_cast<uint8_t>(dtype_.itemsize() * 8), 1 };
+        t.shape = ctx->shape.data();
+        t.strides = nullptr;
+        t.byte_offset = 0;
+        ctx->tensor.manager_ctx = ctx.get();
+        ctx->tensor.deleter = [](DLManagedTensor *self) {
+            Context *c = static_cast<Context *>(self->manager_ctx);
+            // consumers may call this from any thread
+            py::gil_scoped_acquire acquire;
+            Py_DECREF(c->owner);
+            delete c;
+        };
+        DLManagedTensor *managed = &ctx.release()->tensor;
+        return py::capsule(managed, "dltensor", [](PyObject *capsule) {
+            // a consumer renames the capsule to "used_dltensor" and owns the tensor from then on
+            if (PyCapsule_IsValid(capsule, "dltensor")) {
+                auto *tensor = static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule, "dltensor"));
+                tensor->deleter(tensor);
+            }
+        });
+    }
+
+    const std::vector<int64_t> &Shape() const
+    {
+        return shape_;
+    }
+
+private:
+    OpRunner &Op() const
+    {
+        if (runner_ == nullptr) {
+            throw std::runtime_error("the Runner was released when acl was finalized");
+        }
+        return *runner_;
+    }
+
+    void CheckInputShape(size_t ndim, const py::ssize_t *dims) const
+    {
+        bool same = ndim == shape_.size();
+        for (size_t i = 0; same && i < ndim; ++i) {
+            same = dims[i] == shape_[i];
+        }
+        if (!same) {
+            throw std::invalid_argument("input shape does not match the runner shape");
+        }
+    }
+
+    void SetInputFromDlpack(py::object capsuleObj)
+    {
+        PyObject *capsule = capsuleObj.ptr();
+        auto *managed = static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule, "dltensor"));
+        if (managed == nullptr) {
+            throw py::error_already_set();
+        }
+        const DLTensor &t = managed->dl_tensor;
+        std::string error;
+        if (t.device.device_type != DL_CPU && t.device.device_type != DL_CUDA_HOST) {
+            error = "DLPack tensor must live in host memory";
+        } else if (t.dtype.code != DL_FLOAT || t.dtype.bits != dtype_.itemsize() * 8 || t.dtype.lanes != 1) {
+            error = "DLPack tensor dtype does not match the runner";
+        } else if (t.ndim != static_cast<int32_t>(shape_.size()) ||
+            !std::equal(shape_.begin(), shape_.end(), t.shape)) {
+            error = "DLPack tensor shape does not match the runner";
+        } else if (t.strides != nullptr) {
+            int64_t expect = 1;
+            for (int32_t i = t.ndim - 1; i >= 0 && error.empty(); --i) {
+                if (t.shape[i] != 1 && t.strides[i] != expect) {
+                    error = "DLPack tensor must be C contiguous";
+                }
+                expect *= t.shape[i];
+            }
+        }
+        if (error.empty()) {
+            // the device can only DMA from memory the runtime pinned, so foreign memory is copied once
+            memcpy(Op().GetInputBuffer<void>(0), static_cast<const char *>(t.data) + t.byte_offset,
+                Op().GetInputSize(0));
+        }
+        // consumed either way: take ownership and release the producer's tensor
+        PyCapsule_SetName(capsule, "used_dltensor");
+        if (managed->deleter != nullptr) {
+            managed->deleter(managed);
+        }
+        if (!error.empty()) {
+            throw std::invalid_argument(error);
+        }
+    }
+
+    std::vector<int64_t> shape_;
+    py::dtype dtype_;
+    OperatorDesc desc_;
+    std::unique_ptr<OpRunner> runner_;
+};
+
+/**
+ * Object form of a runner output for from_dlpack() style consumers
+ * (numpy.from_dlpack, torch.from_dlpack), which want __dlpack__/__dlpack_device__.
+ */
+class DlpackOutput {
+public:
+    explicit DlpackOutput(py::object runner) : runner_(runner) {}
+
+    py::capsule Dlpack(py::object stream)
+    {
+        (void)stream;  // host memory, nothing to synchronize
+        return runner_.cast<MishRunner &>().OutputDlpack(runner_);
+    }
+
+    py::tuple DlpackDevice() const
+    {
+        return py::make_tuple(DL_CPU, 0);
+    }
+
+private:
+    py::object runner_;
+};
+
+void ReleaseRunners()
+{
+    // Release erases from the set
+    while (!LiveRunners().empty()) {
+        (*LiveRunners().begin())->Release();
+    }
+}
+}
+
+PYBIND11_MODULE(mish_acl, m)
+{
+    m.doc() = "MishCustom runner over pinned host buffers";
+    m.def("init", &Init, py::arg("device_id") = 0, py::arg("acl_config") = "",
+        "aclInit and set the device, once per process");
+    m.def("finalize", &Finalize, "reset the device and aclFinalize, refused while a Runner is alive");
+    py::module::import("atexit").attr("register")(py::cpp_function(&FinalizeAtExit));
+
+    py::class_<MishRunner>(m, "Runner")
+        .def(py::init<const std::vector<int64_t> &, py::object>(), py::arg("shape"),
+            py::arg("dtype") = "float16")
+        .def_property_readonly("shape", &MishRunner::Shape)
+        .def_property_readonly("input", [](py::object self) { return self.cast<MishRunner &>().Input(self); },
+            "writable view of the pinned input buffer, fill it in place to skip the input copy")
+        .def_property_readonly("output", [](py::object self) { return self.cast<MishRunner &>().Output(self); },
+            "read only view of the pinned output buffer, overwritten by the next run")
+        .def("set_input", &MishRunner::SetInput, py::arg("x"),
+            "copy a numpy array, a DLPack capsule or an object with __dlpack__ into the input buffer")
+        .def("run", [](py::object self, py::object x) { return self.cast<MishRunner &>().Run(self, x); },
+            py::arg("x") = py::none(), "run the op, optionally setting the input first, and return output")
+        .def("output_dlpack", [](py::object self) { return self.cast<MishRunner &>().OutputDlpack(self); },
+            "DLPack capsule of the output buffer")
+        .def("output_tensor", [](py::object self) { return DlpackOutput(self); },
+            "output as an object accepted by numpy.from_dlpack / torch.from_dlpack");
+
+    py::class_<DlpackOutput>(m, "DlpackOutput")
+        .def("__dlpack__", &DlpackOutput::Dlpack, py::arg("stream") = py::none())
+        .def("__dlpack_device__", &DlpackOutput::DlpackDevice);
+}
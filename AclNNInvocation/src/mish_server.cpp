@@ -0,0 +1,369 @@
+/**
+* @file mish_server.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "acl/acl.h"
+#include "common.h"
+#include "mish_client.h"
+#include "runner_cache.h"
+
+bool g_isDevice = false;
+int deviceId = 0;
+
+namespace {
+// distinct shapes kept warm at once, each one holds device and pinned host buffers
+constexpr size_t MAX_CACHED_RUNNERS = 16;
+// the socket is only for the user running the server
+constexpr mode_t SOCKET_UMASK = 0177;
+
+volatile sig_atomic_t g_stop = 0;
+
+void OnSignal(int)
+{
+    g_stop = 1;
+}
+
+uint64_t NowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool InitResource()
+{
+    if (aclInit("../scripts/acl.json") != ACL_SUCCESS) {
+        ERROR_LOG("acl init failed");
+        return false;
+    }
+    if (aclrtSetDevice(deviceId) != ACL_SUCCESS) {
+        ERROR_LOG("Set device failed. deviceId is %d", deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    INFO_LOG("Set device[%d] success", deviceId);
+    aclrtRunMode runMode;
+    if (aclrtGetRunMode(&runMode) != ACL_SUCCESS) {
+        ERROR_LOG("Get run mode failed");
+        (void)aclrtResetDevice(deviceId);
+        (void)aclFinalize();
+        return false;
+    }
+    g_isDevice = (runMode == ACL_DEVICE);
+    return true;
+}
+
+void DestoryResource()
+{
+    bool flag = false;
+    if (aclrtResetDevice(deviceId) != ACL_SUCCESS) {
+        ERROR_LOG("Reset device %d failed", deviceId);
+        flag = true;
+    }
+    if (aclFinalize() != ACL_SUCCESS) {
+        ERROR_LOG("Finalize acl failed");
+        flag = true;
+    }
+    if (flag) {
+        ERROR_LOG("Destory resource failed");
+    } else {
+        INFO_LOG("Destory resource success");
+    }
+}
+
+struct Connection {
+    void *region = nullptr;
+    size_t regionSize = 0;
+    uint64_t requests = 0;
+};
+
+void ReleaseRegion(Connection &conn)
+{
+    if (conn.region != nullptr) {
+        (void)munmap(conn.region, conn.regionSize);
+        conn.region = nullptr;
+        conn.regionSize = 0;
+    }
+}
+
+/**
+ * Long lived owner of the device: the acl context, and through the runner cache the
+ * executors' input/output buffers, are created once and shared by all connections.
+ * Requests run one at a time in the poll loop, the device serializes them anyway.
+ */
+class MishServer {
+public:
+    explicit MishServer(const std::string &socketPath) : socketPath_(socketPath), runners_(MAX_CACHED_RUNNERS) {}
+
+    ~MishServer()
+    {
+        for (auto &item : conns_) {
+            ReleaseRegion(item.second);
+            (void)close(item.first);
+        }
+        if (listenFd_ >= 0) {
+            (void)close(listenFd_);
+            (void)unlink(socketPath_.c_str());
+        }
+    }
+
+    bool Listen()
+    {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socketPath_.size() >= sizeof(addr.sun_path)) {
+            ERROR_LOG("Socket path too long: %s", socketPath_.c_str());
+            return false;
+        }
+        strncpy(addr.sun_path, socketPath_.c_str(), sizeof(addr.sun_path) - 1);
+        (void)unlink(socketPath_.c_str());
+        listenFd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        // bind creates the socket file, under this umask it is 0600 from the start
+        mode_t oldMask = umask(SOCKET_UMASK);
+        bool bound = listenFd_ >= 0 && bind(listenFd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+        (void)umask(oldMask);
+        if (!bound || listen(listenFd_, SOMAXCONN) != 0) {
+            ERROR_LOG("Listen on %s failed: %s", socketPath_.c_str(), strerror(errno));
+            return false;
+        }
+        INFO_LOG("Serving on %s", socketPath_.c_str());
+        return true;
+    }
+
+    void Serve()
+    {
+        std::vector<pollfd> fds;
+        while (!g_stop) {
+            fds.clear();
+            fds.push_back({ listenFd_, POLLIN, 0 });
+            for (auto &item : conns_) {
+                fds.push_back({ item.first, POLLIN, 0 });
+            }
+            int ready = poll(fds.data(), fds.size(), 500);
+            if (ready < 0) {
+                if (errno != EINTR) {
+                    ERROR_LOG("poll failed: %s", strerror(errno));
+                    return;
+                }
+                continue;
+            }
+            for (size_t i = 1; i < fds.size(); ++i) {
+                if (fds[i].revents != 0 && !HandleRequest(fds[i].fd)) {
+                    Drop(fds[i].fd);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd >= 0) {
+                    conns_[fd] = Connection();
+                }
+            }
+        }
+        INFO_LOG("Served %lu requests with %zu cached runners", static_cast<unsigned long>(served_), runners_.Size());
+    }
+
+private:
+    void Drop(int fd)
+    {
+        auto it = conns_.find(fd);
+        if (it != conns_.end()) {
+            ReleaseRegion(it->second);
+            conns_.erase(it);
+        }
+        (void)close(fd);
+    }
+
+    bool HandleRequest(int fd)
+    {
+        MishServeRequest request;
+        iovec iov;
+        iov.iov_base = &request;
+        iov.iov_len = sizeof(request);
+        char control[CMSG_SPACE(sizeof(int))];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t got = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        if (got <= 0) {
+            return false;  // closed by the client
+        }
+        int passedFd = -1;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                memcpy(&passedFd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+        if (got != static_cast<ssize_t>(sizeof(request)) || request.magic != MISH_SERVE_MAGIC) {
+            ERROR_LOG("Malformed request on connection %d", fd);
+            if (passedFd >= 0) {
+                (void)close(passedFd);
+            }
+            return false;
+        }
+
+        uint64_t start = NowNs();
+        Connection &conn = conns_[fd];
+        int status = 0;
+        if (request.op == MISH_SERVE_REGISTER) {
+            status = Register(conn, passedFd, request.regionSize) ? 0 : -1;
+        } else {
+            if (passedFd >= 0) {
+                (void)close(passedFd);
+            }
+            status = (request.op == MISH_SERVE_RUN && Run(conn, request)) ? 0 : -1;
+        }
+
+        MishServeReply reply;
+        reply.magic = MISH_SERVE_MAGIC;
+        reply.status = status;
+        reply.id = request.id;
+        reply.serverNs = NowNs() - start;
+        return send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(reply));
+    }
+
+    bool Register(Connection &conn, int memfd, uint64_t regionSize)
+    {
+        if (memfd < 0 || regionSize == 0) {
+            ERROR_LOG("Register without a shared region");
+            if (memfd >= 0) {
+                (void)close(memfd);
+            }
+            return false;
+        }
+        // an unsealed memfd could be truncated by the client while mapped, and the next access faults the server
+        int seals = fcntl(memfd, F_GET_SEALS);
+        struct stat st;
+        if (seals < 0 || (seals & MISH_SERVE_REQUIRED_SEALS) != MISH_SERVE_REQUIRED_SEALS ||
+            fstat(memfd, &st) != 0 || st.st_size < 0 || static_cast<uint64_t>(st.st_size) < regionSize) {
+            ERROR_LOG("Shared region must be a memfd sealed against shrink and grow, of at least %lu bytes",
+                static_cast<unsigned long>(regionSize));
+            (void)close(memfd);
+            return false;
+        }
+        ReleaseRegion(conn);
+        void *region = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        (void)close(memfd);  // the mapping keeps the memory alive
+        if (region == MAP_FAILED) {
+            ERROR_LOG("Map shared region of %lu bytes failed: %s", static_cast<unsigned long>(regionSize),
+                strerror(errno));
+            return false;
+        }
+        conn.region = region;
+        conn.regionSize = regionSize;
+        return true;
+    }
+
+    /**
+     * @brief The request names an fp16 tensor whose size matches its shape, checked before a
+     * runner (and its device memory) is created for the shape
+     */
+    static bool ValidShape(const MishServeRequest &request)
+    {
+        // MishCustom only takes float16
+        if (request.dataType != ACL_FLOAT16 || request.numDims == 0 || request.numDims > MISH_SERVE_MAX_DIMS) {
+            return false;
+        }
+        uint64_t bytes = aclDataTypeSize(ACL_FLOAT16);
+        for (uint32_t i = 0; i < request.numDims; ++i) {
+            if (request.dims[i] <= 0 ||
+                bytes > std::numeric_limits<uint64_t>::max() / static_cast<uint64_t>(request.dims[i])) {
+                return false;
+            }
+            bytes *= static_cast<uint64_t>(request.dims[i]);
+        }
+        return bytes == request.size;
+    }
+
+    bool Run(Connection &conn, const MishServeRequest &request)
+    {
+        if (conn.region == nullptr || !ValidShape(request) ||
+            request.offset > conn.regionSize || request.size > conn.regionSize - request.offset) {
+            ERROR_LOG("Invalid run request %lu", static_cast<unsigned long>(request.id));
+            return false;
+        }
+        std::vector<int64_t> dims(request.dims, request.dims + request.numDims);
+        OpRunner *runner = runners_.Get(static_cast<aclDataType>(request.dataType), dims);
+        if (runner == nullptr || runner->GetInputSize(0) != request.size) {
+            ERROR_LOG("No runner for request %lu of %lu bytes", static_cast<unsigned long>(request.id),
+                static_cast<unsigned long>(request.size));
+            return false;
+        }
+        char *payload = static_cast<char *>(conn.region) + request.offset;
+        // the runner's host buffers are pinned, the device cannot DMA from the client's memfd directly
+        memcpy(runner->GetInputBuffer<void>(0), payload, request.size);
+        if (!runner->RunOp()) {
+            return false;
+        }
+        memcpy(payload, runner->GetOutputBuffer<void>(0), runner->GetOutputSize(0));
+        ++conn.requests;
+        ++served_;
+        return true;
+    }
+
+    std::string socketPath_;
+    int listenFd_ = -1;
+    std::map<int, Connection> conns_;
+    RunnerCache runners_;
+    uint64_t served_ = 0;
+};
+}
+
+int main(int argc, char **argv)
+{
+    std::string socketPath = MISH_SERVE_DEFAULT_SOCKET;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            deviceId = atoi(argv[++i]);
+        } else {
+            ERROR_LOG("Usage: %s [--socket <path>] [--device <id>]", argv[0]);
+            return FAILED;
+        }
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnSignal;
+    (void)sigaction(SIGINT, &action, nullptr);
+    (void)sigaction(SIGTERM, &action, nullptr);
+
+    if (!InitResource()) {
+        ERROR_LOG("Init resource failed");
+        return FAILED;
+    }
+    bool listening;
+    {
+        // runners free their device memory before the device is reset
+        MishServer server(socketPath);
+        listening = server.Listen();
+        if (listening) {
+            server.Serve();
+        }
+    }
+    DestoryResource();
+    return listening ? SUCCESS : FAILED;
+}
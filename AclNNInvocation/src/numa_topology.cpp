@@ -0,0 +1,251 @@
+/**
+* @file numa_topology.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "numa_topology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "common.h"
+
+namespace {
+// node masks handed to the kernel, enough for any host we run on
+constexpr unsigned long MAX_NODES = 1024;
+constexpr size_t BITS_PER_WORD = 8 * sizeof(unsigned long);
+const char *const ASCEND_PCI_DRIVER = "sys/bus/pci/drivers/devdrv_device_driver";
+
+std::atomic<int> g_hostMemoryNode(-1);
+
+std::string JoinPath(const std::string &root, const std::string &path)
+{
+    if (root.empty()) {
+        return "/" + path;
+    }
+    return root.back() == '/' ? root + path : root + "/" + path;
+}
+
+bool ReadLine(const std::string &path, std::string &line)
+{
+    std::ifstream file(path);
+    return file.is_open() && static_cast<bool>(std::getline(file, line));
+}
+
+std::vector<std::string> ListDir(const std::string &path)
+{
+    std::vector<std::string> names;
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return names;
+    }
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    (void)closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// "0-3,8,10-11" as in cpulist
+bool ParseCpuList(const std::string &text, std::vector<int> &cpus)
+{
+    const char *p = text.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char *end = nullptr;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if (*p == ',') {
+            ++p;
+        }
+    }
+    return true;
+}
+
+long SetMemPolicy(int mode, const unsigned long *mask, unsigned long maxNode)
+{
+    return syscall(SYS_set_mempolicy, mode, mask, maxNode);
+}
+}
+
+int NumaTopology::NodeOfDevice(int32_t deviceId) const
+{
+    auto it = deviceNode.find(deviceId);
+    return it == deviceNode.end() ? -1 : it->second;
+}
+
+bool ParseDeviceNodeMap(const std::string &text, std::map<int32_t, int> &deviceNode)
+{
+    const char *p = text.c_str();
+    while (*p != '\0') {
+        char *end = nullptr;
+        long device = strtol(p, &end, 10);
+        if (end == p || *end != ':') {
+            ERROR_LOG("Bad device to node map \"%s\", expect e.g. 0:0,1:0,2:1", text.c_str());
+            return false;
+        }
+        p = end + 1;
+        long node = strtol(p, &end, 10);
+        if (end == p || device < 0 || node < 0 || (*end != ',' && *end != '\0')) {
+            ERROR_LOG("Bad device to node map \"%s\", expect e.g. 0:0,1:0,2:1", text.c_str());
+            return false;
+        }
+        deviceNode[static_cast<int32_t>(device)] = static_cast<int>(node);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return true;
+}
+
+bool LoadNumaTopology(const std::string &root, const std::string &deviceMap, NumaTopology &topology)
+{
+    topology = NumaTopology();
+    const std::string nodeDir = JoinPath(root, "sys/devices/system/node");
+    for (const auto &name : ListDir(nodeDir)) {
+        if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+            name.find_first_not_of("0123456789", 4) != std::string::npos) {
+            continue;
+        }
+        std::string line;
+        std::vector<int> cpus;
+        if (!ReadLine(nodeDir + "/" + name + "/cpulist", line) || !ParseCpuList(line, cpus)) {
+            WARN_LOG("Skip %s: unreadable cpulist", name.c_str());
+            continue;
+        }
+        topology.nodeCpus[atoi(name.c_str() + 4)] = cpus;
+    }
+    if (topology.nodeCpus.empty()) {
+        ERROR_LOG("No numa node found under %s", nodeDir.c_str());
+        return false;
+    }
+
+    // pci functions sorted by bus address, which is the order the driver numbers the devices in
+    const std::string driverDir = JoinPath(root, ASCEND_PCI_DRIVER);
+    int32_t deviceId = 0;
+    for (const auto &name : ListDir(driverDir)) {
+        if (name.find(':') == std::string::npos) {
+            continue;   // bind, unbind, module, ...
+        }
+        std::string line;
+        int node = ReadLine(driverDir + "/" + name + "/numa_node", line) ? atoi(line.c_str()) : -1;
+        if (node >= 0) {
+            topology.deviceNode[deviceId] = node;
+        }
+        ++deviceId;
+    }
+    if (!deviceMap.empty()) {
+        std::map<int32_t, int> overrides;
+        if (!ParseDeviceNodeMap(deviceMap, overrides)) {
+            return false;
+        }
+        for (const auto &item : overrides) {
+            topology.deviceNode[item.first] = item.second;
+        }
+    }
+    for (const auto &item : topology.deviceNode) {
+        if (topology.nodeCpus.count(item.second) == 0) {
+            ERROR_LOG("Device %d is mapped to node %d, which does not exist", item.first, item.second);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PinThreadToNode(const NumaTopology &topology, int node)
+{
+    auto it = topology.nodeCpus.find(node);
+    if (it == topology.nodeCpus.end() || it->second.empty()) {
+        ERROR_LOG("Node %d has no cpus", node);
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : it->second) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+        ERROR_LOG("Pin thread to node %d failed: %s", node, strerror(ret));
+        return false;
+    }
+    return true;
+}
+
+int NodeOfAddress(const void *addr)
+{
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void *>(addr), MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+void SetHostMemoryNode(int node)
+{
+    g_hostMemoryNode.store(node);
+}
+
+int GetHostMemoryNode()
+{
+    return g_hostMemoryNode.load();
+}
+
+ScopedMemPolicy::ScopedMemPolicy(int node)
+{
+    if (node < 0 || static_cast<unsigned long>(node) >= MAX_NODES) {
+        return;
+    }
+    oldMask_.assign(MAX_NODES / BITS_PER_WORD, 0);
+    if (syscall(SYS_get_mempolicy, &oldMode_, oldMask_.data(), MAX_NODES, nullptr, 0) != 0) {
+        WARN_LOG("Get memory policy failed: %s, host buffers keep the default placement", strerror(errno));
+        return;
+    }
+    std::vector<unsigned long> mask(MAX_NODES / BITS_PER_WORD, 0);
+    mask[node / BITS_PER_WORD] |= 1UL << (node % BITS_PER_WORD);
+    // preferred rather than bound: when the node runs out the pinned allocation falls back to other nodes
+    // instead of failing
+    if (SetMemPolicy(MPOL_PREFERRED, mask.data(), MAX_NODES) != 0) {
+        WARN_LOG("Prefer memory on node %d failed: %s, host buffers keep the default placement", node,
+            strerror(errno));
+        return;
+    }
+    applied_ = true;
+}
+
+ScopedMemPolicy::~ScopedMemPolicy()
+{
+    if (applied_) {
+        (void)SetMemPolicy(oldMode_, oldMode_ == MPOL_DEFAULT ? nullptr : oldMask_.data(), MAX_NODES);
+    }
+}
@@ -9,14 +9,30 @@
 */
 #include "op_runner.h"
 #include "aclnn_mish_custom.h"
+#include "aclnn_mish_dropout_custom.h"
+#include "aclnn_gated_mish_custom.h"
+#include "aclnn_matmul_mish_custom.h"
+#include <algorithm>
+#include <chrono>
 #include <limits>
+#include <thread>
 #include <cassert>
+#include <cstdint>
 #include "acl/acl_op_compiler.h"
 #include "common.h"
+#include "cpu_mish.h"
+#include "numa_topology.h"
+#include "trace.h"
 
 using namespace std;
 
-extern bool g_isDevice;
+namespace {
+// MishCustom writes one slot of 8 int32 per core after the system workspace: { magic, saturate high,
+// saturate low, fast, full, 0, 0, 0 }, for the 8 cores its tiling launches
+constexpr size_t MISH_PATH_SLOTS = 8;
+constexpr size_t MISH_PATH_SLOT_INTS = 8;
+constexpr int32_t MISH_PATH_MAGIC = 0x4D495348;
+}
 
 OpRunner::OpRunner(OperatorDesc *opDesc) : opDesc_(opDesc)
 {
@@ -26,10 +42,19 @@ OpRunner::OpRunner(OperatorDesc *opDesc) : opDesc_(opDesc)
 
 OpRunner::~OpRunner()
 {
+    if (event_ != nullptr) {
+        (void)aclrtDestroyEvent(event_);
+    }
+    if (workspace_ != nullptr) {
+        (void)aclrtFree(workspace_);
+    }
     for (size_t i = 0; i < numInputs_; ++i) {
         (void)aclDestroyTensor(inputTensor_[i]);
         (void)aclDestroyDataBuffer(inputBuffers_[i]);
         (void)aclrtFree(devInputs_[i]);
+        if (IsZeroCopy()) {
+            continue;   // hostInputs_ aliases devInputs_
+        }
         if (g_isDevice) {
             (void)aclrtFree(hostInputs_[i]);
         } else {
@@ -41,6 +66,9 @@ OpRunner::~OpRunner()
         (void)aclDestroyTensor(outputTensor_[i]);
         (void)aclDestroyDataBuffer(outputBuffers_[i]);
         (void)aclrtFree(devOutputs_[i]);
+        if (IsZeroCopy()) {
+            continue;
+        }
         if (g_isDevice) {
             (void)aclrtFree(hostOutputs_[i]);
         } else {
@@ -51,6 +79,9 @@ OpRunner::~OpRunner()
 
 bool OpRunner::Init()
 {
+    TRACE_SCOPE("malloc");
+    // pinned host buffers on the node chosen by SetHostMemoryNode, next to the device
+    ScopedMemPolicy placement(g_isDevice ? -1 : GetHostMemoryNode());
     for (size_t i = 0; i < numInputs_; ++i) {
         auto size = GetInputSize(i);
         void *devMem = nullptr;
@@ -62,7 +93,9 @@ bool OpRunner::Init()
         inputBuffers_.emplace_back(aclCreateDataBuffer(devMem, size));
 
         void *hostInput = nullptr;
-        if (g_isDevice) {
+        if (IsZeroCopy()) {
+            hostInput = devMem;
+        } else if (g_isDevice) {
             if (aclrtMalloc(&hostInput, size, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
                 ERROR_LOG("Malloc device memory for input[%zu] failed", i);
                 return false;
@@ -99,7 +132,9 @@ bool OpRunner::Init()
         outputBuffers_.emplace_back(aclCreateDataBuffer(devMem, size));
 
         void *hostOutput = nullptr;
-        if (g_isDevice) {
+        if (IsZeroCopy()) {
+            hostOutput = devMem;
+        } else if (g_isDevice) {
             if (aclrtMalloc(&hostOutput, size, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
                 ERROR_LOG("Malloc device memory for output[%zu] failed", i);
                 return false;
@@ -138,6 +173,18 @@ const size_t OpRunner::NumOutputs()
     return numOutputs_;
 }
 
+size_t OpRunner::GetDeviceMemorySize() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < devInputs_.size(); ++i) {
+        total += GetInputSize(i);
+    }
+    for (size_t i = 0; i < devOutputs_.size(); ++i) {
+        total += GetOutputSize(i);
+    }
+    return total;
+}
+
 const size_t OpRunner::GetInputSize(size_t index) const
 {
     if (index >= numInputs_) {
@@ -282,10 +329,140 @@ size_t OpRunner::GetOutputElementCount(size_t index) const
     return aclGetTensorDescElementCount(opDesc_->outputDesc[index]);
 }
 
+bool ParseCompletionPolicy(const std::string &name, CompletionPolicy &policy)
+{
+    for (auto candidate : { COMPLETION_BLOCK, COMPLETION_SPIN, COMPLETION_HYBRID }) {
+        if (name == CompletionPolicyName(candidate)) {
+            policy = candidate;
+            return true;
+        }
+    }
+    ERROR_LOG("Unknown completion policy %s, expect block, spin or hybrid", name.c_str());
+    return false;
+}
+
+const char *CompletionPolicyName(CompletionPolicy policy)
+{
+    switch (policy) {
+        case COMPLETION_SPIN:
+            return "spin";
+        case COMPLETION_HYBRID:
+            return "hybrid";
+        default:
+            return "block";
+    }
+}
+
+bool OpRunner::WaitCompletion(aclrtStream stream)
+{
+    if (completion_.policy == COMPLETION_BLOCK) {
+        auto ret = aclrtSynchronizeStreamWithTimeout(stream, completion_.timeoutMs);
+        if (ret != ACL_SUCCESS) {
+            ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
+            return false;
+        }
+        return true;
+    }
+
+    if (event_ == nullptr && aclrtCreateEvent(&event_) != ACL_SUCCESS) {
+        event_ = nullptr;
+        ERROR_LOG("Create event failed");
+        return false;
+    }
+    if (aclrtRecordEvent(event_, stream) != ACL_SUCCESS) {
+        ERROR_LOG("Record event failed");
+        return false;
+    }
+    const uint64_t timeoutNs = completion_.timeoutMs < 0 ? UINT64_MAX :
+        static_cast<uint64_t>(completion_.timeoutMs) * 1000000;
+    const uint64_t spinNs = completion_.policy == COMPLETION_SPIN ? UINT64_MAX :
+        static_cast<uint64_t>(completion_.spinUs) * 1000;
+    const uint64_t start = TraceNowNs();
+    uint64_t elapsed = 0;
+    while (elapsed < spinNs) {
+        aclrtEventRecordedStatus status = ACL_EVENT_RECORDED_STATUS_NOT_READY;
+        if (aclrtQueryEventStatus(event_, &status) != ACL_SUCCESS) {
+            ERROR_LOG("Query event status failed");
+            return false;
+        }
+        if (status == ACL_EVENT_RECORDED_STATUS_COMPLETE) {
+            return true;
+        }
+        elapsed = TraceNowNs() - start;
+        if (elapsed >= timeoutNs) {
+            ERROR_LOG("Wait for stream timed out after %d ms", completion_.timeoutMs);
+            return false;
+        }
+    }
+
+    // hybrid: the launch is longer than the spin budget, stop burning the core
+    int32_t remainingMs = -1;
+    if (completion_.timeoutMs >= 0) {
+        remainingMs = std::max<int32_t>(1, completion_.timeoutMs - static_cast<int32_t>(elapsed / 1000000));
+    }
+    auto ret = aclrtSynchronizeStreamWithTimeout(stream, remainingMs);
+    if (ret != ACL_SUCCESS) {
+        ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
+        return false;
+    }
+    return true;
+}
+
+aclnnStatus OpRunner::PrepareExecutor(const std::vector<aclTensor *> &inputs, const std::vector<aclTensor *> &outputs,
+    uint64_t &workspaceSize, aclOpExecutor *&handle)
+{
+    if (opDesc_->opType == "MishDropoutCustom") {
+        // outputs are y and the bit packed keep mask
+        return aclnnMishDropoutCustomGetWorkspaceSize(inputs[0], opDesc_->keepProb, opDesc_->seed,
+            opDesc_->offset, outputs[0], outputs[1], &workspaceSize, &handle);
+    }
+    if (opDesc_->opType == "GatedMishCustom") {
+        return aclnnGatedMishCustomGetWorkspaceSize(inputs[0], outputs[0], &workspaceSize, &handle);
+    }
+    if (opDesc_->opType == "MatmulMishCustom") {
+        // inputs are a, b and bias
+        return aclnnMatmulMishCustomGetWorkspaceSize(inputs[0], inputs[1], inputs[2],
+            outputs[0], &workspaceSize, &handle);
+    }
+    // the optional second output "t" = tanh(softplus(x)) is only produced when the desc declares it
+    aclTensor *residual = numOutputs_ > 1 ? outputs[1] : nullptr;
+    return aclnnMishCustomGetWorkspaceSize(inputs[0], opDesc_->adaptive, true, outputs[0], residual,
+        &workspaceSize, &handle);
+}
+
+aclnnStatus OpRunner::LaunchExecutor(void *workspace, uint64_t workspaceSize, aclOpExecutor *handle,
+    aclrtStream stream)
+{
+    if (opDesc_->opType == "MishDropoutCustom") {
+        return aclnnMishDropoutCustom(workspace, workspaceSize, handle, stream);
+    }
+    if (opDesc_->opType == "GatedMishCustom") {
+        return aclnnGatedMishCustom(workspace, workspaceSize, handle, stream);
+    }
+    if (opDesc_->opType == "MatmulMishCustom") {
+        return aclnnMatmulMishCustom(workspace, workspaceSize, handle, stream);
+    }
+    return aclnnMishCustom(workspace, workspaceSize, handle, stream);
+}
+
 bool OpRunner::RunOp()
 {
-    for (size_t i = 0; i < numInputs_; ++i) {
+    if (coExec_.enabled) {
+        return RunCoExecution();
+    }
+    return RunOnDevice(inputTensor_, outputTensor_, SIZE_MAX);
+}
+
+bool OpRunner::RunOnDevice(const std::vector<aclTensor *> &inputs, const std::vector<aclTensor *> &outputs,
+    size_t elements)
+{
+    uint64_t traceBegin = TraceBeginNs();
+    // in zero copy mode the application wrote straight into devInputs_, there is nothing to stage
+    for (size_t i = 0; i < numInputs_ && !IsZeroCopy(); ++i) {
         auto size = GetInputSize(i);
+        if (elements != SIZE_MAX) {
+            size = std::min(size, elements * aclDataTypeSize(GetInputDataType(i)));
+        }
         aclrtMemcpyKind kind = ACL_MEMCPY_HOST_TO_DEVICE;
         if (g_isDevice) {
             kind = ACL_MEMCPY_DEVICE_TO_DEVICE;
@@ -294,50 +471,74 @@ bool OpRunner::RunOp()
             ERROR_LOG("Copy input[%zu] failed", i);
             return false;
         }
+        ++copyStats_.copies;
+        copyStats_.bytes += size;
         INFO_LOG("Copy input[%zu] success", i);
     }
+    TraceEnd("H2D copy", traceBegin);
 
+    traceBegin = TraceBeginNs();
     aclrtStream stream = nullptr;
     if (aclrtCreateStream(&stream) != ACL_SUCCESS) {
         ERROR_LOG("Create stream failed");
         return false;
     }
     INFO_LOG("Create stream success");
+    TraceEnd("create stream", traceBegin);
 
-    size_t workspaceSize = 0;
+    traceBegin = TraceBeginNs();
+    uint64_t workspaceSize = 0;
     aclOpExecutor *handle = nullptr;
     //添加计算workspace大小并申请内存代码
-    auto ret = aclnnMishCustomGetWorkspaceSize(inputTensor_[0], outputTensor_[0],
-                                              &workspaceSize, &handle);
+    auto ret = PrepareExecutor(inputs, outputs, workspaceSize, handle);
     if (ret != ACL_SUCCESS) {
         (void)aclrtDestroyStream(stream);
         ERROR_LOG("Get Operator Workspace failed. error code is %d", static_cast<int32_t>(ret));
         return false;
     }
-   
-    void *workspace = nullptr;
-    if (workspaceSize != 0) {
-        if (aclrtMalloc(&workspace, workspaceSize, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
-            ERROR_LOG("Malloc device memory failed");
+    TraceEnd("workspace query", traceBegin);
+
+    // the previous RunOp has synchronized, nothing reads the old workspace any more
+    if (workspaceSize > workspaceSize_) {
+        (void)aclrtFree(workspace_);
+        workspace_ = nullptr;
+        workspaceSize_ = 0;
+        if (aclrtMalloc(&workspace_, workspaceSize, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+            // the op would write its workspace through a null pointer, do not launch it
+            workspace_ = nullptr;
+            lastWorkspaceSize_ = 0;
+            (void)aclrtDestroyStream(stream);
+            ERROR_LOG("Malloc device memory for workspace failed, size is %lu",
+                static_cast<unsigned long>(workspaceSize));
+            return false;
         }
+        workspaceSize_ = workspaceSize;
     }
+    lastWorkspaceSize_ = workspaceSize;
     //添加执行算子代码
-    if (aclnnMishCustom(workspace, workspaceSize, handle, stream) != ACL_SUCCESS) {
+    traceBegin = TraceBeginNs();
+    ret = LaunchExecutor(workspaceSize == 0 ? nullptr : workspace_, workspaceSize, handle, stream);
+    if (ret != ACL_SUCCESS) {
         (void)aclrtDestroyStream(stream);
         ERROR_LOG("Execute Operator failed. error code is %d", static_cast<int32_t>(ret));
         return false;
     }
+    TraceEnd("launch", traceBegin);
 
-    ret = aclrtSynchronizeStreamWithTimeout(stream, 5000);
-    if (ret != SUCCESS) {
-        ERROR_LOG("Synchronize stream failed. error code is %d", static_cast<int32_t>(ret));
+    traceBegin = TraceBeginNs();
+    if (!WaitCompletion(stream)) {
         (void)aclrtDestroyStream(stream);
         return false;
     }
     INFO_LOG("Synchronize stream success");
+    TraceEnd("sync", traceBegin);
 
-    for (size_t i = 0; i < numOutputs_; ++i) {
+    traceBegin = TraceBeginNs();
+    for (size_t i = 0; i < numOutputs_ && !IsZeroCopy(); ++i) {
         auto size = GetOutputSize(i);
+        if (elements != SIZE_MAX) {
+            size = std::min(size, elements * aclDataTypeSize(GetOutputDataType(i)));
+        }
         aclrtMemcpyKind kind = ACL_MEMCPY_DEVICE_TO_HOST;
         if (g_isDevice) {
             kind = ACL_MEMCPY_DEVICE_TO_DEVICE;
@@ -347,13 +548,153 @@ bool OpRunner::RunOp()
             (void)aclrtDestroyStream(stream);
             return false;
         }
+        ++copyStats_.copies;
+        copyStats_.bytes += size;
         INFO_LOG("Copy output[%zu] success", i);
     }
+    TraceEnd("D2H copy", traceBegin);
 
     (void)aclrtDestroyStream(stream);
     return true;
 }
 
+bool OpRunner::IsMishCustom() const
+{
+    // PrepareExecutor runs MishCustom for any opType but the three below
+    return opDesc_->opType != "MishDropoutCustom" && opDesc_->opType != "GatedMishCustom" &&
+        opDesc_->opType != "MatmulMishCustom";
+}
+
+bool OpRunner::SetCoExecution(const CoExecOptions &options)
+{
+    if (options.enabled && (!IsMishCustom() || numInputs_ != 1 || GetInputDataType(0) != ACL_FLOAT16)) {
+        ERROR_LOG("Co-execution needs MishCustom with a single fp16 input");
+        return false;
+    }
+    coExec_ = options;
+    coExec_.maxCpuShare = std::min(std::max(options.maxCpuShare, 0.0), 1.0);
+    coExec_.smoothing = std::min(std::max(options.smoothing, 0.01), 1.0);
+    if (coExecStats_.runs == 0) {
+        coExecStats_.cpuShare = std::min(std::max(options.initialCpuShare, 0.0), coExec_.maxCpuShare);
+    }
+    return true;
+}
+
+bool OpRunner::RunCoExecution()
+{
+    if (cpuPool_ == nullptr) {
+        unsigned threads = coExec_.cpuThreads;
+        if (threads == 0) {
+            unsigned cpus = std::thread::hardware_concurrency();
+            threads = cpus > 1 ? cpus - 1 : 1;
+        }
+        cpuPool_.reset(new CpuMishPool(threads));
+        INFO_LOG("Started %u host threads for co-execution", cpuPool_->NumThreads());
+    }
+
+    // the device gets whole 2048 element units so its per core ranges stay on GM burst boundaries
+    size_t total = GetInputElementCount(0);
+    size_t npuElements = static_cast<size_t>((1.0 - coExecStats_.cpuShare) * total / CO_EXEC_ALIGN + 0.5) *
+        CO_EXEC_ALIGN;
+    npuElements = std::min(npuElements, total / CO_EXEC_ALIGN * CO_EXEC_ALIGN);
+    size_t cpuElements = total - npuElements;
+
+    // the host part starts first and runs beside the staging copies, the launch and the wait; it reads and
+    // writes the application buffers past npuElements, which the device part never touches
+    uint64_t traceBegin = TraceBeginNs();
+    const aclFloat16 *x = static_cast<const aclFloat16 *>(hostInputs_[0]);
+    aclFloat16 *y = static_cast<aclFloat16 *>(hostOutputs_[0]);
+    aclFloat16 *t = numOutputs_ > 1 ? static_cast<aclFloat16 *>(hostOutputs_[1]) : nullptr;
+    if (cpuElements > 0) {
+        cpuPool_->Submit(x + npuElements, y + npuElements, t == nullptr ? nullptr : t + npuElements, cpuElements);
+    }
+
+    bool ok = true;
+    double npuNs = 0;
+    if (npuElements > 0) {
+        // 1-D views of the head of the device buffers, mish is elementwise
+        int64_t head = static_cast<int64_t>(npuElements);
+        std::vector<aclTensor *> inputs;
+        std::vector<aclTensor *> outputs;
+        inputs.push_back(aclCreateTensor(&head, 1, ACL_FLOAT16, nullptr, 0, ACL_FORMAT_ND, &head, 1, devInputs_[0]));
+        for (size_t i = 0; i < numOutputs_; ++i) {
+            outputs.push_back(aclCreateTensor(&head, 1, GetOutputDataType(i), nullptr, 0, ACL_FORMAT_ND, &head, 1,
+                devOutputs_[i]));
+        }
+        ok = std::find(inputs.begin(), inputs.end(), nullptr) == inputs.end() &&
+            std::find(outputs.begin(), outputs.end(), nullptr) == outputs.end();
+        if (!ok) {
+            ERROR_LOG("Create tensors for the device part failed");
+        }
+        auto start = std::chrono::steady_clock::now();
+        ok = ok && RunOnDevice(inputs, outputs, npuElements);
+        npuNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        for (aclTensor *tensor : inputs) {
+            (void)aclDestroyTensor(tensor);
+        }
+        for (aclTensor *tensor : outputs) {
+            (void)aclDestroyTensor(tensor);
+        }
+    }
+    // wait even after a failure, the workers must be off the application buffers before RunOp returns
+    double cpuNs = cpuElements > 0 ? static_cast<double>(cpuPool_->Wait()) : 0;
+    TraceEnd("co-execution", traceBegin);
+    if (!ok) {
+        return false;
+    }
+
+    // rates rather than the share itself are averaged, so a run where one side got nothing keeps the other's
+    auto Smooth = [this](double &average, double sample) {
+        average = average == 0 ? sample : average + coExec_.smoothing * (sample - average);
+    };
+    CoExecStats &stats = coExecStats_;
+    if (cpuElements > 0 && cpuNs > 0) {
+        Smooth(stats.cpuRate, cpuElements / cpuNs);
+    }
+    if (npuElements > 0 && npuNs > 0) {
+        Smooth(stats.npuRate, npuElements / npuNs);
+    }
+    // equal finishing times: the host share is its part of the combined throughput
+    if (stats.cpuRate > 0 && stats.npuRate > 0) {
+        stats.cpuShare = std::min(stats.cpuRate / (stats.cpuRate + stats.npuRate), coExec_.maxCpuShare);
+    }
+    ++stats.runs;
+    stats.lastCpuElements = cpuElements;
+    stats.lastNpuElements = npuElements;
+    stats.lastCpuNs = cpuNs;
+    stats.lastNpuNs = npuNs;
+    INFO_LOG("Co-execution: %zu elements on the device in %.1f us, %zu on %u host threads in %.1f us, "
+        "next host share %.3f", npuElements, npuNs / 1000, cpuElements, cpuPool_->NumThreads(), cpuNs / 1000,
+        stats.cpuShare);
+    return true;
+}
+
+bool OpRunner::ReadPathCounters(MishPathCounters &counters)
+{
+    const size_t bytes = MISH_PATH_SLOTS * MISH_PATH_SLOT_INTS * sizeof(int32_t);
+    if (!IsMishCustom() || workspace_ == nullptr || lastWorkspaceSize_ < bytes) {
+        return false;
+    }
+    std::vector<int32_t> slots(MISH_PATH_SLOTS * MISH_PATH_SLOT_INTS);
+    const uint8_t *tail = static_cast<const uint8_t *>(workspace_) + lastWorkspaceSize_ - bytes;
+    aclrtMemcpyKind kind = g_isDevice ? ACL_MEMCPY_DEVICE_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_HOST;
+    if (aclrtMemcpy(slots.data(), bytes, tail, bytes, kind) != ACL_SUCCESS) {
+        ERROR_LOG("Copy path counters failed");
+        return false;
+    }
+    counters = MishPathCounters();
+    for (size_t core = 0; core < MISH_PATH_SLOTS; ++core) {
+        const int32_t *slot = &slots[core * MISH_PATH_SLOT_INTS];
+        if (slot[0] != MISH_PATH_MAGIC) {
+            return false;   // a kernel without counters, or a core that did not run
+        }
+        counters.saturateHigh += static_cast<uint64_t>(slot[1]);
+        counters.saturateLow += static_cast<uint64_t>(slot[2]);
+        counters.fast += static_cast<uint64_t>(slot[3]);
+        counters.full += static_cast<uint64_t>(slot[4]);
+    }
+    return true;
+}
 
 template<typename T>
 void DoPrintData(const T *data, size_t count, size_t elementsPerRow)
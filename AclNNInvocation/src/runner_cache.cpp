@@ -0,0 +1,72 @@
+/**
+* @file runner_cache.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "runner_cache.h"
+
+#include "common.h"
+
+// the runner keeps a pointer to the desc, members are destroyed runner first
+struct RunnerCache::Entry {
+    OperatorDesc desc;
+    std::unique_ptr<OpRunner> runner;
+    uint64_t lastUse = 0;
+};
+
+RunnerCache::RunnerCache(size_t capacity) : capacity_(capacity) {}
+
+RunnerCache::~RunnerCache() = default;
+
+OpRunner *RunnerCache::Get(aclDataType dataType, const std::vector<int64_t> &dims, aclFormat format)
+{
+    std::string key = std::to_string(dataType) + ":" + std::to_string(format);
+    for (int64_t dim : dims) {
+        key += "," + std::to_string(dim);
+    }
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        it->second->lastUse = ++useClock_;
+        return it->second->runner.get();
+    }
+    if (capacity_ != 0 && entries_.size() >= capacity_) {
+        EvictLeastRecent();
+    }
+    std::unique_ptr<Entry> entry(new Entry());
+    entry->desc.AddInputTensorDesc(dataType, dims.size(), dims.data(), format);
+    entry->desc.AddOutputTensorDesc(dataType, dims.size(), dims.data(), format);
+    entry->runner.reset(new OpRunner(&entry->desc));
+    entry->runner->SetCompletion(completion_);
+    if (!entry->runner->Init()) {
+        ERROR_LOG("Init OpRunner failed");
+        return nullptr;
+    }
+    OpRunner *runner = entry->runner.get();
+    entry->lastUse = ++useClock_;
+    entries_[key] = std::move(entry);
+    return runner;
+}
+
+void RunnerCache::EvictLeastRecent()
+{
+    // the cache is a handful of entries, a scan is cheaper than keeping a list in order
+    auto oldest = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second->lastUse < oldest->second->lastUse) {
+            oldest = it;
+        }
+    }
+    if (oldest != entries_.end()) {
+        INFO_LOG("Evict cached runner %s", oldest->first.c_str());
+        entries_.erase(oldest);
+    }
+}
+
+size_t RunnerCache::Size() const
+{
+    return entries_.size();
+}
@@ -0,0 +1,156 @@
+/**
+* @file trace.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include "trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "common.h"
+
+namespace {
+constexpr size_t TRACE_RING_SIZE = 16384; // events kept per thread, older ones are overwritten
+
+/**
+ * One ring slot. seq is i + 1 once event i is complete in it and 0 while the owner
+ * rewrites it, so the dump can skip a slot that is being overwritten instead of
+ * reading a torn event. The fields are relaxed atomics for the same reason.
+ */
+struct TraceEvent {
+    std::atomic<uint64_t> seq{ 0 };
+    std::atomic<const char *> name{ nullptr };
+    std::atomic<uint64_t> beginNs{ 0 };
+    std::atomic<uint64_t> endNs{ 0 };
+};
+
+/**
+ * Single producer ring, only the owning thread writes, recording never takes a lock.
+ * The dump may run while other threads still record: it reads each slot between two
+ * loads of its seq, a seqlock with a single writer.
+ */
+struct TraceRing {
+    explicit TraceRing(long tid) : tid(tid), head(0) {}
+    long tid;
+    std::atomic<uint64_t> head;
+    TraceEvent events[TRACE_RING_SIZE];
+};
+
+const char *TraceFile()
+{
+    static const char *file = std::getenv("MISH_TRACE_FILE");
+    return file;
+}
+
+std::mutex g_ringsMutex;
+std::vector<std::unique_ptr<TraceRing>> g_rings;
+std::atomic<bool> g_dumped(false);
+
+TraceRing *ThreadRing()
+{
+    // registration is the only locked step and happens once per thread
+    thread_local TraceRing *ring = nullptr;
+    if (ring == nullptr) {
+        std::unique_ptr<TraceRing> created(new TraceRing(syscall(SYS_gettid)));
+        ring = created.get();
+        std::lock_guard<std::mutex> lock(g_ringsMutex);
+        g_rings.emplace_back(std::move(created));
+    }
+    return ring;
+}
+}
+
+bool TraceEnabled()
+{
+    return TraceFile() != nullptr;
+}
+
+uint64_t TraceNowNs()
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void TraceRecord(const char *name, uint64_t beginNs, uint64_t endNs)
+{
+    if (!TraceEnabled() || g_dumped.load(std::memory_order_acquire)) {
+        return;
+    }
+    TraceRing *ring = ThreadRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    TraceEvent &event = ring->events[head % TRACE_RING_SIZE];
+    event.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.beginNs.store(beginNs, std::memory_order_relaxed);
+    event.endNs.store(endNs, std::memory_order_relaxed);
+    event.seq.store(head + 1, std::memory_order_release);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+bool TraceDump()
+{
+    if (!TraceEnabled() || g_dumped.exchange(true)) {
+        return true;
+    }
+    FILE *fp = fopen(TraceFile(), "w");
+    if (fp == nullptr) {
+        ERROR_LOG("Open trace file failed. path = %s", TraceFile());
+        return false;
+    }
+    long pid = static_cast<long>(getpid());
+    bool first = true;
+    fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    std::lock_guard<std::mutex> lock(g_ringsMutex);
+    for (auto &ring : g_rings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        if (begin != 0) {
+            WARN_LOG("Trace ring of thread %ld overflowed, %lu oldest events dropped", ring->tid, begin);
+        }
+        uint64_t skipped = 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            const TraceEvent &event = ring->events[i % TRACE_RING_SIZE];
+            uint64_t seq = event.seq.load(std::memory_order_acquire);
+            const char *name = event.name.load(std::memory_order_relaxed);
+            uint64_t beginNs = event.beginNs.load(std::memory_order_relaxed);
+            uint64_t endNs = event.endNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // the owner wrapped around onto this slot while we read it
+            if (seq != i + 1 || event.seq.load(std::memory_order_relaxed) != seq) {
+                ++skipped;
+                continue;
+            }
+            // trace-event timestamps are microseconds, fractional values keep ns precision
+            fprintf(fp, "%s{\"name\": \"%s\", \"cat\": \"host\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                "\"pid\": %ld, \"tid\": %ld}", first ? "" : ",\n", name, beginNs / 1000.0,
+                (endNs - beginNs) / 1000.0, pid, ring->tid);
+            first = false;
+        }
+        if (skipped != 0) {
+            WARN_LOG("Trace ring of thread %ld was being written during the dump, %lu events skipped", ring->tid,
+                static_cast<unsigned long>(skipped));
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    if (fclose(fp) != 0) {
+        ERROR_LOG("Write trace file failed. path = %s", TraceFile());
+        return false;
+    }
+    INFO_LOG("Write trace to %s", TraceFile());
+    return true;
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+scripts/analyze_pipe_trace.py 的离线测试，输入是 fixtures/pipe_trace 下手写的 csv 指令流：
+三个 tile 的 CopyIn -> Compute -> CopyOut，第三个 CopyIn 开始前 Compute 和 CopyOut 都刚结束。
+只依赖标准库：python3 tests/scripts/test_analyze_pipe_trace.py
+"""
+import json
+import os
+import subprocess
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TRACE = os.path.join(HERE, 'fixtures', 'pipe_trace', 'mish_replay.csv')
+SCRIPT = os.path.join(HERE, '..', '..', 'scripts', 'analyze_pipe_trace.py')
+
+
+def run(*args):
+    result = subprocess.run([sys.executable, SCRIPT, TRACE] + list(args), stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE, universal_newlines=True)
+    return result.returncode, result.stdout
+
+
+def stalls(report):
+    return [(s['type'], s['start'], s['cycles']) for s in report['stalls']]
+
+
+class PipeTraceTest(unittest.TestCase):
+    def test_pipes(self):
+        code, out = run('--json')
+        self.assertEqual(code, 0)
+        report = json.loads(out)
+        self.assertEqual(report['span'], 560)
+        self.assertEqual(report['pipes']['MTE2']['busy'], 300)
+        self.assertEqual(report['pipes']['MTE2']['instr'], 3)
+        self.assertEqual(report['pipes']['V']['busy'], 280)
+        self.assertEqual(report['pipes']['MTE3']['idle'], 450)
+        self.assertAlmostEqual(report['pipes']['S']['util'], 10.0 / 560)
+
+    def test_stalls(self):
+        code, out = run('--json')
+        self.assertEqual(code, 0)
+        # Compute 0 前和 CopyOut 0 前的空闲是流水线填充，不算阻塞；
+        # 200-330 的 CopyIn 空闲里 Compute 在 320、CopyOut 在 330 结束，只记给最后结束的 CopyOut
+        self.assertEqual(stalls(json.loads(out)), [
+            ('Compute waits CopyIn', 180, 20),
+            ('CopyIn waits free buffer (CopyOut)', 200, 130),
+            ('CopyOut waits Compute', 230, 90),
+            ('Compute waits CopyIn', 320, 110),
+            ('CopyOut waits Compute', 330, 180),
+        ])
+
+    def test_min_stall_and_slack(self):
+        code, out = run('--json', '--min-stall', '25')
+        self.assertEqual(code, 0)
+        self.assertNotIn(('Compute waits CopyIn', 180, 20), stalls(json.loads(out)))
+        # slack 为 5 时 320 结束的 Compute 不再算，330 结束的 CopyOut 仍然算
+        code, out = run('--json', '--slack', '5')
+        self.assertEqual(code, 0)
+        self.assertIn(('CopyIn waits free buffer (CopyOut)', 200, 130), stalls(json.loads(out)))
+
+    def test_table(self):
+        code, out = run('--width', '56')
+        self.assertEqual(code, 0)
+        lines = out.splitlines()
+        self.assertEqual(lines[0], 'span: 560')
+        self.assertEqual(lines[1], 'MTE2 |####################             ##########             |')
+        self.assertEqual(lines[3], 'MTE3 |                  #####         #                  #####|')
+        self.assertIn('[STALL] CopyOut waits Compute                  count     2  total        270', lines)
+        self.assertIn('[STALL] CopyIn waits free buffer (CopyOut)     count     1  total        130', lines)
+        self.assertIn('[STALL] Compute waits CopyIn                   count     2  total        130', lines)
+        self.assertFalse([line for line in lines if 'free buffer (Compute)' in line])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,135 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+python 模块 mish_acl（src/mish_py.cpp）在桩运行时上的测试，模块由 tests/CMakeLists.txt 在找到 pybind11 时
+链接 stub/stub_acl.cpp 构建，目录通过 MISH_ACL_MODULE_DIR 传入：
+    MISH_ACL_MODULE_DIR=<build_test>/python python3 tests/scripts/test_mish_py.py
+finalize 和退出时的释放顺序在子进程里检查：桩运行时在 aclFinalize 之后收到 aclrtFree 之类的调用会打印
+"[STUB] <接口> after aclFinalize"。
+"""
+import os
+import subprocess
+import sys
+import textwrap
+import unittest
+
+import numpy as np
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCRIPTS = os.path.join(HERE, '..', '..', 'scripts')
+MODULE_DIR = os.environ.get('MISH_ACL_MODULE_DIR', '')
+sys.path.insert(0, MODULE_DIR)
+sys.path.insert(0, SCRIPTS)
+import mish_acl  # noqa: E402
+from verify_result import compare  # noqa: E402
+
+SHAPE = [8, 2048]
+
+
+def golden(x):
+    x = x.astype(np.float32)
+    return (x * np.tanh(np.log1p(np.exp(x)))).astype(np.float16)
+
+
+def run_python(code):
+    """在新进程里执行 code，返回退出码和合并后的输出"""
+    env = dict(os.environ, PYTHONPATH=os.pathsep.join([MODULE_DIR, SCRIPTS]))
+    result = subprocess.run([sys.executable, '-c', textwrap.dedent(code)], env=env, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, universal_newlines=True)
+    return result.returncode, result.stdout
+
+
+class RunnerTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        mish_acl.init(0, '')
+
+    def setUp(self):
+        self.x = np.random.uniform(-10, 10, SHAPE).astype(np.float16)
+
+    def test_run_in_place(self):
+        runner = mish_acl.Runner(SHAPE, np.float16)
+        self.assertEqual(list(runner.shape), SHAPE)
+        runner.input[...] = self.x
+        output = runner.run()
+        self.assertTrue(compare(output, golden(self.x)))
+        # 输出是只读视图
+        with self.assertRaises(ValueError):
+            output[0, 0] = 0
+
+    def test_set_input_and_dlpack(self):
+        runner = mish_acl.Runner(SHAPE)
+        runner.run(self.x)
+        self.assertTrue(compare(np.from_dlpack(runner.output_tensor()), golden(self.x)))
+        # 带 __dlpack__ 的对象和 capsule 都能作为输入
+        y = golden(self.x)
+        runner.set_input(runner.output_tensor())
+        self.assertTrue(compare(runner.run(), golden(y)))
+        runner.run(y)
+        runner.set_input(runner.output_dlpack())
+        self.assertTrue(compare(runner.run(), golden(golden(y))))
+
+    def test_bad_input(self):
+        runner = mish_acl.Runner(SHAPE)
+        with self.assertRaises(ValueError):
+            runner.set_input(np.zeros([8, 1024], dtype=np.float16))
+        with self.assertRaises(ValueError):
+            runner.set_input(np.zeros(SHAPE, dtype=np.float32))
+        with self.assertRaises(ValueError):
+            mish_acl.Runner(SHAPE, np.float32)
+
+    def test_run_mish_py_script(self):
+        result = subprocess.run([sys.executable, os.path.join(SCRIPTS, 'run_mish_py.py'), '--loops', '3'],
+                                env=dict(os.environ, PYTHONPATH=MODULE_DIR), stdout=subprocess.PIPE,
+                                stderr=subprocess.STDOUT, universal_newlines=True)
+        self.assertEqual(result.returncode, 0, result.stdout)
+        self.assertEqual(result.stdout.count('test pass'), 3)
+
+
+class FinalizeTest(unittest.TestCase):
+    def test_finalize_refused_while_runner_alive(self):
+        code, out = run_python('''
+            import numpy as np
+            import mish_acl
+            mish_acl.init(0, '')
+            runner = mish_acl.Runner([64], np.float16)
+            view = runner.input
+            try:
+                mish_acl.finalize()
+            except RuntimeError as e:
+                print('refused:', e)
+            del runner, view
+            mish_acl.finalize()
+            print('finalized')
+        ''')
+        self.assertEqual(code, 0, out)
+        self.assertIn('refused: 1 Runner objects are still alive', out)
+        self.assertIn('finalized', out)
+        self.assertNotIn('after aclFinalize', out)
+
+    def test_exit_releases_live_runners(self):
+        # 先注册的 atexit 函数后执行，它看到的是模块已经 finalize 过的 runner
+        code, out = run_python('''
+            import atexit
+            import numpy as np
+
+            def late():
+                try:
+                    runner.run()
+                except RuntimeError as e:
+                    print('late call:', e)
+
+            atexit.register(late)
+            import mish_acl
+            mish_acl.init(0, '')
+            runner = mish_acl.Runner([64], np.float16)
+            runner.run(np.ones([64], dtype=np.float16))
+        ''')
+        self.assertEqual(code, 0, out)
+        self.assertIn('late call: the Runner was released when acl was finalized', out)
+        self.assertNotIn('after aclFinalize', out)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,196 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+链接桩运行时的 mish_server 的测试：mish_loadgen 4 个客户端各 200 个请求不能出错；
+再按 inc/mish_client.h 的报文格式直接发请求，覆盖客户端库不会发出的情况：
+没有封口的 memfd、超出共享区的 RUN、没有注册共享区的 RUN 和长度不对的报文，之后服务端仍要正常工作。
+    python3 tests/scripts/test_mish_server.py --server <mish_server_stub> --loadgen <mish_loadgen_stub>
+"""
+import argparse
+import array
+import fcntl
+import mmap
+import os
+import re
+import shutil
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import unittest
+
+import numpy as np
+
+REQUEST_FMT = '<IIQiI8qQQQ'
+REPLY_FMT = '<IiQQ'
+MAGIC = 0x4853494d
+OP_REGISTER = 1
+OP_RUN = 2
+ACL_FLOAT16 = 1
+REGION = 4096
+ELEMENTS = REGION // 2
+
+OPTS = None
+
+
+def mish(x):
+    x = x.astype(np.float32)
+    return (x * np.tanh(np.log1p(np.exp(x)))).astype(np.float16)
+
+
+class RawClient:
+    """直接按报文格式和服务端通信，请求内容不做任何检查"""
+
+    def __init__(self, path):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        self.sock.connect(path)
+        self.next_id = 1
+        self.region = None
+
+    def close(self):
+        if self.region is not None:
+            self.region.close()
+        self.sock.close()
+
+    def call(self, op, fd=-1, dims=(), offset=0, size=0, region_size=0):
+        request_id = self.next_id
+        self.next_id += 1
+        dims = list(dims)
+        payload = struct.pack(REQUEST_FMT, MAGIC, op, request_id, ACL_FLOAT16, len(dims),
+                              *(dims + [0] * (8 - len(dims))), offset, size, region_size)
+        ancillary = []
+        if fd >= 0:
+            ancillary = [(socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array('i', [fd]))]
+        self.sock.sendmsg([payload], ancillary)
+        magic, status, reply_id, _ = struct.unpack(REPLY_FMT, self.sock.recv(64))
+        assert magic == MAGIC and reply_id == request_id
+        return status
+
+    def register(self, sealed=True, size=REGION):
+        fd = os.memfd_create('mish_test', os.MFD_CLOEXEC | (os.MFD_ALLOW_SEALING if sealed else 0))
+        try:
+            os.ftruncate(fd, size)
+            if sealed:
+                fcntl.fcntl(fd, fcntl.F_ADD_SEALS, fcntl.F_SEAL_SHRINK | fcntl.F_SEAL_GROW)
+            status = self.call(OP_REGISTER, fd=fd, region_size=size)
+            if status == 0:
+                self.region = mmap.mmap(fd, size)
+            return status
+        finally:
+            os.close(fd)
+
+    def run(self, dims=(ELEMENTS,), offset=0, size=REGION):
+        return self.call(OP_RUN, dims=dims, offset=offset, size=size, region_size=REGION)
+
+
+class ServerTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.work = tempfile.mkdtemp(prefix='mish_server_')
+        cls.path = os.path.join(cls.work, 'mish.sock')
+        cls.log = open(os.path.join(cls.work, 'server.log'), 'w+')
+        cls.server = subprocess.Popen([OPTS.server, '--socket', cls.path], cwd=cls.work,
+                                      env=dict(os.environ, STUB_ACL_REPORT='1'), stdout=cls.log,
+                                      stderr=subprocess.STDOUT)
+        deadline = time.time() + 10
+        while not os.path.exists(cls.path):
+            if cls.server.poll() is not None or time.time() > deadline:
+                raise RuntimeError('mish_server did not start:\n' + cls.server_log())
+            time.sleep(0.05)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.server.send_signal(signal.SIGTERM)
+        code = cls.server.wait(timeout=30)
+        output = cls.server_log()
+        cls.log.close()
+        shutil.rmtree(cls.work, ignore_errors=True)
+        print(output)
+        # 服务端按信号正常退出，资源在 aclFinalize 之前、同步之后释放
+        if code != 0 or re.search(r'\[STUB\] \w+ (after aclFinalize|with \d+ launches not synchronized)', output):
+            raise AssertionError('mish_server exited with {}'.format(code))
+
+    @classmethod
+    def server_log(cls):
+        cls.log.flush()
+        cls.log.seek(0)
+        return cls.log.read()
+
+    def connect(self):
+        client = RawClient(self.path)
+        self.addCleanup(client.close)
+        return client
+
+    def assert_runs(self, client):
+        x = np.random.uniform(-10, 10, ELEMENTS).astype(np.float16)
+        client.region[:REGION] = x.tobytes()
+        self.assertEqual(client.run(), 0)
+        y = np.frombuffer(client.region[:REGION], dtype=np.float16)
+        np.testing.assert_allclose(y.astype(np.float32), mish(x).astype(np.float32), rtol=1e-2, atol=1e-3)
+
+    def test_loadgen(self):
+        result = subprocess.run([OPTS.loadgen, '--socket', self.path, '--clients', '4', '--requests', '200'],
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True,
+                                timeout=120)
+        self.assertEqual(result.returncode, 0, result.stdout)
+        self.assertRegex(result.stdout, r'clients 4, requests 800, errors 0')
+
+    def test_unsealed_memfd_refused(self):
+        client = self.connect()
+        self.assertNotEqual(client.register(sealed=False), 0)
+        self.assertIn('Shared region must be a memfd sealed against shrink and grow', self.server_log())
+        # 连接还在，换成封口的 memfd 可以继续用
+        self.assertEqual(client.register(), 0)
+        self.assert_runs(client)
+
+    def test_region_smaller_than_claimed(self):
+        client = self.connect()
+        fd = os.memfd_create('mish_test', os.MFD_CLOEXEC | os.MFD_ALLOW_SEALING)
+        try:
+            os.ftruncate(fd, REGION)
+            fcntl.fcntl(fd, fcntl.F_ADD_SEALS, fcntl.F_SEAL_SHRINK | fcntl.F_SEAL_GROW)
+            self.assertNotEqual(client.call(OP_REGISTER, fd=fd, region_size=2 * REGION), 0)
+        finally:
+            os.close(fd)
+
+    def test_run_out_of_range(self):
+        client = self.connect()
+        self.assertEqual(client.register(), 0)
+        # 超出共享区末尾、偏移本身越界、偏移加长度溢出
+        self.assertNotEqual(client.run(offset=REGION // 2), 0)
+        self.assertNotEqual(client.run(dims=(8,), offset=REGION, size=16), 0)
+        self.assertNotEqual(client.run(dims=(8,), offset=2 ** 64 - 8, size=16), 0)
+        # 长度与形状不符
+        self.assertNotEqual(client.run(dims=(ELEMENTS // 2,)), 0)
+        self.assertIn('Invalid run request', self.server_log())
+        self.assert_runs(client)
+
+    def test_run_without_region(self):
+        client = self.connect()
+        self.assertNotEqual(client.run(), 0)
+
+    def test_malformed_request_drops_connection(self):
+        client = self.connect()
+        client.sock.send(b'\0' * 8)
+        self.assertEqual(client.sock.recv(64), b'')
+        # 其他连接不受影响
+        other = self.connect()
+        self.assertEqual(other.register(), 0)
+        self.assert_runs(other)
+
+
+def main():
+    global OPTS
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--server', required=True)
+    parser.add_argument('--loadgen', required=True)
+    OPTS, rest = parser.parse_known_args()
+    unittest.main(argv=[sys.argv[0]] + rest)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,154 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+scripts/parse_msprof.py 的离线测试，输入是 fixtures/msprof 下按 msprof 导出格式手写的 csv：
+    base/           op_summary，MishCustom 两种 shape，夹一条 Cast、一条 GatedMishCustom 和一处 N/A
+    new/            op_summary，8,2048 变快，16,4096 消失，新增 32,4096
+    task_time_only/ 只有 task_time，按 kernel_name 匹配 mish_custom，gated_mish_custom 不算
+只依赖标准库：python3 tests/scripts/test_parse_msprof.py
+"""
+import json
+import os
+import subprocess
+import sys
+import unittest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FIXTURES = os.path.join(HERE, 'fixtures', 'msprof')
+SCRIPT = os.path.join(HERE, '..', '..', 'scripts', 'parse_msprof.py')
+
+
+def run(*args):
+    result = subprocess.run([sys.executable, SCRIPT] + list(args), stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE, universal_newlines=True)
+    return result.returncode, result.stdout
+
+
+def fixture(name):
+    return os.path.join(FIXTURES, name)
+
+
+def find_row(output, key):
+    for line in output.splitlines():
+        if line.startswith(key + ' '):
+            return line.split()[len(key.split()):]
+    raise AssertionError('no row for {} in\n{}'.format(key, output))
+
+
+class SummaryTest(unittest.TestCase):
+    def test_json_values(self):
+        code, out = run('--json', '--core-num', '20', 'summary', fixture('base'))
+        self.assertEqual(code, 0)
+        summary = json.loads(out)
+        # Cast 和名字里带 MishCustom 的 GatedMishCustom 都不计入
+        self.assertEqual(sorted(summary), ['16,4096 DT_FLOAT16', '8,2048 DT_FLOAT16'])
+
+        small = summary['8,2048 DT_FLOAT16']
+        self.assertEqual(small['count'], 4)
+        self.assertAlmostEqual(small['duration'], 15.75)
+        self.assertAlmostEqual(small['duration_p50'], 12.0)
+        self.assertAlmostEqual(small['duration_p99'], 30.0)
+        self.assertAlmostEqual(small['aicore_time'], 10.0)
+        self.assertAlmostEqual(small['vec_ratio'], 0.55)
+        self.assertAlmostEqual(small['mte2_ratio'], 0.25)
+        self.assertEqual(small['block_dim'], 8)
+        # 8 个块在 20 个核上一轮做完，利用率 8 / 20
+        self.assertAlmostEqual(small['block_util'], 0.4)
+
+        large = summary['16,4096 DT_FLOAT16']
+        self.assertEqual(large['count'], 2)
+        self.assertAlmostEqual(large['duration'], 42.0)
+        # N/A 的 vec_ratio 不参与平均
+        self.assertAlmostEqual(large['vec_ratio'], 0.6)
+
+    def test_block_util_needs_core_num(self):
+        code, out = run('--json', 'summary', fixture('base'))
+        self.assertEqual(code, 0)
+        self.assertNotIn('block_util', json.loads(out)['8,2048 DT_FLOAT16'])
+
+    def test_partial_last_wave(self):
+        # 16 个块在 12 个核上分两轮，第二轮只有 4 个核工作
+        code, out = run('--json', '--core-num', '12', 'summary', fixture('new'))
+        self.assertEqual(code, 0)
+        self.assertAlmostEqual(json.loads(out)['32,4096 DT_FLOAT16']['block_util'], 16.0 / 24)
+
+    def test_table(self):
+        code, out = run('--core-num', '20', 'summary', fixture('base'))
+        self.assertEqual(code, 0)
+        self.assertEqual(out.splitlines()[0].split(),
+                         ['shape', 'count', 'task(us)', 'p99(us)', 'aicore(us)', 'vec', 'mte2', 'mte3', 'block_dim',
+                          'util'])
+        self.assertEqual(find_row(out, '8,2048 DT_FLOAT16'),
+                         ['4', '15.75', '30.00', '10.00', '55.0%', '25.0%', '12.5%', '8', '40.0%'])
+        self.assertEqual(find_row(out, '16,4096 DT_FLOAT16')[:5], ['2', '42.00', '44.00', '39.00', '60.0%'])
+
+    def test_task_time_fallback(self):
+        code, out = run('--json', 'summary', fixture('task_time_only'))
+        self.assertEqual(code, 0)
+        summary = json.loads(out)
+        # task_time 没有 shape 列，AddCustom 和 gated_mish_custom 的任务被过滤掉
+        self.assertEqual(list(summary), ['unknown'])
+        self.assertEqual(summary['unknown']['count'], 2)
+        self.assertAlmostEqual(summary['unknown']['duration'], 12.0)
+
+    def test_other_op_type(self):
+        code, out = run('--json', '--op-type', 'Cast', 'summary', fixture('base'))
+        self.assertEqual(code, 0)
+        self.assertEqual(json.loads(out)['8,2048 DT_FLOAT']['count'], 1)
+
+    def test_op_type_exact(self):
+        # 按类型只取 GatedMishCustom 自己的一条
+        code, out = run('--json', '--op-type', 'GatedMishCustom', 'summary', fixture('base'))
+        self.assertEqual(code, 0)
+        summary = json.loads(out)
+        self.assertEqual(list(summary), ['8,4096 DT_FLOAT16'])
+        self.assertAlmostEqual(summary['8,4096 DT_FLOAT16']['duration'], 99.0)
+
+        code, out = run('--json', '--op-type', 'GatedMishCustom', 'summary', fixture('task_time_only'))
+        self.assertEqual(code, 0)
+        self.assertEqual(json.loads(out)['unknown']['count'], 1)
+
+    def test_no_matching_task(self):
+        code, out = run('--op-type', 'MatmulMishCustom', 'summary', fixture('base'))
+        self.assertEqual(code, 1)
+        self.assertIn('[ERROR] no MatmulMishCustom task found', out)
+
+    def test_missing_csv(self):
+        result = subprocess.run([sys.executable, SCRIPT, 'summary', HERE + '/no_such_dir'], stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE, universal_newlines=True)
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn('no op_summary*.csv or task_time*.csv', result.stderr)
+
+
+class DiffTest(unittest.TestCase):
+    def test_table(self):
+        code, out = run('diff', fixture('base'), fixture('new'))
+        self.assertEqual(code, 0)
+        lines = out.splitlines()
+        self.assertEqual(lines[0].split(),
+                         ['shape', 'task', 'base', 'task', 'new', 'delta', 'aicore', 'base', 'aicore', 'new', 'delta'])
+        # 每个 shape 一行，按名字排序
+        self.assertEqual([line.split()[0] for line in lines[1:]], ['16,4096', '32,4096', '8,2048'])
+        # (8.5 - 15.75) / 15.75 与 (7.5 - 10) / 10
+        self.assertEqual(find_row(out, '8,2048 DT_FLOAT16'), ['15.75', '8.50', '-46.0%', '10.00', '7.50', '-25.0%'])
+        # 只在一侧出现的 shape 没有变化率
+        self.assertEqual(find_row(out, '16,4096 DT_FLOAT16'), ['42.00', '-', '-', '39.00', '-', '-'])
+        self.assertEqual(find_row(out, '32,4096 DT_FLOAT16'), ['-', '80.00', '-', '-', '76.00', '-'])
+
+    def test_json(self):
+        code, out = run('--json', 'diff', fixture('base'), fixture('new'))
+        self.assertEqual(code, 0)
+        diff = json.loads(out)
+        self.assertAlmostEqual(diff['base']['8,2048 DT_FLOAT16']['duration'], 15.75)
+        self.assertAlmostEqual(diff['new']['8,2048 DT_FLOAT16']['duration'], 8.5)
+        self.assertNotIn('16,4096 DT_FLOAT16', diff['new'])
+
+    def test_same_profile(self):
+        code, out = run('diff', fixture('base'), fixture('base'))
+        self.assertEqual(code, 0)
+        self.assertEqual(find_row(out, '8,2048 DT_FLOAT16'), ['15.75', '15.75', '+0.0%', '10.00', '10.00', '+0.0%'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,112 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+scripts/tensor_file.py 的测试：写出带 4KiB 分块索引的文件，再改写头部字段并重新计算头部 crc，
+读取时要靠结构检查（索引范围、分块覆盖、步长）和分块 crc 发现问题，与 common.cpp 的读取规则一致。
+    python3 tests/scripts/test_tensor_file.py
+"""
+import os
+import shutil
+import struct
+import sys
+import tempfile
+import unittest
+import zlib
+
+import numpy as np
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', '..', 'scripts'))
+import tensor_file as tf  # noqa: E402
+
+STRIDES = 7 + tf.MAX_DIMS
+
+
+def patch(path, edit):
+    """edit(values, chunks) 原地修改头部字段和分块索引，之后重新计算头部 crc"""
+    with open(path, 'r+b') as f:
+        values = list(struct.unpack(tf.HEADER_FMT, f.read(tf.HEADER_SIZE)))
+        chunks = [list(struct.unpack(tf.CHUNK_FMT, f.read(tf.CHUNK_SIZE))) for _ in range(values[6])]
+        edit(values, chunks)
+        crc = zlib.crc32(tf._pack_header(values[:-1], chunks, 0))
+        f.seek(0)
+        f.write(tf._pack_header(values[:-1], chunks, crc))
+
+
+class TensorFileTest(unittest.TestCase):
+    def setUp(self):
+        self.work = tempfile.mkdtemp(prefix='tensor_file_')
+        self.path = os.path.join(self.work, 'x.bin')
+        self.x = np.random.uniform(-10, 10, [8, 2048]).astype(np.float16)
+        tf.write_tensor(self.path, self.x, chunk_size=tf.ALIGN)
+
+    def tearDown(self):
+        shutil.rmtree(self.work, ignore_errors=True)
+
+    def assert_rejected(self, message):
+        with self.assertRaisesRegex(ValueError, message):
+            tf.read_tensor(self.path)
+
+    def test_round_trip(self):
+        header = tf.read_header(self.path)
+        self.assertEqual(len(header['chunks']), 8)
+        self.assertEqual(header['data_offset'] % tf.ALIGN, 0)
+        np.testing.assert_array_equal(tf.read_tensor(self.path), self.x)
+        np.testing.assert_array_equal(tf.read_tensor(self.path, mmap=True), self.x)
+
+    def test_non_contiguous_strides(self):
+        # 步长 [1, 8] 是列优先，按行优先拷贝会读错
+        def edit(values, _):
+            values[STRIDES:STRIDES + 2] = [1, 8]
+        patch(self.path, edit)
+        self.assert_rejected('non contiguous strides')
+
+    def test_unit_dim_any_stride(self):
+        tf.write_tensor(self.path, self.x.reshape(1, 8, 2048))
+
+        def edit(values, _):
+            values[STRIDES] = 12345
+        patch(self.path, edit)
+        np.testing.assert_array_equal(tf.read_tensor(self.path), self.x.reshape(1, 8, 2048))
+
+    def test_chunk_checksum(self):
+        # 整体 crc 仍然正确，只有分块 crc 能发现
+        def edit(_, chunks):
+            chunks[3][2] ^= 1
+        patch(self.path, edit)
+        self.assert_rejected('chunk 3 checksum mismatch')
+        tf.read_tensor(self.path, verify=False)
+
+    def test_huge_chunk_count(self):
+        def edit(values, _):
+            values[6] = 0xFFFFFFFF
+        patch(self.path, edit)
+        self.assert_rejected('chunk index is out of the file')
+
+    def test_chunk_gap(self):
+        def edit(_, chunks):
+            chunks[1][0] += tf.ALIGN
+        patch(self.path, edit)
+        self.assert_rejected('chunk 1 does not continue the payload at 4096')
+
+    def test_chunk_unaligned(self):
+        def edit(_, chunks):
+            chunks[1][0] += 16
+        patch(self.path, edit)
+        self.assert_rejected('chunk 1 does not continue the payload at 4096')
+
+    def test_chunks_short_of_payload(self):
+        def edit(_, chunks):
+            chunks[-1][1] -= 2
+        patch(self.path, edit)
+        self.assert_rejected('chunks cover 32766 of 32768 payload bytes')
+
+    def test_truncated(self):
+        with open(self.path, 'r+b') as f:
+            f.truncate(os.path.getsize(self.path) - 2)
+        self.assert_rejected('is truncated')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,15 @@
+/**
+* @file acl_op_compiler.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef STUB_ACL_OP_COMPILER_H
+#define STUB_ACL_OP_COMPILER_H
+
+#include "acl/acl.h"
+
+#endif // STUB_ACL_OP_COMPILER_H
@@ -0,0 +1,24 @@
+/**
+* @file acl_meta.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef STUB_ACL_META_H
+#define STUB_ACL_META_H
+
+#include "acl/acl.h"
+
+typedef int32_t aclnnStatus;
+struct aclTensor;
+struct aclOpExecutor;
+
+aclTensor *aclCreateTensor(const int64_t *viewDims, uint64_t viewDimsNum, aclDataType dataType,
+    const int64_t *stride, int64_t offset, aclFormat format, const int64_t *storageDims, uint64_t storageDimsNum,
+    void *tensorData);
+aclnnStatus aclDestroyTensor(const aclTensor *tensor);
+
+#endif // STUB_ACL_META_H
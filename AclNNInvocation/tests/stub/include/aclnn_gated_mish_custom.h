@@ -0,0 +1,19 @@
+/**
+* @file aclnn_gated_mish_custom.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef STUB_ACLNN_GATED_MISH_CUSTOM_H
+#define STUB_ACLNN_GATED_MISH_CUSTOM_H
+
+#include "aclnn/acl_meta.h"
+
+aclnnStatus aclnnGatedMishCustomGetWorkspaceSize(const aclTensor *x, const aclTensor *yOut,
+    uint64_t *workspaceSize, aclOpExecutor **executor);
+aclnnStatus aclnnGatedMishCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor, aclrtStream stream);
+
+#endif // STUB_ACLNN_GATED_MISH_CUSTOM_H
@@ -0,0 +1,19 @@
+/**
+* @file aclnn_matmul_mish_custom.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef STUB_ACLNN_MATMUL_MISH_CUSTOM_H
+#define STUB_ACLNN_MATMUL_MISH_CUSTOM_H
+
+#include "aclnn/acl_meta.h"
+
+aclnnStatus aclnnMatmulMishCustomGetWorkspaceSize(const aclTensor *a, const aclTensor *b, const aclTensor *bias,
+    const aclTensor *yOut, uint64_t *workspaceSize, aclOpExecutor **executor);
+aclnnStatus aclnnMatmulMishCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor, aclrtStream stream);
+
+#endif // STUB_ACLNN_MATMUL_MISH_CUSTOM_H
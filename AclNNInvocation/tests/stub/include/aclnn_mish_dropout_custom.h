@@ -0,0 +1,19 @@
+/**
+* @file aclnn_mish_dropout_custom.h
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#ifndef STUB_ACLNN_MISH_DROPOUT_CUSTOM_H
+#define STUB_ACLNN_MISH_DROPOUT_CUSTOM_H
+
+#include "aclnn/acl_meta.h"
+
+aclnnStatus aclnnMishDropoutCustomGetWorkspaceSize(const aclTensor *x, double keepProb, int64_t seed, int64_t offset,
+    const aclTensor *yOut, const aclTensor *maskOut, uint64_t *workspaceSize, aclOpExecutor **executor);
+aclnnStatus aclnnMishDropoutCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor, aclrtStream stream);
+
+#endif // STUB_ACLNN_MISH_DROPOUT_CUSTOM_H
@@ -0,0 +1,665 @@
+/**
+* @file stub_acl.cpp
+*
+* Copyright (C) 2023. Huawei Technologies Co., Ltd. All rights reserved.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "acl/acl.h"
+#include "aclnn/acl_meta.h"
+#include "aclnn_gated_mish_custom.h"
+#include "aclnn_matmul_mish_custom.h"
+#include "aclnn_mish_custom.h"
+#include "aclnn_mish_dropout_custom.h"
+
+struct aclTensorDesc {
+    aclDataType dataType;
+    std::vector<int64_t> dims;
+    aclFormat format;
+};
+
+struct aclDataBuffer {
+    void *data;
+    size_t size;
+};
+
+struct aclTensor {
+    std::vector<int64_t> dims;
+    aclDataType dataType;
+    void *data;
+};
+
+// every stub op keeps its arguments here, the launch reads and deletes it
+struct aclOpExecutor {
+    const aclTensor *inputs[3];
+    const aclTensor *outputs[2];
+    double keepProb;
+    uint64_t seed;
+    uint64_t offset;
+    bool adaptive;
+};
+
+namespace {
+// the MishCustom tiling launches 8 cores with tiles of at most 4096 elements
+constexpr size_t MISH_BLOCK_DIM = 8;
+constexpr size_t MISH_MAX_TILE = 4096;
+constexpr size_t MISH_PATH_SLOT_INTS = 8;
+constexpr size_t MISH_PATH_BYTES = MISH_BLOCK_DIM * MISH_PATH_SLOT_INTS * sizeof(int32_t);
+constexpr size_t SYSTEM_WORKSPACE = 4096;
+constexpr int32_t MISH_PATH_MAGIC = 0x4D495348;
+constexpr float SATURATE_HIGH = 4.5f;
+constexpr float SATURATE_LOW = -20.5f;
+constexpr float CLAMP_HIGH = 20.0f;
+constexpr size_t TOTAL_MEMORY = static_cast<size_t>(1) << 33;
+
+struct StubState {
+    std::mutex mutex;
+    size_t deviceBytes = 0;
+    uint64_t copies[4] = { 0, 0, 0, 0 };  // indexed by aclrtMemcpyKind
+    uint64_t copyBytes[4] = { 0, 0, 0, 0 };
+    uint64_t launches = 0;
+    uint64_t unsynced = 0;      // launches no synchronize or completed event has covered yet
+    uint64_t failLaunch = 0;    // STUB_ACL_FAIL_LAUNCH=N fails the Nth launch, 0 never
+    bool finalized = false;
+};
+
+StubState &State()
+{
+    static StubState state;
+    return state;
+}
+
+// memory and streams must be released before aclFinalize, a late call is reported on stderr and fails
+bool Initialized(const char *call)
+{
+    std::lock_guard<std::mutex> lock(State().mutex);
+    if (State().finalized) {
+        fprintf(stderr, "[STUB] %s after aclFinalize\n", call);
+        return false;
+    }
+    return true;
+}
+
+size_t ElementCount(const std::vector<int64_t> &dims)
+{
+    size_t count = 1;
+    for (int64_t dim : dims) {
+        count *= static_cast<size_t>(dim);
+    }
+    return count;
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    float magnitude;
+    if (exponent == 0) {
+        magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+    } else if (exponent == 0x1f) {
+        magnitude = mantissa != 0 ? NAN : INFINITY;
+    } else {
+        magnitude = std::ldexp(static_cast<float>(mantissa | 0x400), static_cast<int>(exponent) - 25);
+    }
+    return (value & 0x8000) != 0 ? -magnitude : magnitude;
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+    float magnitude = std::fabs(value);
+    if (std::isnan(value)) {
+        return sign | 0x7e00;
+    }
+    if (magnitude >= 65520.0f) {
+        return sign | 0x7c00;
+    }
+    if (magnitude < std::ldexp(1.0f, -14)) {
+        return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+    }
+    int exponent;
+    float fraction = std::frexp(magnitude, &exponent);    // magnitude = fraction * 2^exponent, fraction in [0.5, 1)
+    uint32_t mantissa = static_cast<uint32_t>(std::nearbyint(std::ldexp(fraction, 11)));   // 1024..2048
+    uint32_t bits = (static_cast<uint32_t>(exponent + 14) << 10) + mantissa - 0x400;
+    return sign | static_cast<uint16_t>(bits);
+}
+
+// tanh(softplus(x)) the way the kernels compute it
+float TanhSoftplus(float x)
+{
+    float e = std::exp(std::min(x, CLAMP_HIGH));
+    float n = e * (e + 2.0f);
+    return n / (n + 2.0f);
+}
+
+// the per-core path counters MishCustom writes to the end of its workspace
+void WritePathCounters(void *workspace, uint64_t workspaceSize, const uint16_t *x, size_t count, bool adaptive)
+{
+    if (workspace == nullptr || workspaceSize < MISH_PATH_BYTES) {
+        return;
+    }
+    int32_t *slots = reinterpret_cast<int32_t *>(static_cast<char *>(workspace) + workspaceSize - MISH_PATH_BYTES);
+    size_t perCore = (count + MISH_BLOCK_DIM - 1) / MISH_BLOCK_DIM;
+    for (size_t core = 0; core < MISH_BLOCK_DIM; ++core) {
+        int32_t *slot = slots + core * MISH_PATH_SLOT_INTS;
+        std::fill(slot, slot + MISH_PATH_SLOT_INTS, 0);
+        slot[0] = MISH_PATH_MAGIC;
+        size_t begin = std::min(count, core * perCore);
+        size_t end = std::min(count, begin + perCore);
+        for (size_t tile = begin; tile < end; tile += MISH_MAX_TILE) {
+            size_t tileEnd = std::min(end, tile + MISH_MAX_TILE);
+            float minValue = INFINITY;
+            float maxValue = -INFINITY;
+            for (size_t i = tile; i < tileEnd; ++i) {
+                minValue = std::min(minValue, HalfToFloat(x[i]));
+                maxValue = std::max(maxValue, HalfToFloat(x[i]));
+            }
+            int path = 4;
+            if (adaptive && minValue >= SATURATE_HIGH) {
+                path = 1;
+            } else if (adaptive && maxValue <= SATURATE_LOW) {
+                path = 2;
+            } else if (adaptive && maxValue < SATURATE_HIGH) {
+                path = 3;
+            }
+            ++slot[path];
+        }
+    }
+}
+
+void Philox(uint32_t counter[4], uint32_t key0, uint32_t key1)
+{
+    for (int round = 0; round < 10; ++round) {
+        uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+        uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+        uint32_t c1 = counter[1];
+        uint32_t c3 = counter[3];
+        counter[0] = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ key0;
+        counter[1] = static_cast<uint32_t>(product1);
+        counter[2] = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ key1;
+        counter[3] = static_cast<uint32_t>(product0);
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+}
+
+aclOpExecutor *NewExecutor(const aclTensor *in0, const aclTensor *in1, const aclTensor *in2,
+    const aclTensor *out0, const aclTensor *out1)
+{
+    aclOpExecutor *executor = new aclOpExecutor();
+    executor->inputs[0] = in0;
+    executor->inputs[1] = in1;
+    executor->inputs[2] = in2;
+    executor->outputs[0] = out0;
+    executor->outputs[1] = out1;
+    return executor;
+}
+
+// a launch failing with STUB_ACL_FAIL_LAUNCH never reaches the stream
+bool StartLaunch(aclOpExecutor *executor)
+{
+    std::lock_guard<std::mutex> lock(State().mutex);
+    StubState &state = State();
+    if (state.failLaunch != 0 && state.launches + 1 == state.failLaunch) {
+        state.failLaunch = 0;
+        delete executor;
+        return false;
+    }
+    ++state.launches;
+    ++state.unsynced;
+    return true;
+}
+
+// the stub runs launches synchronously, a real device may still be using the buffer
+bool Synchronized(const char *call)
+{
+    std::lock_guard<std::mutex> lock(State().mutex);
+    if (State().unsynced != 0) {
+        fprintf(stderr, "[STUB] %s with %lu launches not synchronized\n", call,
+            static_cast<unsigned long>(State().unsynced));
+        return false;
+    }
+    return true;
+}
+
+aclError MarkSynchronized()
+{
+    std::lock_guard<std::mutex> lock(State().mutex);
+    State().unsynced = 0;
+    return ACL_SUCCESS;
+}
+}
+
+aclError aclInit(const char *)
+{
+    const char *failLaunch = std::getenv("STUB_ACL_FAIL_LAUNCH");
+    std::lock_guard<std::mutex> lock(State().mutex);
+    State().finalized = false;
+    State().failLaunch = failLaunch == nullptr ? 0 : std::strtoull(failLaunch, nullptr, 10);
+    return ACL_SUCCESS;
+}
+
+aclError aclFinalize()
+{
+    // STUB_ACL_REPORT=1 prints what the runtime saw, tests compare it with the harness' own accounting
+    StubState &state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.finalized = true;
+    if (std::getenv("STUB_ACL_REPORT") != nullptr) {
+        printf("[STUB] launches: %lu\n", static_cast<unsigned long>(state.launches));
+        printf("[STUB] memcpy host_to_device: %lu, device_to_host: %lu, device_to_device: %lu, bytes: %lu\n",
+            static_cast<unsigned long>(state.copies[ACL_MEMCPY_HOST_TO_DEVICE]),
+            static_cast<unsigned long>(state.copies[ACL_MEMCPY_DEVICE_TO_HOST]),
+            static_cast<unsigned long>(state.copies[ACL_MEMCPY_DEVICE_TO_DEVICE]),
+            static_cast<unsigned long>(state.copyBytes[ACL_MEMCPY_HOST_TO_DEVICE] +
+                state.copyBytes[ACL_MEMCPY_DEVICE_TO_HOST] + state.copyBytes[ACL_MEMCPY_DEVICE_TO_DEVICE]));
+    }
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSetDevice(int32_t)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclrtResetDevice(int32_t)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclrtGetRunMode(aclrtRunMode *runMode)
+{
+    const char *device = std::getenv("STUB_ACL_DEVICE");
+    *runMode = (device != nullptr && std::strcmp(device, "0") != 0) ? ACL_DEVICE : ACL_HOST;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtGetMemInfo(aclrtMemAttr, size_t *free, size_t *total)
+{
+    std::lock_guard<std::mutex> lock(State().mutex);
+    *total = TOTAL_MEMORY;
+    *free = TOTAL_MEMORY - std::min(TOTAL_MEMORY, State().deviceBytes);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMalloc(void **devPtr, size_t size, aclrtMemMallocPolicy)
+{
+    if (!Initialized("aclrtMalloc")) {
+        return ACL_ERROR_UNINITIALIZE;
+    }
+    if (devPtr == nullptr || size == 0) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *devPtr = std::malloc(size);
+    if (*devPtr == nullptr) {
+        return ACL_ERROR_BAD_ALLOC;
+    }
+    std::lock_guard<std::mutex> lock(State().mutex);
+    State().deviceBytes += (size + 511) / 512 * 512;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtFree(void *devPtr)
+{
+    if (!Initialized("aclrtFree")) {
+        return ACL_ERROR_UNINITIALIZE;
+    }
+    (void)Synchronized("aclrtFree");
+    std::free(devPtr);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMallocHost(void **hostPtr, size_t size)
+{
+    if (!Initialized("aclrtMallocHost")) {
+        return ACL_ERROR_UNINITIALIZE;
+    }
+    if (hostPtr == nullptr || size == 0) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *hostPtr = std::malloc(size);
+    return *hostPtr == nullptr ? ACL_ERROR_BAD_ALLOC : ACL_SUCCESS;
+}
+
+aclError aclrtFreeHost(void *hostPtr)
+{
+    if (!Initialized("aclrtFreeHost")) {
+        return ACL_ERROR_UNINITIALIZE;
+    }
+    std::free(hostPtr);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemcpy(void *dst, size_t destMax, const void *src, size_t count, aclrtMemcpyKind kind)
+{
+    if (count > destMax || (count != 0 && (dst == nullptr || src == nullptr))) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    memmove(dst, src, count);
+    std::lock_guard<std::mutex> lock(State().mutex);
+    ++State().copies[kind];
+    State().copyBytes[kind] += count;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtCreateStream(aclrtStream *stream)
+{
+    if (!Initialized("aclrtCreateStream")) {
+        return ACL_ERROR_UNINITIALIZE;
+    }
+    *stream = new int(0);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyStream(aclrtStream stream)
+{
+    if (!Initialized("aclrtDestroyStream")) {
+        return ACL_ERROR_UNINITIALIZE;
+    }
+    delete static_cast<int *>(stream);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSynchronizeStream(aclrtStream)
+{
+    return MarkSynchronized();
+}
+
+aclError aclrtSynchronizeStreamWithTimeout(aclrtStream, int32_t)
+{
+    return MarkSynchronized();
+}
+
+aclError aclrtCreateEvent(aclrtEvent *event)
+{
+    *event = new int(0);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyEvent(aclrtEvent event)
+{
+    delete static_cast<int *>(event);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtRecordEvent(aclrtEvent, aclrtStream)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclrtQueryEventStatus(aclrtEvent, aclrtEventRecordedStatus *status)
+{
+    // launches run synchronously, an event is complete as soon as it is recorded
+    *status = ACL_EVENT_RECORDED_STATUS_COMPLETE;
+    return MarkSynchronized();
+}
+
+aclTensorDesc *aclCreateTensorDesc(aclDataType dataType, int numDims, const int64_t *dims, aclFormat format)
+{
+    aclTensorDesc *desc = new aclTensorDesc();
+    desc->dataType = dataType;
+    desc->dims.assign(dims, dims + numDims);
+    desc->format = format;
+    return desc;
+}
+
+void aclDestroyTensorDesc(const aclTensorDesc *desc)
+{
+    delete desc;
+}
+
+size_t aclGetTensorDescElementCount(const aclTensorDesc *desc)
+{
+    return ElementCount(desc->dims);
+}
+
+size_t aclGetTensorDescSize(const aclTensorDesc *desc)
+{
+    return ElementCount(desc->dims) * aclDataTypeSize(desc->dataType);
+}
+
+size_t aclGetTensorDescNumDims(const aclTensorDesc *desc)
+{
+    return desc->dims.size();
+}
+
+aclDataType aclGetTensorDescType(const aclTensorDesc *desc)
+{
+    return desc->dataType;
+}
+
+aclFormat aclGetTensorDescFormat(const aclTensorDesc *desc)
+{
+    return desc->format;
+}
+
+aclError aclGetTensorDescDimV2(const aclTensorDesc *desc, size_t index, int64_t *dimSize)
+{
+    if (index >= desc->dims.size()) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *dimSize = desc->dims[index];
+    return ACL_SUCCESS;
+}
+
+aclDataBuffer *aclCreateDataBuffer(void *data, size_t size)
+{
+    return new aclDataBuffer{ data, size };
+}
+
+aclError aclDestroyDataBuffer(const aclDataBuffer *dataBuffer)
+{
+    delete dataBuffer;
+    return ACL_SUCCESS;
+}
+
+float aclFloat16ToFloat(aclFloat16 value)
+{
+    return HalfToFloat(value);
+}
+
+aclFloat16 aclFloatToFloat16(float value)
+{
+    return FloatToHalf(value);
+}
+
+size_t aclDataTypeSize(aclDataType dataType)
+{
+    switch (dataType) {
+        case ACL_FLOAT16:
+        case ACL_INT16:
+        case ACL_UINT16:
+        case ACL_BF16:
+            return 2;
+        case ACL_FLOAT:
+        case ACL_INT32:
+        case ACL_UINT32:
+            return 4;
+        case ACL_INT64:
+        case ACL_UINT64:
+        case ACL_DOUBLE:
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+aclTensor *aclCreateTensor(const int64_t *viewDims, uint64_t viewDimsNum, aclDataType dataType, const int64_t *,
+    int64_t, aclFormat, const int64_t *, uint64_t, void *tensorData)
+{
+    aclTensor *tensor = new aclTensor();
+    tensor->dims.assign(viewDims, viewDims + viewDimsNum);
+    tensor->dataType = dataType;
+    tensor->data = tensorData;
+    return tensor;
+}
+
+aclnnStatus aclDestroyTensor(const aclTensor *tensor)
+{
+    delete tensor;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnMishCustomGetWorkspaceSize(const aclTensor *x, bool adaptive, bool, const aclTensor *yOut,
+    const aclTensor *tOutOptional, uint64_t *workspaceSize, aclOpExecutor **executor)
+{
+    if (x == nullptr || yOut == nullptr || x->dataType != ACL_FLOAT16) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *workspaceSize = SYSTEM_WORKSPACE + MISH_PATH_BYTES;
+    *executor = NewExecutor(x, nullptr, nullptr, yOut, tOutOptional);
+    (*executor)->adaptive = adaptive;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnMishCustom(void *workspace, uint64_t workspaceSize, aclOpExecutor *executor, aclrtStream)
+{
+    if (!StartLaunch(executor)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    const aclTensor *xTensor = executor->inputs[0];
+    size_t count = ElementCount(xTensor->dims);
+    const uint16_t *x = static_cast<const uint16_t *>(xTensor->data);
+    uint16_t *y = static_cast<uint16_t *>(executor->outputs[0]->data);
+    uint16_t *t = executor->outputs[1] == nullptr ? nullptr : static_cast<uint16_t *>(executor->outputs[1]->data);
+    WritePathCounters(workspace, workspaceSize, x, count, executor->adaptive);
+    for (size_t i = 0; i < count; ++i) {
+        float value = HalfToFloat(x[i]);
+        float tanhSoftplus = TanhSoftplus(value);
+        y[i] = FloatToHalf(tanhSoftplus == 0.0f ? 0.0f : value * tanhSoftplus);
+        if (t != nullptr) {
+            t[i] = FloatToHalf(tanhSoftplus);
+        }
+    }
+    delete executor;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnMishDropoutCustomGetWorkspaceSize(const aclTensor *x, double keepProb, int64_t seed, int64_t offset,
+    const aclTensor *yOut, const aclTensor *maskOut, uint64_t *workspaceSize, aclOpExecutor **executor)
+{
+    if (x == nullptr || yOut == nullptr || maskOut == nullptr || keepProb <= 0 || keepProb > 1) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *workspaceSize = 0;
+    *executor = NewExecutor(x, nullptr, nullptr, yOut, maskOut);
+    (*executor)->keepProb = keepProb;
+    (*executor)->seed = static_cast<uint64_t>(seed);
+    (*executor)->offset = static_cast<uint64_t>(offset);
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnMishDropoutCustom(void *, uint64_t, aclOpExecutor *executor, aclrtStream)
+{
+    if (!StartLaunch(executor)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    size_t count = ElementCount(executor->inputs[0]->dims);
+    const uint16_t *x = static_cast<const uint16_t *>(executor->inputs[0]->data);
+    uint16_t *y = static_cast<uint16_t *>(executor->outputs[0]->data);
+    uint8_t *mask = static_cast<uint8_t *>(executor->outputs[1]->data);
+    // same stream as the kernel: philox-4x32-10 keyed by seed, counter { i / 4, 0, offset }, 24 bit compare
+    uint32_t threshold = static_cast<uint32_t>(executor->keepProb * (1 << 24) + 0.5);
+    float scale = HalfToFloat(FloatToHalf(static_cast<float>(1.0 / executor->keepProb)));
+    uint64_t seed = executor->seed;
+    uint64_t offset = executor->offset;
+    for (size_t i = 0; i < count; i += 8) {
+        uint32_t bits = 0;
+        for (uint32_t part = 0; part < 2; ++part) {
+            uint32_t counter[4] = { static_cast<uint32_t>(i / 4 + part), 0, static_cast<uint32_t>(offset),
+                static_cast<uint32_t>(offset >> 32) };
+            Philox(counter, static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32));
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                bits |= static_cast<uint32_t>((counter[lane] >> 8) < threshold) << (part * 4 + lane);
+            }
+        }
+        mask[i / 8] = static_cast<uint8_t>(bits);
+        for (size_t j = i; j < i + 8 && j < count; ++j) {
+            float value = HalfToFloat(x[j]);
+            float mish = HalfToFloat(FloatToHalf(value * TanhSoftplus(value)));
+            y[j] = ((bits >> (j - i)) & 1) != 0 ? FloatToHalf(mish * scale) : 0;
+        }
+    }
+    delete executor;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnGatedMishCustomGetWorkspaceSize(const aclTensor *x, const aclTensor *yOut,
+    uint64_t *workspaceSize, aclOpExecutor **executor)
+{
+    if (x == nullptr || yOut == nullptr || x->dims.empty() || x->dims.back() % 2 != 0) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *workspaceSize = 0;
+    *executor = NewExecutor(x, nullptr, nullptr, yOut, nullptr);
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnGatedMishCustom(void *, uint64_t, aclOpExecutor *executor, aclrtStream)
+{
+    if (!StartLaunch(executor)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    const aclTensor *xTensor = executor->inputs[0];
+    size_t last = static_cast<size_t>(xTensor->dims.back());
+    size_t half = last / 2;
+    size_t rows = ElementCount(xTensor->dims) / last;
+    const uint16_t *x = static_cast<const uint16_t *>(xTensor->data);
+    uint16_t *y = static_cast<uint16_t *>(executor->outputs[0]->data);
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t col = 0; col < half; ++col) {
+            float a = HalfToFloat(x[row * last + col]);
+            float b = HalfToFloat(x[row * last + half + col]);
+            y[row * half + col] = FloatToHalf(a * b * TanhSoftplus(b));
+        }
+    }
+    delete executor;
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnMatmulMishCustomGetWorkspaceSize(const aclTensor *a, const aclTensor *b, const aclTensor *bias,
+    const aclTensor *yOut, uint64_t *workspaceSize, aclOpExecutor **executor)
+{
+    if (a == nullptr || b == nullptr || bias == nullptr || yOut == nullptr || a->dims.size() != 2 ||
+        b->dims.size() != 2 || a->dims[1] != b->dims[0]) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *workspaceSize = SYSTEM_WORKSPACE;
+    *executor = NewExecutor(a, b, bias, yOut, nullptr);
+    return ACL_SUCCESS;
+}
+
+aclnnStatus aclnnMatmulMishCustom(void *, uint64_t, aclOpExecutor *executor, aclrtStream)
+{
+    if (!StartLaunch(executor)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    size_t m = static_cast<size_t>(executor->inputs[0]->dims[0]);
+    size_t k = static_cast<size_t>(executor->inputs[0]->dims[1]);
+    size_t n = static_cast<size_t>(executor->inputs[1]->dims[1]);
+    const uint16_t *a = static_cast<const uint16_t *>(executor->inputs[0]->data);
+    const uint16_t *b = static_cast<const uint16_t *>(executor->inputs[1]->data);
+    const float *bias = static_cast<const float *>(executor->inputs[2]->data);
+    uint16_t *y = static_cast<uint16_t *>(executor->outputs[0]->data);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            float acc = bias[j];
+            for (size_t p = 0; p < k; ++p) {
+                acc += HalfToFloat(a[i * k + p]) * HalfToFloat(b[p * n + j]);
+            }
+            y[i * n + j] = FloatToHalf(acc * TanhSoftplus(acc));
+        }
+    }
+    delete executor;
+    return ACL_SUCCESS;
+}
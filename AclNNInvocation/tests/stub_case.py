@@ -0,0 +1,126 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+在临时目录里按 run.sh 的布局（input/ output/ scripts/）生成数据，运行链接了 stub/stub_acl.cpp 的 execute_mish_op，
+检查日志中的计数并用 scripts/verify_result.py 比较输出和真值：
+    python3 tests/stub_case.py --exe <execute_mish_op> [--env K=V] [--expect 正则] [--verify 输出:真值]
+        [--manifest N [--missing I]] [--tamper 方式] [--expect-fail] -- <参数>
+--expect 可以重复，每个正则都要在 stdout 中出现；--verify 的文件名相对 output/。
+--manifest N 写一个 N 行的批量清单，输入都是 input_x.bin，输出 batch_<i>.bin 都与 golden.bin 比较，
+参数中的 @manifest 换成清单路径；--missing I 让第 I 行的输入文件不存在，此时只检查 --verify 指定的输出。
+--tamper 把 input_x.bin 改写成带 4KiB 分块索引的文件再破坏索引，头部 crc 重新计算，只有结构检查能发现：
+    huge_index 分块数改成 0xFFFFFFFF；chunk_gap 第 1 块后移 4KiB；chunk_unaligned 第 1 块后移 16 字节。
+--expect-fail 要求进程自己返回非 0，被信号杀死（崩溃）仍算失败。
+"""
+import argparse
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCRIPTS = os.path.join(HERE, '..', 'scripts')
+
+
+def prepare(work):
+    for name in ('input', 'output', 'scripts', 'run'):
+        os.makedirs(os.path.join(work, name))
+    for name in ('gen_data.py', 'tensor_file.py', 'verify_result.py'):
+        shutil.copy(os.path.join(SCRIPTS, name), os.path.join(work, 'scripts'))
+    subprocess.check_call([sys.executable, os.path.join(work, 'scripts', 'gen_data.py')], stdout=subprocess.DEVNULL)
+
+
+def tamper(path, mode):
+    sys.path.insert(0, SCRIPTS)
+    import tensor_file as tf
+    tf.write_tensor(path, tf.read_tensor(path), chunk_size=tf.ALIGN)
+    with open(path, 'r+b') as f:
+        values = list(struct.unpack(tf.HEADER_FMT, f.read(tf.HEADER_SIZE)))
+        chunks = [list(struct.unpack(tf.CHUNK_FMT, f.read(tf.CHUNK_SIZE))) for _ in range(values[6])]
+        if mode == 'huge_index':
+            values[6] = 0xFFFFFFFF
+        elif mode == 'chunk_gap':
+            chunks[1][0] += tf.ALIGN
+        elif mode == 'chunk_unaligned':
+            chunks[1][0] += 16
+        else:
+            raise ValueError('unknown tamper mode ' + mode)
+        header_crc = zlib.crc32(tf._pack_header(values[:-1], chunks, 0))
+        f.seek(0)
+        f.write(tf._pack_header(values[:-1], chunks, header_crc))
+
+
+def verify(work, output, golden):
+    result = subprocess.run([sys.executable, os.path.join(work, 'scripts', 'verify_result.py'),
+                             os.path.join(work, 'output', output), os.path.join(work, 'output', golden)],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    return 'test pass' in result.stdout, result.stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(description='run execute_mish_op on the stub runtime')
+    parser.add_argument('--exe', required=True)
+    parser.add_argument('--env', action='append', default=[], help='K=V，可重复')
+    parser.add_argument('--expect', action='append', default=[], help='stdout 中必须出现的正则，可重复')
+    parser.add_argument('--verify', action='append', default=[], help='output/ 下的 输出:真值，可重复')
+    parser.add_argument('--manifest', type=int, default=0, help='批量清单的行数')
+    parser.add_argument('--missing', type=int, default=-1, help='清单中输入文件不存在的行')
+    parser.add_argument('--tamper', choices=('huge_index', 'chunk_gap', 'chunk_unaligned'), help='破坏输入的分块索引')
+    parser.add_argument('--expect-fail', action='store_true', help='进程应当返回非 0')
+    parser.add_argument('args', nargs=argparse.REMAINDER)
+    opts = parser.parse_args()
+    args = opts.args[1:] if opts.args[:1] == ['--'] else opts.args
+
+    work = tempfile.mkdtemp(prefix='mish_stub_')
+    try:
+        prepare(work)
+        if opts.tamper:
+            tamper(os.path.join(work, 'input', 'input_x.bin'), opts.tamper)
+        if opts.manifest:
+            manifest = os.path.join(work, 'manifest.txt')
+            with open(manifest, 'w') as f:
+                for i in range(opts.manifest):
+                    source = 'missing_x.bin' if i == opts.missing else 'input_x.bin'
+                    f.write('../input/{} ../output/batch_{}.bin\n'.format(source, i))
+                    if opts.missing < 0:
+                        opts.verify.append('batch_{}.bin:golden.bin'.format(i))
+            args = [manifest if arg == '@manifest' else arg for arg in args]
+        env = dict(os.environ, STUB_ACL_REPORT='1')
+        env.update(item.split('=', 1) for item in opts.env)
+        # execute_mish_op 按 ../input 和 ../output 找文件
+        result = subprocess.run([os.path.abspath(opts.exe)] + args, cwd=os.path.join(work, 'run'), env=env,
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        print(result.stdout)
+        ok = result.returncode > 0 if opts.expect_fail else result.returncode == 0
+        if not ok:
+            print('[ERROR] exit code {}'.format(result.returncode))
+        # 桩运行时在 aclFinalize 之后还收到释放内存或流的调用
+        if re.search(r'\[STUB\] \w+ after aclFinalize', result.stdout):
+            print('[ERROR] acl calls after aclFinalize')
+            ok = False
+        # 已下发的任务还没同步就释放了内存
+        if re.search(r'\[STUB\] \w+ with \d+ launches not synchronized', result.stdout):
+            print('[ERROR] device memory freed before the stream was synchronized')
+            ok = False
+        for pattern in opts.expect:
+            if not re.search(pattern, result.stdout):
+                print('[ERROR] missing "{}"'.format(pattern))
+                ok = False
+        for pair in opts.verify:
+            output, golden = pair.split(':')
+            passed, message = verify(work, output, golden)
+            if not passed:
+                print('[ERROR] {} against {}: {}'.format(output, golden, message.strip()))
+                ok = False
+        return 0 if ok else 1
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -11,6 +11,12 @@ endif()
 if (NOT DEFINED ASCEND_PYTHON_EXECUTABLE)
     set(ASCEND_PYTHON_EXECUTABLE python3 CACHE STRING "")
 endif()
+if (NOT DEFINED ENABLE_OPS_REPLAY)
+    set(ENABLE_OPS_REPLAY False CACHE BOOL "")
+endif()
+if (NOT DEFINED ASCEND_REPLAY_OPS)
+    set(ASCEND_REPLAY_OPS "MishCustom" CACHE STRING "")
+endif()
 if (NOT DEFINED ASCEND_COMPUTE_UNIT)
     message(FATAL_ERROR "ASCEND_COMPUTE_UNIT not set in CMakePreset.json ! 
 ")
@@ -47,6 +47,26 @@ function(opbuild)
   message(STATUS "Opbuild generating sources - done")
 endfunction()
 
+# 根据算子描述 json 中的 expression 生成逐元素融合算子的 op_host / op_kernel 源码，需要在 add_subdirectory 之前调用
+function(add_elementwise_codegen)
+  cmake_parse_arguments(EWGEN "" "DESC;HOST_DIR;KERNEL_DIR" "" ${ARGN})
+  execute_process(COMMAND ${ASCEND_PYTHON_EXECUTABLE} ${CMAKE_SOURCE_DIR}/cmake/util/elementwise_codegen.py gen
+                          ${EWGEN_DESC} --host-dir ${EWGEN_HOST_DIR} --kernel-dir ${EWGEN_KERNEL_DIR}
+                  RESULT_VARIABLE EXEC_RESULT
+                  OUTPUT_VARIABLE EXEC_INFO
+                  ERROR_VARIABLE  EXEC_ERROR
+  )
+  if (${EXEC_RESULT})
+    message("elementwise codegen info: ${EXEC_INFO}")
+    message("elementwise codegen error: ${EXEC_ERROR}")
+    message(FATAL_ERROR "elementwise codegen run failed!")
+  endif()
+  message(STATUS "${EXEC_INFO}")
+  # 修改 json 或生成脚本后重新配置
+  set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS
+               ${EWGEN_DESC} ${CMAKE_SOURCE_DIR}/cmake/util/elementwise_codegen.py)
+endfunction()
+
 function(add_ops_info_target)
   cmake_parse_arguments(OPINFO "" "TARGET;OPS_INFO;OUTPUT;INSTALL_DIR" "" ${ARGN})
   get_filename_component(opinfo_file_path "${OPINFO_OUTPUT}" DIRECTORY)
@@ -94,6 +114,79 @@ function(add_ops_impl_target)
   endif()
 endfunction()
 
+function(add_ops_replay_targets)
+  cmake_parse_arguments(OPREPLAY "" "OPS_INFO;COMPUTE_UNIT;IMPL_DIR;OUT_DIR;INSTALL_DIR" "OPS_BATCH;OPS_ITERATE" ${ARGN})
+  # ccec compile options
+  set(ccec_base_opts -c -O2 --cce-aicore-only -mllvm -cce-aicore-function-stack-size=16000
+      -mllvm -cce-aicore-record-overflow=false -std=c++17)
+  set(ccec_extopts_ascend310p --cce-aicore-arch=dav-m200 -mllvm -cce-aicore-fp-ceiling=2)
+  set(ccec_extopts_ascend310b --cce-aicore-arch=dav-m300)
+  set(ccec_extopts_ascend910 --cce-aicore-arch=dav-c100)
+  set(ccec_extopts_ascend910b --cce-aicore-arch=dav-c220-cube)
+  set(tikreplay_path ${ASCEND_TENSOR_COMPILER_PATH}/tikcpp/tikreplaylib)
+  set(tikcfw_path ${ASCEND_TENSOR_COMPILER_PATH}/tikcpp/tikcfw)
+  file(MAKE_DIRECTORY ${OPREPLAY_OUT_DIR})
+  execute_process(COMMAND ${ASCEND_PYTHON_EXECUTABLE} ${CMAKE_SOURCE_DIR}/cmake/util/ascendc_replay_build.py
+                          ${OPREPLAY_OPS_INFO}
+                          "${OPREPLAY_OPS_BATCH}" "${OPREPLAY_OPS_ITERATE}"
+                          ${OPREPLAY_IMPL_DIR}
+                          ${OPREPLAY_OUT_DIR}
+                          ${OPREPLAY_COMPUTE_UNIT}
+                  RESULT_VARIABLE EXEC_RESULT
+                  OUTPUT_VARIABLE EXEC_INFO
+                  ERROR_VARIABLE  EXEC_ERROR
+  )
+  if (${EXEC_RESULT})
+    message("ops replay code gen info: ${EXEC_INFO}")
+    message("ops replay code gen error: ${EXEC_ERROR}")
+    message(FATAL_ERROR "ops replay code gen failed!")
+  endif()
+  file(GLOB replay_kernel_entries ${OPREPLAY_OUT_DIR}/*_entry.cce)
+  foreach(replay_kernel_file ${replay_kernel_entries})
+    get_filename_component(replay_kernel_file_name "${replay_kernel_file}" NAME)
+    string(REPLACE "_entry.cce" "" op_kernel_name ${replay_kernel_file_name})
+    set(replay_lib replay_${op_kernel_name}_${OPREPLAY_COMPUTE_UNIT})
+    set(replay_entry ${OPREPLAY_OUT_DIR}/${op_kernel_name}_entry_${OPREPLAY_COMPUTE_UNIT}.o)
+    add_library(${replay_lib} SHARED
+                ${OPREPLAY_OUT_DIR}/${op_kernel_name}_impl.cpp
+                ${OPREPLAY_OUT_DIR}/${op_kernel_name}_replay.cpp
+    )
+    # the kernel source is compiled for the host, the tiling struct comes from the generated header
+    target_compile_options(${replay_lib} PRIVATE
+                           -include ${OPREPLAY_OUT_DIR}/${op_kernel_name}_tiling_data.h
+    )
+    target_include_directories(${replay_lib} PRIVATE
+                               ${tikreplay_path}/include
+                               ${tikcfw_path}
+                               ${tikcfw_path}/impl
+                               ${tikcfw_path}/interface
+    )
+    target_link_directories(${replay_lib} PRIVATE
+                            ${tikreplay_path}/lib
+                            ${tikreplay_path}/lib/${OPREPLAY_COMPUTE_UNIT}
+    )
+    target_link_libraries(${replay_lib} PRIVATE
+                          intf_pub
+                          tikreplaylib_codegen
+                          tikreplaylib_stub
+                          register
+    )
+    add_custom_command(OUTPUT ${replay_entry}
+                       COMMAND ${ASCEND_CCEC_COMPILER_PATH}/ccec ${ccec_base_opts} ${ccec_extopts_${OPREPLAY_COMPUTE_UNIT}}
+                               ${replay_kernel_file} -o ${replay_entry}
+                       DEPENDS ${replay_kernel_file}
+    )
+    add_custom_target(${replay_lib}_entry ALL DEPENDS ${replay_entry})
+    add_dependencies(${replay_lib} ${replay_lib}_entry)
+    install(TARGETS ${replay_lib}
+            LIBRARY DESTINATION ${OPREPLAY_INSTALL_DIR}
+    )
+    install(FILES ${replay_entry}
+            DESTINATION ${OPREPLAY_INSTALL_DIR}
+    )
+  endforeach()
+endfunction()
+
 function(add_npu_support_target)
   cmake_parse_arguments(NPUSUP "" "TARGET;OPS_INFO_DIR;OUT_DIR;INSTALL_DIR" "" ${ARGN})
   get_filename_component(npu_sup_file_path "${NPUSUP_OUT_DIR}" DIRECTORY)
@@ -0,0 +1,719 @@
+#!/usr/bin/env python
+# -*- coding: UTF-8 -*-
+"""
+Function:
+根据 MishCustom.json 中带 "expression" 字段的算子描述，生成逐元素融合算子的 op_host / op_kernel 源码。
+expression 是若干条赋值语句，右侧只能调用 AscendC 矢量接口（以及展开成基本接口的 Mish、Cast），
+最后一条对输出名赋值，例如：
+    t = Muls(x, 0.5); y = Cast(Mins(Maxs(Mish(t), -1.0), 6.0), "float16")
+生成的 kernel 沿用 KernelMish 的 CopyIn / Compute / CopyOut 双缓冲流水，中间结果按活跃区间复用 UB，
+分块长度由每个元素实际占用的 UB 字节数和平台 UB 大小在 TilingFunc 中算出。
+    python3 elementwise_codegen.py gen MishCustom.json --host-dir op_host --kernel-dir op_kernel
+    python3 elementwise_codegen.py check MishCustom.json [--dump <dir>]
+check 用 numpy 按分配结果模拟 UB 复用（读到被覆盖的缓冲区直接报错），并与表达式的直接求值比较；
+--dump 额外写出 CPU 调测（ICPU_RUN_KF）用的输入和标杆数据。
+Copyright Information:
+Huawei Technologies Co., Ltd. All Rights Reserved © 2023
+"""
+
+import argparse
+import ast
+import json
+import os
+import re
+import sys
+
+DTYPES = {
+    'fp16': 'float16', 'float16': 'float16',
+    'float': 'float32', 'fp32': 'float32', 'float32': 'float32',
+}
+CTYPES = {'float16': 'half', 'float32': 'float'}
+GE_TYPES = {'float16': 'ge::DT_FLOAT16', 'float32': 'ge::DT_FLOAT'}
+SIZES = {'float16': 2, 'float32': 4}
+BUFFER_NUM = 2
+BLOCK_BYTES = 32
+
+UNARY_OPS = ('Exp', 'Ln', 'Abs', 'Reciprocal', 'Sqrt', 'Relu')
+BINARY_OPS = ('Add', 'Sub', 'Mul', 'Div', 'Max', 'Min')
+SCALAR_OPS = ('Adds', 'Muls', 'Maxs', 'Mins')
+# Mish 展开时 exp 之前的截断点：超过后 n / (n + 2) 在该精度下已经等于 1，截断只为避免 exp 溢出
+MISH_CLAMP = {'float16': 5.0, 'float32': 20.0}
+
+
+class CodegenError(Exception):
+    pass
+
+
+class Value:
+    """表达式 DAG 中的一个张量：输入，或一条矢量指令的结果"""
+    def __init__(self, vid, dtype, op=None, args=None, scalar=None, name=None):
+        self.vid = vid
+        self.dtype = dtype
+        self.op = op
+        self.args = args or []
+        self.scalar = scalar
+        self.name = name
+
+
+class Program:
+    def __init__(self, op_desc):
+        self.op_type = op_desc['op']
+        self.expression = op_desc['expression']
+        self.inputs = []
+        self.values = []
+        for desc in op_desc['input_desc']:
+            self.inputs.append(self._new(_dtype_of(desc), name=desc['name']))
+        if len(op_desc['output_desc']) != 1:
+            raise CodegenError('{}: expression ops have exactly one output'.format(self.op_type))
+        self.output_name = op_desc['output_desc'][0]['name']
+        self.output_dtype = _dtype_of(op_desc['output_desc'][0])
+        self.output = None
+        self.instrs = []
+
+    def _new(self, dtype, **kwargs):
+        value = Value(len(self.values), dtype, **kwargs)
+        self.values.append(value)
+        return value
+
+    def emit(self, op, args, scalar=None, dtype=None):
+        return self._new(dtype or args[0].dtype, op=op, args=args, scalar=scalar)
+
+
+def _dtype_of(desc):
+    types = desc['type']
+    if len(types) != 1 or types[0] not in DTYPES:
+        raise CodegenError('{}: expression ops support one fp16/float type per tensor'.format(desc['name']))
+    return DTYPES[types[0]]
+
+
+def camel_to_snake(name):
+    return re.sub(r'(?<!^)(?=[A-Z])', '_', name).lower()
+
+
+def _number(node):
+    if isinstance(node, ast.UnaryOp) and isinstance(node.op, ast.USub):
+        return -_number(node.operand)
+    if isinstance(node, ast.Constant) and isinstance(node.value, (int, float)) and \
+            not isinstance(node.value, bool):
+        return float(node.value)
+    raise CodegenError('expected a number, got {}'.format(ast.dump(node)))
+
+
+def _lower_call(prog, call, env):
+    if not isinstance(call, ast.Call) or not isinstance(call.func, ast.Name) or call.keywords:
+        if isinstance(call, ast.Name):
+            if call.id not in env:
+                raise CodegenError('undefined name {}'.format(call.id))
+            return env[call.id]
+        raise CodegenError('unsupported expression {}'.format(ast.dump(call)))
+    op = call.func.id
+    args = call.args
+
+    def tensor(i):
+        return _lower_call(prog, args[i], env)
+
+    def arity(n):
+        if len(args) != n:
+            raise CodegenError('{} takes {} arguments'.format(op, n))
+
+    if op in UNARY_OPS:
+        arity(1)
+        return prog.emit(op, [tensor(0)])
+    if op in BINARY_OPS:
+        arity(2)
+        a, b = tensor(0), tensor(1)
+        if a.dtype != b.dtype:
+            raise CodegenError('{} mixes {} and {}, insert a Cast'.format(op, a.dtype, b.dtype))
+        return prog.emit(op, [a, b])
+    if op in SCALAR_OPS:
+        arity(2)
+        return prog.emit(op, [tensor(0)], scalar=_number(args[1]))
+    if op == 'Cast':
+        arity(2)
+        src = tensor(0)
+        if not isinstance(args[1], ast.Constant) or args[1].value not in DTYPES:
+            raise CodegenError('Cast target must be "float16" or "float32"')
+        dst = DTYPES[args[1].value]
+        if dst == src.dtype:
+            return src
+        return prog.emit('Cast', [src], dtype=dst)
+    if op == 'Mish':
+        # Mish(x) = x * tanh(ln(1 + e)) = x * n / (n + 2)，n = e * (e + 2)，e = exp(x)
+        arity(1)
+        x = tensor(0)
+        e = prog.emit('Exp', [prog.emit('Mins', [x], scalar=MISH_CLAMP[x.dtype])])
+        n = prog.emit('Mul', [e, prog.emit('Adds', [e], scalar=2.0)])
+        ratio = prog.emit('Div', [n, prog.emit('Adds', [n], scalar=2.0)])
+        return prog.emit('Mul', [x, ratio])
+    raise CodegenError('unsupported op {}'.format(op))
+
+
+def _parse_statements(expression):
+    # 语句之间可以用分号或换行分隔
+    return ast.parse('\n'.join(stmt.strip() for stmt in re.split('[;\n]', expression)))
+
+
+def parse(op_desc):
+    prog = Program(op_desc)
+    env = {value.name: value for value in prog.inputs}
+    try:
+        tree = _parse_statements(prog.expression)
+    except SyntaxError as err:
+        raise CodegenError('{}: bad expression: {}'.format(prog.op_type, err)) from err
+    for stmt in tree.body:
+        if not isinstance(stmt, ast.Assign) or len(stmt.targets) != 1 or not isinstance(stmt.targets[0], ast.Name):
+            raise CodegenError('{}: only "name = expr" statements are allowed'.format(prog.op_type))
+        env[stmt.targets[0].id] = _lower_call(prog, stmt.value, env)
+    prog.output = env.get(prog.output_name)
+    if prog.output is None or prog.output.op is None:
+        raise CodegenError('{}: expression must compute output {}'.format(prog.op_type, prog.output_name))
+    if prog.output.dtype != prog.output_dtype:
+        raise CodegenError('{}: {} is {} but declared {}'.format(prog.op_type, prog.output_name,
+                                                                prog.output.dtype, prog.output_dtype))
+    # 从输出出发后序遍历，得到去掉死代码后的指令顺序，输出指令一定在最后
+    seen = set()
+
+    def visit(value):
+        if value.vid in seen or value.op is None:
+            return
+        seen.add(value.vid)
+        for arg in value.args:
+            visit(arg)
+        prog.instrs.append(value)
+    visit(prog.output)
+    return prog
+
+
+class Slot:
+    """UB 中的一块缓冲区：输入/输出队列里的张量，或一块 TBuf 临时空间"""
+    def __init__(self, kind, index, dtype=None):
+        self.kind = kind
+        self.index = index
+        self.dtype = dtype
+        self.width = SIZES[dtype] if dtype else 0
+        self.dtypes = set()
+
+    def can_hold(self, dtype):
+        # 队列里的张量类型固定；临时空间按需要的最大字节数分配，可以装任何类型
+        return self.kind == 'tmp' or self.dtype == dtype
+
+
+def allocate(prog):
+    """按活跃区间给每条指令的结果分配缓冲区，返回 {vid: Slot} 和临时缓冲区列表"""
+    last_use = {}
+    for i, instr in enumerate(prog.instrs):
+        for arg in instr.args:
+            last_use[arg.vid] = i
+    slot_of = {}
+    in_slots = []
+    for i, value in enumerate(prog.inputs):
+        slot = Slot('in', i, value.dtype)
+        in_slots.append(slot)
+        slot_of[value.vid] = slot
+    out_slot = Slot('out', 0, prog.output_dtype)
+    tmp_slots = []
+    free = [slot for slot, value in zip(in_slots, prog.inputs) if value.vid not in last_use]
+
+    final = len(prog.instrs) - 1
+    for i, instr in enumerate(prog.instrs):
+        dying = []
+        for arg in instr.args:
+            slot = slot_of[arg.vid]
+            if last_use[arg.vid] == i and slot not in dying:
+                dying.append(slot)
+        dst = None
+        if i == final:
+            dst = out_slot
+        else:
+            # 优先原地计算：源操作数在这条指令后不再使用时，直接写回它的缓冲区
+            # Cast 前后位宽不同，不能原地进行
+            if instr.op != 'Cast':
+                dst = next((slot for slot in dying if slot.can_hold(instr.dtype)), None)
+            if dst is None:
+                candidates = [slot for slot in free if slot.can_hold(instr.dtype)]
+                candidates.sort(key=lambda slot: (slot.kind == 'tmp', slot.width < SIZES[instr.dtype]))
+                if candidates:
+                    dst = candidates[0]
+                    free.remove(dst)
+            if dst is None:
+                dst = Slot('tmp', len(tmp_slots))
+                tmp_slots.append(dst)
+        if dst.kind == 'tmp':
+            dst.width = max(dst.width, SIZES[instr.dtype])
+            dst.dtypes.add(instr.dtype)
+        slot_of[instr.vid] = dst
+        free.extend(slot for slot in dying if slot is not dst)
+    return slot_of, in_slots, out_slot, tmp_slots
+
+
+class Kernel:
+    """分配完成的逐元素程序，以及生成代码需要的各项常量"""
+    def __init__(self, op_desc):
+        self.prog = parse(op_desc)
+        self.slot_of, self.in_slots, self.out_slot, self.tmp_slots = allocate(self.prog)
+        io_bytes = sum(SIZES[v.dtype] for v in self.prog.inputs) + SIZES[self.prog.output_dtype]
+        self.ub_bytes_per_element = BUFFER_NUM * io_bytes + sum(slot.width for slot in self.tmp_slots)
+        # DataCopy 以 32 字节为单位，按最窄的输入输出类型对齐后所有张量都满足
+        narrowest = min(SIZES[v.dtype] for v in self.prog.inputs + [self.out_slot])
+        self.align_elements = BLOCK_BYTES // narrowest
+        self.snake = camel_to_snake(self.prog.op_type)
+        self.class_name = 'Kernel' + re.sub('Custom$', '', self.prog.op_type)
+
+    def tensor_name(self, value):
+        slot = self.slot_of[value.vid]
+        if slot.kind == 'in':
+            return self.prog.inputs[slot.index].name + 'Local'
+        if slot.kind == 'out':
+            return self.prog.output_name + 'Local'
+        return 'tmp{}{}'.format(slot.index, 'F16' if value.dtype == 'float16' else 'F32')
+
+
+# ---------------------------------------------------------------- 代码生成
+
+GEN_NOTE = '由 cmake/util/elementwise_codegen.py 根据 MishCustom.json 中 {} 的 expression 生成，请勿手工修改'
+
+
+def _scalar_literal(value, dtype):
+    return 'static_cast<{}>({!r})'.format(CTYPES[dtype], value)
+
+
+def gen_tiling_header(kernel):
+    op_type = kernel.prog.op_type
+    return '\n'.join([
+        '#include "register/tilingdata_base.h"',
+        '/**',
+        GEN_NOTE.format(op_type) + '。',
+        '每个核处理连续的 blockLength 个元素（最后一个核可能更少），每次搬运 tileLength 个元素。',
+        '**/',
+        'namespace optiling {',
+        '\tBEGIN_TILING_DATA_DEF({}TilingData)'.format(op_type),
+        '\tTILING_DATA_FIELD_DEF(uint32_t, totalLength);',
+        '\tTILING_DATA_FIELD_DEF(uint32_t, blockLength);',
+        '\tTILING_DATA_FIELD_DEF(uint32_t, tileLength);',
+        '\tEND_TILING_DATA_DEF;',
+        '\tREGISTER_TILING_DATA_CLASS({0}, {0}TilingData)'.format(op_type),
+        '}',
+        '',
+    ])
+
+
+def gen_host(kernel):
+    prog = kernel.prog
+    op_type = prog.op_type
+    lines = [
+        '// ' + GEN_NOTE.format(op_type),
+        '// expression: ' + ' '.join(prog.expression.split()),
+        '#include "{}_tiling.h"'.format(kernel.snake),
+        '#include "register/op_def_registry.h"',
+        '#include "tiling/platform/platform_ascendc.h"',
+        '',
+        'namespace optiling {',
+        '    // DataCopy 以 32 字节为单位搬运，元素总数需要是 ALIGN_ELEMENTS 的整数倍',
+        '    const uint32_t ALIGN_ELEMENTS = {};'.format(kernel.align_elements),
+        '    // 每个元素占用的 UB 字节数：输入输出各双缓冲，加上 {} 块中间结果缓冲区'.format(len(kernel.tmp_slots)),
+        '    const uint32_t UB_BYTES_PER_ELEMENT = {};'.format(kernel.ub_bytes_per_element),
+        '',
+        '    /**',
+        '    * @brief TilingFunc 按 ALIGN_ELEMENTS 为单位把数据平分给各个核，分块长度取 UB 能放下的最大值。',
+        '    *',
+        '    * @param context 当前的分块上下文，包含输入输出的形状信息。',
+        '    * @return 成功返回 ge::GRAPH_SUCCESS，元素数不对齐或输入形状不一致时返回 ge::GRAPH_FAILED。',
+        '    */',
+        '    static ge::graphStatus TilingFunc(gert::TilingContext* context)',
+        '    {',
+        '        {}TilingData tiling;'.format(op_type),
+        '',
+        '        uint32_t totalLength = context->GetInputShape(0)->GetOriginShape().GetShapeSize();',
+        '        if (totalLength == 0 || totalLength % ALIGN_ELEMENTS != 0) {',
+        '            return ge::GRAPH_FAILED;',
+        '        }',
+    ]
+    if len(prog.inputs) > 1:
+        lines += [
+            '        for (size_t i = 1; i < {}; ++i) {{'.format(len(prog.inputs)),
+            '            if (context->GetInputShape(i)->GetOriginShape().GetShapeSize() != totalLength) {',
+            '                return ge::GRAPH_FAILED;',
+            '            }',
+            '        }',
+        ]
+    lines += [
+        '',
+        '        auto ascendcPlatform = platform_ascendc::PlatformAscendC(context->GetPlatformInfo());',
+        '        uint64_t ubSize = 0;',
+        '        ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);',
+        '        uint32_t coreNum = ascendcPlatform.GetCoreNumAiv();',
+        '',
+        '        // 数据不足时少启动几个核，保证每个核至少分到一个对齐单位',
+        '        uint32_t units = totalLength / ALIGN_ELEMENTS;',
+        '        uint32_t blockUnits = (units + coreNum - 1) / coreNum;',
+        '        uint32_t blockDim = (units + blockUnits - 1) / blockUnits;',
+        '        uint32_t blockLength = blockUnits * ALIGN_ELEMENTS;',
+        '',
+        '        uint32_t tileLength = static_cast<uint32_t>(ubSize / UB_BYTES_PER_ELEMENT) / ALIGN_ELEMENTS * ALIGN_ELEMENTS;',
+        '        if (tileLength == 0) {',
+        '            return ge::GRAPH_FAILED;',
+        '        }',
+        '        if (tileLength > blockLength) {',
+        '            tileLength = blockLength;',
+        '        }',
+        '',
+        '        context->SetBlockDim(blockDim);',
+        '        tiling.set_totalLength(totalLength);',
+        '        tiling.set_blockLength(blockLength);',
+        '        tiling.set_tileLength(tileLength);',
+        '',
+        '        tiling.SaveToBuffer(context->GetRawTilingData()->GetData(),',
+        '            context->GetRawTilingData()->GetCapacity());',
+        '        context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());',
+        '',
+        '        size_t* currentWorkspace = context->GetWorkspaceSizes(1);',
+        '        currentWorkspace[0] = 0;',
+        '',
+        '        return ge::GRAPH_SUCCESS;',
+        '    }',
+        '}',
+        '',
+        'namespace ge {',
+        '    /**',
+        '    * @brief InferShape 函数：逐元素计算，输出形状与第一个输入相同。',
+        '    */',
+        '    static ge::graphStatus InferShape(gert::InferShapeContext* context)',
+        '    {',
+        '        const gert::Shape* x_shape = context->GetInputShape(0);',
+        '        gert::Shape* y_shape = context->GetOutputShape(0);',
+        '        *y_shape = *x_shape;',
+        '        return GRAPH_SUCCESS;',
+        '    }',
+        '}',
+        '',
+        'namespace ops {',
+        '    class {} : public OpDef {{'.format(op_type),
+        '    public:',
+        '        explicit {}(const char* name) : OpDef(name)'.format(op_type),
+        '        {',
+    ]
+    for value in prog.inputs:
+        lines += _gen_param('Input', value.name, value.dtype)
+    lines += _gen_param('Output', prog.output_name, prog.output_dtype)
+    lines += [
+        '            this->SetInferShape(ge::InferShape);',
+        '',
+        '            this->AICore()',
+        '                .SetTiling(optiling::TilingFunc);',
+        '            this->AICore().AddConfig("ascend310b");',
+        '        }',
+        '    };',
+        '',
+        '    OP_ADD({});'.format(op_type),
+        '}',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def _gen_param(kind, name, dtype):
+    return [
+        '            this->{}("{}")'.format(kind, name),
+        '                .ParamType(REQUIRED)',
+        '                .DataType({{ {} }})'.format(GE_TYPES[dtype]),
+        '                .Format({ ge::FORMAT_ND })',
+        '                .UnknownShapeFormat({ ge::FORMAT_ND });',
+        '',
+    ]
+
+
+def _gen_instr(kernel, instr):
+    dst = kernel.tensor_name(instr)
+    srcs = [kernel.tensor_name(arg) for arg in instr.args]
+    if instr.op in UNARY_OPS:
+        return '{}({}, {}, count);'.format(instr.op, dst, srcs[0])
+    if instr.op in BINARY_OPS:
+        return '{}({}, {}, {}, count);'.format(instr.op, dst, srcs[0], srcs[1])
+    if instr.op in SCALAR_OPS:
+        return '{}({}, {}, {}, count);'.format(instr.op, dst, srcs[0], _scalar_literal(instr.scalar, instr.dtype))
+    # fp32 -> fp16 需要指定舍入方式，fp16 -> fp32 是精确转换
+    mode = 'CAST_ROUND' if instr.dtype == 'float16' else 'CAST_NONE'
+    return 'Cast({}, {}, RoundMode::{}, count);'.format(dst, srcs[0], mode)
+
+
+def gen_kernel(kernel):
+    prog = kernel.prog
+    op_type = prog.op_type
+    cls = kernel.class_name
+    out = prog.output_name
+    out_type = CTYPES[prog.output_dtype]
+    gm_args = ', '.join('GM_ADDR ' + v.name for v in prog.inputs) + ', GM_ADDR ' + out
+    lines = [
+        '// ' + GEN_NOTE.format(op_type),
+        '// expression: ' + ' '.join(prog.expression.split()),
+        '#include "kernel_operator.h"',
+        'using namespace AscendC;',
+        '',
+        'constexpr int32_t BUFFER_NUM = {};'.format(BUFFER_NUM),
+        '',
+        'class {} {{'.format(cls),
+        'public:',
+        '    __aicore__ inline {}() {{}}'.format(cls),
+        '',
+        '    __aicore__ inline void Init({}, uint32_t totalLength, uint32_t blockLength, uint32_t tileLength)'.format(
+            gm_args),
+        '    {',
+        '        ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");',
+        '',
+        '        // 最后一个核只处理剩下的部分，长度仍是 32 字节对齐的',
+        '        uint32_t offset = blockLength * GetBlockIdx();',
+        '        this->length = totalLength - offset < blockLength ? totalLength - offset : blockLength;',
+        '        this->tileLength = tileLength;',
+        '',
+    ]
+    for value in prog.inputs:
+        lines.append('        {0}Gm.SetGlobalBuffer((__gm__ {1}*){0} + offset, this->length);'.format(
+            value.name, CTYPES[value.dtype]))
+    lines.append('        {0}Gm.SetGlobalBuffer((__gm__ {1}*){0} + offset, this->length);'.format(out, out_type))
+    lines.append('')
+    for value in prog.inputs:
+        lines.append('        pipe.InitBuffer({}, BUFFER_NUM, tileLength * sizeof({}));'.format(
+            _queue(value.name, 'in'), CTYPES[value.dtype]))
+    lines.append('        pipe.InitBuffer({}, BUFFER_NUM, tileLength * sizeof({}));'.format(_queue(out, 'out'), out_type))
+    for slot in kernel.tmp_slots:
+        lines.append('        pipe.InitBuffer(tmpBuffer{}, tileLength * {});'.format(slot.index, slot.width))
+    lines += [
+        '    }',
+        '',
+        '    __aicore__ inline void Process()',
+        '    {',
+        '        uint32_t loopCount = (this->length + this->tileLength - 1) / this->tileLength;',
+        '        for (uint32_t i = 0; i < loopCount; i++) {',
+        '            uint32_t offset = i * this->tileLength;',
+        '            uint32_t count = this->length - offset < this->tileLength ? this->length - offset : this->tileLength;',
+        '            CopyIn(offset, count);',
+        '            Compute(count);',
+        '            CopyOut(offset, count);',
+        '        }',
+        '    }',
+        '',
+        'private:',
+        '    __aicore__ inline void CopyIn(uint32_t offset, uint32_t count)',
+        '    {',
+    ]
+    for value in prog.inputs:
+        ctype = CTYPES[value.dtype]
+        lines += [
+            '        LocalTensor<{0}> {1}Local = {2}.AllocTensor<{0}>();'.format(ctype, value.name, _queue(value.name, 'in')),
+            '        DataCopy({0}Local, {0}Gm[offset], count);'.format(value.name),
+            '        {}.EnQue({}Local);'.format(_queue(value.name, 'in'), value.name),
+        ]
+    lines += [
+        '    }',
+        '',
+        '    __aicore__ inline void Compute(uint32_t count)',
+        '    {',
+    ]
+    for value in prog.inputs:
+        lines.append('        LocalTensor<{0}> {1}Local = {2}.DeQue<{0}>();'.format(
+            CTYPES[value.dtype], value.name, _queue(value.name, 'in')))
+    lines.append('        LocalTensor<{0}> {1}Local = {2}.AllocTensor<{0}>();'.format(out_type, out, _queue(out, 'out')))
+    for slot in kernel.tmp_slots:
+        for dtype in sorted(slot.dtypes):
+            lines.append('        LocalTensor<{0}> tmp{1}{2} = tmpBuffer{1}.Get<{0}>();'.format(
+                CTYPES[dtype], slot.index, 'F16' if dtype == 'float16' else 'F32'))
+    lines.append('')
+    for instr in prog.instrs:
+        lines.append('        ' + _gen_instr(kernel, instr))
+    lines.append('')
+    lines.append('        {}.EnQue<{}>({}Local);'.format(_queue(out, 'out'), out_type, out))
+    for value in prog.inputs:
+        lines.append('        {}.FreeTensor({}Local);'.format(_queue(value.name, 'in'), value.name))
+    lines += [
+        '    }',
+        '',
+        '    __aicore__ inline void CopyOut(uint32_t offset, uint32_t count)',
+        '    {',
+        '        LocalTensor<{0}> {1}Local = {2}.DeQue<{0}>();'.format(out_type, out, _queue(out, 'out')),
+        '        DataCopy({0}Gm[offset], {0}Local, count);'.format(out),
+        '        {}.FreeTensor({}Local);'.format(_queue(out, 'out'), out),
+        '    }',
+        '',
+        'private:',
+        '    TPipe pipe;',
+    ]
+    for value in prog.inputs:
+        lines.append('    TQue<QuePosition::VECIN, BUFFER_NUM> {};'.format(_queue(value.name, 'in')))
+    lines.append('    TQue<QuePosition::VECOUT, BUFFER_NUM> {};'.format(_queue(out, 'out')))
+    for slot in kernel.tmp_slots:
+        lines.append('    TBuf<QuePosition::VECCALC> tmpBuffer{};'.format(slot.index))
+    for value in prog.inputs:
+        lines.append('    GlobalTensor<{}> {}Gm;'.format(CTYPES[value.dtype], value.name))
+    lines.append('    GlobalTensor<{}> {}Gm;'.format(out_type, out))
+    call_args = ', '.join(v.name for v in prog.inputs) + ', ' + out
+    lines += [
+        '    uint32_t length;',
+        '    uint32_t tileLength;',
+        '};',
+        '',
+        'extern "C" __global__ __aicore__ void {}({}, GM_ADDR workspace, GM_ADDR tiling) {{'.format(
+            kernel.snake, gm_args),
+        '    GET_TILING_DATA(tiling_data, tiling);',
+        '    {} op;'.format(cls),
+        '    op.Init({}, tiling_data.totalLength, tiling_data.blockLength, tiling_data.tileLength);'.format(call_args),
+        '    op.Process();',
+        '}',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def _queue(name, kind):
+    return ('inQueue' if kind == 'in' else 'outQueue') + name[0].upper() + name[1:]
+
+
+def _write_if_changed(path, content):
+    # 内容不变时不改动文件时间戳，避免每次 cmake 配置都触发重新编译
+    if os.path.exists(path):
+        with open(path, 'r') as fd:
+            if fd.read() == content:
+                return False
+    with open(path, 'w') as fd:
+        fd.write(content)
+    return True
+
+
+def expression_ops(desc_file):
+    with open(desc_file, 'r') as fd:
+        return [op for op in json.load(fd) if 'expression' in op]
+
+
+def run_gen(args):
+    for op_desc in expression_ops(args.desc):
+        kernel = Kernel(op_desc)
+        outputs = {
+            os.path.join(args.host_dir, kernel.snake + '_tiling.h'): gen_tiling_header(kernel),
+            os.path.join(args.host_dir, kernel.snake + '.cpp'): gen_host(kernel),
+            os.path.join(args.kernel_dir, kernel.snake + '.cpp'): gen_kernel(kernel),
+        }
+        for path, content in outputs.items():
+            if _write_if_changed(path, content):
+                print('generate elementwise op source: ', path)
+        print('{}: {} instructions, {} temp buffers, {} UB bytes per element'.format(
+            kernel.prog.op_type, len(kernel.prog.instrs), len(kernel.tmp_slots), kernel.ub_bytes_per_element))
+    return 0
+
+
+# ---------------------------------------------------------------- numpy 校验
+
+def _np_apply(np, op, args, scalar, dtype):
+    a = args[0]
+    table = {
+        'Exp': lambda: np.exp(a), 'Ln': lambda: np.log(a), 'Abs': lambda: np.abs(a),
+        'Reciprocal': lambda: np.reciprocal(a), 'Sqrt': lambda: np.sqrt(a), 'Relu': lambda: np.maximum(a, 0),
+        'Add': lambda: a + args[1], 'Sub': lambda: a - args[1], 'Mul': lambda: a * args[1],
+        'Div': lambda: a / args[1], 'Max': lambda: np.maximum(a, args[1]), 'Min': lambda: np.minimum(a, args[1]),
+        'Adds': lambda: a + dtype(scalar), 'Muls': lambda: a * dtype(scalar),
+        'Maxs': lambda: np.maximum(a, dtype(scalar)), 'Mins': lambda: np.minimum(a, dtype(scalar)),
+        'Cast': lambda: a.astype(dtype),
+    }
+    return table[op]().astype(dtype)
+
+
+def simulate(np, kernel, feeds):
+    """按分配结果执行指令序列：每块缓冲区记录当前存放的值，读到被覆盖的值即为分配错误"""
+    storage = {}
+    owner = {}
+    for value in kernel.prog.inputs:
+        slot = kernel.slot_of[value.vid]
+        storage[id(slot)] = feeds[value.name]
+        owner[id(slot)] = value.vid
+    for instr in kernel.prog.instrs:
+        args = []
+        for arg in instr.args:
+            slot = kernel.slot_of[arg.vid]
+            if owner.get(id(slot)) != arg.vid:
+                raise CodegenError('{}: value %{} was overwritten before its last use'.format(
+                    kernel.prog.op_type, arg.vid))
+            args.append(storage[id(slot)])
+        result = _np_apply(np, instr.op, args, instr.scalar, getattr(np, instr.dtype))
+        slot = kernel.slot_of[instr.vid]
+        storage[id(slot)] = result
+        owner[id(slot)] = instr.vid
+    return storage[id(kernel.out_slot)]
+
+
+def reference(np, op_desc, feeds):
+    """不经过展开和缓冲区分配，直接按表达式求值，Mish 用 float64 的 x * tanh(log1p(exp(x)))"""
+    env = dict(feeds)
+
+    def ev(node):
+        if isinstance(node, ast.Name):
+            return env[node.id]
+        op = node.func.id
+        args = node.args
+        if op == 'Mish':
+            x = ev(args[0])
+            x64 = x.astype(np.float64)
+            return (x64 * np.tanh(np.logaddexp(0, x64))).astype(x.dtype)
+        if op == 'Cast':
+            return ev(args[0]).astype(getattr(np, DTYPES[args[1].value]))
+        first = ev(args[0])
+        dtype = first.dtype.type
+        if op in SCALAR_OPS:
+            return _np_apply(np, op, [first], _number(args[1]), dtype)
+        return _np_apply(np, op, [first] + [ev(arg) for arg in args[1:]], None, dtype)
+
+    for stmt in _parse_statements(op_desc['expression']).body:
+        env[stmt.targets[0].id] = ev(stmt.value)
+    return env[op_desc['output_desc'][0]['name']]
+
+
+def run_check(args):
+    import numpy as np
+    ok = True
+    for op_desc in expression_ops(args.desc):
+        kernel = Kernel(op_desc)
+        rng = np.random.default_rng(2024)
+        feeds = {}
+        for value in kernel.prog.inputs:
+            feeds[value.name] = rng.uniform(-10, 10, args.length).astype(getattr(np, value.dtype))
+        golden = reference(np, op_desc, feeds)
+        with np.errstate(all='ignore'):
+            result = simulate(np, kernel, feeds)
+        tol = 1e-3 if kernel.prog.output_dtype == 'float16' else 1e-4
+        diff = np.abs(result.astype(np.float64) - golden.astype(np.float64))
+        bad = int(np.count_nonzero(diff > tol * (1 + np.abs(golden.astype(np.float64)))))
+        passed = bad <= args.length * tol
+        ok = ok and passed
+        print('{}: max abs error {:.3e}, {} of {} elements out of tolerance, {}'.format(
+            kernel.prog.op_type, float(diff.max()), bad, args.length, 'pass' if passed else 'FAILED'))
+        if args.dump:
+            os.makedirs(args.dump, exist_ok=True)
+            for name, data in feeds.items():
+                data.tofile(os.path.join(args.dump, 'input_{}.bin'.format(name)))
+            golden.tofile(os.path.join(args.dump, 'golden_{}.bin'.format(kernel.snake)))
+    return 0 if ok else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description='generate fused elementwise ops from MishCustom.json expressions')
+    sub = parser.add_subparsers(dest='command')
+    gen = sub.add_parser('gen', help='生成 op_host / op_kernel 源码')
+    gen.add_argument('desc')
+    gen.add_argument('--host-dir', required=True)
+    gen.add_argument('--kernel-dir', required=True)
+    check = sub.add_parser('check', help='用 numpy 校验缓冲区分配和表达式展开')
+    check.add_argument('desc')
+    check.add_argument('--length', type=int, default=8 * 2048)
+    check.add_argument('--dump', help='写出 CPU 调测用的输入和标杆数据的目录')
+    args = parser.parse_args()
+    try:
+        if args.command == 'gen':
+            return run_gen(args)
+        if args.command == 'check':
+            return run_check(args)
+    except CodegenError as err:
+        print('[ERROR] {}'.format(err))
+        return 1
+    parser.print_help()
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
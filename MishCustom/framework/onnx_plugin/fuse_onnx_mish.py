@@ -0,0 +1,142 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+把 onnx 模型里拆开的 mish（x * tanh(softplus(x))）改写成单个 custom::MishCustom 节点，
+ATC 转换时由 onnx_mish_custom_plugin.cc 按 "custom::1::MishCustom" 映射到 MishCustom。识别两种 softplus 写法：
+    Softplus(x)
+    Log(Add(Exp(x), 1))
+改写后的节点放在自定义域里，并补上该域的 opset_import，任何 ai.onnx opset 的模型都能通过 onnx.checker；
+标准 Mish 只在 opset >= 18 存在，模型里原有的 Mish 节点由插件按 "ai.onnx::18::Mish" 映射。
+    python3 fuse_onnx_mish.py model.onnx model_mish.onnx [--no-check]
+"""
+import argparse
+import sys
+
+import numpy as np
+import onnx
+from onnx import helper, numpy_helper
+
+# 与 onnx_mish_custom_plugin.cc 里注册的 OriginOpType 保持一致
+CUSTOM_DOMAIN = 'custom'
+CUSTOM_DOMAIN_VERSION = 1
+CUSTOM_OP_TYPE = 'MishCustom'
+
+
+def build_index(graph, nodes):
+    producer = {}
+    consumers = {}
+    for node in nodes:
+        for out in node.output:
+            producer[out] = node
+        for inp in node.input:
+            consumers.setdefault(inp, []).append(node)
+    constants = {init.name: numpy_helper.to_array(init) for init in graph.initializer}
+    for node in nodes:
+        if node.op_type == 'Constant':
+            for attr in node.attribute:
+                if attr.name == 'value':
+                    constants[node.output[0]] = numpy_helper.to_array(attr.t)
+    return producer, consumers, constants
+
+
+def is_one(name, constants):
+    value = constants.get(name)
+    return value is not None and value.size == 1 and np.allclose(value.astype(np.float64), 1.0)
+
+
+def match_softplus(name, producer, consumers, constants, graph_outputs):
+    """返回 (softplus 的输入 x, 被吸收的节点列表)，不匹配时返回 (None, None)"""
+    def private(node):
+        # 中间结果只能被子图内部使用，否则删除后其他节点会断开
+        return all(len(consumers.get(out, [])) == 1 and out not in graph_outputs for out in node.output)
+
+    node = producer.get(name)
+    if node is None or not private(node):
+        return None, None
+    if node.op_type == 'Softplus':
+        return node.input[0], [node]
+    if node.op_type != 'Log':
+        return None, None
+    add = producer.get(node.input[0])
+    if add is None or add.op_type != 'Add' or not private(add):
+        return None, None
+    for exp_in, one in ((add.input[0], add.input[1]), (add.input[1], add.input[0])):
+        exp = producer.get(exp_in)
+        if exp is not None and exp.op_type == 'Exp' and private(exp) and is_one(one, constants):
+            return exp.input[0], [node, add, exp]
+    return None, None
+
+
+def import_custom_domain(model):
+    for opset in model.opset_import:
+        if opset.domain == CUSTOM_DOMAIN:
+            if opset.version != CUSTOM_DOMAIN_VERSION:
+                raise ValueError('model already imports domain {} version {}, expect {}'.format(
+                    CUSTOM_DOMAIN, opset.version, CUSTOM_DOMAIN_VERSION))
+            return
+    model.opset_import.extend([helper.make_opsetid(CUSTOM_DOMAIN, CUSTOM_DOMAIN_VERSION)])
+
+
+def fuse(model):
+    graph = model.graph
+    # 固定一份节点引用，下面用 id() 标记节点，不能每次重新从 repeated 字段取
+    nodes = list(graph.node)
+    producer, consumers, constants = build_index(graph, nodes)
+    graph_outputs = {out.name for out in graph.output}
+    removed = set()
+    replaced = {}
+    count = 0
+    for mul in nodes:
+        if mul.op_type != 'Mul' or len(mul.input) != 2:
+            continue
+        for x, other in ((mul.input[0], mul.input[1]), (mul.input[1], mul.input[0])):
+            tanh = producer.get(other)
+            if tanh is None or tanh.op_type != 'Tanh' or id(tanh) in removed:
+                continue
+            if len(consumers.get(tanh.output[0], [])) != 1 or tanh.output[0] in graph_outputs:
+                continue
+            softplus_in, absorbed = match_softplus(tanh.input[0], producer, consumers, constants, graph_outputs)
+            if softplus_in != x:
+                continue
+            for node in absorbed + [tanh]:
+                removed.add(id(node))
+            replaced[id(mul)] = helper.make_node(CUSTOM_OP_TYPE, [x], [mul.output[0]], name=mul.name or mul.output[0],
+                                                 domain=CUSTOM_DOMAIN)
+            count += 1
+            break
+
+    if count == 0:
+        return 0
+    import_custom_domain(model)
+    # 保持原有拓扑顺序：MishCustom 放在原 Mul 的位置
+    new_nodes = []
+    for node in nodes:
+        if id(node) in removed:
+            continue
+        kept = onnx.NodeProto()
+        kept.CopyFrom(replaced.get(id(node), node))
+        new_nodes.append(kept)
+    del graph.node[:]
+    graph.node.extend(new_nodes)
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description='fuse decomposed mish into custom::MishCustom nodes')
+    parser.add_argument('input', help='输入 onnx 模型')
+    parser.add_argument('output', help='输出 onnx 模型')
+    parser.add_argument('--no-check', action='store_true', help='不做 onnx.checker 检查')
+    args = parser.parse_args()
+
+    model = onnx.load(args.input)
+    count = fuse(model)
+    if not args.no_check:
+        onnx.checker.check_model(model)
+    onnx.save(model, args.output)
+    print('fused {} mish pattern(s) into {}::{}, saved to {}'.format(count, CUSTOM_DOMAIN, CUSTOM_OP_TYPE, args.output))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,34 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "register/register.h"
+
+namespace domi {
+// Mish 没有属性，直接沿用 onnx 节点的输入输出
+Status ParseParamsMishCustom(const ge::Operator &opSrc, ge::Operator &opDest)
+{
+    (void)opSrc;
+    (void)opDest;
+    return SUCCESS;
+}
+
+// register op info to GE
+// ai.onnx 从 opset 18 开始才有 Mish；fuse_onnx_mish.py 把 Softplus/Tanh/Mul 改写成自定义域的 custom::MishCustom，
+// 与模型的 ai.onnx opset 无关
+REGISTER_CUSTOM_OP("MishCustom")
+    .FrameworkType(ONNX)   // type: CAFFE, TENSORFLOW, ONNX
+    .OriginOpType({ ge::AscendString("ai.onnx::18::Mish"),
+                    ge::AscendString("custom::1::MishCustom") })  // name in onnx module
+    .ParseParamsByOperatorFn(ParseParamsMishCustom);
+}  // namespace domi
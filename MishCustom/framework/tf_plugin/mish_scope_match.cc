@@ -0,0 +1,176 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include "mish_scope_match.h"
+
+#include <map>
+
+namespace ge {
+namespace {
+const char *const kControlPrefix = "^";
+
+bool IsControl(const std::string &input)
+{
+    return input.compare(0, 1, kControlPrefix) == 0;
+}
+
+// "node" 与 "node:0" 是同一个张量，统一成 "node:0"；控制边返回节点名
+std::string Canonical(const std::string &input)
+{
+    if (IsControl(input)) {
+        return input.substr(1);
+    }
+    size_t colon = input.rfind(':');
+    if (colon == std::string::npos || colon + 1 == input.size() ||
+        input.find_first_not_of("0123456789", colon + 1) != std::string::npos) {
+        return input + ":0";
+    }
+    return input;
+}
+
+std::string NodeOf(const std::string &tensor)
+{
+    size_t colon = tensor.rfind(':');
+    return colon == std::string::npos ? tensor : tensor.substr(0, colon);
+}
+
+std::vector<std::string> DataInputs(const MishGraphNode &node)
+{
+    std::vector<std::string> inputs;
+    for (const auto &input : node.inputs) {
+        if (!IsControl(input)) {
+            inputs.push_back(input);
+        }
+    }
+    return inputs;
+}
+
+class ScopeView {
+public:
+    ScopeView(const std::vector<MishGraphNode> &graph, const std::string &scopeName) : scopeName_(scopeName)
+    {
+        for (const auto &node : graph) {
+            byName_[node.name] = &node;
+        }
+    }
+
+    bool InScope(const std::string &nodeName) const
+    {
+        return nodeName.compare(0, scopeName_.size(), scopeName_) == 0;
+    }
+
+    // 穿过 scope 内的 Identity，得到真正产生该张量的输出；控制边同样按节点穿过
+    std::string Resolve(const std::string &input) const
+    {
+        bool control = IsControl(input);
+        std::string tensor = Canonical(input);
+        // Identity 链最长不超过节点数，防止环
+        for (size_t hops = 0; hops <= byName_.size(); ++hops) {
+            std::string nodeName = control ? tensor : NodeOf(tensor);
+            auto it = byName_.find(nodeName);
+            if (it == byName_.end() || !InScope(nodeName) || it->second->type != "Identity") {
+                return tensor;
+            }
+            std::vector<std::string> inputs = DataInputs(*it->second);
+            if (inputs.empty()) {
+                return tensor;
+            }
+            tensor = Canonical(inputs[0]);
+            if (control) {
+                tensor = NodeOf(tensor);
+            }
+        }
+        return tensor;
+    }
+
+private:
+    std::string scopeName_;
+    std::map<std::string, const MishGraphNode *> byName_;
+};
+}  // namespace
+
+bool MatchMishScope(const std::vector<MishGraphNode> &graph, const std::string &scopeName, MishScopeMatch *match)
+{
+    if (scopeName.empty() || scopeName[scopeName.size() - 1] != '/') {
+        return false;
+    }
+    ScopeView view(graph, scopeName);
+    std::map<std::string, const MishGraphNode *> byType;
+    for (const auto &node : graph) {
+        if (!view.InScope(node.name) || node.type == "Identity") {
+            continue;
+        }
+        // 同一类型出现两次就不是单个 mish
+        if (!byType.emplace(node.type, &node).second) {
+            return false;
+        }
+    }
+    bool softplusForm = byType.size() == 3 && byType.count("Softplus") != 0;
+    bool log1pForm = byType.size() == 4 && byType.count("Exp") != 0 && byType.count("Log1p") != 0;
+    if ((!softplusForm && !log1pForm) || byType.count("Tanh") == 0 || byType.count("Mul") == 0) {
+        return false;
+    }
+
+    const MishGraphNode &first = *byType[softplusForm ? "Softplus" : "Exp"];
+    const MishGraphNode &softplus = *byType[softplusForm ? "Softplus" : "Log1p"];
+    const MishGraphNode &tanh = *byType["Tanh"];
+    const MishGraphNode &mul = *byType["Mul"];
+    std::vector<std::string> firstInputs = DataInputs(first);
+    std::vector<std::string> softplusInputs = DataInputs(softplus);
+    std::vector<std::string> tanhInputs = DataInputs(tanh);
+    std::vector<std::string> mulInputs = DataInputs(mul);
+    if (firstInputs.size() != 1 || softplusInputs.size() != 1 || tanhInputs.size() != 1 || mulInputs.size() != 2) {
+        return false;
+    }
+
+    // Log1p 读 Exp，Tanh 读 softplus
+    if (log1pForm && view.Resolve(softplusInputs[0]) != first.name + ":0") {
+        return false;
+    }
+    if (view.Resolve(tanhInputs[0]) != softplus.name + ":0") {
+        return false;
+    }
+    // x 来自 scope 外，Mul 的两路是 x 与 Tanh，顺序不限
+    std::string x = view.Resolve(firstInputs[0]);
+    if (view.InScope(NodeOf(x))) {
+        return false;
+    }
+    std::string mul0 = view.Resolve(mulInputs[0]);
+    std::string mul1 = view.Resolve(mulInputs[1]);
+    std::string tanhOut = tanh.name + ":0";
+    if (!((mul0 == x && mul1 == tanhOut) || (mul0 == tanhOut && mul1 == x))) {
+        return false;
+    }
+
+    // 融合后只保留 Mul 的输出，其余中间结果被 scope 外使用时不能删
+    for (const auto &node : graph) {
+        if (view.InScope(node.name)) {
+            continue;
+        }
+        for (const auto &input : node.inputs) {
+            std::string producer = IsControl(input) ? view.Resolve(input) : NodeOf(view.Resolve(input));
+            if (producer == first.name || producer == softplus.name || producer == tanh.name) {
+                return false;
+            }
+        }
+    }
+
+    if (match != nullptr) {
+        match->first = first.name;
+        match->mul = mul.name;
+        match->x = x;
+    }
+    return true;
+}
+}  // namespace ge
@@ -0,0 +1,54 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#ifndef MISH_SCOPE_MATCH_H
+#define MISH_SCOPE_MATCH_H
+
+#include <string>
+#include <vector>
+
+namespace ge {
+/**
+ * 图中一个节点的连线信息，与 TF NodeDef 的 name/op/input 对应。
+ * input 保持 TF 的写法："node"、"node:1"，控制边为 "^node"
+ */
+struct MishGraphNode {
+    std::string name;
+    std::string type;
+    std::vector<std::string> inputs;
+};
+
+/**
+ * 匹配成功时 scope 内的关键节点
+ */
+struct MishScopeMatch {
+    std::string first;   // softplus 分支的第一个节点（Softplus 或 Exp），其输入 0 就是 x
+    std::string mul;     // 输出 mish 结果的 Mul
+    std::string x;       // x 所在的张量，scope 外的某个输出
+};
+
+/**
+ * @brief 按连线确认 scope 内恰好是一个 x * tanh(softplus(x))，softplus 写作 Softplus 或 Log1p(Exp)
+ * 要求：scope 内除 Identity 外只有这几个节点；softplus 分支读的张量与 Mul 的另一路输入相同且来自 scope 外；
+ * Tanh 读 softplus、Mul 读 Tanh；除 Mul 外的中间结果不被 scope 外的节点使用（包括控制边）。
+ * scope 内的 Identity 视为其输入的别名。
+ * @param [in] graph: 整张图的节点
+ * @param [in] scopeName: scope 名，以 "/" 结尾，如 "model/mish/"
+ * @param [out] match: 匹配成功时填写，可为 nullptr
+ * @return 是否匹配
+ */
+bool MatchMishScope(const std::vector<MishGraphNode> &graph, const std::string &scopeName, MishScopeMatch *match);
+}  // namespace ge
+
+#endif  // MISH_SCOPE_MATCH_H
@@ -15,9 +15,18 @@ rights reserved.
 #include "register/register.h"
 
 namespace domi {
+// ScopeMishPass 把 Softplus/Tanh/Mul 子图融合成的 MishCustom 节点，没有需要从子图节点中解析的属性
+Status FusionParseParamsMish(const std::vector<ge::Operator> &insideNodes, ge::Operator &opDest)
+{
+    (void)insideNodes;
+    (void)opDest;
+    return SUCCESS;
+}
+
 // register op info to GE
 REGISTER_CUSTOM_OP("MishCustom")
     .FrameworkType(TENSORFLOW)   // type: CAFFE, TENSORFLOW
     .OriginOpType("MishCustom")      // name in tf module
-    .ParseParamsByOperatorFn(AutoMappingByOpFn);
+    .ParseParamsByOperatorFn(AutoMappingByOpFn)
+    .FusionParseParamsFn(FusionParseParamsMish);
 }  // namespace domi
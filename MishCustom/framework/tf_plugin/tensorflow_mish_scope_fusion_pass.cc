@@ -0,0 +1,163 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "register/register.h"
+#include "register/scope/scope_fusion_pass_register.h"
+#include "mish_scope_match.h"
+
+namespace ge {
+namespace {
+// 两种 mish 写法对应的 scope 子类型
+const char *const kScopeTypeMishSoftplus = "MishSoftplusScope";
+const char *const kScopeTypeMishLog1pExp = "MishLog1pExpScope";
+const char *const kScopeInvalidType = "invalid";
+
+// 把 softplus 写作 Softplus 或 Log1p(Exp) 的两种 mish 子图，各节点在 scope 内恰好出现一次
+const std::vector<std::vector<std::string>> kMishOpTypes = {
+    { "Softplus", "Tanh", "Mul" },
+    { "Exp", "Log1p", "Tanh", "Mul" },
+};
+
+std::string GetOpType(const ge::OperatorPtr &op)
+{
+    ge::AscendString type;
+    (void)op->GetOpType(type);
+    return type.GetString() == nullptr ? "" : type.GetString();
+}
+
+// scope 图里的算子按 NodeDef 建立，输入描述以 TF 的输入串（"node"、"node:1"、"^node"）命名。
+// 取不到输入时该节点没有连线，MatchMishScope 因此不会匹配，宁可不融合也不误改写
+std::vector<MishGraphNode> CollectGraph(const ScopeGraph &scopeGraph)
+{
+    std::vector<MishGraphNode> graph;
+    for (const auto &item : scopeGraph.GetNodesMap()) {
+        if (item.second == nullptr) {
+            continue;
+        }
+        MishGraphNode node;
+        node.name = item.first;
+        node.type = GetOpType(item.second);
+        for (size_t i = 0; i < item.second->GetInputsSize(); ++i) {
+            ge::TensorDesc desc = item.second->GetInputDesc(static_cast<uint32_t>(i));
+            ge::AscendString input;
+            if (desc.GetName(input) == ge::GRAPH_SUCCESS && input.GetString() != nullptr) {
+                node.inputs.push_back(input.GetString());
+            }
+        }
+        graph.push_back(node);
+    }
+    return graph;
+}
+}  // namespace
+
+/**
+ * 把 x * tanh(softplus(x)) 的 name scope（如 Keras/tfa 导出的 .../mish/）融合成一个 MishCustom 节点。
+ * scope 融合按 name scope 匹配，所以只有整个 mish 单独处在一个 scope 中、且 scope 内没有其他节点时才会融合；
+ * 散落在同一 scope 中的 Softplus/Tanh/Mul 不会被改写。类型特征命中后再由 MatchMishScope 按连线确认，
+ * a * tanh(softplus(b)) 或中间结果被 scope 外使用的子图不融合。
+ * 注册为非通用 pass，转换时用 atc --enable_scope_fusion_passes=ScopeMishPass 打开。
+ */
+class ScopeMishPass : public ScopeBasePass {
+protected:
+    std::vector<ScopeFusionPatterns> DefinePatterns() override;
+    std::string PassName() override;
+    Status LastMatchScopesAndOPs(std::shared_ptr<ScopeGraph> &scopeGraph, std::vector<ScopesResult> &results) override;
+    void GenerateFusionResult(const std::vector<Scope *> &scopes, FusionScopesResult *fusionRlt) override;
+
+private:
+    std::map<std::string, MishScopeMatch> matches_;
+};
+
+std::vector<ScopeFusionPatterns> ScopeMishPass::DefinePatterns()
+{
+    std::vector<ScopeFusionPatterns> patternsList;
+    const char *subTypes[] = { kScopeTypeMishSoftplus, kScopeTypeMishLog1pExp };
+    for (size_t i = 0; i < kMishOpTypes.size(); ++i) {
+        ScopePattern *pattern = new (std::nothrow) ScopePattern();
+        if (pattern == nullptr) {
+            return patternsList;
+        }
+        pattern->SetSubType(subTypes[i]);
+        for (const auto &opType : kMishOpTypes[i]) {
+            pattern->AddNodeOpTypeFeature(NodeOpTypeFeature(opType, 1, 0));
+        }
+        ScopeFusionPatterns patterns;
+        patterns.push_back({ pattern });
+        patternsList.push_back(patterns);
+    }
+    return patternsList;
+}
+
+std::string ScopeMishPass::PassName()
+{
+    return "ScopeMishPass";
+}
+
+Status ScopeMishPass::LastMatchScopesAndOPs(std::shared_ptr<ScopeGraph> &scopeGraph,
+                                            std::vector<ScopesResult> &results)
+{
+    if (scopeGraph == nullptr) {
+        return domi::PARAM_INVALID;
+    }
+    const ScopeTree *scopeTree = scopeGraph->GetScopeTree();
+    if (scopeTree == nullptr) {
+        return domi::PARAM_INVALID;
+    }
+    matches_.clear();
+    std::vector<MishGraphNode> graph = CollectGraph(*scopeGraph);
+    for (auto &scope : scopeTree->GetAllScopes()) {
+        std::string subType = scope->SubType();
+        if (subType != kScopeTypeMishSoftplus && subType != kScopeTypeMishLog1pExp) {
+            continue;
+        }
+        MishScopeMatch match;
+        if (!MatchMishScope(graph, scope->Name(), &match)) {
+            continue;
+        }
+        matches_[scope->Name()] = match;
+        ScopesResult result;
+        std::vector<Scope *> resultScopes = { scope };
+        result.SetScopes(resultScopes);
+        results.push_back(result);
+    }
+    return results.empty() ? FAILED : SUCCESS;
+}
+
+void ScopeMishPass::GenerateFusionResult(const std::vector<Scope *> &scopes, FusionScopesResult *fusionRlt)
+{
+    if (fusionRlt == nullptr) {
+        return;
+    }
+    auto it = scopes.size() == 1 ? matches_.find(scopes[0]->Name()) : matches_.end();
+    if (it == matches_.end()) {
+        fusionRlt->SetType(kScopeInvalidType);
+        return;
+    }
+    // softplus 分支的第一个节点提供 x；Mul 的两个输入一个是 x、一个是 Tanh，x 已经由上面映射，两路都不再单独接入
+    fusionRlt->InsertInputs(it->second.first, { 0 });
+    fusionRlt->InsertInputs(it->second.mul, { kFusionDisableIndex, kFusionDisableIndex });
+    fusionRlt->InsertOutputs(it->second.mul, { 0 });
+    fusionRlt->SetType("MishCustom");
+    fusionRlt->SetDescription("x * tanh(softplus(x)) fused into MishCustom");
+    std::string scopeName = scopes[0]->Name();
+    fusionRlt->SetName(scopeName.substr(0, scopeName.length() - 1));
+}
+
+REGISTER_SCOPE_FUSION_PASS("ScopeMishPass", ScopeMishPass, false);
+}  // namespace ge
@@ -0,0 +1,129 @@
+#include "gated_mish_custom_tiling.h"
+#include "register/op_def_registry.h"
+
+namespace optiling {
+    // DataCopy 以 32 字节为单位搬运，halfDim 需要是 16 个 fp16 的整数倍
+    const uint32_t ALIGN_ELEMENTS = 16;
+    // 单个分块的最大元素数，两路输入、输出双缓冲和一块中间结果一起放进 UB
+    const uint32_t MAX_TILE_ELEMENTS = 4096;
+
+    /**
+    * @brief TilingFunc 按行把数据分给各个核，再在核内按 tileRows x tileCols 分块。
+    *
+    * 一行放得下时整行作为一个分块的列，多行拼成一个分块；行太长时每次只搬一行中的一段。
+    *
+    * @param context 当前的分块上下文，包含输入输出的形状信息。
+    * @return 成功返回 ge::GRAPH_SUCCESS，最后一维不是 32 的整数倍时返回 ge::GRAPH_FAILED。
+    */
+    static ge::graphStatus TilingFunc(gert::TilingContext* context)
+    {
+        GatedMishCustomTilingData tiling;
+
+        // 定义最多使用的核数
+        const uint32_t BLOCK_DIM = 8;
+
+        const gert::Shape& shape = context->GetInputShape(0)->GetOriginShape();
+        size_t dimNum = shape.GetDimNum();
+        if (dimNum == 0) {
+            return ge::GRAPH_FAILED;
+        }
+        uint32_t lastDim = shape.GetDim(dimNum - 1);
+        if (lastDim == 0 || lastDim % (2 * ALIGN_ELEMENTS) != 0) {
+            return ge::GRAPH_FAILED;
+        }
+        uint32_t halfDim = lastDim / 2;
+        uint32_t totalRows = shape.GetShapeSize() / lastDim;
+
+        // 行数不足 BLOCK_DIM 时只启动 totalRows 个核
+        uint32_t blockRows = (totalRows + BLOCK_DIM - 1) / BLOCK_DIM;
+        uint32_t blockDim = (totalRows + blockRows - 1) / blockRows;
+
+        // 列方向取不超过 MAX_TILE_ELEMENTS 且能整除 halfDim 的最大对齐长度
+        uint32_t tileCols = halfDim < MAX_TILE_ELEMENTS ? halfDim : MAX_TILE_ELEMENTS;
+        while (halfDim % tileCols != 0) {
+            tileCols -= ALIGN_ELEMENTS;
+        }
+        uint32_t tileRows = MAX_TILE_ELEMENTS / tileCols;
+        if (tileRows > blockRows) {
+            tileRows = blockRows;
+        }
+
+        context->SetBlockDim(blockDim);
+        tiling.set_totalRows(totalRows);
+        tiling.set_halfDim(halfDim);
+        tiling.set_blockRows(blockRows);
+        tiling.set_tileRows(tileRows);
+        tiling.set_tileCols(tileCols);
+
+        tiling.SaveToBuffer(context->GetRawTilingData()->GetData(),
+            context->GetRawTilingData()->GetCapacity());
+        context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+
+        size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+        currentWorkspace[0] = 0;
+
+        return ge::GRAPH_SUCCESS;
+    }
+}
+
+namespace ge {
+    /**
+    * @brief InferShape 函数：输出与输入相同，只是最后一维减半。
+    *
+    * @param context 形状推理的上下文，包含输入输出的形状信息。
+    * @return 成功返回 GRAPH_SUCCESS，最后一维为奇数时返回 GRAPH_FAILED。
+    */
+    static ge::graphStatus InferShape(gert::InferShapeContext* context)
+    {
+        const gert::Shape* x_shape = context->GetInputShape(0);
+        gert::Shape* y_shape = context->GetOutputShape(0);
+
+        size_t dimNum = x_shape->GetDimNum();
+        if (dimNum == 0 || x_shape->GetDim(dimNum - 1) % 2 != 0) {
+            return GRAPH_FAILED;
+        }
+        *y_shape = *x_shape;
+        y_shape->SetDim(dimNum - 1, x_shape->GetDim(dimNum - 1) / 2);
+
+        return GRAPH_SUCCESS;
+    }
+}
+
+namespace ops {
+    /**
+    * @brief GatedMishCustom：GLU 形式的门控 Mish。
+    *
+    * 把最后一维平分为 [a, b] 两半，y = a * Mish(b)，替代 Split + Mish + Mul，
+    * 不再产生两个中间张量。
+    */
+    class GatedMishCustom : public OpDef {
+    public:
+        /**
+        * @brief 构造函数，初始化 GatedMishCustom 算子的输入输出及相关配置。
+        *
+        * @param name 算子的名称。
+        */
+        explicit GatedMishCustom(const char* name) : OpDef(name)
+        {
+            this->Input("x")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->Output("y")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->SetInferShape(ge::InferShape);
+
+            this->AICore()
+                .SetTiling(optiling::TilingFunc);
+            this->AICore().AddConfig("ascend310b");
+        }
+    };
+
+    OP_ADD(GatedMishCustom);
+}
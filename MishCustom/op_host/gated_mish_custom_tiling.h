@@ -0,0 +1,16 @@
+#include "register/tilingdata_base.h"
+/**
+GatedMishCustom 的 tiling 数据：输入看作 [totalRows, 2 * halfDim] 的矩阵，
+每个核处理连续的 blockRows 行（最后一个核可能更少），
+每次搬运 tileRows 行 x tileCols 列，左右两半各用一路带行跨度的 DataCopy 读入。
+**/
+namespace optiling {
+	BEGIN_TILING_DATA_DEF(GatedMishCustomTilingData)
+	TILING_DATA_FIELD_DEF(uint32_t, totalRows);
+	TILING_DATA_FIELD_DEF(uint32_t, halfDim);
+	TILING_DATA_FIELD_DEF(uint32_t, blockRows);
+	TILING_DATA_FIELD_DEF(uint32_t, tileRows);
+	TILING_DATA_FIELD_DEF(uint32_t, tileCols);
+	END_TILING_DATA_DEF;
+	REGISTER_TILING_DATA_CLASS(GatedMishCustom, GatedMishCustomTilingData)
+}
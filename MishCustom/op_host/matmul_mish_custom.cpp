@@ -0,0 +1,155 @@
+#include "matmul_mish_custom_tiling.h"
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+
+using namespace matmul_tiling;
+
+namespace optiling {
+    // Cube 的分形边长，M/N/K 需要是它的整数倍
+    const int32_t FRACTAL = 16;
+    // 输出分块的上限
+    const int32_t MAX_BASE = 128;
+    // Mish 后处理每个输出元素占用的 UB：fp32 的 C 分块、两块 fp32 中间结果和 fp16 的输出
+    const int32_t EPILOGUE_BYTES_PER_ELEMENT = 4 + 4 + 4 + 2;
+
+    /**
+    * @brief TilingFunc 生成 Matmul 的多核 tiling，并让 baseM x baseN 的输出分块与 Mish 后处理共用 UB。
+    *
+    * 先取 baseN，再按 UB 的一半能放下多少后处理元素算出 baseM，剩下的 UB 通过 SetBufferSpace 交给 Matmul。
+    * 核内按整块写回、不处理尾块：要求 M/N 能被单核的 singleCoreM/singleCoreN 整除，
+    * 单核的 M/N 又能被 baseM/baseN 整除，不满足的形状在这里拒绝，而不是让核写出越界或缺块的结果。
+    *
+    * @param context 当前的分块上下文，包含输入输出的形状信息。
+    * @return 成功返回 ge::GRAPH_SUCCESS，形状不满足对齐或整除要求、Matmul tiling 失败时返回 ge::GRAPH_FAILED。
+    */
+    static ge::graphStatus TilingFunc(gert::TilingContext* context)
+    {
+        auto ascendcPlatform = platform_ascendc::PlatformAscendC(context->GetPlatformInfo());
+        const gert::Shape& aShape = context->GetInputShape(0)->GetOriginShape();
+        const gert::Shape& bShape = context->GetInputShape(1)->GetOriginShape();
+        int32_t M = aShape.GetDim(0);
+        int32_t K = aShape.GetDim(1);
+        int32_t N = bShape.GetDim(1);
+        if (M % FRACTAL != 0 || N % FRACTAL != 0 || K % FRACTAL != 0 || bShape.GetDim(0) != K) {
+            return ge::GRAPH_FAILED;
+        }
+
+        uint64_t ubSize = 0;
+        ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+        int32_t baseN = N < MAX_BASE ? N : MAX_BASE;
+        int32_t baseM = static_cast<int32_t>(ubSize / 2 / (baseN * EPILOGUE_BYTES_PER_ELEMENT)) / FRACTAL * FRACTAL;
+        baseM = baseM < MAX_BASE ? baseM : MAX_BASE;
+        baseM = baseM < M ? baseM : M;
+        if (baseM == 0) {
+            return ge::GRAPH_FAILED;
+        }
+        int32_t epilogueBytes = baseM * baseN * EPILOGUE_BYTES_PER_ELEMENT;
+
+        MultiCoreMatmulTiling cubeTiling(ascendcPlatform);
+        cubeTiling.SetDim(ascendcPlatform.GetCoreNumAiv());
+        cubeTiling.SetAType(TPosition::GM, CubeFormat::ND, matmul_tiling::DataType::DT_FLOAT16);
+        cubeTiling.SetBType(TPosition::GM, CubeFormat::ND, matmul_tiling::DataType::DT_FLOAT16);
+        // C 直接输出到 UB，由核内做 Mish 后再写回 GM
+        cubeTiling.SetCType(TPosition::VECIN, CubeFormat::ND, matmul_tiling::DataType::DT_FLOAT);
+        cubeTiling.SetBiasType(TPosition::GM, CubeFormat::ND, matmul_tiling::DataType::DT_FLOAT);
+        cubeTiling.SetShape(M, N, K);
+        cubeTiling.SetOrgShape(M, N, K);
+        cubeTiling.SetFixSplit(baseM, baseN, -1);
+        cubeTiling.SetBias(true);
+        cubeTiling.SetBufferSpace(-1, -1, static_cast<int32_t>(ubSize) - epilogueBytes);
+
+        MatmulMishCustomTilingData tiling;
+        if (cubeTiling.GetTiling(tiling.cubeTilingData) == -1) {
+            return ge::GRAPH_FAILED;
+        }
+        int32_t singleCoreM = tiling.cubeTilingData.get_singleCoreM();
+        int32_t singleCoreN = tiling.cubeTilingData.get_singleCoreN();
+        if (singleCoreM <= 0 || singleCoreN <= 0 || M % singleCoreM != 0 || N % singleCoreN != 0 ||
+            singleCoreM % baseM != 0 || singleCoreN % baseN != 0) {
+            return ge::GRAPH_FAILED;
+        }
+
+        context->SetBlockDim(tiling.cubeTilingData.get_usedCoreNum());
+        tiling.SaveToBuffer(context->GetRawTilingData()->GetData(),
+            context->GetRawTilingData()->GetCapacity());
+        context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+
+        // Matmul 高阶 API 需要系统 workspace，算子本身不使用 workspace
+        size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+        currentWorkspace[0] = ascendcPlatform.GetLibApiWorkSpaceSize();
+
+        return ge::GRAPH_SUCCESS;
+    }
+}
+
+namespace ge {
+    /**
+    * @brief InferShape 函数：y = [M, N]，M 来自 a = [M, K]，N 来自 b = [K, N]。
+    *
+    * @param context 形状推理的上下文，包含输入输出的形状信息。
+    * @return 返回图计算状态，成功则返回 GRAPH_SUCCESS。
+    */
+    static ge::graphStatus InferShape(gert::InferShapeContext* context)
+    {
+        const gert::Shape* a_shape = context->GetInputShape(0);
+        const gert::Shape* b_shape = context->GetInputShape(1);
+        gert::Shape* y_shape = context->GetOutputShape(0);
+
+        y_shape->SetDimNum(2);
+        y_shape->SetDim(0, a_shape->GetDim(0));
+        y_shape->SetDim(1, b_shape->GetDim(1));
+
+        return GRAPH_SUCCESS;
+    }
+}
+
+namespace ops {
+    /**
+    * @brief MatmulMishCustom：y = Mish(a @ b + bias)。
+    *
+    * Matmul 的 fp32 结果分块留在 UB 中直接做 Mish 并转成 fp16 写回，
+    * 省掉 Matmul 写 GM、KernelMish 再读回来的一整轮 HBM 读写。
+    */
+    class MatmulMishCustom : public OpDef {
+    public:
+        /**
+        * @brief 构造函数，初始化 MatmulMishCustom 算子的输入输出及相关配置。
+        *
+        * @param name 算子的名称。
+        */
+        explicit MatmulMishCustom(const char* name) : OpDef(name)
+        {
+            this->Input("a")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->Input("b")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->Input("bias")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->Output("y")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->SetInferShape(ge::InferShape);
+
+            this->AICore()
+                .SetTiling(optiling::TilingFunc);
+            this->AICore().AddConfig("ascend310b");
+        }
+    };
+
+    OP_ADD(MatmulMishCustom);
+}
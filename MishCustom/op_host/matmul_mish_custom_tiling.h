@@ -0,0 +1,12 @@
+#include "register/tilingdata_base.h"
+#include "tiling/tiling_api.h"
+/**
+MatmulMishCustom 的 tiling 数据：cubeTilingData 由 Matmul 高阶 API 的 MultiCoreMatmulTiling 生成，
+其中 baseM x baseN 的输出分块大小按照 Mish 后处理需要的 UB 空间选定。
+**/
+namespace optiling {
+	BEGIN_TILING_DATA_DEF(MatmulMishCustomTilingData)
+	TILING_DATA_FIELD_DEF_STRUCT(TCubeTiling, cubeTilingData);
+	END_TILING_DATA_DEF;
+	REGISTER_TILING_DATA_CLASS(MatmulMishCustom, MatmulMishCustomTilingData)
+}
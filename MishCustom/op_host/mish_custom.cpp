@@ -1,7 +1,20 @@
 #include "mish_custom_tiling.h"
 #include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
 
 namespace optiling {
+    // kernel 在用户 workspace 中为每个核写 8 个 int32 的路径计数，与 op_kernel/mish_custom.cpp 的 PATH_COUNTER_NUM 一致
+    const uint32_t PATH_COUNTER_BYTES = 8 * sizeof(int32_t);
+
+    // GM 一次突发传输的字节数，各核起始地址按它对齐时搬运不会跨突发拆分
+    const uint32_t GM_BURST_BYTES = 512;
+
+    // DataCopy 的最小粒度，也是旧版按核均分时的对齐单位
+    const uint32_t DATA_COPY_ALIGN_BYTES = 32;
+
+    // 单个 tile 的元素上限：x、y、t 各两份队列加两块临时缓冲共 8 份 float16，约 64KB，留出 UB 余量
+    const uint32_t MAX_TILE_LENGTH = 4096;
+
     /**
     * @brief TilingFunc 函数负责将输入数据进行分块（Tile）处理。
     *
@@ -17,18 +30,60 @@ namespace optiling {
         // 定义每次计算操作需要处理的块的数量
         const uint32_t BLOCK_DIM = 8;
 
-        // 定义在每个计算块中进一步划分的子块数量
+        // 定义每个核期望切出的 tile 数，双缓冲时每份队列轮转 TILE_NUM 次
         const uint32_t TILE_NUM = 8;
+        const uint32_t BUFFER_NUM = 2;
+
+        // 输入只支持 float16
+        const uint32_t TYPE_SIZE = sizeof(uint16_t);
 
         // 获取输入数据的总长度（元素数量）
         uint32_t totalLength = context->GetInputShape(0)->GetOriginShape().GetShapeSize();
 
+        // 尾块也要能整块 DataCopy，否则最后不足 32 字节的数据会被漏掉
+        const uint32_t alignLength = DATA_COPY_ALIGN_BYTES / TYPE_SIZE;
+        if (totalLength % alignLength != 0) {
+            return ge::GRAPH_FAILED;
+        }
+
+        // 以划分单位计的总量均分到各核，多出的单位前几个核各分一个，不足一个单位的余数交给最后一个核。
+        // 划分单位默认是 GM 突发长度；属性 burst_align 仅供性能对比，关掉时退回 32 字节粒度
+        const bool* burstAlign = context->GetAttrs()->GetAttrPointer<bool>(1);
+        const bool aligned = burstAlign == nullptr || *burstAlign;
+        const uint32_t unitLength = (aligned ? GM_BURST_BYTES : DATA_COPY_ALIGN_BYTES) / TYPE_SIZE;
+        uint32_t unitCount = totalLength / unitLength;
+        uint32_t formerNum = unitCount % BLOCK_DIM;
+        uint32_t tailLength = unitCount / BLOCK_DIM * unitLength;
+        uint32_t formerLength = tailLength + unitLength;
+        uint32_t lastRemain = totalLength % unitLength;
+
+        // tile 长度同样取单位的整数倍，使每次搬运的 GM 地址也保持对齐
+        uint32_t maxBlockLength = formerNum > 0 ? formerLength : tailLength;
+        if (tailLength + lastRemain > maxBlockLength) {
+            maxBlockLength = tailLength + lastRemain;
+        }
+        uint32_t tileUnits = (maxBlockLength + TILE_NUM * BUFFER_NUM * unitLength - 1) / (TILE_NUM * BUFFER_NUM * unitLength);
+        uint32_t maxTileUnits = MAX_TILE_LENGTH / unitLength;
+        if (tileUnits > maxTileUnits) {
+            tileUnits = maxTileUnits;
+        }
+        if (tileUnits == 0) {
+            tileUnits = 1;
+        }
+
         // 设置分块维度
         context->SetBlockDim(BLOCK_DIM);
 
-        // 保存总长度和子块数量到 tiling 对象中
+        // 保存划分结果到 tiling 对象中
         tiling.set_totalLength(totalLength);
-        tiling.set_tileNum(TILE_NUM);
+        tiling.set_formerNum(formerNum);
+        tiling.set_formerLength(formerLength);
+        tiling.set_tailLength(tailLength);
+        tiling.set_lastRemain(lastRemain);
+        tiling.set_tileLength(tileUnits * unitLength);
+        // 属性 adaptive 默认关闭，所有 tile 走完整路径；打开后 kernel 每个 tile 先归约取值范围再选路径
+        const bool* adaptive = context->GetAttrs()->GetAttrPointer<bool>(0);
+        tiling.set_adaptive(adaptive != nullptr && *adaptive ? 1 : 0);
 
         // 将 tiling 数据保存到 RawTilingData 缓冲区中
         tiling.SaveToBuffer(context->GetRawTilingData()->GetData(),
@@ -37,9 +92,10 @@ namespace optiling {
         // 设置 RawTilingData 的实际数据大小
         context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
 
-        // 获取当前工作空间的指针，并初始化第一个工作空间大小为 0
+        // 系统 workspace 之后是各核的路径计数，位于整个 workspace 的末尾，调用方可以直接读回
+        auto ascendcPlatform = platform_ascendc::PlatformAscendC(context->GetPlatformInfo());
         size_t* currentWorkspace = context->GetWorkspaceSizes(1);
-        currentWorkspace[0] = 0;
+        currentWorkspace[0] = ascendcPlatform.GetLibApiWorkSpaceSize() + BLOCK_DIM * PATH_COUNTER_BYTES;
 
         return ge::GRAPH_SUCCESS;
     }
@@ -65,6 +121,59 @@ namespace ge {
         // 将输入形状赋值给输出形状，确保两者相同
         *y_shape = *x1_shape;
 
+        // 可选输出 t（反向用的 tanh(softplus(x))）与输入同形状，未连接时为空
+        gert::Shape* t_shape = context->GetOutputShape(1);
+        if (t_shape != nullptr) {
+            *t_shape = *x1_shape;
+        }
+
+        return GRAPH_SUCCESS;
+    }
+
+    /**
+    * @brief InferShapeRange 函数：动态 shape 下输出的取值范围与输入相同。
+    *
+    * 图模式据此在编译期按最大形状规划静态内存，不必每一步都重新推导。
+    *
+    * @param context 形状范围推理的上下文。
+    * @return 成功返回 GRAPH_SUCCESS，输入范围缺失时返回 GRAPH_FAILED。
+    */
+    static ge::graphStatus InferShapeRange(gert::InferShapeRangeContext* context)
+    {
+        const gert::Range<gert::Shape>* x_range = context->GetInputShapeRange(0);
+        gert::Range<gert::Shape>* y_range = context->GetOutputShapeRange(0);
+        if (x_range == nullptr || y_range == nullptr) {
+            return GRAPH_FAILED;
+        }
+        *y_range->GetMin() = *x_range->GetMin();
+        *y_range->GetMax() = *x_range->GetMax();
+
+        gert::Range<gert::Shape>* t_range = context->GetOutputShapeRange(1);
+        if (t_range != nullptr) {
+            *t_range->GetMin() = *x_range->GetMin();
+            *t_range->GetMax() = *x_range->GetMax();
+        }
+
+        return GRAPH_SUCCESS;
+    }
+
+    /**
+    * @brief InferDataType 函数：输出 y 和可选输出 t 的数据类型都与输入 x 相同。
+    *
+    * @param context 数据类型推理的上下文。
+    * @return 返回图计算状态，成功则返回 GRAPH_SUCCESS。
+    */
+    static ge::graphStatus InferDataType(gert::InferDataTypeContext* context)
+    {
+        const ge::DataType x_dtype = context->GetInputDataType(0);
+        ge::graphStatus ret = context->SetOutputDataType(0, x_dtype);
+        if (ret != GRAPH_SUCCESS) {
+            return ret;
+        }
+
+        // t 未连接时设置失败不影响 y
+        (void)context->SetOutputDataType(1, x_dtype);
+
         return GRAPH_SUCCESS;
     }
 }
@@ -99,8 +208,25 @@ namespace ops {
                 .Format({ ge::FORMAT_ND })                  // 数据格式为 N 维格式
                 .UnknownShapeFormat({ ge::FORMAT_ND });      // 未知形状时的数据格式
 
-            // 设置形状推理函数
-            this->SetInferShape(ge::InferShape);
+            // 定义可选输出 "t" = tanh(softplus(x))，训练时保存给反向，
+            // 反向 dx = dy * (t + x * (1 - t^2) * sigmoid(x)) 只需要 x 和 fp16 的 t
+            this->Output("t")
+                .ParamType(OPTIONAL)                       // 输出为可选参数，推理时不传
+                .DataType({ ge::DT_FLOAT16 })              // 数据类型为 float16
+                .Format({ ge::FORMAT_ND })                  // 数据格式为 N 维格式
+                .UnknownShapeFormat({ ge::FORMAT_ND });      // 未知形状时的数据格式
+
+            // 是否按 tile 的取值范围选择计算路径，默认关闭，饱和区占多数的输入可以打开
+            this->Attr("adaptive").AttrType(OPTIONAL).Bool(false);
+            // 各核数据按 GM 突发长度划分，默认打开，关掉只用于对比 32 字节划分的带宽
+            this->Attr("burst_align").AttrType(OPTIONAL).Bool(true);
+
+            // 设置形状、形状范围和数据类型推理函数，图模式可以据此完整地做静态内存规划。
+            // kernel 按 tile 先整块读入再写回同一位置，y 与 x 指向同一块内存（原地计算）时结果不变，
+            // 图上 x 不再被其他节点使用时可以复用 x 的内存存放 y
+            this->SetInferShape(ge::InferShape)
+                .SetInferShapeRange(ge::InferShapeRange)
+                .SetInferDataType(ge::InferDataType);
 
             // 配置 AICore 相关设置，包括分块函数和特定的硬件配置
             this->AICore()
@@ -1,14 +1,22 @@
 
 #include "register/tilingdata_base.h"
 /**
-这里定义了tiling数据结构的字段totalLength和tileNum，它们分别表示输入数据的总长度和分块数目。
+这里定义了tiling数据结构的字段，totalLength 表示输入数据的总长度。
+各核的数据量以 GM 突发长度为单位划分：前 formerNum 个核各处理 formerLength 个元素，其余核各处理 tailLength 个，
+不足一个单位的 lastRemain 个元素交给最后一个核；核内每次搬运 tileLength 个元素。
+adaptive 取自同名算子属性（默认关闭），为 1 时 kernel 按 tile 的取值范围选择计算路径，为 0 时所有 tile 都走完整路径。
 通过REGISTER_TILING_DATA_CLASS将MishCustomTilingData与算子MishCustom进行绑定。
 **/
 namespace optiling {
 	BEGIN_TILING_DATA_DEF(MishCustomTilingData)
 	// 定义tiling结构体成员变量
 	TILING_DATA_FIELD_DEF(uint32_t, totalLength);
-	TILING_DATA_FIELD_DEF(uint32_t, tileNum);
+	TILING_DATA_FIELD_DEF(uint32_t, formerNum);
+	TILING_DATA_FIELD_DEF(uint32_t, formerLength);
+	TILING_DATA_FIELD_DEF(uint32_t, tailLength);
+	TILING_DATA_FIELD_DEF(uint32_t, lastRemain);
+	TILING_DATA_FIELD_DEF(uint32_t, tileLength);
+	TILING_DATA_FIELD_DEF(uint32_t, adaptive);
 	END_TILING_DATA_DEF;
 	REGISTER_TILING_DATA_CLASS(MishCustom, MishCustomTilingData)
 }
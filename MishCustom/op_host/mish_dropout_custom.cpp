@@ -0,0 +1,151 @@
+#include "mish_dropout_custom_tiling.h"
+#include "register/op_def_registry.h"
+
+namespace optiling {
+    // 分块需要是 256 个元素的整数倍：256 个 fp16 是 512 字节，对应的掩码是 32 字节
+    const uint32_t ALIGN_ELEMENTS = 256;
+    // 单个分块的最大元素数，输入、输出、掩码双缓冲和两块中间结果一起放进 UB
+    const uint32_t MAX_TILE_LENGTH = 4096;
+
+    /**
+    * @brief TilingFunc 按 256 元素对齐的方式切分数据，并把 keep_prob/seed/offset 换算成核内使用的形式。
+    *
+    * 随机数只由元素的全局下标、seed 和 offset 决定，与 blockDim 和分块方式无关，
+    * 因此这里可以按需要调整核数而不改变结果。
+    *
+    * @param context 当前的分块上下文，包含输入输出的形状信息及属性。
+    * @return 成功返回 ge::GRAPH_SUCCESS，形状不满足对齐要求或 keep_prob 越界时返回 ge::GRAPH_FAILED。
+    */
+    static ge::graphStatus TilingFunc(gert::TilingContext* context)
+    {
+        MishDropoutCustomTilingData tiling;
+
+        // 定义最多使用的核数
+        const uint32_t BLOCK_DIM = 8;
+
+        uint32_t totalLength = context->GetInputShape(0)->GetOriginShape().GetShapeSize();
+        if (totalLength == 0 || totalLength % ALIGN_ELEMENTS != 0) {
+            return ge::GRAPH_FAILED;
+        }
+
+        // 每个核处理整数个对齐单元，数据较少时减少核数
+        uint32_t units = totalLength / ALIGN_ELEMENTS;
+        uint32_t blockDim = BLOCK_DIM;
+        while (units % blockDim != 0) {
+            blockDim--;
+        }
+        uint32_t blockLength = totalLength / blockDim;
+
+        // 取不超过 MAX_TILE_LENGTH 且能整除 blockLength 的最大分块
+        uint32_t tileLength = MAX_TILE_LENGTH;
+        while (blockLength % tileLength != 0) {
+            tileLength -= ALIGN_ELEMENTS;
+        }
+
+        const gert::RuntimeAttrs* attrs = context->GetAttrs();
+        const float* keepProb = attrs->GetAttrPointer<float>(0);
+        const int64_t* seed = attrs->GetAttrPointer<int64_t>(1);
+        const int64_t* offset = attrs->GetAttrPointer<int64_t>(2);
+        if (*keepProb <= 0.0f || *keepProb > 1.0f) {
+            return ge::GRAPH_FAILED;
+        }
+        uint64_t seedBits = static_cast<uint64_t>(*seed);
+        uint64_t offsetBits = static_cast<uint64_t>(*offset);
+
+        context->SetBlockDim(blockDim);
+        tiling.set_totalLength(totalLength);
+        tiling.set_tileNum(blockLength / tileLength);
+        tiling.set_tileLength(tileLength);
+        // keep_prob 为 1 时阈值为 2^24，24 位随机数总是小于它，所有元素都被保留
+        tiling.set_keepThreshold(static_cast<uint32_t>(static_cast<double>(*keepProb) * (1 << 24) + 0.5));
+        tiling.set_scale(1.0f / *keepProb);
+        tiling.set_seedLo(static_cast<uint32_t>(seedBits));
+        tiling.set_seedHi(static_cast<uint32_t>(seedBits >> 32));
+        tiling.set_offsetLo(static_cast<uint32_t>(offsetBits));
+        tiling.set_offsetHi(static_cast<uint32_t>(offsetBits >> 32));
+
+        tiling.SaveToBuffer(context->GetRawTilingData()->GetData(),
+            context->GetRawTilingData()->GetCapacity());
+        context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+
+        size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+        currentWorkspace[0] = 0;
+
+        return ge::GRAPH_SUCCESS;
+    }
+}
+
+namespace ge {
+    /**
+    * @brief InferShape 函数：y 与 x 同形状，mask 是每 8 个元素 1 个字节的一维张量。
+    *
+    * @param context 形状推理的上下文，包含输入输出的形状信息。
+    * @return 返回图计算状态，成功则返回 GRAPH_SUCCESS。
+    */
+    static ge::graphStatus InferShape(gert::InferShapeContext* context)
+    {
+        const gert::Shape* x_shape = context->GetInputShape(0);
+        gert::Shape* y_shape = context->GetOutputShape(0);
+        gert::Shape* mask_shape = context->GetOutputShape(1);
+
+        *y_shape = *x_shape;
+        mask_shape->SetDimNum(1);
+        mask_shape->SetDim(0, (x_shape->GetShapeSize() + 7) / 8);
+
+        return GRAPH_SUCCESS;
+    }
+}
+
+namespace ops {
+    /**
+    * @brief MishDropoutCustom 是训练用的 Mish + Dropout 融合算子。
+    *
+    * y = Mish(x) * mask / keep_prob，mask 由核内的 Philox4x32-10 计数器随机数生成，
+    * 并按位打包输出给反向使用（第 i 个元素对应第 i/8 个字节的第 i%8 位）。
+    * 同样的 seed/offset 在任意 blockDim 下产生相同的结果。
+    */
+    class MishDropoutCustom : public OpDef {
+    public:
+        /**
+        * @brief 构造函数，初始化 MishDropoutCustom 算子的输入输出、属性及相关配置。
+        *
+        * @param name 算子的名称。
+        */
+        explicit MishDropoutCustom(const char* name) : OpDef(name)
+        {
+            this->Input("x")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->Output("y")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            // 按位打包的保留掩码，1 表示保留
+            this->Output("mask")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_UINT8 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            // 保留概率，取值 (0, 1]
+            this->Attr("keep_prob").AttrType(OPTIONAL).Float(0.9);
+            // Philox 密钥
+            this->Attr("seed").AttrType(OPTIONAL).Int(0);
+            // Philox 计数器高 64 位，每个训练步递增即可得到新的掩码
+            this->Attr("offset").AttrType(OPTIONAL).Int(0);
+
+            this->SetInferShape(ge::InferShape);
+
+            this->AICore()
+                .SetTiling(optiling::TilingFunc);
+            this->AICore().AddConfig("ascend310b");
+        }
+    };
+
+    OP_ADD(MishDropoutCustom);
+}
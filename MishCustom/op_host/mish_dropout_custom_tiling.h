@@ -0,0 +1,21 @@
+#include "register/tilingdata_base.h"
+/**
+MishDropoutCustom 的 tiling 数据：
+totalLength/tileNum/tileLength 描述分块，tileLength 是 256 的整数倍，保证 fp16 数据和按位打包的掩码都按 32 字节对齐；
+keepThreshold 是 keep_prob * 2^24，随机数高 24 位小于它的元素被保留；scale 为 1/keep_prob；
+seed/offset 拆成高低 32 位，作为 Philox4x32-10 的密钥和计数器高位。
+**/
+namespace optiling {
+	BEGIN_TILING_DATA_DEF(MishDropoutCustomTilingData)
+	TILING_DATA_FIELD_DEF(uint32_t, totalLength);
+	TILING_DATA_FIELD_DEF(uint32_t, tileNum);
+	TILING_DATA_FIELD_DEF(uint32_t, tileLength);
+	TILING_DATA_FIELD_DEF(uint32_t, keepThreshold);
+	TILING_DATA_FIELD_DEF(float, scale);
+	TILING_DATA_FIELD_DEF(uint32_t, seedLo);
+	TILING_DATA_FIELD_DEF(uint32_t, seedHi);
+	TILING_DATA_FIELD_DEF(uint32_t, offsetLo);
+	TILING_DATA_FIELD_DEF(uint32_t, offsetHi);
+	END_TILING_DATA_DEF;
+	REGISTER_TILING_DATA_CLASS(MishDropoutCustom, MishDropoutCustomTilingData)
+}
@@ -0,0 +1,102 @@
+// 由 cmake/util/elementwise_codegen.py 根据 MishCustom.json 中 ScaledMishClampCustom 的 expression 生成，请勿手工修改
+// expression: t = Muls(x, 0.5); y = Cast(Mins(Maxs(Mish(t), -1.0), 6.0), 'float16')
+#include "scaled_mish_clamp_custom_tiling.h"
+#include "register/op_def_registry.h"
+#include "tiling/platform/platform_ascendc.h"
+
+namespace optiling {
+    // DataCopy 以 32 字节为单位搬运，元素总数需要是 ALIGN_ELEMENTS 的整数倍
+    const uint32_t ALIGN_ELEMENTS = 16;
+    // 每个元素占用的 UB 字节数：输入输出各双缓冲，加上 2 块中间结果缓冲区
+    const uint32_t UB_BYTES_PER_ELEMENT = 20;
+
+    /**
+    * @brief TilingFunc 按 ALIGN_ELEMENTS 为单位把数据平分给各个核，分块长度取 UB 能放下的最大值。
+    *
+    * @param context 当前的分块上下文，包含输入输出的形状信息。
+    * @return 成功返回 ge::GRAPH_SUCCESS，元素数不对齐或输入形状不一致时返回 ge::GRAPH_FAILED。
+    */
+    static ge::graphStatus TilingFunc(gert::TilingContext* context)
+    {
+        ScaledMishClampCustomTilingData tiling;
+
+        uint32_t totalLength = context->GetInputShape(0)->GetOriginShape().GetShapeSize();
+        if (totalLength == 0 || totalLength % ALIGN_ELEMENTS != 0) {
+            return ge::GRAPH_FAILED;
+        }
+
+        auto ascendcPlatform = platform_ascendc::PlatformAscendC(context->GetPlatformInfo());
+        uint64_t ubSize = 0;
+        ascendcPlatform.GetCoreMemSize(platform_ascendc::CoreMemType::UB, ubSize);
+        uint32_t coreNum = ascendcPlatform.GetCoreNumAiv();
+
+        // 数据不足时少启动几个核，保证每个核至少分到一个对齐单位
+        uint32_t units = totalLength / ALIGN_ELEMENTS;
+        uint32_t blockUnits = (units + coreNum - 1) / coreNum;
+        uint32_t blockDim = (units + blockUnits - 1) / blockUnits;
+        uint32_t blockLength = blockUnits * ALIGN_ELEMENTS;
+
+        uint32_t tileLength = static_cast<uint32_t>(ubSize / UB_BYTES_PER_ELEMENT) / ALIGN_ELEMENTS * ALIGN_ELEMENTS;
+        if (tileLength == 0) {
+            return ge::GRAPH_FAILED;
+        }
+        if (tileLength > blockLength) {
+            tileLength = blockLength;
+        }
+
+        context->SetBlockDim(blockDim);
+        tiling.set_totalLength(totalLength);
+        tiling.set_blockLength(blockLength);
+        tiling.set_tileLength(tileLength);
+
+        tiling.SaveToBuffer(context->GetRawTilingData()->GetData(),
+            context->GetRawTilingData()->GetCapacity());
+        context->GetRawTilingData()->SetDataSize(tiling.GetDataSize());
+
+        size_t* currentWorkspace = context->GetWorkspaceSizes(1);
+        currentWorkspace[0] = 0;
+
+        return ge::GRAPH_SUCCESS;
+    }
+}
+
+namespace ge {
+    /**
+    * @brief InferShape 函数：逐元素计算，输出形状与第一个输入相同。
+    */
+    static ge::graphStatus InferShape(gert::InferShapeContext* context)
+    {
+        const gert::Shape* x_shape = context->GetInputShape(0);
+        gert::Shape* y_shape = context->GetOutputShape(0);
+        *y_shape = *x_shape;
+        return GRAPH_SUCCESS;
+    }
+}
+
+namespace ops {
+    class ScaledMishClampCustom : public OpDef {
+    public:
+        explicit ScaledMishClampCustom(const char* name) : OpDef(name)
+        {
+            this->Input("x")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->Output("y")
+                .ParamType(REQUIRED)
+                .DataType({ ge::DT_FLOAT16 })
+                .Format({ ge::FORMAT_ND })
+                .UnknownShapeFormat({ ge::FORMAT_ND });
+
+            this->SetInferShape(ge::InferShape);
+
+            this->AICore()
+                .SetTiling(optiling::TilingFunc);
+            this->AICore().AddConfig("ascend310b");
+        }
+    };
+
+    OP_ADD(ScaledMishClampCustom);
+}
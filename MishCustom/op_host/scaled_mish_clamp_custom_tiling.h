@@ -0,0 +1,13 @@
+#include "register/tilingdata_base.h"
+/**
+由 cmake/util/elementwise_codegen.py 根据 MishCustom.json 中 ScaledMishClampCustom 的 expression 生成，请勿手工修改。
+每个核处理连续的 blockLength 个元素（最后一个核可能更少），每次搬运 tileLength 个元素。
+**/
+namespace optiling {
+	BEGIN_TILING_DATA_DEF(ScaledMishClampCustomTilingData)
+	TILING_DATA_FIELD_DEF(uint32_t, totalLength);
+	TILING_DATA_FIELD_DEF(uint32_t, blockLength);
+	TILING_DATA_FIELD_DEF(uint32_t, tileLength);
+	END_TILING_DATA_DEF;
+	REGISTER_TILING_DATA_CLASS(ScaledMishClampCustom, ScaledMishClampCustomTilingData)
+}
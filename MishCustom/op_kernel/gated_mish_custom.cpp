@@ -0,0 +1,165 @@
+
+#include "kernel_operator.h"
+using namespace AscendC;
+
+constexpr int32_t BUFFER_NUM = 2;  // 定义缓冲区的数量为2
+constexpr uint32_t BLOCK_ELEMENTS = 16;  // 32 字节的 DataCopy 块对应的 fp16 个数
+// b >= 4.5 时 fp16 的 tanh(Softplus(b)) 已舍入为 1，先截断到这里再 Exp，避免 e * (e + 2) 溢出
+constexpr float SATURATE_HIGH = 4.5f;
+
+// 定义 KernelGatedMish 类：把每行的左右两半分别读入，计算 y = a * Mish(b)
+class KernelGatedMish {
+public:
+    __aicore__ inline KernelGatedMish() {}
+
+    /**
+    * @brief Init 函数负责初始化全局内存、局部缓存以及本核负责的行范围。
+    *
+    * @param x 输入数据的全局内存地址，按 [totalRows, 2 * halfDim] 排布
+    * @param y 输出数据的全局内存地址，按 [totalRows, halfDim] 排布
+    * @param tiling 分块信息
+    */
+    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, const GatedMishCustomTilingData &tiling)
+    {
+        ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");
+        ASSERT(tiling.tileRows != 0 && tiling.tileCols != 0 && "tile can not be empty!");
+
+        this->halfDim = tiling.halfDim;
+        this->tileRows = tiling.tileRows;
+        this->tileCols = tiling.tileCols;
+        uint32_t rowStart = tiling.blockRows * GetBlockIdx();
+        uint32_t rowEnd = rowStart + tiling.blockRows;
+        this->rowCount = rowEnd > tiling.totalRows ? tiling.totalRows - rowStart : tiling.blockRows;
+
+        // a 从每行的开头读，b 从每行的 halfDim 处读，二者的行跨度都是 2 * halfDim
+        aGm.SetGlobalBuffer((__gm__ DTYPE_X*)x + rowStart * 2 * this->halfDim, this->rowCount * 2 * this->halfDim);
+        bGm.SetGlobalBuffer((__gm__ DTYPE_X*)x + rowStart * 2 * this->halfDim + this->halfDim,
+            this->rowCount * 2 * this->halfDim - this->halfDim);
+        yGm.SetGlobalBuffer((__gm__ DTYPE_Y*)y + rowStart * this->halfDim, this->rowCount * this->halfDim);
+
+        uint32_t tileLength = this->tileRows * this->tileCols;
+        pipe.InitBuffer(inQueueA, BUFFER_NUM, tileLength * sizeof(DTYPE_X));
+        pipe.InitBuffer(inQueueB, BUFFER_NUM, tileLength * sizeof(DTYPE_X));
+        pipe.InitBuffer(outQueueY, BUFFER_NUM, tileLength * sizeof(DTYPE_Y));
+        pipe.InitBuffer(tmpBuffer, tileLength * sizeof(DTYPE_X));
+    }
+
+    /**
+    * @brief Process 函数按行块、列块依次处理，最后一个行块可能不足 tileRows 行。
+    */
+    __aicore__ inline void Process()
+    {
+        for (uint32_t row = 0; row < this->rowCount; row += this->tileRows) {
+            uint32_t rows = this->rowCount - row < this->tileRows ? this->rowCount - row : this->tileRows;
+            for (uint32_t col = 0; col < this->halfDim; col += this->tileCols) {
+                CopyIn(row, col, rows);
+                Compute(rows * this->tileCols);
+                CopyOut(row, col, rows);
+            }
+        }
+    }
+
+private:
+    /**
+    * @brief CopyIn 用两路带行跨度的 DataCopy 分别读入 a 和 b 的 rows x tileCols 子块，在 UB 中紧密排布
+    */
+    __aicore__ inline void CopyIn(uint32_t row, uint32_t col, uint32_t rows)
+    {
+        LocalTensor<DTYPE_X> aLocal = inQueueA.AllocTensor<DTYPE_X>();
+        LocalTensor<DTYPE_X> bLocal = inQueueB.AllocTensor<DTYPE_X>();
+
+        // 每行搬 tileCols 个元素，跳过本行剩下的部分和另一半
+        DataCopyParams params;
+        params.blockCount = rows;
+        params.blockLen = this->tileCols / BLOCK_ELEMENTS;
+        params.srcStride = (2 * this->halfDim - this->tileCols) / BLOCK_ELEMENTS;
+        params.dstStride = 0;
+        uint32_t offset = row * 2 * this->halfDim + col;
+        DataCopy(aLocal, aGm[offset], params);
+        DataCopy(bLocal, bGm[offset], params);
+
+        inQueueA.EnQue(aLocal);
+        inQueueB.EnQue(bLocal);
+    }
+
+    /**
+    * @brief Compute 计算 y = a * b * tanh(Softplus(b))
+    *
+    * 先算 a * b，b 之后可以原地覆盖，不需要 KernelMish 里的 x 备份；
+    * 与 KernelMish 一样记 e = exp(min(b, SATURATE_HIGH))，tanh(Softplus(b)) = n / (n + 2)，n = e * (e + 2)，
+    * 只需一次 Exp，截断保证大的 b 不会因 e 溢出得到 NaN。
+    */
+    __aicore__ inline void Compute(uint32_t count)
+    {
+        LocalTensor<DTYPE_X> aLocal = inQueueA.DeQue<DTYPE_X>();
+        LocalTensor<DTYPE_X> bLocal = inQueueB.DeQue<DTYPE_X>();
+        LocalTensor<DTYPE_Y> yLocal = outQueueY.AllocTensor<DTYPE_Y>();
+        LocalTensor<DTYPE_X> tmpTensor = tmpBuffer.Get<DTYPE_X>();
+
+        Mul(aLocal, aLocal, bLocal, count);
+
+        // e = exp(min(b, SATURATE_HIGH))，n = e * (e + 2)，t = n / (n + 2)
+        Mins(bLocal, bLocal, static_cast<DTYPE_X>(SATURATE_HIGH), count);
+        Exp(bLocal, bLocal, count);
+        Adds(yLocal, bLocal, static_cast<DTYPE_X>(2), count);
+        Mul(bLocal, bLocal, yLocal, count);
+        Adds(yLocal, bLocal, static_cast<DTYPE_X>(2), count);
+        Div(tmpTensor, bLocal, yLocal, count);
+
+        Mul(yLocal, aLocal, tmpTensor, count);
+
+        outQueueY.EnQue<DTYPE_Y>(yLocal);
+        inQueueA.FreeTensor(aLocal);
+        inQueueB.FreeTensor(bLocal);
+    }
+
+    /**
+    * @brief CopyOut 把 rows x tileCols 的结果写回输出矩阵，行跨度为 halfDim
+    */
+    __aicore__ inline void CopyOut(uint32_t row, uint32_t col, uint32_t rows)
+    {
+        LocalTensor<DTYPE_Y> yLocal = outQueueY.DeQue<DTYPE_Y>();
+
+        DataCopyParams params;
+        params.blockCount = rows;
+        params.blockLen = this->tileCols / BLOCK_ELEMENTS;
+        params.srcStride = 0;
+        params.dstStride = (this->halfDim - this->tileCols) / BLOCK_ELEMENTS;
+        DataCopy(yGm[row * this->halfDim + col], yLocal, params);
+
+        outQueueY.FreeTensor(yLocal);
+    }
+
+private:
+    TPipe pipe;
+    TQue<QuePosition::VECIN, BUFFER_NUM> inQueueA;
+    TQue<QuePosition::VECIN, BUFFER_NUM> inQueueB;
+    TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueY;
+
+    GlobalTensor<half> aGm;
+    GlobalTensor<half> bGm;
+    GlobalTensor<half> yGm;
+
+    TBuf<QuePosition::VECCALC> tmpBuffer;
+
+    uint32_t halfDim;
+    uint32_t rowCount;
+    uint32_t tileRows;
+    uint32_t tileCols;
+};
+
+/**
+* @brief 自定义的内核函数，通过 Init 初始化操作，并调用 Process 执行计算
+*
+* @param x 输入数据的全局内存地址
+* @param y 输出数据的全局内存地址
+* @param workspace 工作空间的地址
+* @param tiling 分块信息的地址
+*/
+extern "C" __global__ __aicore__ void gated_mish_custom(GM_ADDR x, GM_ADDR y, GM_ADDR workspace, GM_ADDR tiling)
+{
+    GET_TILING_DATA(tiling_data, tiling);
+    KernelGatedMish op;
+    op.Init(x, y, tiling_data);
+    op.Process();
+}
@@ -0,0 +1,173 @@
+
+#include "kernel_operator.h"
+#include "lib/matmul_intf.h"
+using namespace AscendC;
+using namespace matmul;
+
+// 输入超过该值时 n/(n+2) 在 fp32 下已经等于 1，先截断再做 Exp 以免溢出成 inf/inf
+constexpr float MISH_EXP_CLAMP = 20.0f;
+
+__aicore__ inline uint32_t Ceiling(uint32_t a, uint32_t b)
+{
+    return (a + b - 1) / b;
+}
+
+/**
+* @brief KernelMatmulMish：Matmul 高阶 API 逐个产生 baseM x baseN 的 fp32 输出分块，
+* 分块在 UB 中完成 Mish 并转成 fp16 后再写回 GM。
+*/
+template <typename aType, typename bType, typename cType, typename biasType, typename yType>
+class KernelMatmulMish {
+public:
+    __aicore__ inline KernelMatmulMish() {}
+
+    /**
+    * @brief Init 函数根据核号定位本核负责的 A 行块、B 列块和输出子矩阵。
+    *
+    * @param a 左矩阵 [M, K] 的全局内存地址
+    * @param b 右矩阵 [K, N] 的全局内存地址
+    * @param bias 偏置 [N] 的全局内存地址
+    * @param y 输出 [M, N] 的全局内存地址
+    * @param tiling Matmul 的 tiling
+    */
+    __aicore__ inline void Init(GM_ADDR a, GM_ADDR b, GM_ADDR bias, GM_ADDR y, const TCubeTiling &tiling)
+    {
+        this->tiling = tiling;
+        aGm.SetGlobalBuffer(reinterpret_cast<__gm__ aType *>(a), tiling.M * tiling.Ka);
+        bGm.SetGlobalBuffer(reinterpret_cast<__gm__ bType *>(b), tiling.Kb * tiling.N);
+        biasGm.SetGlobalBuffer(reinterpret_cast<__gm__ biasType *>(bias), tiling.N);
+        yGm.SetGlobalBuffer(reinterpret_cast<__gm__ yType *>(y), tiling.M * tiling.N);
+
+        // 多核按 M 方向优先切分
+        uint32_t mBlocks = Ceiling(tiling.M, tiling.singleCoreM);
+        uint32_t mIdx = GetBlockIdx() % mBlocks;
+        uint32_t nIdx = GetBlockIdx() / mBlocks;
+        aGm = aGm[mIdx * tiling.singleCoreM * tiling.Ka];
+        bGm = bGm[nIdx * tiling.singleCoreN];
+        biasGm = biasGm[nIdx * tiling.singleCoreN];
+        yGm = yGm[mIdx * tiling.singleCoreM * tiling.N + nIdx * tiling.singleCoreN];
+    }
+
+    /**
+    * @brief Process 逐个取出 Matmul 的输出分块，做 Mish 后写回
+    */
+    __aicore__ inline void Process(TPipe *pipe)
+    {
+        uint32_t tileLength = tiling.baseM * tiling.baseN;
+        pipe->InitBuffer(cQueue, 1, tileLength * sizeof(cType));
+        pipe->InitBuffer(yQueue, 1, tileLength * sizeof(yType));
+        pipe->InitBuffer(tmpBufferA, tileLength * sizeof(cType));
+        pipe->InitBuffer(tmpBufferB, tileLength * sizeof(cType));
+
+        matmulObj.SetTensorA(aGm);
+        matmulObj.SetTensorB(bGm);
+        matmulObj.SetBias(biasGm);
+        uint32_t round = 0;
+        while (matmulObj.template Iterate<true>()) {
+            MatmulCompute();
+            MishCompute(tileLength);
+            CopyOut(round);
+            round++;
+        }
+        matmulObj.End();
+    }
+
+    Matmul<MatmulType<TPosition::GM, CubeFormat::ND, aType>, MatmulType<TPosition::GM, CubeFormat::ND, bType>,
+        MatmulType<TPosition::VECIN, CubeFormat::ND, cType>, MatmulType<TPosition::GM, CubeFormat::ND, biasType>>
+        matmulObj;
+
+private:
+    /**
+    * @brief MatmulCompute 把当前 fp32 输出分块取到 UB
+    */
+    __aicore__ inline void MatmulCompute()
+    {
+        LocalTensor<cType> cLocal = cQueue.AllocTensor<cType>();
+        matmulObj.template GetTensorC<true>(cLocal, false, true);
+        cQueue.EnQue(cLocal);
+    }
+
+    /**
+    * @brief MishCompute 在 fp32 下计算 Mish(c) 并转成 fp16
+    *
+    * tanh(Softplus(c)) = n / (n + 2)，n = e^c * (e^c + 2)，只需一次 Exp、不需要 Ln，
+    * 也不需要 KernelMish 里对输入的备份。
+    */
+    __aicore__ inline void MishCompute(uint32_t count)
+    {
+        LocalTensor<cType> cLocal = cQueue.DeQue<cType>();
+        LocalTensor<yType> yLocal = yQueue.AllocTensor<yType>();
+        LocalTensor<cType> tmpA = tmpBufferA.Get<cType>();
+        LocalTensor<cType> tmpB = tmpBufferB.Get<cType>();
+        cType two = 2;
+
+        Mins(tmpA, cLocal, static_cast<cType>(MISH_EXP_CLAMP), count);
+        Exp(tmpA, tmpA, count);
+        Adds(tmpB, tmpA, two, count);
+        Mul(tmpA, tmpA, tmpB, count);
+        Adds(tmpB, tmpA, two, count);
+        Div(tmpA, tmpA, tmpB, count);
+        Mul(cLocal, cLocal, tmpA, count);
+        Cast(yLocal, cLocal, RoundMode::CAST_ROUND, count);
+
+        yQueue.EnQue<yType>(yLocal);
+        cQueue.FreeTensor(cLocal);
+    }
+
+    /**
+    * @brief CopyOut 把第 round 个输出分块写回
+    *
+    * 分块的产生顺序由 tiling 的 iterateOrder 决定：0 先沿 M 方向偏移再沿 N 方向，1 先沿 N 方向再沿 M 方向。
+    * host 已保证单核的 M/N 是 baseM/baseN 的整数倍，所以每个分块都是完整的 baseM x baseN。
+    */
+    __aicore__ inline void CopyOut(uint32_t round)
+    {
+        LocalTensor<yType> yLocal = yQueue.DeQue<yType>();
+        uint32_t roundM = tiling.singleCoreM / tiling.baseM;
+        uint32_t roundN = tiling.singleCoreN / tiling.baseN;
+        uint32_t mIter = tiling.iterateOrder == 0 ? round % roundM : round / roundN;
+        uint32_t nIter = tiling.iterateOrder == 0 ? round / roundM : round % roundN;
+        uint32_t offset = mIter * tiling.baseM * tiling.N + nIter * tiling.baseN;
+        DataCopyParams params;
+        params.blockCount = tiling.baseM;
+        params.blockLen = tiling.baseN * sizeof(yType) / DEFAULT_C0_SIZE;
+        params.srcStride = 0;
+        params.dstStride = (tiling.N - tiling.baseN) * sizeof(yType) / DEFAULT_C0_SIZE;
+        DataCopy(yGm[offset], yLocal, params);
+        yQueue.FreeTensor(yLocal);
+    }
+
+    TCubeTiling tiling;
+    GlobalTensor<aType> aGm;
+    GlobalTensor<bType> bGm;
+    GlobalTensor<biasType> biasGm;
+    GlobalTensor<yType> yGm;
+    TQue<QuePosition::VECIN, 1> cQueue;
+    TQue<QuePosition::VECOUT, 1> yQueue;
+    TBuf<QuePosition::VECCALC> tmpBufferA;
+    TBuf<QuePosition::VECCALC> tmpBufferB;
+};
+
+/**
+* @brief 自定义的内核函数：注册 Matmul 对象后初始化并执行
+*
+* @param a 左矩阵的全局内存地址
+* @param b 右矩阵的全局内存地址
+* @param bias 偏置的全局内存地址
+* @param y 输出的全局内存地址
+* @param workspace 工作空间的地址，Matmul 使用其中的系统 workspace
+* @param tiling 分块信息的地址
+*/
+extern "C" __global__ __aicore__ void matmul_mish_custom(GM_ADDR a, GM_ADDR b, GM_ADDR bias, GM_ADDR y,
+    GM_ADDR workspace, GM_ADDR tiling)
+{
+    GET_TILING_DATA(tiling_data, tiling);
+    if (GetSysWorkSpacePtr() == nullptr) {
+        return;
+    }
+    TPipe pipe;
+    KernelMatmulMish<half, half, float, float, half> op;
+    REGIST_MATMUL_OBJ(&pipe, GetSysWorkSpacePtr(), op.matmulObj, &tiling_data.cubeTilingData);
+    op.Init(a, b, bias, y, tiling_data.cubeTilingData);
+    op.Process(&pipe);
+}
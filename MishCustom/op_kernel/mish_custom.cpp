@@ -3,6 +3,22 @@ using namespace AscendC;
 
 constexpr int32_t BUFFER_NUM = 2;  // 定义缓冲区的数量为2
 
+// fp16 下的饱和区间：x >= 4.5 时 tanh(softplus(x)) 舍入为 1，y == x；x <= -20.5 时 t 与 y 都舍入为 0
+constexpr float SATURATE_HIGH = 4.5f;
+constexpr float SATURATE_LOW = -20.5f;
+
+// 每个 tile 的计算路径，统计时作为计数器下标
+enum MishPath : int32_t {
+    PATH_SATURATE_HIGH = 1,   // 整个 tile 都 >= SATURATE_HIGH：y = x，t = 1
+    PATH_SATURATE_LOW = 2,    // 整个 tile 都 <= SATURATE_LOW：y = 0，t = 0
+    PATH_FAST = 3,            // 最大值 < SATURATE_HIGH：n / (n + 2) 不会溢出，不需要截断
+    PATH_FULL = 4,            // 其余情况：先把 x 截断到 SATURATE_HIGH 再算 t
+};
+
+// 用户 workspace 中每个核一个 32 字节的计数槽：{ 魔数, 四种路径各自的 tile 数, 0, 0, 0 }
+constexpr int32_t PATH_COUNTER_NUM = 8;
+constexpr int32_t PATH_COUNTER_MAGIC = 0x4D495348;  // "MISH"
+
 // 定义自定义的 KernelMish 类，用于实现 Mish 运算的自定义内核
 class KernelMish {
 public:
@@ -14,36 +30,64 @@ public:
     *
     * @param x 输入数据的全局内存地址
     * @param y 输出数据的全局内存地址
-    * @param totalLength 输入数据的总长度
-    * @param tileNum 每个块内的数据将被进一步划分为多少个Tile
+    * @param t 可选输出 tanh(softplus(x)) 的全局内存地址，为空时不输出
+    * @param counters 用户 workspace，按核写入各路径的 tile 数，为空时不统计
+    * @param tiling 分块信息：前 formerNum 个核各处理 formerLength 个元素，其余核各处理 tailLength 个，
+    *               最后一个核再加上不足一个 GM 突发的 lastRemain 个；核内按 tileLength 分块，最后一块可以更短
     */
-    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, uint32_t totalLength, uint32_t tileNum)
+    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, GM_ADDR t, GM_ADDR counters, const MishCustomTilingData& tiling)
     {
         // 确保块的数量不为0，否则输出错误信息
         ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");
-
-        // 计算每个块需要处理的数据长度
-        this->blockLength = totalLength / GetBlockNum();
-        this->tileNum = tileNum;
-
-        // 确保tile的数量不为0，否则输出错误信息
-        ASSERT(tileNum != 0 && "tile num can not be zero!");
-
-        // 计算每个Tile的数据长度
-        this->tileLength = this->blockLength / tileNum / BUFFER_NUM;
+        ASSERT(tiling.tileLength != 0 && "tile length can not be zero!");
+
+        // 计算本核的起始位置和长度，除最后一个核的末尾外，起点和长度都是 GM 突发长度的整数倍
+        uint32_t blockIdx = GetBlockIdx();
+        uint32_t blockOffset;
+        if (blockIdx < tiling.formerNum) {
+            this->blockLength = tiling.formerLength;
+            blockOffset = tiling.formerLength * blockIdx;
+        } else {
+            this->blockLength = tiling.tailLength;
+            blockOffset = tiling.formerLength * tiling.formerNum + tiling.tailLength * (blockIdx - tiling.formerNum);
+        }
+        if (blockIdx == GetBlockNum() - 1) {
+            this->blockLength += tiling.lastRemain;
+        }
+        this->tileLength = tiling.tileLength;
 
         // 初始化全局内存中输入和输出数据的缓存区域
-        xGm.SetGlobalBuffer((__gm__ DTYPE_X*)x + this->blockLength * GetBlockIdx(),
-            this->blockLength);
-        yGm.SetGlobalBuffer((__gm__ DTYPE_Y*)y + this->blockLength * GetBlockIdx(),
-            this->blockLength);
+        xGm.SetGlobalBuffer((__gm__ DTYPE_X*)x + blockOffset, this->blockLength);
+        yGm.SetGlobalBuffer((__gm__ DTYPE_Y*)y + blockOffset, this->blockLength);
+
+        // 反向需要的 tanh(softplus(x))，只有调用方传入 t 时才占用 UB 和带宽
+        this->hasResidual = (t != nullptr);
+        if (this->hasResidual) {
+            tGm.SetGlobalBuffer((__gm__ DTYPE_Y*)t + blockOffset, this->blockLength);
+        }
 
         // 初始化队列和缓冲区，用于存储计算中间数据
         pipe.InitBuffer(inQueueX, BUFFER_NUM, this->tileLength * sizeof(DTYPE_X));
         pipe.InitBuffer(outQueueY, BUFFER_NUM, this->tileLength * sizeof(DTYPE_Y));
         pipe.InitBuffer(tmpBuffer, this->tileLength * sizeof(DTYPE_X));
         pipe.InitBuffer(copyBuffer, this->tileLength * sizeof(DTYPE_X));
+        if (this->hasResidual) {
+            pipe.InitBuffer(outQueueT, BUFFER_NUM, this->tileLength * sizeof(DTYPE_Y));
+        }
 
+        // 归约结果：最大值放在第 0 个元素，最小值放在第 16 个元素（32 字节对齐）
+        this->adaptive = (tiling.adaptive != 0);
+        if (this->adaptive) {
+            pipe.InitBuffer(reduceBuffer, 2 * 32);
+        }
+        this->hasCounters = (counters != nullptr);
+        if (this->hasCounters) {
+            counterGm.SetGlobalBuffer((__gm__ int32_t*)counters + PATH_COUNTER_NUM * GetBlockIdx(), PATH_COUNTER_NUM);
+            pipe.InitBuffer(counterBuffer, PATH_COUNTER_NUM * sizeof(int32_t));
+        }
+        for (int32_t i = 0; i < PATH_COUNTER_NUM; i++) {
+            this->pathCount[i] = 0;
+        }
     }
 
     /**
@@ -51,14 +95,19 @@ public:
     */
     __aicore__ inline void Process()
     {
-        // 计算循环次数，等于 tileNum 乘以缓冲区数量
-        int32_t loopCount = this->tileNum * BUFFER_NUM;
+        // 按 tileLength 切分本核的数据，最后一块取剩余长度（tiling 保证是 32 字节的整数倍）
+        int32_t loopCount = (this->blockLength + this->tileLength - 1) / this->tileLength;
         for (int32_t i = 0; i < loopCount; i++) {
+            uint32_t length = this->blockLength - i * this->tileLength;
+            if (length > this->tileLength) {
+                length = this->tileLength;
+            }
             // 依次进行输入数据拷贝、计算以及输出数据拷贝
-            CopyIn(i);
-            Compute(i);
-            CopyOut(i);
+            CopyIn(i, length);
+            Compute(i, length);
+            CopyOut(i, length);
         }
+        WriteCounters();
     }
 
 private:
@@ -66,25 +115,62 @@ private:
     * @brief CopyIn 函数从全局内存将数据拷贝到局部内存
     *
     * @param progress 当前处理进度
+    * @param length 本 tile 的元素个数
     */
-    __aicore__ inline void CopyIn(int32_t progress)
+    __aicore__ inline void CopyIn(int32_t progress, uint32_t length)
     {
         // 从输入队列中分配一个局部张量，用于存储输入数据
         LocalTensor<DTYPE_X> xLocal = inQueueX.AllocTensor<DTYPE_X>();
 
         // 将全局内存中的数据拷贝到局部张量中
-        DataCopy(xLocal, xGm[progress * this->tileLength], this->tileLength);
+        DataCopy(xLocal, xGm[progress * this->tileLength], length);
 
         // 将局部张量加入到输入队列中
         inQueueX.EnQue(xLocal);
     }
 
+    /**
+    * @brief SelectPath 对 tile 做 ReduceMax/ReduceMin，按取值范围选出计算路径
+    *
+    * 归约结果要回到标量单元才能分支，这里会等向量流水执行完；tile 内取值混杂时这部分开销白花，
+    * 所以可以通过 tiling 的 adaptive 关掉。
+    *
+    * @param xLocal 当前 tile 的输入
+    * @param work 归约用的临时空间，不小于一个 tile
+    * @param length 本 tile 的元素个数
+    * @return MishPath
+    */
+    __aicore__ inline int32_t SelectPath(const LocalTensor<DTYPE_X>& xLocal, const LocalTensor<DTYPE_X>& work,
+        uint32_t length)
+    {
+        if (!this->adaptive) {
+            return PATH_FULL;
+        }
+        LocalTensor<DTYPE_X> maxLocal = reduceBuffer.Get<DTYPE_X>();
+        LocalTensor<DTYPE_X> minLocal = maxLocal[32 / sizeof(DTYPE_X)];
+        ReduceMax(maxLocal, xLocal, work, length, false);
+        ReduceMin(minLocal, xLocal, work, length, false);
+        event_t eventVS = static_cast<event_t>(GetTPipePtr()->FetchEventID(HardEvent::V_S));
+        SetFlag<HardEvent::V_S>(eventVS);
+        WaitFlag<HardEvent::V_S>(eventVS);
+        float maxValue = static_cast<float>(maxLocal.GetValue(0));
+        float minValue = static_cast<float>(minLocal.GetValue(0));
+        if (minValue >= SATURATE_HIGH) {
+            return PATH_SATURATE_HIGH;
+        }
+        if (maxValue <= SATURATE_LOW) {
+            return PATH_SATURATE_LOW;
+        }
+        return maxValue < SATURATE_HIGH ? PATH_FAST : PATH_FULL;
+    }
+
     /**
     * @brief Compute 函数执行具体的Mish计算操作
     *
     * @param progress 当前处理进度
+    * @param length 本 tile 的元素个数
     */
-    __aicore__ inline void Compute(int32_t progress)
+    __aicore__ inline void Compute(int32_t progress, uint32_t length)
     {
         // 从输入队列中获取一个局部张量
         LocalTensor<DTYPE_X> xLocal = inQueueX.DeQue<DTYPE_X>();
@@ -94,58 +180,96 @@ private:
 
         // 为中间计算结果分配临时张量
         LocalTensor<DTYPE_X> tmpTensor = tmpBuffer.Get<DTYPE_X>();
-        LocalTensor<DTYPE_X> xCopy = copyBuffer.Get<DTYPE_X>();
+        LocalTensor<DTYPE_X> tmpTensor2 = copyBuffer.Get<DTYPE_X>();
+
+        // 需要输出 t 时直接把商写进 t 的输出张量，省掉一次 UB 内拷贝
+        LocalTensor<DTYPE_Y> tLocal = this->hasResidual ? outQueueT.AllocTensor<DTYPE_Y>() : tmpTensor2;
 
-        // 定义计算过程中的常量
-        DTYPE_X oneAdd = 1;
-        
         /**************Mish算子公式**************
-        Mish(x) = x*tanh(Softplus(x))
-        tanh(x) = (exp(x) - exp(-x)) / (exp(x) + exp(-x))
-        Softplus(x) = ln(1 + exp(x))
+        Mish(x) = x*tanh(Softplus(x))，Softplus(x) = ln(1 + exp(x))
+        记 e = exp(x)，tanh(ln(1 + e)) = ((1 + e)^2 - 1) / ((1 + e)^2 + 1) = n / (n + 2)，n = e * (e + 2)
+        只需要一次 Exp，也不需要 Ln；n 在 x > 5.5 时超出 fp16，而 x >= SATURATE_HIGH 时 t 已经舍入为 1，
+        所以先把 x 截断到 SATURATE_HIGH 再算 t 结果不变
+        反向：dMish/dx = t + x * (1 - t^2) * sigmoid(x)，t = tanh(Softplus(x))，
+        因此保存 fp16 的 t 即可，不需要保留 softplus/tanh 的 fp32 中间结果
         ***************************************/
-
-        // 复制x的值
-        Copy(xCopy, xLocal, this->tileLength);
-
-        // 计算 Softplus(x) = ln(1 + exp(x))
-        Exp(xLocal, xLocal, this->tileLength);
-        Adds(xLocal, xLocal, oneAdd, this->tileLength);
-        Ln(xLocal, xLocal, this->tileLength);
-
-        // 计算 tanh(x) = (exp(x) - exp(-x)) / (exp(x) + exp(-x))
-        Exp(xLocal, xLocal, this->tileLength);
-        Reciprocal(yLocal, xLocal, this->tileLength);
-        Sub(tempLocal, xLocal, yLocal, this->tileLength);
-        Add(yLocal, xLocal, yLocal, this->tileLength);
-        Div(tempLocal, tempLocal, yLocal, this->tileLength);
-
-        // 计算 Mish(x) = x*tanh(Softplus(x))
-        Mul(yLocal, xCopy, tempLocal, this->tileLength);        
-	    outQueueY.EnQue<DTYPE_Y>(yLocal);
+        int32_t path = SelectPath(xLocal, tmpTensor, length);
+        this->pathCount[path]++;
+        if (path == PATH_SATURATE_HIGH) {
+            Duplicate(tLocal, static_cast<DTYPE_Y>(1), length);
+            Copy(yLocal, xLocal, length);
+        } else if (path == PATH_SATURATE_LOW) {
+            Duplicate(tLocal, static_cast<DTYPE_Y>(0), length);
+            Duplicate(yLocal, static_cast<DTYPE_Y>(0), length);
+        } else {
+            // e = exp(x)，PATH_FULL 先截断
+            if (path == PATH_FULL) {
+                Mins(tmpTensor, xLocal, static_cast<DTYPE_X>(SATURATE_HIGH), length);
+                Exp(tmpTensor, tmpTensor, length);
+            } else {
+                Exp(tmpTensor, xLocal, length);
+            }
+            // n = e * (e + 2)
+            Adds(yLocal, tmpTensor, static_cast<DTYPE_X>(2), length);
+            Mul(tmpTensor, tmpTensor, yLocal, length);
+            // t = n / (n + 2)
+            Adds(yLocal, tmpTensor, static_cast<DTYPE_X>(2), length);
+            Div(tLocal, tmpTensor, yLocal, length);
+            // 计算 Mish(x) = x*tanh(Softplus(x))
+            Mul(yLocal, xLocal, tLocal, length);
+        }
 
         // 将输出张量放入输出队列
         outQueueY.EnQue<DTYPE_Y>(yLocal);
+        if (this->hasResidual) {
+            outQueueT.EnQue<DTYPE_Y>(tLocal);
+        }
 
         // 释放局部张量
         inQueueX.FreeTensor(xLocal);
     }
 
+    /**
+    * @brief WriteCounters 把本核各路径的 tile 数写到用户 workspace 中属于本核的槽位
+    */
+    __aicore__ inline void WriteCounters()
+    {
+        if (!this->hasCounters) {
+            return;
+        }
+        LocalTensor<int32_t> counterLocal = counterBuffer.Get<int32_t>();
+        this->pathCount[0] = PATH_COUNTER_MAGIC;
+        for (int32_t i = 0; i < PATH_COUNTER_NUM; i++) {
+            counterLocal.SetValue(i, this->pathCount[i]);
+        }
+        event_t eventSMte3 = static_cast<event_t>(GetTPipePtr()->FetchEventID(HardEvent::S_MTE3));
+        SetFlag<HardEvent::S_MTE3>(eventSMte3);
+        WaitFlag<HardEvent::S_MTE3>(eventSMte3);
+        DataCopy(counterGm, counterLocal, PATH_COUNTER_NUM);
+    }
+
     /**
     * @brief CopyOut 函数将局部内存中的结果拷贝回全局内存
     *
     * @param progress 当前处理进度
+    * @param length 本 tile 的元素个数
     */
-    __aicore__ inline void CopyOut(int32_t progress)
+    __aicore__ inline void CopyOut(int32_t progress, uint32_t length)
     {
         // 从输出队列中获取一个局部张量
         LocalTensor<DTYPE_Y> yLocal = outQueueY.DeQue<DTYPE_Y>();
 
         // 将局部内存中的结果拷贝到全局内存
-        DataCopy(yGm[progress * this->tileLength], yLocal, this->tileLength);
+        DataCopy(yGm[progress * this->tileLength], yLocal, length);
 
         // 释放局部张量
         outQueueY.FreeTensor(yLocal);
+
+        if (this->hasResidual) {
+            LocalTensor<DTYPE_Y> tLocal = outQueueT.DeQue<DTYPE_Y>();
+            DataCopy(tGm[progress * this->tileLength], tLocal, length);
+            outQueueT.FreeTensor(tLocal);
+        }
     }
 
 private:
@@ -155,19 +279,27 @@ private:
     // 输入和输出队列，深度为缓冲区数量
     TQue<QuePosition::VECIN, BUFFER_NUM> inQueueX;
     TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueY;
+    TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueT;
 
     // 全局张量，用于存储全局内存中的输入和输出
     GlobalTensor<half> xGm;
     GlobalTensor<half> yGm;
+    GlobalTensor<half> tGm;
+    GlobalTensor<int32_t> counterGm;
 
     // 定义临时缓冲区，用于中间计算
     TBuf<QuePosition::VECCALC> tmpBuffer;
     TBuf<QuePosition::VECCALC> copyBuffer;
+    TBuf<QuePosition::VECCALC> reduceBuffer;
+    TBuf<QuePosition::VECCALC> counterBuffer;
 
-    // 存储块的长度、Tile数量和Tile长度
+    // 存储本核的数据长度和Tile长度
     uint32_t blockLength;
-    uint32_t tileNum;
     uint32_t tileLength;
+    bool hasResidual;
+    bool adaptive;
+    bool hasCounters;
+    int32_t pathCount[PATH_COUNTER_NUM];
 };
 
 /**
@@ -175,10 +307,11 @@ private:
 *
 * @param x 输入数据的全局内存地址
 * @param y 输出数据的全局内存地址
-* @param workspace 工作空间的地址
+* @param t 可选输出 tanh(softplus(x)) 的全局内存地址，未传入时为空
+* @param workspace 工作空间的地址，用户 workspace 存放各路径的 tile 计数
 * @param tiling 分块信息的地址
 */
-extern "C" __global__ __aicore__ void mish_custom(GM_ADDR x, GM_ADDR y, GM_ADDR workspace, GM_ADDR tiling) {
+extern "C" __global__ __aicore__ void mish_custom(GM_ADDR x, GM_ADDR y, GM_ADDR t, GM_ADDR workspace, GM_ADDR tiling) {
     // 获取分块数据
     GET_TILING_DATA(tiling_data, tiling);
 
@@ -186,6 +319,6 @@ extern "C" __global__ __aicore__ void mish_custom(GM_ADDR x, GM_ADDR y, GM_ADDR
     KernelMish op;
 
     // 调用 Init 和 Process 函数，进行初始化和计算
-    op.Init(x, y, tiling_data.totalLength, tiling_data.tileNum);
+    op.Init(x, y, t, GetUserWorkspace(workspace), tiling_data);
     op.Process();
 }
@@ -0,0 +1,205 @@
+
+#include "kernel_operator.h"
+using namespace AscendC;
+
+constexpr int32_t BUFFER_NUM = 2;  // 定义缓冲区的数量为2
+// x >= 4.5 时 fp16 的 tanh(Softplus(x)) 已舍入为 1，先截断到这里再 Exp，避免 e * (e + 2) 溢出
+constexpr float SATURATE_HIGH = 4.5f;
+
+// Philox4x32-10 的乘数和密钥递增常数
+constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+constexpr int32_t PHILOX_ROUNDS = 10;
+
+/**
+* @brief Philox4x32-10 计数器随机数：同一个 (key, counter) 总是得到同样的 4 个 32 位随机数。
+*
+* 向量单元没有 32x32->64 位的乘法，这里在标量单元上计算；结果与 gen_data.py 中的主机参考实现逐位一致。
+*/
+__aicore__ inline void Philox4x32(uint32_t ctr[4], uint32_t k0, uint32_t k1)
+{
+    for (int32_t round = 0; round < PHILOX_ROUNDS; round++) {
+        uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * ctr[2];
+        uint32_t c1 = ctr[1];
+        uint32_t c3 = ctr[3];
+        ctr[0] = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        ctr[1] = static_cast<uint32_t>(p1);
+        ctr[2] = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        ctr[3] = static_cast<uint32_t>(p0);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// 定义 KernelMishDropout 类：Mish 之后按 Philox 随机数做 dropout，并输出按位打包的掩码
+class KernelMishDropout {
+public:
+    __aicore__ inline KernelMishDropout() {}
+
+    /**
+    * @brief Init 函数负责初始化全局内存、局部缓存以及分块参数。
+    *
+    * @param x 输入数据的全局内存地址
+    * @param y 输出数据的全局内存地址
+    * @param mask 掩码输出的全局内存地址，每个字节对应 8 个元素
+    * @param tiling 分块及随机数参数
+    */
+    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, GM_ADDR mask, const MishDropoutCustomTilingData &tiling)
+    {
+        ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");
+        ASSERT(tiling.tileNum != 0 && "tile num can not be zero!");
+
+        this->tileNum = tiling.tileNum;
+        this->tileLength = tiling.tileLength;
+        this->blockLength = tiling.tileNum * tiling.tileLength;
+        // 元素的全局下标决定随机数，保证结果与 blockDim 无关
+        this->blockOffset = this->blockLength * GetBlockIdx();
+        this->keepThreshold = tiling.keepThreshold;
+        this->scale = static_cast<DTYPE_X>(tiling.scale);
+        this->seedLo = tiling.seedLo;
+        this->seedHi = tiling.seedHi;
+        this->offsetLo = tiling.offsetLo;
+        this->offsetHi = tiling.offsetHi;
+
+        xGm.SetGlobalBuffer((__gm__ DTYPE_X*)x + this->blockOffset, this->blockLength);
+        yGm.SetGlobalBuffer((__gm__ DTYPE_Y*)y + this->blockOffset, this->blockLength);
+        maskGm.SetGlobalBuffer((__gm__ uint8_t*)mask + this->blockOffset / 8, this->blockLength / 8);
+
+        pipe.InitBuffer(inQueueX, BUFFER_NUM, this->tileLength * sizeof(DTYPE_X));
+        pipe.InitBuffer(outQueueY, BUFFER_NUM, this->tileLength * sizeof(DTYPE_Y));
+        pipe.InitBuffer(outQueueMask, BUFFER_NUM, this->tileLength / 8);
+        pipe.InitBuffer(tmpBuffer, this->tileLength * sizeof(DTYPE_X));
+    }
+
+    /**
+    * @brief Process 函数负责执行主循环，包括数据拷贝和计算。
+    */
+    __aicore__ inline void Process()
+    {
+        for (int32_t i = 0; i < static_cast<int32_t>(this->tileNum); i++) {
+            CopyIn(i);
+            Compute(i);
+            CopyOut(i);
+        }
+    }
+
+private:
+    __aicore__ inline void CopyIn(int32_t progress)
+    {
+        LocalTensor<DTYPE_X> xLocal = inQueueX.AllocTensor<DTYPE_X>();
+        DataCopy(xLocal, xGm[progress * this->tileLength], this->tileLength);
+        inQueueX.EnQue(xLocal);
+    }
+
+    /**
+    * @brief GenMask 在标量单元上为一个分块生成按位打包的保留掩码。
+    *
+    * 全局下标为 i 的元素使用计数器 (i/4, 0, offsetLo, offsetHi) 的第 i%4 个随机数，
+    * 随机数高 24 位小于 keepThreshold 时保留，对应第 i/8 个字节的第 i%8 位置 1。
+    */
+    __aicore__ inline void GenMask(LocalTensor<uint8_t> &maskLocal, int32_t progress)
+    {
+        uint32_t base = this->blockOffset + progress * this->tileLength;
+        for (uint32_t i = 0; i < this->tileLength; i += 8) {
+            uint32_t bits = 0;
+            for (uint32_t part = 0; part < 2; part++) {
+                uint32_t ctr[4] = { (base + i) / 4 + part, 0, this->offsetLo, this->offsetHi };
+                Philox4x32(ctr, this->seedLo, this->seedHi);
+                for (uint32_t lane = 0; lane < 4; lane++) {
+                    bits |= static_cast<uint32_t>((ctr[lane] >> 8) < this->keepThreshold) << (part * 4 + lane);
+                }
+            }
+            maskLocal.SetValue(i / 8, static_cast<uint8_t>(bits));
+        }
+    }
+
+    /**
+    * @brief Compute 先生成掩码，再计算 Mish，最后用掩码选择并乘以 1/keep_prob
+    */
+    __aicore__ inline void Compute(int32_t progress)
+    {
+        LocalTensor<DTYPE_X> xLocal = inQueueX.DeQue<DTYPE_X>();
+        LocalTensor<DTYPE_Y> yLocal = outQueueY.AllocTensor<DTYPE_Y>();
+        LocalTensor<uint8_t> maskLocal = outQueueMask.AllocTensor<uint8_t>();
+        LocalTensor<DTYPE_X> tmpTensor = tmpBuffer.Get<DTYPE_X>();
+
+        GenMask(maskLocal, progress);
+        // 标量写入的掩码要被向量单元读取，先同步 S->V
+        event_t eventSV = static_cast<event_t>(GetTPipePtr()->FetchEventID(HardEvent::S_V));
+        SetFlag<HardEvent::S_V>(eventSV);
+        WaitFlag<HardEvent::S_V>(eventSV);
+
+        // Mish(x) = x*tanh(Softplus(x))，与 KernelMish 的完整路径相同：e = exp(min(x, SATURATE_HIGH))，
+        // n = e * (e + 2)，tanh(Softplus(x)) = n / (n + 2)；截断保证大的 x 不会因 e 溢出得到 NaN
+        Mins(tmpTensor, xLocal, static_cast<DTYPE_X>(SATURATE_HIGH), this->tileLength);
+        Exp(tmpTensor, tmpTensor, this->tileLength);
+        Adds(yLocal, tmpTensor, static_cast<DTYPE_X>(2), this->tileLength);
+        Mul(tmpTensor, tmpTensor, yLocal, this->tileLength);
+        Adds(yLocal, tmpTensor, static_cast<DTYPE_X>(2), this->tileLength);
+        Div(tmpTensor, tmpTensor, yLocal, this->tileLength);
+        Mul(yLocal, xLocal, tmpTensor, this->tileLength);
+
+        // 掩码位为 1 的元素保留 y，为 0 的元素置 0，再乘以 1/keep_prob
+        Select(yLocal, maskLocal, yLocal, static_cast<DTYPE_Y>(0), SELMODE::VSEL_TENSOR_SCALAR_MODE, this->tileLength);
+        Muls(yLocal, yLocal, this->scale, this->tileLength);
+
+        outQueueY.EnQue<DTYPE_Y>(yLocal);
+        outQueueMask.EnQue<uint8_t>(maskLocal);
+        inQueueX.FreeTensor(xLocal);
+    }
+
+    __aicore__ inline void CopyOut(int32_t progress)
+    {
+        LocalTensor<DTYPE_Y> yLocal = outQueueY.DeQue<DTYPE_Y>();
+        DataCopy(yGm[progress * this->tileLength], yLocal, this->tileLength);
+        outQueueY.FreeTensor(yLocal);
+
+        LocalTensor<uint8_t> maskLocal = outQueueMask.DeQue<uint8_t>();
+        DataCopy(maskGm[progress * this->tileLength / 8], maskLocal, this->tileLength / 8);
+        outQueueMask.FreeTensor(maskLocal);
+    }
+
+private:
+    TPipe pipe;
+    TQue<QuePosition::VECIN, BUFFER_NUM> inQueueX;
+    TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueY;
+    TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueMask;
+
+    GlobalTensor<half> xGm;
+    GlobalTensor<half> yGm;
+    GlobalTensor<uint8_t> maskGm;
+
+    TBuf<QuePosition::VECCALC> tmpBuffer;
+
+    uint32_t blockLength;
+    uint32_t blockOffset;
+    uint32_t tileNum;
+    uint32_t tileLength;
+    uint32_t keepThreshold;
+    DTYPE_X scale;
+    uint32_t seedLo;
+    uint32_t seedHi;
+    uint32_t offsetLo;
+    uint32_t offsetHi;
+};
+
+/**
+* @brief 自定义的内核函数，通过 Init 初始化操作，并调用 Process 执行计算
+*
+* @param x 输入数据的全局内存地址
+* @param y 输出数据的全局内存地址
+* @param mask 按位打包的掩码输出地址
+* @param workspace 工作空间的地址
+* @param tiling 分块信息的地址
+*/
+extern "C" __global__ __aicore__ void mish_dropout_custom(GM_ADDR x, GM_ADDR y, GM_ADDR mask, GM_ADDR workspace,
+    GM_ADDR tiling)
+{
+    GET_TILING_DATA(tiling_data, tiling);
+    KernelMishDropout op;
+    op.Init(x, y, mask, tiling_data);
+    op.Process();
+}
@@ -0,0 +1,97 @@
+// 由 cmake/util/elementwise_codegen.py 根据 MishCustom.json 中 ScaledMishClampCustom 的 expression 生成，请勿手工修改
+// expression: t = Muls(x, 0.5); y = Cast(Mins(Maxs(Mish(t), -1.0), 6.0), 'float16')
+#include "kernel_operator.h"
+using namespace AscendC;
+
+constexpr int32_t BUFFER_NUM = 2;
+
+class KernelScaledMishClamp {
+public:
+    __aicore__ inline KernelScaledMishClamp() {}
+
+    __aicore__ inline void Init(GM_ADDR x, GM_ADDR y, uint32_t totalLength, uint32_t blockLength, uint32_t tileLength)
+    {
+        ASSERT(GetBlockNum() != 0 && "block dim can not be zero!");
+
+        // 最后一个核只处理剩下的部分，长度仍是 32 字节对齐的
+        uint32_t offset = blockLength * GetBlockIdx();
+        this->length = totalLength - offset < blockLength ? totalLength - offset : blockLength;
+        this->tileLength = tileLength;
+
+        xGm.SetGlobalBuffer((__gm__ float*)x + offset, this->length);
+        yGm.SetGlobalBuffer((__gm__ half*)y + offset, this->length);
+
+        pipe.InitBuffer(inQueueX, BUFFER_NUM, tileLength * sizeof(float));
+        pipe.InitBuffer(outQueueY, BUFFER_NUM, tileLength * sizeof(half));
+        pipe.InitBuffer(tmpBuffer0, tileLength * 4);
+        pipe.InitBuffer(tmpBuffer1, tileLength * 4);
+    }
+
+    __aicore__ inline void Process()
+    {
+        uint32_t loopCount = (this->length + this->tileLength - 1) / this->tileLength;
+        for (uint32_t i = 0; i < loopCount; i++) {
+            uint32_t offset = i * this->tileLength;
+            uint32_t count = this->length - offset < this->tileLength ? this->length - offset : this->tileLength;
+            CopyIn(offset, count);
+            Compute(count);
+            CopyOut(offset, count);
+        }
+    }
+
+private:
+    __aicore__ inline void CopyIn(uint32_t offset, uint32_t count)
+    {
+        LocalTensor<float> xLocal = inQueueX.AllocTensor<float>();
+        DataCopy(xLocal, xGm[offset], count);
+        inQueueX.EnQue(xLocal);
+    }
+
+    __aicore__ inline void Compute(uint32_t count)
+    {
+        LocalTensor<float> xLocal = inQueueX.DeQue<float>();
+        LocalTensor<half> yLocal = outQueueY.AllocTensor<half>();
+        LocalTensor<float> tmp0F32 = tmpBuffer0.Get<float>();
+        LocalTensor<float> tmp1F32 = tmpBuffer1.Get<float>();
+
+        Muls(xLocal, xLocal, static_cast<float>(0.5), count);
+        Mins(tmp0F32, xLocal, static_cast<float>(20.0), count);
+        Exp(tmp0F32, tmp0F32, count);
+        Adds(tmp1F32, tmp0F32, static_cast<float>(2.0), count);
+        Mul(tmp0F32, tmp0F32, tmp1F32, count);
+        Adds(tmp1F32, tmp0F32, static_cast<float>(2.0), count);
+        Div(tmp0F32, tmp0F32, tmp1F32, count);
+        Mul(xLocal, xLocal, tmp0F32, count);
+        Maxs(xLocal, xLocal, static_cast<float>(-1.0), count);
+        Mins(xLocal, xLocal, static_cast<float>(6.0), count);
+        Cast(yLocal, xLocal, RoundMode::CAST_ROUND, count);
+
+        outQueueY.EnQue<half>(yLocal);
+        inQueueX.FreeTensor(xLocal);
+    }
+
+    __aicore__ inline void CopyOut(uint32_t offset, uint32_t count)
+    {
+        LocalTensor<half> yLocal = outQueueY.DeQue<half>();
+        DataCopy(yGm[offset], yLocal, count);
+        outQueueY.FreeTensor(yLocal);
+    }
+
+private:
+    TPipe pipe;
+    TQue<QuePosition::VECIN, BUFFER_NUM> inQueueX;
+    TQue<QuePosition::VECOUT, BUFFER_NUM> outQueueY;
+    TBuf<QuePosition::VECCALC> tmpBuffer0;
+    TBuf<QuePosition::VECCALC> tmpBuffer1;
+    GlobalTensor<float> xGm;
+    GlobalTensor<half> yGm;
+    uint32_t length;
+    uint32_t tileLength;
+};
+
+extern "C" __global__ __aicore__ void scaled_mish_clamp_custom(GM_ADDR x, GM_ADDR y, GM_ADDR workspace, GM_ADDR tiling) {
+    GET_TILING_DATA(tiling_data, tiling);
+    KernelScaledMishClamp op;
+    op.Init(x, y, tiling_data.totalLength, tiling_data.blockLength, tiling_data.tileLength);
+    op.Process();
+}
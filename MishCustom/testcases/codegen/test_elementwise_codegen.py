@@ -0,0 +1,55 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+cmake/util/elementwise_codegen.py 的生成结果与仓库里提交的 op_host / op_kernel 源码一致：
+按 MishCustom.json 重新生成到临时目录，逐个文件比较。改了 json 或生成脚本后需要重新生成并一起提交：
+    python3 cmake/util/elementwise_codegen.py gen MishCustom.json --host-dir op_host --kernel-dir op_kernel
+    python3 testcases/codegen/test_elementwise_codegen.py
+"""
+import difflib
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+MISH_CUSTOM_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+SCRIPT = os.path.join(MISH_CUSTOM_DIR, 'cmake', 'util', 'elementwise_codegen.py')
+DESC = os.path.join(MISH_CUSTOM_DIR, 'MishCustom.json')
+
+
+class RegenerateTest(unittest.TestCase):
+    def setUp(self):
+        self.work = tempfile.mkdtemp(prefix='elementwise_codegen_')
+
+    def tearDown(self):
+        shutil.rmtree(self.work, ignore_errors=True)
+
+    def test_committed_sources_up_to_date(self):
+        generated = {}
+        for sub in ('op_host', 'op_kernel'):
+            os.makedirs(os.path.join(self.work, sub))
+        result = subprocess.run([sys.executable, SCRIPT, 'gen', DESC, '--host-dir', os.path.join(self.work, 'op_host'),
+                                 '--kernel-dir', os.path.join(self.work, 'op_kernel')],
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        self.assertEqual(result.returncode, 0, result.stdout)
+        for sub in ('op_host', 'op_kernel'):
+            for name in os.listdir(os.path.join(self.work, sub)):
+                generated[os.path.join(sub, name)] = os.path.join(self.work, sub, name)
+        self.assertTrue(generated, 'MishCustom.json has no expression op')
+        for rel, path in sorted(generated.items()):
+            committed = os.path.join(MISH_CUSTOM_DIR, rel)
+            self.assertTrue(os.path.exists(committed), '{} is generated but not committed'.format(rel))
+            with open(path) as f:
+                want = f.readlines()
+            with open(committed) as f:
+                got = f.readlines()
+            diff = ''.join(difflib.unified_diff(got, want, 'committed/' + rel, 'generated/' + rel))
+            if diff:
+                self.fail('{} is stale, regenerate it:\n{}'.format(rel, diff))
+
+
+if __name__ == '__main__':
+    unittest.main()
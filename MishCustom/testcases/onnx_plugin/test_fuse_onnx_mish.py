@@ -0,0 +1,211 @@
+#!/usr/bin/python3
+# -*- coding:utf-8 -*-
+# Copyright 2022-2023 Huawei Technologies Co., Ltd
+"""
+framework/onnx_plugin/fuse_onnx_mish.py 的测试，夹具模型用 onnx.helper 现场构造：
+两种 softplus 写法都要改写成一个 custom::MishCustom，a * tanh(softplus(b)) 和中间结果另有用途时保持原样。
+参考实现不认识自定义域，MishCustom 的数值由下面的 OpRun 给出。
+    python3 testcases/onnx_plugin/test_fuse_onnx_mish.py
+"""
+import os
+import re
+import sys
+import unittest
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+from onnx.reference import ReferenceEvaluator
+from onnx.reference.op_run import OpRun
+
+PLUGIN_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'framework', 'onnx_plugin')
+sys.path.insert(0, PLUGIN_DIR)
+from fuse_onnx_mish import CUSTOM_DOMAIN, CUSTOM_DOMAIN_VERSION, CUSTOM_OP_TYPE, fuse  # noqa: E402
+
+SHAPE = [2, 8]
+
+
+def make_model(nodes, inputs=('x',), outputs=('y',), initializers=(), opset=18):
+    graph = helper.make_graph(
+        list(nodes), 'mish_fixture',
+        [helper.make_tensor_value_info(name, TensorProto.FLOAT, SHAPE) for name in inputs],
+        [helper.make_tensor_value_info(name, TensorProto.FLOAT, SHAPE) for name in outputs],
+        initializer=list(initializers))
+    return helper.make_model(graph, opset_imports=[helper.make_opsetid('', opset)])
+
+
+def one(name='one', value=1.0):
+    return numpy_helper.from_array(np.array(value, dtype=np.float32), name)
+
+
+def softplus_nodes(x='x', y='y'):
+    return [
+        helper.make_node('Softplus', [x], [x + '_sp'], name=x + '/Softplus'),
+        helper.make_node('Tanh', [x + '_sp'], [x + '_tanh'], name=x + '/Tanh'),
+        helper.make_node('Mul', [x, x + '_tanh'], [y], name=x + '/Mul'),
+    ]
+
+
+def log1p_exp_nodes(x='x', y='y', one_name='one', swap_add=False, swap_mul=False):
+    add_inputs = [one_name, x + '_exp'] if swap_add else [x + '_exp', one_name]
+    mul_inputs = [x + '_tanh', x] if swap_mul else [x, x + '_tanh']
+    return [
+        helper.make_node('Exp', [x], [x + '_exp'], name=x + '/Exp'),
+        helper.make_node('Add', add_inputs, [x + '_add'], name=x + '/Add'),
+        helper.make_node('Log', [x + '_add'], [x + '_sp'], name=x + '/Log'),
+        helper.make_node('Tanh', [x + '_sp'], [x + '_tanh'], name=x + '/Tanh'),
+        helper.make_node('Mul', mul_inputs, [y], name=x + '/Mul'),
+    ]
+
+
+def op_types(model):
+    return [node.op_type for node in model.graph.node]
+
+
+class MishCustom(OpRun):
+    op_domain = CUSTOM_DOMAIN
+
+    def _run(self, x):
+        return (x * np.tanh(np.logaddexp(0, x)).astype(x.dtype),)
+
+
+def run(model, feeds):
+    return ReferenceEvaluator(model, new_ops=[MishCustom]).run(None, feeds)
+
+
+def custom_opsets(model):
+    return [(o.domain, o.version) for o in model.opset_import if o.domain == CUSTOM_DOMAIN]
+
+
+class FuseTest(unittest.TestCase):
+    def setUp(self):
+        # 覆盖饱和区和 0 附近
+        self.x = np.linspace(-25.0, 25.0, int(np.prod(SHAPE)), dtype=np.float32).reshape(SHAPE)
+
+    def assert_fused(self, model, expected_count, feeds=None):
+        feeds = feeds or {'x': self.x}
+        original = onnx.ModelProto()
+        original.CopyFrom(model)
+        self.assertEqual(fuse(model), expected_count)
+        onnx.checker.check_model(model)
+        self.assertEqual(custom_opsets(model), [(CUSTOM_DOMAIN, CUSTOM_DOMAIN_VERSION)])
+        # 改写前后数值一致，输出名不变
+        self.assertEqual([o.name for o in model.graph.output], [o.name for o in original.graph.output])
+        for got, want in zip(run(model, feeds), run(original, feeds)):
+            np.testing.assert_allclose(got, want, rtol=1e-5, atol=1e-6)
+
+    def assert_unchanged(self, model):
+        before = model.SerializeToString()
+        self.assertEqual(fuse(model), 0)
+        self.assertEqual(model.SerializeToString(), before)
+
+    def test_softplus_form(self):
+        model = make_model(softplus_nodes())
+        self.assert_fused(model, 1)
+        self.assertEqual(op_types(model), ['MishCustom'])
+        mish = model.graph.node[0]
+        self.assertEqual(mish.domain, CUSTOM_DOMAIN)
+        self.assertEqual(list(mish.input), ['x'])
+        self.assertEqual(list(mish.output), ['y'])
+        self.assertEqual(mish.name, 'x/Mul')
+
+    def test_log1p_exp_form(self):
+        model = make_model(log1p_exp_nodes(), initializers=[one()])
+        self.assert_fused(model, 1)
+        self.assertEqual(op_types(model), ['MishCustom'])
+
+    def test_log1p_exp_form_swapped_operands(self):
+        # Add(1, Exp(x)) 与 Mul(tanh, x) 同样识别
+        model = make_model(log1p_exp_nodes(swap_add=True, swap_mul=True), initializers=[one()])
+        self.assert_fused(model, 1)
+        self.assertEqual(op_types(model), ['MishCustom'])
+
+    def test_log1p_exp_form_constant_node(self):
+        constant = helper.make_node('Constant', [], ['one'], value=one('one_value'))
+        model = make_model([constant] + log1p_exp_nodes())
+        self.assert_fused(model, 1)
+        # 常量节点还在，只是没人用了
+        self.assertEqual(op_types(model), ['Constant', 'MishCustom'])
+
+    def test_chained_mish_keeps_order(self):
+        nodes = softplus_nodes('x', 'h') + [helper.make_node('Relu', ['h'], ['r'], name='relu')] + \
+            log1p_exp_nodes('r', 'y')
+        model = make_model(nodes, initializers=[one()])
+        self.assert_fused(model, 2)
+        self.assertEqual(op_types(model), ['MishCustom', 'Relu', 'MishCustom'])
+
+    def test_different_inputs_not_fused(self):
+        # a * tanh(softplus(b)) 不是 mish
+        nodes = [
+            helper.make_node('Softplus', ['b'], ['sp']),
+            helper.make_node('Tanh', ['sp'], ['tanh']),
+            helper.make_node('Mul', ['a', 'tanh'], ['y']),
+        ]
+        self.assert_unchanged(make_model(nodes, inputs=('a', 'b')))
+
+    def test_log1p_exp_different_inputs_not_fused(self):
+        nodes = [
+            helper.make_node('Exp', ['b'], ['e']),
+            helper.make_node('Add', ['e', 'one'], ['s']),
+            helper.make_node('Log', ['s'], ['sp']),
+            helper.make_node('Tanh', ['sp'], ['tanh']),
+            helper.make_node('Mul', ['a', 'tanh'], ['y']),
+        ]
+        self.assert_unchanged(make_model(nodes, inputs=('a', 'b'), initializers=[one()]))
+
+    def test_tanh_used_elsewhere_not_fused(self):
+        nodes = softplus_nodes() + [helper.make_node('Neg', ['x_tanh'], ['z'])]
+        self.assert_unchanged(make_model(nodes, outputs=('y', 'z')))
+
+    def test_softplus_used_elsewhere_not_fused(self):
+        nodes = softplus_nodes() + [helper.make_node('Neg', ['x_sp'], ['z'])]
+        self.assert_unchanged(make_model(nodes, outputs=('y', 'z')))
+
+    def test_exp_used_elsewhere_not_fused(self):
+        nodes = log1p_exp_nodes() + [helper.make_node('Neg', ['x_exp'], ['z'])]
+        self.assert_unchanged(make_model(nodes, outputs=('y', 'z'), initializers=[one()]))
+
+    def test_intermediate_graph_output_not_fused(self):
+        self.assert_unchanged(make_model(softplus_nodes(), outputs=('y', 'x_tanh')))
+
+    def test_add_not_one_not_fused(self):
+        # log(exp(x) + 2) 不是 softplus
+        self.assert_unchanged(make_model(log1p_exp_nodes(), initializers=[one(value=2.0)]))
+
+    def test_partial_fusion(self):
+        # 第一个 mish 的 tanh 另有用途，只改写第二个
+        nodes = softplus_nodes('x', 'h') + [helper.make_node('Neg', ['x_tanh'], ['z'])] + softplus_nodes('h', 'y')
+        model = make_model(nodes, outputs=('y', 'z'))
+        self.assert_fused(model, 1)
+        self.assertEqual(op_types(model), ['Softplus', 'Tanh', 'Mul', 'Neg', 'MishCustom'])
+
+    def test_low_opset(self):
+        # opset 13 没有 Mish，自定义域的节点照样通过 checker
+        model = make_model(log1p_exp_nodes(), initializers=[one()], opset=13)
+        self.assert_fused(model, 1)
+        self.assertEqual(op_types(model), ['MishCustom'])
+
+    def test_existing_custom_import_reused(self):
+        model = make_model(softplus_nodes())
+        model.opset_import.extend([helper.make_opsetid(CUSTOM_DOMAIN, CUSTOM_DOMAIN_VERSION)])
+        self.assert_fused(model, 1)
+
+    def test_custom_import_version_conflict(self):
+        model = make_model(softplus_nodes())
+        model.opset_import.extend([helper.make_opsetid(CUSTOM_DOMAIN, CUSTOM_DOMAIN_VERSION + 1)])
+        with self.assertRaises(ValueError):
+            fuse(model)
+
+
+class PluginTest(unittest.TestCase):
+    def test_origin_op_types(self):
+        # 插件只认原生的 opset 18 Mish 和脚本写出的自定义域节点
+        with open(os.path.join(PLUGIN_DIR, 'onnx_mish_custom_plugin.cc')) as f:
+            source = f.read()
+        registered = re.findall(r'AscendString\("([^"]+)"\)', source)
+        expected = ['ai.onnx::18::Mish', '{}::{}::{}'.format(CUSTOM_DOMAIN, CUSTOM_DOMAIN_VERSION, CUSTOM_OP_TYPE)]
+        self.assertEqual(sorted(registered), sorted(expected))
+
+
+if __name__ == '__main__':
+    unittest.main()
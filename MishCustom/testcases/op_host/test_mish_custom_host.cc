@@ -0,0 +1,207 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include <cstring>
+#include <memory>
+
+#include "gtest/gtest.h"
+// 推理和 tiling 函数是 static 的，直接包含源文件；CANN 接口由 testcases/stub 提供
+#include "mish_custom.cpp"
+
+namespace {
+// MishCustomTilingData 的字段顺序
+enum TilingField { TOTAL_LENGTH, FORMER_NUM, FORMER_LENGTH, TAIL_LENGTH, LAST_REMAIN, TILE_LENGTH, ADAPTIVE,
+    FIELD_NUM };
+
+std::unique_ptr<ops::OpDef> CreateMishCustom()
+{
+    auto it = ops::OpDefRegistry().find("MishCustom");
+    return std::unique_ptr<ops::OpDef>(it == ops::OpDefRegistry().end() ? nullptr : it->second());
+}
+
+gert::TilingContext MakeTilingContext(int64_t length, bool adaptive, bool burstAlign)
+{
+    gert::TilingContext context;
+    context.inputs.push_back(gert::StorageShape({ length }, { length }));
+    context.attrs.Append(adaptive);
+    context.attrs.Append(burstAlign);
+    return context;
+}
+
+std::vector<uint32_t> ReadTiling(gert::TilingContext &context)
+{
+    std::vector<uint32_t> fields(FIELD_NUM);
+    EXPECT_EQ(context.GetRawTilingData()->GetDataSize(), FIELD_NUM * sizeof(uint32_t));
+    std::memcpy(fields.data(), context.GetRawTilingData()->GetData(), FIELD_NUM * sizeof(uint32_t));
+    return fields;
+}
+}  // namespace
+
+TEST(MishCustomInferShapeRange, DynamicRangeWithResidual)
+{
+    gert::Shape xMin({ 1, 16 });
+    gert::Shape xMax({ 64, 16 });
+    gert::Range<gert::Shape> xRange(&xMin, &xMax);
+    gert::Shape yMin, yMax, tMin, tMax;
+    gert::Range<gert::Shape> yRange(&yMin, &yMax);
+    gert::Range<gert::Shape> tRange(&tMin, &tMax);
+    gert::InferShapeRangeContext context;
+    context.inputs = { &xRange };
+    context.outputs = { &yRange, &tRange };
+
+    ASSERT_EQ(ge::InferShapeRange(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(yMin, xMin);
+    EXPECT_EQ(yMax, xMax);
+    EXPECT_EQ(tMin, xMin);
+    EXPECT_EQ(tMax, xMax);
+}
+
+TEST(MishCustomInferShapeRange, UnboundedDimWithoutResidual)
+{
+    // -1 表示上界未知，原样传给 y
+    gert::Shape xMin({ 1, 1, 128 });
+    gert::Shape xMax({ -1, 512, 128 });
+    gert::Range<gert::Shape> xRange(&xMin, &xMax);
+    gert::Shape yMin, yMax;
+    gert::Range<gert::Shape> yRange(&yMin, &yMax);
+    gert::InferShapeRangeContext context;
+    context.inputs = { &xRange };
+    context.outputs = { &yRange };
+
+    ASSERT_EQ(ge::InferShapeRange(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(yMin, xMin);
+    EXPECT_EQ(yMax, xMax);
+    EXPECT_EQ(yMax.GetShapeSize(), -1);
+
+    // t 的位置存在但没有连接
+    context.outputs = { &yRange, nullptr };
+    EXPECT_EQ(ge::InferShapeRange(&context), ge::GRAPH_SUCCESS);
+}
+
+TEST(MishCustomInferShapeRange, MissingRange)
+{
+    gert::Shape yMin, yMax;
+    gert::Range<gert::Shape> yRange(&yMin, &yMax);
+    gert::InferShapeRangeContext context;
+    context.outputs = { &yRange };
+    EXPECT_EQ(ge::InferShapeRange(&context), ge::GRAPH_FAILED);
+
+    gert::Shape xMin({ 8 });
+    gert::Shape xMax({ 8 });
+    gert::Range<gert::Shape> xRange(&xMin, &xMax);
+    context.inputs = { &xRange };
+    context.outputs.clear();
+    EXPECT_EQ(ge::InferShapeRange(&context), ge::GRAPH_FAILED);
+}
+
+TEST(MishCustomInferShape, WithAndWithoutResidual)
+{
+    gert::Shape x({ 4, 8, 2048 });
+    gert::Shape y, t;
+    gert::InferShapeContext context;
+    context.inputs = { &x };
+    context.outputs = { &y, &t };
+    ASSERT_EQ(ge::InferShape(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(y, x);
+    EXPECT_EQ(t, x);
+
+    gert::Shape y2;
+    context.outputs = { &y2 };
+    ASSERT_EQ(ge::InferShape(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(y2, x);
+}
+
+TEST(MishCustomInferDataType, PropagatesInputType)
+{
+    gert::InferDataTypeContext context;
+    context.inputs = { ge::DT_FLOAT16 };
+    context.outputs = { ge::DT_UNDEFINED, ge::DT_UNDEFINED };
+    ASSERT_EQ(ge::InferDataType(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(context.outputs[0], ge::DT_FLOAT16);
+    EXPECT_EQ(context.outputs[1], ge::DT_FLOAT16);
+
+    // 输出类型跟随输入，而不是写死 float16
+    context.inputs = { ge::DT_FLOAT };
+    ASSERT_EQ(ge::InferDataType(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(context.outputs[0], ge::DT_FLOAT);
+    EXPECT_EQ(context.outputs[1], ge::DT_FLOAT);
+}
+
+TEST(MishCustomInferDataType, WithoutResidual)
+{
+    gert::InferDataTypeContext context;
+    context.inputs = { ge::DT_FLOAT16 };
+    context.outputs = { ge::DT_UNDEFINED };
+    ASSERT_EQ(ge::InferDataType(&context), ge::GRAPH_SUCCESS);
+    EXPECT_EQ(context.outputs[0], ge::DT_FLOAT16);
+
+    context.outputs.clear();
+    EXPECT_EQ(ge::InferDataType(&context), ge::GRAPH_FAILED);
+}
+
+TEST(MishCustomOpDef, RegistersInferAndAttrs)
+{
+    std::unique_ptr<ops::OpDef> def = CreateMishCustom();
+    ASSERT_NE(def, nullptr);
+    EXPECT_EQ(def->inferShape, &ge::InferShape);
+    EXPECT_EQ(def->inferShapeRange, &ge::InferShapeRange);
+    EXPECT_EQ(def->inferDataType, &ge::InferDataType);
+    EXPECT_EQ(def->aicore.tiling, &optiling::TilingFunc);
+
+    ASSERT_EQ(def->outputs.size(), 2U);
+    EXPECT_EQ(def->outputs[0].paramType, ops::REQUIRED);
+    EXPECT_EQ(def->outputs[1].name, "t");
+    EXPECT_EQ(def->outputs[1].paramType, ops::OPTIONAL);
+
+    // 属性下标与 TilingFunc 中 GetAttrPointer 的下标一致
+    ASSERT_EQ(def->attrs.size(), 2U);
+    EXPECT_EQ(def->attrs[0].name, "adaptive");
+    EXPECT_EQ(def->attrs[0].type, "bool");
+    EXPECT_EQ(def->attrs[0].defaultValue, "false");
+    EXPECT_EQ(def->attrs[1].name, "burst_align");
+    EXPECT_EQ(def->attrs[1].defaultValue, "true");
+}
+
+TEST(MishCustomTiling, AttrsSelectPathChoiceAndSplit)
+{
+    // 65536 + 48 个元素，按 512 字节（256 个元素）划分余 48 个给最后一个核
+    gert::TilingContext context = MakeTilingContext(65584, false, true);
+    ASSERT_EQ(optiling::TilingFunc(&context), ge::GRAPH_SUCCESS);
+    std::vector<uint32_t> fields = ReadTiling(context);
+    EXPECT_EQ(context.GetBlockDim(), 8U);
+    EXPECT_EQ(fields[TOTAL_LENGTH], 65584U);
+    EXPECT_EQ(fields[FORMER_NUM], 0U);
+    EXPECT_EQ(fields[TAIL_LENGTH], 8192U);
+    EXPECT_EQ(fields[LAST_REMAIN], 48U);
+    EXPECT_EQ(fields[TILE_LENGTH] % 256, 0U);
+    EXPECT_EQ(fields[ADAPTIVE], 0U);
+    ASSERT_EQ(context.workspaceSizes.size(), 1U);
+    EXPECT_EQ(context.workspaceSizes[0], platform_ascendc::STUB_LIB_API_WORKSPACE_SIZE + 8 * 8 * sizeof(int32_t));
+
+    // burst_align 关闭时按 32 字节（16 个元素）划分，adaptive 打开后写入 tiling
+    gert::TilingContext unaligned = MakeTilingContext(65584, true, false);
+    ASSERT_EQ(optiling::TilingFunc(&unaligned), ge::GRAPH_SUCCESS);
+    fields = ReadTiling(unaligned);
+    EXPECT_EQ(fields[FORMER_NUM], 3U);
+    EXPECT_EQ(fields[FORMER_LENGTH], 8208U);
+    EXPECT_EQ(fields[TAIL_LENGTH], 8192U);
+    EXPECT_EQ(fields[LAST_REMAIN], 0U);
+    EXPECT_EQ(fields[ADAPTIVE], 1U);
+}
+
+TEST(MishCustomTiling, RejectsUnalignedLength)
+{
+    gert::TilingContext context = MakeTilingContext(65536 + 8, false, true);
+    EXPECT_EQ(optiling::TilingFunc(&context), ge::GRAPH_FAILED);
+}
@@ -0,0 +1,364 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+// 主机侧单元测试用的桩：只实现 op_host 用到的 ge/gert/ops 接口，行为与 CANN 一致，
+// 上下文由测试直接填写输入输出，没连接的可选输出返回 nullptr
+#ifndef STUB_REGISTER_OP_DEF_REGISTRY_H
+#define STUB_REGISTER_OP_DEF_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ge {
+using graphStatus = uint32_t;
+const graphStatus GRAPH_SUCCESS = 0;
+const graphStatus GRAPH_FAILED = 0xFFFFFFFF;
+
+enum DataType { DT_FLOAT = 0, DT_FLOAT16 = 1, DT_INT8 = 2, DT_INT32 = 3, DT_UINT8 = 4, DT_INT64 = 9,
+    DT_UNDEFINED = 28 };
+enum Format { FORMAT_NCHW = 0, FORMAT_NHWC = 1, FORMAT_ND = 2 };
+}  // namespace ge
+
+namespace fe {
+class PlatFormInfos {};
+}  // namespace fe
+
+namespace gert {
+class Shape {
+public:
+    Shape() {}
+    Shape(std::initializer_list<int64_t> dims) : dims_(dims) {}
+
+    size_t GetDimNum() const { return dims_.size(); }
+    int64_t GetDim(size_t idx) const { return idx < dims_.size() ? dims_[idx] : 0; }
+    void SetDimNum(size_t num) { dims_.resize(num); }
+    void SetDim(size_t idx, int64_t value) { dims_[idx] = value; }
+    Shape &AppendDim(int64_t value)
+    {
+        dims_.push_back(value);
+        return *this;
+    }
+
+    // 标量返回 1，任一维为 -1（未知）时返回 -1
+    int64_t GetShapeSize() const
+    {
+        int64_t size = 1;
+        for (int64_t dim : dims_) {
+            if (dim < 0) {
+                return -1;
+            }
+            size *= dim;
+        }
+        return size;
+    }
+
+    bool operator==(const Shape &other) const { return dims_ == other.dims_; }
+    bool operator!=(const Shape &other) const { return dims_ != other.dims_; }
+
+private:
+    std::vector<int64_t> dims_;
+};
+
+class StorageShape {
+public:
+    StorageShape() {}
+    StorageShape(std::initializer_list<int64_t> origin, std::initializer_list<int64_t> storage)
+        : origin_(origin), storage_(storage) {}
+
+    const Shape &GetOriginShape() const { return origin_; }
+    const Shape &GetStorageShape() const { return storage_; }
+    Shape &MutableOriginShape() { return origin_; }
+    Shape &MutableStorageShape() { return storage_; }
+
+private:
+    Shape origin_;
+    Shape storage_;
+};
+
+template <typename T>
+class Range {
+public:
+    Range() : min_(nullptr), max_(nullptr) {}
+    Range(T *min, T *max) : min_(min), max_(max) {}
+
+    const T *GetMin() const { return min_; }
+    const T *GetMax() const { return max_; }
+    T *GetMin() { return min_; }
+    T *GetMax() { return max_; }
+
+private:
+    T *min_;
+    T *max_;
+};
+
+// 属性按 OpDef 中 Attr 的声明顺序编号，测试只放需要的几个
+class RuntimeAttrs {
+public:
+    template <typename T>
+    const T *GetAttrPointer(size_t idx) const
+    {
+        if (idx >= values_.size() || values_[idx].size() != sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(values_[idx].data());
+    }
+
+    template <typename T>
+    void Append(const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        values_.push_back(std::vector<char>(bytes, bytes + sizeof(T)));
+    }
+
+private:
+    std::vector<std::vector<char>> values_;
+};
+
+class TilingData {
+public:
+    explicit TilingData(size_t capacity) : data_(capacity), dataSize_(0) {}
+
+    void *GetData() { return data_.data(); }
+    size_t GetCapacity() const { return data_.size(); }
+    size_t GetDataSize() const { return dataSize_; }
+    void SetDataSize(size_t size) { dataSize_ = size; }
+
+private:
+    std::vector<char> data_;
+    size_t dataSize_;
+};
+
+class TilingContext {
+public:
+    TilingContext() : rawTilingData_(4096), blockDim_(0) {}
+
+    const StorageShape *GetInputShape(size_t idx) const { return idx < inputs.size() ? &inputs[idx] : nullptr; }
+    const RuntimeAttrs *GetAttrs() const { return &attrs; }
+    void SetBlockDim(uint32_t blockDim) { blockDim_ = blockDim; }
+    uint32_t GetBlockDim() const { return blockDim_; }
+    TilingData *GetRawTilingData() { return &rawTilingData_; }
+    size_t *GetWorkspaceSizes(size_t num)
+    {
+        workspaceSizes.resize(num);
+        return workspaceSizes.data();
+    }
+    fe::PlatFormInfos *GetPlatformInfo() { return &platform_; }
+
+    std::vector<StorageShape> inputs;
+    RuntimeAttrs attrs;
+    std::vector<size_t> workspaceSizes;
+
+private:
+    TilingData rawTilingData_;
+    uint32_t blockDim_;
+    fe::PlatFormInfos platform_;
+};
+
+class InferShapeContext {
+public:
+    const Shape *GetInputShape(size_t idx) const { return idx < inputs.size() ? inputs[idx] : nullptr; }
+    Shape *GetOutputShape(size_t idx) { return idx < outputs.size() ? outputs[idx] : nullptr; }
+
+    std::vector<const Shape *> inputs;
+    std::vector<Shape *> outputs;
+};
+
+class InferShapeRangeContext {
+public:
+    const Range<Shape> *GetInputShapeRange(size_t idx) const
+    {
+        return idx < inputs.size() ? inputs[idx] : nullptr;
+    }
+    Range<Shape> *GetOutputShapeRange(size_t idx) { return idx < outputs.size() ? outputs[idx] : nullptr; }
+
+    std::vector<const Range<Shape> *> inputs;
+    std::vector<Range<Shape> *> outputs;
+};
+
+class InferDataTypeContext {
+public:
+    ge::DataType GetInputDataType(size_t idx) const
+    {
+        return idx < inputs.size() ? inputs[idx] : ge::DT_UNDEFINED;
+    }
+    ge::graphStatus SetOutputDataType(size_t idx, ge::DataType dataType)
+    {
+        if (idx >= outputs.size()) {
+            return ge::GRAPH_FAILED;
+        }
+        outputs[idx] = dataType;
+        return ge::GRAPH_SUCCESS;
+    }
+
+    std::vector<ge::DataType> inputs;
+    std::vector<ge::DataType> outputs;
+};
+}  // namespace gert
+
+namespace ops {
+enum Option { IGNORE = 0, OPTIONAL = 1, REQUIRED = 2, DYNAMIC = 3 };
+
+class OpParamDef {
+public:
+    OpParamDef &ParamType(Option type)
+    {
+        paramType = type;
+        return *this;
+    }
+    OpParamDef &DataType(std::vector<ge::DataType> types)
+    {
+        dataTypes = types;
+        return *this;
+    }
+    OpParamDef &Format(std::vector<ge::Format> formats)
+    {
+        this->formats = formats;
+        return *this;
+    }
+    OpParamDef &UnknownShapeFormat(std::vector<ge::Format> formats)
+    {
+        unknownShapeFormats = formats;
+        return *this;
+    }
+
+    std::string name;
+    Option paramType = REQUIRED;
+    std::vector<ge::DataType> dataTypes;
+    std::vector<ge::Format> formats;
+    std::vector<ge::Format> unknownShapeFormats;
+};
+
+class OpAttrDef {
+public:
+    OpAttrDef &AttrType(Option type)
+    {
+        attrType = type;
+        return *this;
+    }
+    OpAttrDef &Bool(bool value)
+    {
+        type = "bool";
+        defaultValue = value ? "true" : "false";
+        return *this;
+    }
+    OpAttrDef &Float(float value)
+    {
+        type = "float";
+        defaultValue = std::to_string(value);
+        return *this;
+    }
+    OpAttrDef &Int(int64_t value)
+    {
+        type = "int";
+        defaultValue = std::to_string(value);
+        return *this;
+    }
+
+    std::string name;
+    Option attrType = REQUIRED;
+    std::string type;
+    std::string defaultValue;
+};
+
+using TilingFunc = ge::graphStatus (*)(gert::TilingContext *);
+using InferShapeFunc = ge::graphStatus (*)(gert::InferShapeContext *);
+using InferShapeRangeFunc = ge::graphStatus (*)(gert::InferShapeRangeContext *);
+using InferDataTypeFunc = ge::graphStatus (*)(gert::InferDataTypeContext *);
+
+class OpAICoreDef {
+public:
+    OpAICoreDef &SetTiling(TilingFunc func)
+    {
+        tiling = func;
+        return *this;
+    }
+    OpAICoreDef &AddConfig(const char *soc)
+    {
+        configs.push_back(soc);
+        return *this;
+    }
+
+    TilingFunc tiling = nullptr;
+    std::vector<std::string> configs;
+};
+
+class OpDef {
+public:
+    explicit OpDef(const char *type) : type(type) {}
+    virtual ~OpDef() {}
+
+    OpParamDef &Input(const char *name) { return Param(inputs, name); }
+    OpParamDef &Output(const char *name) { return Param(outputs, name); }
+    OpAttrDef &Attr(const char *name)
+    {
+        attrs.push_back(OpAttrDef());
+        attrs.back().name = name;
+        return attrs.back();
+    }
+    OpDef &SetInferShape(InferShapeFunc func)
+    {
+        inferShape = func;
+        return *this;
+    }
+    OpDef &SetInferShapeRange(InferShapeRangeFunc func)
+    {
+        inferShapeRange = func;
+        return *this;
+    }
+    OpDef &SetInferDataType(InferDataTypeFunc func)
+    {
+        inferDataType = func;
+        return *this;
+    }
+    OpAICoreDef &AICore() { return aicore; }
+
+    std::string type;
+    std::vector<OpParamDef> inputs;
+    std::vector<OpParamDef> outputs;
+    std::vector<OpAttrDef> attrs;
+    InferShapeFunc inferShape = nullptr;
+    InferShapeRangeFunc inferShapeRange = nullptr;
+    InferDataTypeFunc inferDataType = nullptr;
+    OpAICoreDef aicore;
+
+private:
+    static OpParamDef &Param(std::vector<OpParamDef> &params, const char *name)
+    {
+        params.push_back(OpParamDef());
+        params.back().name = name;
+        return params.back();
+    }
+};
+
+// OP_ADD 注册的算子定义，测试按类型名取出检查输入输出、属性和推理函数
+inline std::map<std::string, std::function<OpDef *()>> &OpDefRegistry()
+{
+    static std::map<std::string, std::function<OpDef *()>> registry;
+    return registry;
+}
+
+struct OpDefRegisterer {
+    OpDefRegisterer(const char *type, std::function<OpDef *()> creator) { OpDefRegistry()[type] = creator; }
+};
+}  // namespace ops
+
+#define OP_ADD(opType) \
+    static ops::OpDefRegisterer g_##opType##_registerer(#opType, []() -> ops::OpDef * { return new opType(#opType); })
+
+#endif  // STUB_REGISTER_OP_DEF_REGISTRY_H
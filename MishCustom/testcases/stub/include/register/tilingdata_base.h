@@ -0,0 +1,83 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+// 主机侧单元测试用的桩：字段按声明顺序紧密排列，SaveToBuffer 写出的布局与 kernel 侧读取的一致
+#ifndef STUB_REGISTER_TILINGDATA_BASE_H
+#define STUB_REGISTER_TILINGDATA_BASE_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "register/op_def_registry.h"
+
+namespace optiling {
+class TilingDef {
+public:
+    TilingDef() {}
+    TilingDef(const TilingDef &) = delete;
+    TilingDef &operator=(const TilingDef &) = delete;
+    virtual ~TilingDef() {}
+
+    void SaveToBuffer(void *buffer, size_t capacity) const
+    {
+        size_t offset = 0;
+        for (const auto &field : fields_) {
+            if (offset + field.second > capacity) {
+                return;
+            }
+            std::memcpy(static_cast<char *>(buffer) + offset, field.first, field.second);
+            offset += field.second;
+        }
+    }
+
+    size_t GetDataSize() const
+    {
+        size_t size = 0;
+        for (const auto &field : fields_) {
+            size += field.second;
+        }
+        return size;
+    }
+
+protected:
+    int AddField(const void *field, size_t size)
+    {
+        fields_.emplace_back(field, size);
+        return 0;
+    }
+
+private:
+    std::vector<std::pair<const void *, size_t>> fields_;
+};
+}  // namespace optiling
+
+#define BEGIN_TILING_DATA_DEF(className) \
+    class className : public TilingDef { \
+    public:
+
+#define TILING_DATA_FIELD_DEF(dataType, fieldName) \
+    void set_##fieldName(dataType value) { fieldName##_ = value; } \
+    dataType get_##fieldName() const { return fieldName##_; } \
+    \
+private: \
+    dataType fieldName##_ = static_cast<dataType>(AddField(&fieldName##_, sizeof(dataType))); \
+    \
+public:
+
+#define END_TILING_DATA_DEF }
+
+#define REGISTER_TILING_DATA_CLASS(opType, className)
+
+#endif  // STUB_REGISTER_TILINGDATA_BASE_H
@@ -0,0 +1,34 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+// 主机侧单元测试用的桩：系统 workspace 固定为 16MB
+#ifndef STUB_TILING_PLATFORM_PLATFORM_ASCENDC_H
+#define STUB_TILING_PLATFORM_PLATFORM_ASCENDC_H
+
+#include <cstdint>
+
+#include "register/op_def_registry.h"
+
+namespace platform_ascendc {
+const uint32_t STUB_LIB_API_WORKSPACE_SIZE = 16 * 1024 * 1024;
+
+class PlatformAscendC {
+public:
+    explicit PlatformAscendC(fe::PlatFormInfos *) {}
+
+    uint32_t GetLibApiWorkSpaceSize() const { return STUB_LIB_API_WORKSPACE_SIZE; }
+};
+}  // namespace platform_ascendc
+
+#endif  // STUB_TILING_PLATFORM_PLATFORM_ASCENDC_H
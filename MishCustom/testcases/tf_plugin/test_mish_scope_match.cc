@@ -0,0 +1,138 @@
+/* Copyright (C) 2020-2021. Huawei Technologies Co., Ltd. All
+rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the Apache License Version 2.0.
+ * You may not use this file except in compliance with the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * Apache License for more details at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mish_scope_match.h"
+
+using ge::MatchMishScope;
+using ge::MishGraphNode;
+using ge::MishScopeMatch;
+
+namespace {
+// 只读 GraphDef 文本格式里 node 的 name/op/input，attr 等嵌套块跳过
+std::vector<MishGraphNode> LoadGraphDef(const std::string &fileName)
+{
+    std::ifstream file(std::string(MISH_FIXTURE_DIR) + "/" + fileName);
+    EXPECT_TRUE(file.is_open()) << fileName;
+    std::vector<MishGraphNode> graph;
+    std::string line;
+    int depth = 0;
+    while (std::getline(file, line)) {
+        std::istringstream tokens(line);
+        std::string key;
+        if (!(tokens >> key) || key[0] == '#') {
+            continue;
+        }
+        if (key == "}") {
+            --depth;
+            continue;
+        }
+        if (line.find('{') != std::string::npos) {
+            if (depth == 0 && key == "node") {
+                graph.push_back(MishGraphNode());
+            }
+            depth += line.find('}') == std::string::npos ? 1 : 0;
+            continue;
+        }
+        if (depth != 1 || graph.empty()) {
+            continue;
+        }
+        size_t begin = line.find('"');
+        size_t end = line.rfind('"');
+        std::string value = begin < end ? line.substr(begin + 1, end - begin - 1) : "";
+        if (key == "name:") {
+            graph.back().name = value;
+        } else if (key == "op:") {
+            graph.back().type = value;
+        } else if (key == "input:") {
+            graph.back().inputs.push_back(value);
+        }
+    }
+    return graph;
+}
+}  // namespace
+
+TEST(MishScopeMatch, SoftplusForm)
+{
+    std::vector<MishGraphNode> graph = LoadGraphDef("mish_softplus.pbtxt");
+    ASSERT_EQ(graph.size(), 5U);
+    MishScopeMatch match;
+    ASSERT_TRUE(MatchMishScope(graph, "model/mish/", &match));
+    EXPECT_EQ(match.first, "model/mish/Softplus");
+    EXPECT_EQ(match.mul, "model/mish/mul");
+    EXPECT_EQ(match.x, "x:0");
+}
+
+TEST(MishScopeMatch, Log1pExpFormThroughIdentity)
+{
+    std::vector<MishGraphNode> graph = LoadGraphDef("mish_log1p_exp.pbtxt");
+    MishScopeMatch match;
+    ASSERT_TRUE(MatchMishScope(graph, "mish/", &match));
+    EXPECT_EQ(match.first, "mish/Exp");
+    EXPECT_EQ(match.mul, "mish/mul");
+    EXPECT_EQ(match.x, "x:0");
+}
+
+TEST(MishScopeMatch, ChainedScopes)
+{
+    std::vector<MishGraphNode> graph = LoadGraphDef("two_mish.pbtxt");
+    MishScopeMatch match;
+    ASSERT_TRUE(MatchMishScope(graph, "block1/mish/", &match));
+    EXPECT_EQ(match.x, "x:0");
+    // block1 的输出被 block2 使用没有问题，它是 Mul 的结果
+    ASSERT_TRUE(MatchMishScope(graph, "block2/mish/", &match));
+    EXPECT_EQ(match.x, "block1/mish/mul:0");
+    // scope 名须以 "/" 结尾，不存在的 scope 不匹配
+    EXPECT_FALSE(MatchMishScope(graph, "block", nullptr));
+    EXPECT_FALSE(MatchMishScope(graph, "block3/", nullptr));
+}
+
+TEST(MishScopeMatch, RejectsDifferentInputs)
+{
+    EXPECT_FALSE(MatchMishScope(LoadGraphDef("mish_other_input.pbtxt"), "mish/", nullptr));
+}
+
+TEST(MishScopeMatch, RejectsIntermediateUsedOutside)
+{
+    EXPECT_FALSE(MatchMishScope(LoadGraphDef("mish_shared_tanh.pbtxt"), "mish/", nullptr));
+}
+
+TEST(MishScopeMatch, RejectsControlEdgeOnIntermediate)
+{
+    std::vector<MishGraphNode> graph = LoadGraphDef("mish_control_edge.pbtxt");
+    EXPECT_FALSE(MatchMishScope(graph, "mish/", nullptr));
+    // 去掉控制边后 Identity 只是别名，可以融合
+    graph.pop_back();
+    EXPECT_TRUE(MatchMishScope(graph, "mish/", nullptr));
+}
+
+TEST(MishScopeMatch, RejectsTanhNotFedBySoftplus)
+{
+    EXPECT_FALSE(MatchMishScope(LoadGraphDef("mish_tanh_bypass.pbtxt"), "mish/", nullptr));
+}
+
+TEST(MishScopeMatch, RejectsMissingWiring)
+{
+    // 取不到输入信息时不融合
+    std::vector<MishGraphNode> graph = LoadGraphDef("mish_softplus.pbtxt");
+    for (auto &node : graph) {
+        node.inputs.clear();
+    }
+    EXPECT_FALSE(MatchMishScope(graph, "model/mish/", nullptr));
+}